@@ -20,7 +20,11 @@
 
 #include <boost/shared_ptr.hpp>
 #include <string>
+#include <algorithm>
 #include <XBotInterface/Logger.hpp>
+#include <OpenSoT/utils/RTLogger.h>
+#include <OpenSoT/utils/UpdateCycle.h>
+#include <vector>
 
  namespace OpenSoT {
 
@@ -96,6 +100,13 @@
          */
         Vector_type _bUpperBound;
 
+        /**
+         * @brief _rowKeys a key for each row of _Aineq, which identifies the same constraint across the cycles.
+         * Constraints whose rows appear, disappear or change order between two updates fill it,
+         * empty means that row i is always the same constraint
+         */
+        std::vector<std::size_t> _rowKeys;
+
         /**
          * @brief _log can be used to log internal Constraint variables
          * @param logger a shared pointer to a MatLogger
@@ -105,10 +116,69 @@
 
         }
 
+        /**
+         * @brief _registerLog can be used to register internal Constraint variables on a real-time logger
+         * @param logger a shared pointer to a RTLogger
+         */
+        virtual void _registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+
+        }
+
+        /**
+         * @brief _log can be used to log internal Constraint variables registered in _registerLog()
+         * @param logger a shared pointer to a RTLogger
+         */
+        virtual void _log(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+
+        }
+
+    private:
+        /**
+         * @brief _rt_logger, _rt_log_handles the real-time logger on which the Constraint is registered and
+         * the handles of _Aeq, _Aineq, _beq, _bLowerBound, _bUpperBound, _upperBound, _lowerBound
+         */
+        OpenSoT::utils::RTLogger* _rt_logger;
+        std::vector<OpenSoT::utils::RTLogger::Handle> _rt_log_handles;
+
+        /**
+         * @brief _update_divider the cycles in which the constraint is updated by scheduledUpdate()
+         */
+        utils::UpdateDivider _update_divider;
+
+        /**
+         * @brief _update_stamp cycle and state of the last scheduledUpdate()
+         */
+        utils::UpdateStamp<Vector_type> _update_stamp;
+
+        static const char* getChannelName(const unsigned int i)
+        {
+            static const char* names[] = {"_Aeq", "_Aineq", "_beq", "_bLowerBound", "_bUpperBound",
+                                          "_upperBound", "_lowerBound"};
+            return names[i];
+        }
+
+        void registerChannel(OpenSoT::utils::RTLogger::Ptr logger, const unsigned int i,
+                             const unsigned int rows, const unsigned int cols)
+        {
+            _rt_log_handles[i] = logger->registerChannel(_constraint_id + getChannelName(i), rows, cols);
+        }
+
+        /**
+         * @brief logChannel logs a sample: a sample larger than its channel is dropped and counted by the logger
+         */
+        template <class Data_type>
+        void logChannel(OpenSoT::utils::RTLogger::Ptr logger, const unsigned int i, const Data_type& data)
+        {
+            if(data.size() > 0)
+                logger->add(_rt_log_handles[i], data);
+        }
+
     public:
         Constraint(const std::string constraint_id,
                    const unsigned int x_size) :
-            _constraint_id(constraint_id), _x_size(x_size) {}
+            _constraint_id(constraint_id), _x_size(x_size), _rt_logger(NULL) {}
         virtual ~Constraint() {}
 
         const unsigned int getXSize() { return _x_size; }
@@ -122,6 +192,13 @@
         virtual const Vector_type& getbLowerBound() { return _bLowerBound; }
         virtual const Vector_type& getbUpperBound() { return _bUpperBound; }
 
+        /**
+         * @brief getRowKeys
+         * @return a key for each row of Aineq identifying the same constraint across the cycles, empty if
+         * the rows do not change order (see _rowKeys)
+         */
+        virtual const std::vector<std::size_t>& getRowKeys() { return _rowKeys; }
+
         /**
          * @brief isEqualityConstraint
          * @return true if Constraint enforces an equality constraint
@@ -134,6 +211,15 @@
          */
         virtual bool isInequalityConstraint() { return _Aineq.rows() > 0; }
 
+        /**
+         * @brief getMaxAineqRows
+         * @return the maximum number of rows of Aineq, bLowerBound and bUpperBound, for constraints whose
+         * number of rows changes between the updates. The channels of the real-time logger are registered with
+         * this size (see registerLog()) and are never enlarged, so constraints whose rows can grow have to
+         * override it: larger samples are dropped. The default is the actual number of rows
+         */
+        virtual unsigned int getMaxAineqRows() { return _Aineq.rows(); }
+
         /**
          * @brief isUnilateralConstraint
          * @return true if the Constraint is an unilateral inequality
@@ -178,6 +264,40 @@
             @param x variable state at the current step (input) */
         virtual void update(const Vector_type& x) {}
 
+        /**
+         * @brief setUpdateDivider makes the constraint slower than the control loop: scheduledUpdate() updates it
+         * once every divider update cycles (see utils::UpdateCycle, e.g. AutoStack::update()), and in the other
+         * cycles its matrices and bounds are held. A cycle is counted once, however many containers share the
+         * constraint. Outside of an update cycle the divider is not applied and the constraint is updated at every call.
+         * AutoStack::setUpdateDivider() chooses the phases of its slow tasks and constraints.
+         * @param divider number of cycles between two updates, 1 to update at every cycle
+         * @param phase the first update is in the cycle divider - phase (0 updates at the first cycle)
+         * @return false if divider is 0
+         */
+        bool setUpdateDivider(const unsigned int divider, const unsigned int phase = 0)
+        {
+            return _update_divider.set(divider, phase);
+        }
+
+        unsigned int getUpdateDivider() const { return _update_divider.get(); }
+
+        /**
+         * @brief scheduledUpdate updates the constraint in the cycles of its update divider (see setUpdateDivider()).
+         * It is called by the containers of the constraint (AutoStack, Aggregated, Task) in place of update().
+         * Inside an update cycle (see utils::UpdateCycle) a constraint already updated with the same x is skipped
+         * @param x variable state at the current step (input)
+         * @return true if the constraint was updated
+         */
+        bool scheduledUpdate(const Vector_type& x)
+        {
+            if(!_update_stamp.stamp(x))
+                return false;
+            if(!_update_divider.isScheduled())
+                return false;
+            update(x);
+            return true;
+        }
+
         /**
          * @brief log logs common Constraint internal variables
          * @param logger a shared pointer to a MathLogger
@@ -200,6 +320,49 @@
                 logger->add(_constraint_id + "_lowerBound", _lowerBound);
             _log(logger);
         }
+
+        /**
+         * @brief registerLog registers common Constraint internal variables on a real-time logger.
+         * Aineq, bLowerBound and bUpperBound are registered with getMaxAineqRows() rows, the others with their actual size.
+         * It allocates: it is meant to be called before the control loop
+         * @param logger a shared pointer to a RTLogger
+         */
+        virtual void registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+            _rt_logger = logger.get();
+            _rt_log_handles.assign(7, -1);
+            const unsigned int max_rows = std::max<unsigned int>(getMaxAineqRows(), _Aineq.rows());
+            registerChannel(logger, 0, _Aeq.rows(), _Aeq.cols());
+            registerChannel(logger, 1, max_rows, _x_size);
+            registerChannel(logger, 2, _beq.size(), 1);
+            registerChannel(logger, 3, max_rows, 1);
+            registerChannel(logger, 4, max_rows, 1);
+            registerChannel(logger, 5, _upperBound.size(), 1);
+            registerChannel(logger, 6, _lowerBound.size(), 1);
+            _registerLog(logger);
+        }
+
+        /**
+         * @brief log logs common Constraint internal variables on a real-time logger.
+         * If the Constraint was not registered on logger, it is registered first (this allocates).
+         * The channels are not registered again: a sample larger than its channel (e.g. Aineq of a constraint
+         * whose rows grow without declaring getMaxAineqRows()) is dropped and counted in RTLogger::getDroppedSamples()
+         * @param logger a shared pointer to a RTLogger
+         */
+        virtual void log(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+            if(_rt_logger != logger.get())
+                registerLog(logger);
+
+            logChannel(logger, 0, _Aeq);
+            logChannel(logger, 1, _Aineq);
+            logChannel(logger, 2, _beq);
+            logChannel(logger, 3, _bLowerBound);
+            logChannel(logger, 4, _bUpperBound);
+            logChannel(logger, 5, _upperBound);
+            logChannel(logger, 6, _lowerBound);
+            _log(logger);
+        }
     };
  }
 
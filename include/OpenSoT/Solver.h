@@ -50,6 +50,24 @@ using namespace std;
 
         }
 
+        /**
+         * @brief _registerLog implement this on the solver to register data on a real-time logger
+         * @param logger a pointer to a RTLogger
+         */
+        virtual void _registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+
+        }
+
+        /**
+         * @brief _log implement this on the solver to log data registered in _registerLog()
+         * @param logger a pointer to a RTLogger
+         */
+        virtual void _log(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+
+        }
+
 
     public:
 
@@ -93,6 +111,25 @@ using namespace std;
         {
             _log(logger);
         }
+
+        /**
+         * @brief registerLog registers data related to the solver on a real-time logger.
+         * It allocates: it is meant to be called before the control loop
+         * @param logger a pointer to a RTLogger
+         */
+        virtual void registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+            _registerLog(logger);
+        }
+
+        /**
+         * @brief log logs data related to the solver on a real-time logger
+         * @param logger a pointer to a RTLogger
+         */
+        virtual void log(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+            _log(logger);
+        }
     };
  }
 
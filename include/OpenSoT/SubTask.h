@@ -52,6 +52,8 @@
         Indices _subTaskMap;
 
         virtual void _log(XBot::MatLogger::Ptr logger);
+        virtual void _registerLog(OpenSoT::utils::RTLogger::Ptr logger);
+        virtual void _log(OpenSoT::utils::RTLogger::Ptr logger);
 
         void generateA();
 
@@ -115,6 +117,12 @@
          * @return true if success
          */
         virtual bool setActiveJointsMask(const std::vector<bool>& active_joints_mask);
+
+        /**
+         * @brief applyReferences applies the references published on the ports of the father Task
+         * @return true if a new reference was applied
+         */
+        virtual bool applyReferences();
     };
 
 
@@ -136,6 +136,24 @@
 
         }
 
+        /**
+         * @brief _registerLog can be used to register internal Task variables on a real-time logger
+         * @param logger a shared pointer to a RTLogger
+         */
+        virtual void _registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+
+        }
+
+        /**
+         * @brief _log can be used to log internal Task variables registered in _registerLog()
+         * @param logger a shared pointer to a RTLogger
+         */
+        virtual void _log(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+
+        }
+
     private:
 
         /**
@@ -158,6 +176,13 @@
          * 
          */
         bool _is_active;
+
+        /**
+         * @brief _rt_logger, _rt_log_handles the real-time logger on which the Task is registered
+         * and the handles of _A, _b, _W, _lambda
+         */
+        OpenSoT::utils::RTLogger* _rt_logger;
+        std::vector<OpenSoT::utils::RTLogger::Handle> _rt_log_handles;
         
         /**
          * @brief ...
@@ -165,6 +190,23 @@
          */
         Matrix_type _A_last_active;
 
+        /**
+         * @brief _update_divider the cycles in which the task is updated by scheduledUpdate()
+         */
+        utils::UpdateDivider _update_divider;
+
+        /**
+         * @brief _extrapolate, _x_refresh, _b_refresh, _dx in the cycles without update b is extrapolated
+         * from the state and b of the last update
+         */
+        bool _extrapolate;
+        Vector_type _x_refresh, _b_refresh, _dx;
+
+        /**
+         * @brief _update_stamp cycle and state of the last update
+         */
+        utils::UpdateStamp<Vector_type> _update_stamp;
+
     public:
         /**
          * @brief Task define a task in terms of Ax = b
@@ -173,7 +215,8 @@
          */
         Task(const std::string task_id,
              const unsigned int x_size) :
-            _task_id(task_id), _x_size(x_size), _active_joints_mask(x_size), _is_active(true)
+            _task_id(task_id), _x_size(x_size), _active_joints_mask(x_size), _is_active(true), _rt_logger(NULL),
+            _extrapolate(false)
         {
             _lambda = 1.0;
             _hessianType = HST_UNKNOWN;
@@ -302,13 +345,16 @@
             @return the number of rows of A */
         virtual const unsigned int getTaskSize() const { return _A.rows(); }
 
-        /** Updates the A, b, Aeq, beq, Aineq, b*Bound matrices 
+        /** Updates the A, b, Aeq, beq, Aineq, b*Bound matrices.
+            Inside an update cycle (see utils::UpdateCycle) a task already updated with the same x is not
+            updated again
             @param x variable state at the current step (input) */
         void update(const Vector_type &x) {
-           
-            
+            if(!_update_stamp.stamp(x))
+                return;
+
             for(typename std::list< ConstraintPtr >::iterator i = this->getConstraints().begin();
-                i != this->getConstraints().end(); ++i) (*i)->update(x);
+                i != this->getConstraints().end(); ++i) (*i)->scheduledUpdate(x);
             this->_update(x);
             
             if(!_is_active){
@@ -331,6 +377,76 @@
             
         }
 
+        /**
+         * @brief setUpdateDivider makes the task slower than the control loop: scheduledUpdate() updates it once
+         * every divider update cycles (see utils::UpdateCycle, e.g. AutoStack::update()), and in the other cycles
+         * A and b are held, or b is extrapolated. A cycle is counted once, however many containers share the task.
+         * Outside of an update cycle the divider is not applied and the task is updated at every call.
+         * The extrapolation assumes that the state is the one the task is linearized about (e.g. q for the
+         * velocity tasks) and that b = lambda*e(state) with de/dstate = -A, so that
+         *
+         *      b = b_update - lambda*A*(state - state_update)
+         *
+         * When the size of the state is not the number of columns of A, b is held.
+         * AutoStack::setUpdateDivider() chooses the phases of its slow tasks and constraints.
+         * @param divider number of cycles between two updates, 1 to update at every cycle
+         * @param phase the first update is in the cycle divider - phase (0 updates at the first cycle)
+         * @param extrapolate true to extrapolate b between the updates
+         * @return false if divider is 0
+         */
+        bool setUpdateDivider(const unsigned int divider, const unsigned int phase = 0, const bool extrapolate = false)
+        {
+            if(!_update_divider.set(divider, phase))
+                return false;
+            _extrapolate = extrapolate;
+            _x_refresh.resize(0);
+            return true;
+        }
+
+        unsigned int getUpdateDivider() const { return _update_divider.get(); }
+
+        /**
+         * @brief scheduledUpdate updates the task in the cycles of its update divider (see setUpdateDivider()),
+         * and holds or extrapolates it in the others. It is called by the containers of the task
+         * (AutoStack, Aggregated, SubTask) in place of update().
+         * Inside an update cycle (see utils::UpdateCycle) a task already updated with the same x is skipped
+         * @param x variable state at the current step (input)
+         * @return true if the task was updated
+         */
+        bool scheduledUpdate(const Vector_type &x)
+        {
+            if(_update_stamp.isStamped(x))
+                return false;
+
+            if(!_update_divider.isScheduled())
+            {
+                _update_stamp.stamp(x);
+                if(_extrapolate && _x_refresh.size() == x.size() && x.size() == _A.cols())
+                {
+                    _dx = x - _x_refresh;
+                    _b = _b_refresh;
+                    _b.noalias() -= _lambda*_A*_dx;
+                }
+                return false;
+            }
+
+            update(x);
+            if(_update_divider.get() > 1 && _extrapolate)
+            {
+                _x_refresh = x;
+                _b_refresh = _b;
+            }
+            return true;
+        }
+
+        /**
+         * @brief applyReferences applies the references published on the lock-free reference ports of the task
+         * by another thread (e.g. velocity::Cartesian::setReferenceAsync()). It is called by the control thread
+         * before update(): AutoStack::update() calls it on all the tasks of the stack.
+         * @return true if a new reference was applied
+         */
+        virtual bool applyReferences(){ return false; }
+
         /**
          * @brief getTaskID return the task id
          * @return a string with the task id
@@ -378,6 +494,47 @@
                 constraint->log(logger);
 
         }
+
+        /**
+         * @brief registerLog registers common Task internal variables (and the ones of its constraints)
+         * on a real-time logger, with their actual size. It allocates: it is meant to be called before the control loop.
+         * Tasks are not expected to change size between the updates: if A or b grow, their samples are dropped
+         * until the Task is registered again
+         * @param logger a shared pointer to a RTLogger
+         */
+        virtual void registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+            _rt_logger = logger.get();
+            _rt_log_handles.clear();
+            _rt_log_handles.push_back(logger->registerChannel(_task_id + "_A", _A.rows(), _A.cols()));
+            _rt_log_handles.push_back(logger->registerChannel(_task_id + "_b", _b.rows(), _b.cols()));
+            _rt_log_handles.push_back(logger->registerChannel(_task_id + "_W", _W.rows(), _W.cols()));
+            _rt_log_handles.push_back(logger->registerChannel(_task_id + "_lambda", 1));
+            _registerLog(logger);
+
+            for(auto constraint : _constraints)
+                constraint->registerLog(logger);
+        }
+
+        /**
+         * @brief log logs common Task internal variables on a real-time logger.
+         * If the Task was not registered on logger, it is registered first
+         * @param logger a shared pointer to a RTLogger
+         */
+        virtual void log(OpenSoT::utils::RTLogger::Ptr logger)
+        {
+            if(_rt_logger != logger.get())
+                registerLog(logger);
+
+            logger->add(_rt_log_handles[0], _A);
+            logger->add(_rt_log_handles[1], _b);
+            logger->add(_rt_log_handles[2], _W);
+            logger->add(_rt_log_handles[3], _lambda);
+            _log(logger);
+
+            for(auto constraint : _constraints)
+                constraint->log(logger);
+        }
     };
 
 
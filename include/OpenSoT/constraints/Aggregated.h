@@ -92,6 +92,8 @@ using namespace OpenSoT::utils;
             }
 
             virtual void _log(XBot::MatLogger::Ptr logger);
+            virtual void _registerLog(OpenSoT::utils::RTLogger::Ptr logger);
+            virtual void _log(OpenSoT::utils::RTLogger::Ptr logger);
 
         public:
             /**
@@ -137,6 +139,12 @@ using namespace OpenSoT::utils;
 
             std::list< ConstraintPtr >& getConstraintsList() { return _bounds; }
 
+            /**
+             * @brief getMaxAineqRows
+             * @return the number of rows of Aineq when the aggregated constraints have their maximum number of rows
+             */
+            unsigned int getMaxAineqRows();
+
             void generateAll();
         };
     }
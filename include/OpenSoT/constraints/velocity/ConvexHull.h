@@ -50,6 +50,34 @@
                 std::vector<KDL::Vector> _ch;
                 std::list<std::string> _links_in_contact;
 
+                /**
+                 * @brief _points contact points, in world frame
+                 * @brief _contact_positions contact points used for the last computation of the convex hull
+                 */
+                std::vector<KDL::Vector> _points;
+                std::vector<KDL::Vector> _contact_positions;
+                double _hull_tolerance;
+                /**
+                 * @brief _lines coefficients (a, b, c) of the edges of the convex hull in world frame,
+                 *        one per row, cached between computations of the convex hull
+                 */
+                Eigen::MatrixXd _lines;
+
+                /**
+                 * @brief _vertices index in _points of each vertex of the convex hull
+                 */
+                std::vector<unsigned int> _vertices;
+                Eigen::MatrixXd _A_ch;
+                Eigen::MatrixXd _JCoM;
+                KDL::Vector _world_CoM;
+
+                /**
+                 * @brief updateSupportPolygon recomputes the convex hull (in world frame) and its edges
+                 *        only if some contact moved more than the hull tolerance since the last computation
+                 * @return true if the convex hull is valid
+                 */
+                bool updateSupportPolygon();
+
             public:
                 /**
                  * @brief ConvexHull constructor
@@ -91,6 +119,13 @@
                  */
                 void setSafetyMargin(const double safetyMargin);
 
+                /**
+                 * @brief setHullTolerance sets the displacement, in [m], of the contact points
+                 *        above which the convex hull is recomputed (default 1e-4)
+                 * @param hullTolerance
+                 */
+                void setHullTolerance(const double hullTolerance);
+
                 void update(const Eigen::VectorXd &x);
 
                 std::list<std::string> getLinksInContact()
@@ -101,7 +136,14 @@
                 void setLinksInContact(const std::list<std::string>& links_inc_contact)
                 {
                     _links_in_contact = links_inc_contact;
+                    _contact_positions.clear();
                 }
+
+                /**
+                 * @brief getMaxAineqRows
+                 * @return the number of links in contact, the maximum number of edges of the convex hull
+                 */
+                unsigned int getMaxAineqRows() { return _links_in_contact.size(); }
             };
         }
     }
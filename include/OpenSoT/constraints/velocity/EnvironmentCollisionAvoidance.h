@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi
+ * email:  alessio.rocchi@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __BOUNDS_VELOCITY_ENVIRONMENTCOLLISIONAVOIDANCE_H__
+#define __BOUNDS_VELOCITY_ENVIRONMENTCOLLISIONAVOIDANCE_H__
+
+#include <OpenSoT/Constraint.h>
+#include <OpenSoT/utils/SignedDistanceField.h>
+#include <XBotInterface/ModelInterface.h>
+#include <Eigen/Dense>
+#include <limits>
+#include <vector>
+
+namespace OpenSoT {
+    namespace constraints {
+        namespace velocity {
+
+            /**
+             * @brief The EnvironmentCollisionAvoidance class implements a constraint which keeps a set of
+             *        control shapes (spheres and capsules) rigidly attached to the robot links away from the environment.
+             *        The environment is described by a precomputed OpenSoT::utils::SignedDistanceField, in world frame.
+             *
+             *        For every control shape, the point of the shape axis closest to the environment is found by
+             *        sampling the field along the axis (a single sample for spheres), each sample costing a constant time.
+             *        Then, as in SelfCollisionAvoidance, the constraint is:
+             *
+             *              -n^T * J_p * dq <= (d - r - d_threshold) * boundScaling
+             *
+             *        where d and n are distance and gradient of the field at the closest point p, J_p the linear
+             *        jacobian of p, and r the radius of the shape.
+             *
+             *        The constraint has one row for each control shape: shapes farther than the detection threshold
+             *        give an empty row with an infinite upper bound, so that the size of the problem never changes.
+             */
+            class EnvironmentCollisionAvoidance: public Constraint<Eigen::MatrixXd, Eigen::VectorXd> {
+            public:
+                typedef boost::shared_ptr<EnvironmentCollisionAvoidance> Ptr;
+
+                /**
+                 * @brief EnvironmentCollisionAvoidance
+                 * @param x the robot current configuration vector
+                 * @param robot the robot model reference
+                 * @param sdf the signed distance field of the environment, in world frame
+                 * @param detection_threshold control shapes farther than this threshold from the environment are not constrained
+                 * @param distance_threshold the minimum allowed distance between control shapes and environment
+                 * @param boundScaling the bound scaling (a lower number means we will approach
+                 *        the distance_threshold more slowly)
+                 */
+                EnvironmentCollisionAvoidance(const Eigen::VectorXd& x,
+                                              XBot::ModelInterface& robot,
+                                              OpenSoT::utils::SignedDistanceField::Ptr sdf,
+                                              const double detection_threshold = std::numeric_limits<double>::infinity(),
+                                              const double distance_threshold = 0.0,
+                                              const double boundScaling = 1.0);
+
+                /**
+                 * @brief addControlSphere adds a sphere attached to a link
+                 * @param link_name the name of the link
+                 * @param center the center of the sphere, in link frame
+                 * @param radius the radius of the sphere
+                 * @return false if the link does not exist
+                 */
+                bool addControlSphere(const std::string& link_name,
+                                      const Eigen::Vector3d& center,
+                                      const double radius);
+
+                /**
+                 * @brief addControlCapsule adds a capsule attached to a link
+                 * @param link_name the name of the link
+                 * @param ep1 the first endpoint of the capsule axis, in link frame
+                 * @param ep2 the second endpoint of the capsule axis, in link frame
+                 * @param radius the radius of the capsule
+                 * @return false if the link does not exist
+                 */
+                bool addControlCapsule(const std::string& link_name,
+                                       const Eigen::Vector3d& ep1,
+                                       const Eigen::Vector3d& ep2,
+                                       const double radius);
+
+                /**
+                 * @brief getNumberOfControlShapes
+                 * @return the number of control shapes, which is also the number of rows of the constraint
+                 */
+                unsigned int getNumberOfControlShapes() const { return _shapes.size(); }
+
+                /**
+                 * @brief getDistances
+                 * @return the distance of each control shape from the environment, computed at the last update
+                 */
+                const Eigen::VectorXd& getDistances() const { return _distances; }
+
+                double getDetectionThreshold() const { return _detection_threshold; }
+                void setDetectionThreshold(const double detection_threshold);
+
+                double getDistanceThreshold() const { return _distance_threshold; }
+                void setDistanceThreshold(const double distance_threshold);
+
+                /**
+                 * @brief setBoundScaling sets bound scaling for the constraint
+                 * @param boundScaling is a number which should be lower than 1.0
+                 */
+                void setBoundScaling(const double boundScaling);
+
+                /**
+                 * @brief update recomputes Aineq and bUpperBound from the current state of the robot model
+                 * @param x the state vector
+                 */
+                void update(const Eigen::VectorXd& x);
+
+            private:
+                /**
+                 * @brief The ControlShape struct is a capsule in link frame, spheres have ep1 == ep2.
+                 *        The axis is sampled in number_of_samples points, at most one resolution of the field apart
+                 */
+                struct ControlShape
+                {
+                    std::string link_name;
+                    Eigen::Vector3d ep1, ep2;
+                    double radius;
+                    unsigned int number_of_samples;
+                };
+
+                void calculate_Aineq_bUpperB(Eigen::MatrixXd& Aineq, Eigen::VectorXd& bUpperBound);
+
+                virtual void _log(XBot::MatLogger::Ptr logger);
+
+                XBot::ModelInterface& _robot;
+                OpenSoT::utils::SignedDistanceField::Ptr _sdf;
+
+                double _detection_threshold;
+                double _distance_threshold;
+                double _boundScaling;
+
+                std::vector<ControlShape> _shapes;
+                Eigen::VectorXd _distances;
+
+                Eigen::Affine3d _w_T_link;
+                Eigen::MatrixXd _J;
+            };
+        }
+    }
+}
+
+#endif
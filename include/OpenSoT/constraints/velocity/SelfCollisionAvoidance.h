@@ -71,6 +71,35 @@
                 std::string base_name;
 
                 Eigen::MatrixXd _J_transform;
+
+                /**
+                 * @brief _linkPairDistances preallocated buffer of the link pairs closer than the detection threshold
+                 */
+                std::vector<IndexedLinkPairDistance> _linkPairDistances;
+
+                /**
+                 * @brief _base_T_link, _base_J_link pose and jacobian of each link, indexed by the link id
+                 * given by computeLinksDistance. They are computed at most once per update, the first time
+                 * a pair involving the link is found, and shared among all the pairs involving the same link
+                 */
+                std::vector<KDL::Frame> _base_T_link;
+                std::vector<Eigen::MatrixXd> _base_J_link;
+
+                /**
+                 * @brief _link_update_stamp the value of _update_stamp when each link was last cached
+                 */
+                std::vector<unsigned int> _link_update_stamp;
+                unsigned int _update_stamp;
+
+                Eigen::MatrixXd _temp_trans_matrix;
+                Eigen::MatrixXd _J_tmp;
+                Eigen::RowVectorXd _dir_T_J_transform;
+
+                /**
+                 * @brief updateLinkCache computes pose and jacobian of a link, if not already done in this update
+                 * @param link_id the id of the link
+                 */
+                void updateLinkCache(const unsigned int link_id);
             public:               
                 /**
                  * @brief Skew_symmetric_operator is used to get the transformation matrix which is used to transform
@@ -101,13 +130,16 @@
                  * @param linkPair_threshold the minimum distance between each Link pair
                  * @param boundScaling the bound scaling for the capsule distance (a lower number means we will approach
                  *        the linkPair_threshold more slowly)
+                 * @param cache_directory the directory where the collision geometries are cached,
+                 *        if empty no cache is used (see ComputeLinksDistance)
                  */
                 SelfCollisionAvoidance(const Eigen::VectorXd& x,
                                        XBot::ModelInterface &robot,
                                        std::string& base_link,
                                        double detection_threshold = std::numeric_limits<double>::infinity(),
                                        double linkPair_threshold = 0.0,
-                                       const double boundScaling = 1.0);
+                                       const double boundScaling = 1.0,
+                                       const std::string& cache_directory = "");
 
                 /**
                  * @brief getLinkPairThreshold
@@ -133,6 +165,12 @@
                  */
                 void setDetectionThreshold(const double detection_threshold);
 
+                /**
+                 * @brief getMaxAineqRows
+                 * @return the number of link pairs, since only the pairs within the detection threshold give a row
+                 */
+                unsigned int getMaxAineqRows();
+
                 /**
                  * @brief update recomputes Aineq and bUpperBound if x is different than the previously stored value
                  * @param x the state vector. It gets cached so that we won't recompute capsules distances if x didn't change
@@ -3,9 +3,8 @@
 
 #include <OpenSoT/utils/FloatingBaseEstimation.h>
 #include <OpenSoT/tasks/floating_base/Contact.h>
-#include <OpenSoT/utils/AutoStack.h>
-#include <OpenSoT/constraints/GenericConstraint.h>
 #include <OpenSoT/tasks/floating_base/IMU.h>
+#include <OpenSoT/solvers/BoxQP.h>
 
 
 namespace OpenSoT{
@@ -13,7 +12,13 @@ namespace floating_base_estimation{
 /**
      * @brief The qp_estimation class uses a QP to estimate the floating base pose and velocities from
      * contact information and IMU (optional).
-     * The QP solved is a weighted sum of the measurements.
+     * The QP solved is a weighted sum of the measurements, with bounds on the floating base velocities:
+     * being a 6x6 problem with bounds only, it is solved by a BoxQP without allocations.
+     * The model is updated once per cycle, at the end of update() where the IMU orientation is applied:
+     * the Jacobians of a cycle are computed with the IMU orientation of the previous sample and the columns
+     * of the floating base translation of the contacts are rotated by the change of orientation of the IMU.
+     * The angular velocity of the floating base is measured by the IMU, the one of the QP solution is
+     * expressed with the orientation of the previous sample.
      */
     class qp_estimation: public OpenSoT::FloatingBaseEstimation
     {
@@ -31,13 +36,32 @@ namespace floating_base_estimation{
         virtual void log(XBot::MatLogger::Ptr logger);
 
     private:
-        std::list<OpenSoT::tasks::Aggregated::TaskPtr> _contact_tasks;
+        std::vector<OpenSoT::tasks::floating_base::Contact::Ptr> _contact_tasks;
         OpenSoT::tasks::floating_base::IMU::Ptr _imu_task;
         std::map<std::string, unsigned int> _map_tasks;
-        tasks::Aggregated::Ptr _aggregated_tasks;
-        solvers::iHQP::Ptr _solver;
-        constraints::GenericConstraint::Ptr _fb_limits;
-        AutoStack::Ptr _autostack;
+
+        /**
+         * @brief _qp weighted sum of the measurements, 1/2 x'Hx + g'x, with bounds _lb <= x <= _ub
+         */
+        solvers::BoxQP<6> _qp;
+        solvers::BoxQP<6>::MatrixN _H;
+        solvers::BoxQP<6>::VectorN _g, _lb, _ub, _x;
+        Eigen::Matrix<double, Eigen::Dynamic, 6, 0, 6, 6> _WA;
+        Eigen::VectorXd _dummy;
+
+        /**
+         * @brief _R_imu, _R_previous, _delta_R orientation of the IMU, orientation of the IMU link in the model
+         * (previous sample) and rotation between them, _A_contact Jacobian of a contact with the actual orientation
+         * and _A_translation its columns of the floating base translation
+         */
+        Eigen::Matrix3d _R_imu, _R_previous, _delta_R;
+        Eigen::MatrixXd _A_contact;
+        Eigen::Matrix<double, Eigen::Dynamic, 3, 0, 6, 3> _A_translation;
+
+        /**
+         * @brief addMeasurement adds ||A*x - b||_W to the cost function
+         */
+        void addMeasurement(const Eigen::MatrixXd& A, const Eigen::VectorXd& b, const Eigen::MatrixXd& W);
 
     };
 }
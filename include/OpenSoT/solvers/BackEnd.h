@@ -2,7 +2,9 @@
 #define _WB_SOT_SOLVERS_BACK_END_H_
 
 #include <Eigen/Dense>
+#include <vector>
 #include <XBotInterface/Logger.hpp>
+#include <OpenSoT/utils/RTLogger.h>
 #include <boost/any.hpp>
 
 namespace OpenSoT{
@@ -19,18 +21,18 @@ namespace OpenSoT{
          * @brief getSolution return the actual solution of the QP problem
          * @return solution
          */
-        const Eigen::VectorXd& getSolution(){return _solution;}
+        const Eigen::VectorXd& getSolution() const {return _solution;}
 
         /**
          * Getters for internal matrices and Eigen::VectorXds
          */
-        const Eigen::MatrixXd& getH(){return _H;}
-        const Eigen::VectorXd& getg(){return _g;}
-        const Eigen::MatrixXd& getA(){return _A;}
-        const Eigen::VectorXd& getlA(){return _lA;}
-        const Eigen::VectorXd& getuA(){return _uA;}
-        const Eigen::VectorXd& getl(){return _l;}
-        const Eigen::VectorXd& getu(){return _u;}
+        const Eigen::MatrixXd& getH() const {return _H;}
+        const Eigen::VectorXd& getg() const {return _g;}
+        const Eigen::MatrixXd& getA() const {return _A;}
+        const Eigen::VectorXd& getlA() const {return _lA;}
+        const Eigen::VectorXd& getuA() const {return _uA;}
+        const Eigen::VectorXd& getl() const {return _l;}
+        const Eigen::VectorXd& getu() const {return _u;}
         
         int getNumVariables() const;
         int getNumConstraints() const;
@@ -42,6 +44,22 @@ namespace OpenSoT{
          */
         void log(XBot::MatLogger::Ptr logger, int i);
 
+        /**
+         * @brief registerLog registers Tasks, Constraints and Bounds matrices on a real-time logger,
+         * with their actual size. It allocates: it is meant to be called before the control loop
+         * @param logger a pointer to a RTLogger
+         * @param i an index related to the particular index of the problem
+         */
+        void registerLog(OpenSoT::utils::RTLogger::Ptr logger, int i);
+
+        /**
+         * @brief log Tasks, Constraints and Bounds matrices on a real-time logger.
+         * If the problem was not registered on logger, it is registered first
+         * @param logger a pointer to a RTLogger
+         * @param i an index related to the particular index of the problem
+         */
+        void log(OpenSoT::utils::RTLogger::Ptr logger, int i);
+
         /**
          * @brief updateProblem update the whole problem see updateTask(), updateConstraints() and updateBounds()
          * @param H updated task matrix
@@ -99,6 +117,15 @@ namespace OpenSoT{
          */
         virtual bool updateBounds(const Eigen::VectorXd& l, const Eigen::VectorXd& u);
 
+        /**
+         * @brief remapConstraints tells the back-end that the next constraints are the actual ones in another
+         * order: the i-th row of the next constraints is the row_map[i]-th row of the actual ones, or a new row
+         * if row_map[i] < 0. Back-ends warm started from a working set use it to keep the working set when the rows
+         * appear, disappear or move; by default it does nothing. It has to be called before updateConstraints()
+         * @param row_map for each row of the next constraints, the index of the same row in the actual ones or -1
+         */
+        virtual void remapConstraints(const std::vector<int>& row_map){}
+
 
 
         ///PURE VIRTUAL METHODS:
@@ -156,6 +183,20 @@ namespace OpenSoT{
          */
         virtual void _log(XBot::MatLogger::Ptr logger, int i){}
 
+        /**
+         * @brief _registerLog can be used to register extra information on a real-time logger
+         * @param logger a pointer to a RTLogger
+         * @param i an index related to the particular index of the problem
+         */
+        virtual void _registerLog(OpenSoT::utils::RTLogger::Ptr logger, int i){}
+
+        /**
+         * @brief _log can be used to log extra information registered in _registerLog()
+         * @param logger a pointer to a RTLogger
+         * @param i an index related to the particular index of the problem
+         */
+        virtual void _log(OpenSoT::utils::RTLogger::Ptr logger, int i){}
+
         /**
          * @brief _printProblemInformation can be used to print extra information
          */
@@ -185,6 +226,14 @@ namespace OpenSoT{
          */
         Eigen::VectorXd _solution;
 
+    private:
+        /**
+         * @brief _rt_logger, _rt_log_handles the real-time logger on which the problem is registered
+         * and the handles of _H, _g, _A, _lA, _uA, _l, _u, _solution
+         */
+        OpenSoT::utils::RTLogger* _rt_logger;
+        std::vector<OpenSoT::utils::RTLogger::Handle> _rt_log_handles;
+
     };
 
     }
@@ -4,6 +4,7 @@
 #include <OpenSoT/solvers/QPOasesBackEnd.h>
 #include <OpenSoT/solvers/OSQPBackEnd.h>
 #include <boost/make_shared.hpp>
+#include <vector>
 
 namespace OpenSoT{
     namespace solvers{
@@ -12,12 +13,34 @@ namespace OpenSoT{
             OSQP
         };
 
+        /**
+         * @brief The BackEndCandidate struct is a back-end with a set of options (empty options are the default ones
+         * of the back-end), see iHQP::autotune()
+         */
+        struct BackEndCandidate
+        {
+            BackEndCandidate(const solver_back_ends be_solver, const std::string& candidate_name,
+                             const boost::any& candidate_options = boost::any()):
+                back_end(be_solver), name(candidate_name), options(candidate_options){}
+
+            solver_back_ends back_end;
+            std::string name;
+            boost::any options;
+        };
+
         BackEnd::Ptr BackEndFactory(const solver_back_ends be_solver, const int number_of_variables,
                                const int number_of_constraints,
                                OpenSoT::HessianType hessian_type,
                                const double eps_regularisation);
 
         std::string whichBackEnd(const solver_back_ends be_solver);
+
+        /**
+         * @brief getBackEndCandidates
+         * @return the available back-ends with their option presets, the first one of each back-end
+         * has the default options used by OpenSoT
+         */
+        std::vector<BackEndCandidate> getBackEndCandidates();
     }
 }
 
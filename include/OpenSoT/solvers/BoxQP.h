@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi, Enrico Mingo
+ * email:  alessio.rocchi@iit.it, enrico.mingo@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _WB_SOT_SOLVERS_BOX_QP_H_
+#define _WB_SOT_SOLVERS_BOX_QP_H_
+
+#include <Eigen/Dense>
+#include <algorithm>
+
+namespace OpenSoT{
+    namespace solvers{
+
+    /**
+     * @brief The BoxQP class solves small QP problems with bounds only,
+     *
+     *      min 1/2 x'Hx + g'x  s.t.  l <= x <= u
+     *
+     * with H positive definite, by a primal active-set method on the bounds. All the matrices have fixed size N,
+     * the free variables are factorized with a Cholesky decomposition of at most N x N on the stack:
+     * nothing is allocated. The bounds active at the last solve are the guess of the next one.
+     */
+    template <int N>
+    class BoxQP
+    {
+    public:
+        typedef Eigen::Matrix<double, N, N> MatrixN;
+        typedef Eigen::Matrix<double, N, 1> VectorN;
+
+        /**
+         * @brief The BoundStatus enum of each variable
+         */
+        enum BoundStatus {
+            FREE = 0,
+            AT_LOWER = -1,
+            AT_UPPER = 1
+        };
+
+        BoxQP():
+            _max_iterations(10*N),
+            _iterations(0),
+            _tolerance(1e-9)
+        {
+            _status.setZero();
+        }
+
+        /**
+         * @brief solve
+         * @param H positive definite hessian
+         * @param g gradient
+         * @param l lower bounds
+         * @param u upper bounds, u >= l
+         * @param x the starting point, moved inside the bounds, and the solution
+         * @return false if the free hessian is not positive definite or the iterations do not converge
+         */
+        bool solve(const MatrixN& H, const VectorN& g, const VectorN& l, const VectorN& u, VectorN& x)
+        {
+            // the active bounds of the last solve are the guess
+            for(int i = 0; i < N; ++i)
+            {
+                if(_status[i] == AT_LOWER || l[i] >= u[i])
+                {
+                    _status[i] = AT_LOWER;
+                    x[i] = l[i];
+                }
+                else if(_status[i] == AT_UPPER)
+                    x[i] = u[i];
+                else
+                    x[i] = std::min(std::max(x[i], l[i]), u[i]);
+            }
+
+            for(_iterations = 0; _iterations < _max_iterations; ++_iterations)
+            {
+                // minimum on the free variables, the others at their bounds
+                int free = 0;
+                for(int i = 0; i < N; ++i)
+                {
+                    if(_status[i] == FREE)
+                        _free[free++] = i;
+                }
+
+                _H_free.resize(free, free);
+                _rhs.resize(free);
+                for(int r = 0; r < free; ++r)
+                {
+                    _rhs[r] = -g[_free[r]];
+                    for(int c = 0; c < N; ++c)
+                    {
+                        if(_status[c] != FREE)
+                            _rhs[r] -= H(_free[r], c)*x[c];
+                    }
+                    for(int c = 0; c < free; ++c)
+                        _H_free(r, c) = H(_free[r], _free[c]);
+                }
+
+                if(free > 0)
+                {
+                    _llt.compute(_H_free);
+                    if(_llt.info() != Eigen::Success)
+                        return false;
+                    _rhs = _llt.solve(_rhs);
+                }
+
+                // longest step toward the minimum inside the bounds
+                double alpha = 1.0;
+                int blocking = -1;
+                bool blocking_upper = false;
+                for(int r = 0; r < free; ++r)
+                {
+                    const int i = _free[r];
+                    const double step = _rhs[r] - x[i];
+                    if(x[i] + step > u[i] && step > 0.0 && (u[i] - x[i])/step < alpha)
+                    {
+                        alpha = (u[i] - x[i])/step;
+                        blocking = i;
+                        blocking_upper = true;
+                    }
+                    else if(x[i] + step < l[i] && step < 0.0 && (l[i] - x[i])/step < alpha)
+                    {
+                        alpha = (l[i] - x[i])/step;
+                        blocking = i;
+                        blocking_upper = false;
+                    }
+                }
+                for(int r = 0; r < free; ++r)
+                    x[_free[r]] += alpha*(_rhs[r] - x[_free[r]]);
+
+                if(blocking >= 0)
+                {
+                    _status[blocking] = blocking_upper ? AT_UPPER : AT_LOWER;
+                    x[blocking] = blocking_upper ? u[blocking] : l[blocking];
+                    continue;
+                }
+
+                // the multipliers of the active bounds are the gradient
+                _gradient.noalias() = H*x;
+                _gradient += g;
+                int release = -1;
+                double violation = _tolerance;
+                for(int i = 0; i < N; ++i)
+                {
+                    if(l[i] >= u[i])
+                        continue;
+                    const double v = _status[i] == AT_LOWER ? -_gradient[i] :
+                                     _status[i] == AT_UPPER ? _gradient[i] : 0.0;
+                    if(v > violation)
+                    {
+                        violation = v;
+                        release = i;
+                    }
+                }
+                if(release < 0)
+                    return true;
+                _status[release] = FREE;
+            }
+            return false;
+        }
+
+        /**
+         * @brief getActiveSet
+         * @return the BoundStatus of each variable at the last solve
+         */
+        const Eigen::Matrix<int, N, 1>& getActiveSet() const { return _status; }
+
+        /**
+         * @brief resetActiveSet the next solve starts with all the variables free
+         */
+        void resetActiveSet(){ _status.setZero(); }
+
+        void setMaxIterations(const unsigned int max_iterations){ _max_iterations = max_iterations; }
+
+        /**
+         * @brief setTolerance
+         * @param tolerance on the multipliers of the active bounds (default 1e-9)
+         */
+        void setTolerance(const double tolerance){ _tolerance = tolerance; }
+
+        unsigned int getNumberOfIterations() const { return _iterations; }
+
+    private:
+        unsigned int _max_iterations;
+        unsigned int _iterations;
+        double _tolerance;
+
+        Eigen::Matrix<int, N, 1> _status;
+        Eigen::Matrix<int, N, 1> _free;
+        Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, N, N> _H_free;
+        Eigen::Matrix<double, Eigen::Dynamic, 1, 0, N, 1> _rhs;
+        Eigen::LLT<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, N, N> > _llt;
+        VectorN _gradient;
+    };
+
+    }
+}
+
+#endif
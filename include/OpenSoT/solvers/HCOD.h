@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi, Enrico Mingo
+ * email:  alessio.rocchi@iit.it, enrico.mingo@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _WB_SOT_SOLVERS_HCOD_H_
+#define _WB_SOT_SOLVERS_HCOD_H_
+
+#include <OpenSoT/Solver.h>
+#include <OpenSoT/constraints/Aggregated.h>
+#include <Eigen/Dense>
+#include <vector>
+
+namespace OpenSoT{
+    namespace solvers{
+
+    /**
+     * @brief The HCOD class implements a lexicographic least-squares solver for stacks with inequality constraints,
+     * based on hierarchical complete orthogonal decompositions and a primal active-set method.
+     *
+     * All the constraints (bounds, global constraints and the constraints of the tasks) are hard:
+     * they are piled in a single set of rows lG <= G*x <= uG. The levels are then solved in sequence, each one
+     * in the nullspace Z of the levels above:
+     *
+     *      min ||L'(A_k(x + Z*z) - b_k)||  s.t.  lG <= G(x + Z*z) <= uG,   with W_k = LL'
+     *
+     * so that no optimality constraint is added to the lower levels. The remaining redundancy is resolved
+     * by the minimum norm solution. The solver starts from the previous solution and warm starts the active set
+     * of each level from the one of the previous cycle: when the active set does not change, each level costs a
+     * couple of small factorizations instead of a full QP.
+     */
+    class HCOD: public Solver<Eigen::MatrixXd, Eigen::VectorXd>
+    {
+    public:
+        typedef boost::shared_ptr<HCOD> Ptr;
+
+        /**
+         * @brief The ActiveStatus enum describes a row of the constraints in an active set
+         */
+        enum ActiveStatus {
+            INACTIVE = 0,
+            ACTIVE_LOWER = -1,
+            ACTIVE_UPPER = 1,
+            /** lG = uG, the row is always active */
+            ACTIVE_EQUALITY = 2
+        };
+
+        /**
+         * @brief HCOD constructor of the problem
+         * @param stack_of_tasks a vector of tasks
+         */
+        HCOD(Stack& stack_of_tasks);
+
+        /**
+         * @brief HCOD constructor of the problem
+         * @param stack_of_tasks a vector of tasks
+         * @param bounds a vector of bounds passed to all the stacks
+         */
+        HCOD(Stack& stack_of_tasks, ConstraintPtr bounds);
+
+        /**
+         * @brief HCOD constructor of the problem
+         * @param stack_of_tasks a vector of tasks
+         * @param bounds a vector of bounds passed to all the stacks
+         * @param globalConstraints a vector of constraints passed to all the stacks
+         */
+        HCOD(Stack& stack_of_tasks, ConstraintPtr bounds, ConstraintPtr globalConstraints);
+
+        ~HCOD(){}
+
+        /**
+         * @brief solve solves the hierarchy
+         * @param solution the solution, also used as starting point if it satisfies the constraints
+         * @return false if the constraints are infeasible or the active-set iterations do not converge
+         */
+        bool solve(Eigen::VectorXd& solution);
+
+        /**
+         * @brief setTolerance
+         * @param tolerance used for feasibility, multipliers and rank decisions (default 1e-9)
+         */
+        void setTolerance(const double tolerance){ _tolerance = tolerance; }
+        double getTolerance() const { return _tolerance; }
+
+        /**
+         * @brief setMaxIterations
+         * @param max_iterations number of active-set iterations allowed for each level (default 100)
+         */
+        void setMaxIterations(const unsigned int max_iterations){ _max_iterations = max_iterations; }
+        unsigned int getMaxIterations() const { return _max_iterations; }
+
+        /**
+         * @brief getNumberOfIterations
+         * @return the number of active-set iterations done in the last solve, for all the levels
+         */
+        unsigned int getNumberOfIterations() const { return _iterations; }
+
+        /**
+         * @brief getConstraints
+         * @return the hard constraints of the hierarchy, the bounds are the last rows of G if present
+         */
+        OpenSoT::constraints::Aggregated::Ptr getConstraints() const { return _constraints; }
+
+        /**
+         * @brief getActiveSet
+         * @param i level, tasks.size() is the minimum norm level
+         * @return the ActiveStatus of each row of the constraints at the end of level i in the last solve
+         */
+        const std::vector<int>& getActiveSet(const unsigned int i) const { return _active_sets[i]; }
+
+        unsigned int getNumberOfLevels() const { return _active_sets.size(); }
+
+    private:
+        /**
+         * @brief _x_size size of the problem
+         */
+        unsigned int _x_size;
+
+        /**
+         * @brief _constraints all the constraints and bounds of the hierarchy
+         */
+        OpenSoT::constraints::Aggregated::Ptr _constraints;
+
+        /**
+         * @brief _G, _lG, _uG the rows of the constraints, bounds included
+         */
+        Eigen::MatrixXd _G;
+        Eigen::VectorXd _lG, _uG;
+
+        /**
+         * @brief _active_sets active set of each level, warm start of the next cycle
+         */
+        std::vector<std::vector<int> > _active_sets;
+
+        /**
+         * @brief _Z basis of the nullspace of the levels solved
+         */
+        Eigen::MatrixXd _Z;
+        Eigen::MatrixXd _M, _MZ, _GZ;
+        Eigen::VectorXd _r, _z, _lGz, _uGz;
+        Eigen::LLT<Eigen::MatrixXd> _WChol;
+
+        /**
+         * @brief _Q, _R factorization Q'B' = [R; 0] of the rows B of the working set of solveLSI(), updated with
+         * Givens rotations when a row enters or leaves it. The last columns of _Q, in reverse order,
+         * are a basis N of the nullspace of the working set
+         */
+        Eigen::MatrixXd _Q, _R;
+        /**
+         * @brief _MQ M*Q, rotated together with _Q
+         */
+        Eigen::MatrixXd _MQ;
+        /**
+         * @brief _T Cholesky factor T'T = N'(M'M + mu*I)N of the reduced hessian, rotated together with _Q:
+         * the damping mu only slows down the steps along the directions of the nullspace not seen by M,
+         * which the levels below or the minimum norm level resolve
+         */
+        Eigen::MatrixXd _T;
+        Eigen::VectorXd _v, _dv, _e, _d, _u, _y, _w, _step;
+        /**
+         * @brief _factorized rows of G in the columns of _R, the other rows of the working set depend on them
+         */
+        std::vector<unsigned int> _factorized;
+        /**
+         * @brief _n, _m, _rank columns and rows of M in solveLSI(), columns of _R
+         */
+        unsigned int _n, _m, _rank;
+        double _damping;
+
+        double _tolerance;
+        unsigned int _max_iterations;
+        unsigned int _iterations;
+
+        void init();
+
+        /**
+         * @brief reserve grows the factors of solveLSI() to n columns, m rows of M and p rows of G:
+         * they are allocated only when the problem grows
+         */
+        void reserve(const unsigned int n, const unsigned int m, const unsigned int p);
+
+        /**
+         * @brief initFactorization factorizes an empty working set of solveLSI()
+         */
+        void initFactorization(const Eigen::MatrixXd& M, const unsigned int n);
+
+        /**
+         * @brief addToFactorization adds the row j of G to the factorization of the working set
+         * @return false if the row depends on the ones in the factorization, which is not changed
+         */
+        bool addToFactorization(const Eigen::MatrixXd& G, const unsigned int j);
+
+        /**
+         * @brief removeFromFactorization removes the k-th row of the factorization of the working set
+         */
+        void removeFromFactorization(const unsigned int k);
+
+        /**
+         * @brief removeFromWorkingSet makes the row j of G inactive, the rows of the working set which depended
+         * on it are added to the factorization
+         */
+        void removeFromWorkingSet(const Eigen::MatrixXd& G, const unsigned int j, std::vector<int>& active);
+
+        void generateConstraints();
+
+        /**
+         * @brief findFeasiblePoint moves x in lG <= G*x <= uG, minimizing the violation of the rows
+         * violated in x
+         * @return false if the constraints are infeasible
+         */
+        bool findFeasiblePoint(Eigen::VectorXd& x);
+
+        /**
+         * @brief solveLSI solves the least squares problem with inequalities
+         *
+         *      min ||M*x - r||  s.t.  lG <= G*x <= uG
+         *
+         * with a primal active-set method. The factorizations of the working set and of the reduced hessian
+         * are computed once and updated with Givens rotations when a row enters or leaves the working set,
+         * so that an iteration costs O(n^2) instead of a factorization.
+         * @param x a feasible starting point, the solution
+         * @param active a guess of the active set, the active set at the solution
+         * @return false if the iterations do not converge
+         */
+        bool solveLSI(const Eigen::MatrixXd& M, const Eigen::VectorXd& r,
+                      const Eigen::MatrixXd& G, const Eigen::VectorXd& lG, const Eigen::VectorXd& uG,
+                      Eigen::VectorXd& x, std::vector<int>& active);
+    };
+
+    }
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi, Enrico Mingo
+ * email:  alessio.rocchi@iit.it, enrico.mingo@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _WB_SOT_SOLVERS_PRESOLVE_H_
+#define _WB_SOT_SOLVERS_PRESOLVE_H_
+
+#include <Eigen/Dense>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace OpenSoT{
+    namespace solvers{
+
+    /**
+     * @brief The Presolve class removes from lA <= A*x <= uA the rows which can not be active
+     * when x is in the box l <= x <= u.
+     *
+     * The range of each row over the box is computed exactly by interval arithmetic:
+     *
+     *      A+*l + A-*u <= A*x <= A+*u + A-*l,      A+ = max(A, 0), A- = min(A, 0)
+     *
+     * and a row whose range is inside [lA, uA] is dropped. Since the box changes every cycle, a dropped row is
+     * taken again as soon as its range reaches lA or uA; a taken row is dropped only when both its margins are
+     * larger than margin times the width of its range, so that the rows do not enter and leave at every cycle.
+     */
+    class Presolve
+    {
+    public:
+        typedef boost::shared_ptr<Presolve> Ptr;
+
+        /**
+         * @brief Presolve
+         * @param margin relative margin of the hysteresis between taking and dropping a row
+         */
+        Presolve(const double margin = 0.1);
+
+        /**
+         * @brief compute selects the rows which can be active and copies them in getA(), getlA(), getuA()
+         * @param A constraint matrix
+         * @param lA lower bounds of the constraints
+         * @param uA upper bounds of the constraints
+         * @param l lower bounds of the variables
+         * @param u upper bounds of the variables
+         * @return true if the selected rows changed
+         */
+        bool compute(const Eigen::MatrixXd& A, const Eigen::VectorXd& lA, const Eigen::VectorXd& uA,
+                     const Eigen::VectorXd& l, const Eigen::VectorXd& u);
+
+        const Eigen::MatrixXd& getA() const { return _A; }
+        const Eigen::VectorXd& getlA() const { return _lA; }
+        const Eigen::VectorXd& getuA() const { return _uA; }
+
+        /**
+         * @brief getRows
+         * @return the indices of the selected rows
+         */
+        const std::vector<unsigned int>& getRows() const { return _rows; }
+
+        /**
+         * @brief getNumberOfDroppedRows
+         * @return number of rows dropped in the last compute()
+         */
+        unsigned int getNumberOfDroppedRows() const { return _taken.size() - _rows.size(); }
+
+        double getMargin() const { return _margin; }
+
+    private:
+        double _margin;
+        std::vector<bool> _taken;
+        std::vector<unsigned int> _rows;
+
+        Eigen::MatrixXd _A;
+        Eigen::VectorXd _lA, _uA;
+        Eigen::VectorXd _min, _max;
+    };
+
+    }
+}
+
+#endif
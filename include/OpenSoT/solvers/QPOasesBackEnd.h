@@ -135,6 +135,13 @@ namespace OpenSoT{
          */
         virtual bool solve();
 
+        /**
+         * @brief remapConstraints remaps the active constraints and their dual solution on the next rows:
+         * the next solve() initializes the problem again from this working set instead of hotstarting
+         * @param row_map for each row of the next constraints, the index of the same row in the actual ones or -1
+         */
+        virtual void remapConstraints(const std::vector<int>& row_map);
+
 
         /**
          * @brief getHessianType return the hessian type f the problem
@@ -196,6 +203,12 @@ namespace OpenSoT{
          */
         void checkInfeasibility();
 
+        /**
+         * @brief getSolutionAndWorkingSet gets the primal and dual solution and the working set after a solve
+         * @return false if the solution can not be retrieved and the problem can not be initialized again
+         */
+        bool getSolutionAndWorkingSet();
+
         /**
          * @brief checkINFTY if a bound/constraint is set to a value less than -INFTY then the bound/constraint is
          * set to -INFTY, if a bound/constraint is set to a value more than INFTY then the bound/constraint is
@@ -223,6 +236,11 @@ namespace OpenSoT{
          */
         int _nWSR;
 
+        /**
+         * @brief _remapped true if the working set has been remapped on new rows by remapConstraints()
+         */
+        bool _remapped;
+
         /**
          * @brief _epsRegularisation is a factor that multiplies standard epsRegularisation of qpOases
          */
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi, Enrico Mingo
+ * email:  alessio.rocchi@iit.it, enrico.mingo@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _WB_SOT_SOLVERS_QP_RECORDER_H_
+#define _WB_SOT_SOLVERS_QP_RECORDER_H_
+
+#include <OpenSoT/solvers/BackEndFactory.h>
+#include <OpenSoT/utils/RTLogger.h>
+#include <vector>
+
+namespace OpenSoT{
+    namespace solvers{
+
+    /**
+     * @brief The QPSnapshot struct is the exact data of a QP problem solved by a BackEnd:
+     *
+     *      min = ||Hx - g||
+     *  st.     lA <= Ax <= uA
+     *           l <=  x <= u
+     *
+     * together with the solution before the solve (the warm start) and after it
+     */
+    struct QPSnapshot
+    {
+        unsigned int cycle;
+        int level;
+        solver_back_ends back_end;
+        OpenSoT::HessianType hessian_type;
+        double eps_regularisation;
+
+        Eigen::MatrixXd H;
+        Eigen::VectorXd g;
+        Eigen::MatrixXd A;
+        Eigen::VectorXd lA;
+        Eigen::VectorXd uA;
+        Eigen::VectorXd l;
+        Eigen::VectorXd u;
+
+        Eigen::VectorXd warm_start;
+        Eigen::VectorXd solution;
+        bool success;
+        /**
+         * @brief solve_time in seconds
+         */
+        double solve_time;
+    };
+
+    /**
+     * @brief The QPRecorder class records the QP problems solved by one or more BackEnds (e.g. the levels of an iHQP)
+     * to be replayed offline with QPReplay, see iHQP::setRecorder().
+     *
+     * A snapshot of a problem is written as a single sample through a RTLogger, so recording does not allocate
+     * and does not wait for the disk (when the buffer is full the snapshot is dropped, never part of it).
+     * Only one cycle every decimation cycles is recorded. Using:
+     *
+     *      recorder->registerProblem(i, *problem, back_end, hessian_type, eps_regularisation); //before the control loop
+     *      ...
+     *      recorder->startCycle();
+     *      recorder->recordWarmStart(i, *problem);
+     *      bool success = problem->solve();
+     *      recorder->record(i, *problem, success, solve_time);
+     */
+    class QPRecorder
+    {
+    public:
+        typedef boost::shared_ptr<QPRecorder> Ptr;
+
+        /**
+         * @brief QPRecorder
+         * @param file_name the file where the problems are recorded
+         * @param decimation one cycle every decimation is recorded
+         * @param buffer_size size in bytes of the buffer of the RTLogger, it has to contain many snapshots
+         */
+        QPRecorder(const std::string& file_name, const unsigned int decimation = 1,
+                   const unsigned int buffer_size = 1 << 24);
+
+        /**
+         * @brief registerProblem registers a problem with its actual size. It allocates: it is meant to be called
+         * before the control loop. Problems which grow are registered again when recorded
+         * @param i index of the problem (the level of the stack)
+         * @param problem the back-end
+         * @param back_end the type of the back-end
+         * @param hessian_type the type of the hessian
+         * @param eps_regularisation regularisation factor of the back-end
+         */
+        void registerProblem(const int i, const BackEnd& problem, const solver_back_ends back_end,
+                             const OpenSoT::HessianType hessian_type, const double eps_regularisation);
+
+        /**
+         * @brief startCycle has to be called once per control cycle, before the problems are recorded
+         */
+        void startCycle();
+
+        /**
+         * @brief isRecording
+         * @return true if the actual cycle is recorded
+         */
+        bool isRecording() const { return _recording; }
+
+        /**
+         * @brief recordWarmStart stores the solution of the problem before it is solved
+         * @param i index of the problem
+         * @param problem the back-end
+         */
+        void recordWarmStart(const int i, const BackEnd& problem);
+
+        /**
+         * @brief record writes the snapshot of a solved problem
+         * @param i index of the problem
+         * @param problem the back-end
+         * @param success value returned by problem.solve()
+         * @param solve_time time spent in problem.solve() [s]
+         * @return false if the problem is not registered or the snapshot is dropped
+         */
+        bool record(const int i, const BackEnd& problem, const bool success, const double solve_time);
+
+        /**
+         * @brief getLogger
+         * @return the logger where the snapshots are written, e.g. to flush() it
+         */
+        OpenSoT::utils::RTLogger::Ptr getLogger() const { return _logger; }
+
+        /**
+         * @brief load reads the snapshots recorded in a file
+         * @param file_name the file
+         * @param snapshots the snapshots, in the order they were recorded
+         * @return false if the file can not be read
+         */
+        static bool load(const std::string& file_name, std::vector<QPSnapshot>& snapshots);
+
+    private:
+        /**
+         * @brief HEADER_SIZE doubles precede the data of the problem in a sample:
+         * cycle, level, back_end, hessian_type, eps_regularisation, variables, constraints, bounds,
+         * success, solve_time
+         */
+        static const unsigned int HEADER_SIZE = 10;
+
+        struct Problem
+        {
+            OpenSoT::utils::RTLogger::Handle handle;
+            unsigned int size;
+            solver_back_ends back_end;
+            OpenSoT::HessianType hessian_type;
+            double eps_regularisation;
+            Eigen::VectorXd warm_start;
+        };
+
+        OpenSoT::utils::RTLogger::Ptr _logger;
+        std::vector<Problem> _problems;
+        Eigen::VectorXd _sample;
+        unsigned int _decimation;
+        unsigned int _cycle;
+        bool _recording;
+
+        static unsigned int sampleSize(const BackEnd& problem);
+        static std::string channelName(const int i);
+    };
+
+    }
+}
+
+#endif
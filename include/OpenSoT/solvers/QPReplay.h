@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi, Enrico Mingo
+ * email:  alessio.rocchi@iit.it, enrico.mingo@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _WB_SOT_SOLVERS_QP_REPLAY_H_
+#define _WB_SOT_SOLVERS_QP_REPLAY_H_
+
+#include <OpenSoT/solvers/QPRecorder.h>
+
+namespace OpenSoT{
+    namespace solvers{
+
+    /**
+     * @brief The QPReplayResult struct collects, for each replayed snapshot, the solve time and the distance
+     * of the solution from the recorded one
+     */
+    struct QPReplayResult
+    {
+        /**
+         * @brief solve_times in seconds
+         */
+        std::vector<double> solve_times;
+
+        /**
+         * @brief solution_errors infinity norm of the difference between the solution and the recorded one
+         * (NaN if the recorded solve failed)
+         */
+        std::vector<double> solution_errors;
+
+        unsigned int failures;
+
+        double getMeanSolveTime() const;
+
+        /**
+         * @brief getSolveTimePercentile
+         * @param p percentile in [0, 100]
+         * @return the solve time below which p% of the solve times are
+         */
+        double getSolveTimePercentile(const double p) const;
+
+        double getMaxSolutionError() const;
+    };
+
+    /**
+     * @brief The QPReplay class solves again offline the problems recorded by a QPRecorder, with any back-end
+     * and options. The snapshots are solved in the order they were recorded, each level of the stack by
+     * its own back-end: when all the cycles are recorded (decimation 1) the back-ends are warm started as they were
+     * in the control loop.
+     */
+    class QPReplay
+    {
+    public:
+        /**
+         * @brief QPReplay
+         * @param snapshots the recorded problems, see QPRecorder::load()
+         */
+        QPReplay(const std::vector<QPSnapshot>& snapshots);
+
+        /**
+         * @brief replay solves all the snapshots
+         * @param be_solver the back-end used to solve them
+         * @param result solve times and solution errors, one per snapshot
+         * @param options if not empty, options set to the back-ends (see BackEnd::setOptions())
+         * @return false if the back-end can not be created
+         */
+        bool replay(const solver_back_ends be_solver, QPReplayResult& result,
+                    const boost::any& options = boost::any());
+
+        const std::vector<QPSnapshot>& getSnapshots() const { return _snapshots; }
+
+    private:
+        std::vector<QPSnapshot> _snapshots;
+    };
+
+    }
+}
+
+#endif
@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi, Enrico Mingo
+ * email:  alessio.rocchi@iit.it, enrico.mingo@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _WB_SOT_SOLVERS_RECEDING_HORIZON_H_
+#define _WB_SOT_SOLVERS_RECEDING_HORIZON_H_
+
+#include <OpenSoT/Solver.h>
+#include <OpenSoT/constraints/Aggregated.h>
+#include <OpenSoT/utils/Affine.h>
+#include <Eigen/Dense>
+#include <vector>
+
+namespace OpenSoT{
+    namespace solvers{
+
+    /**
+     * @brief The RecedingHorizon class solves a stack of acceleration tasks over a preview horizon of K steps.
+     *
+     * The variable x of the stack is replicated at each step. The joint accelerations qddot = M*x_k + q
+     * integrate the state z_k = [dq_k; dqdot_k], displacement from the actual state:
+     *
+     *      z_{k+1} = [I dt*I; 0 I]*z_k + [dt^2/2*I; dt*I]*qddot_k,     z_0 = 0
+     *
+     * and the references of the tasks follow the predicted state through their feedback gains
+     * (see setFeedbackGains()), so that at step k the task A*x = b is
+     *
+     *      A*x_k = b - kp*J*dq_k - kd*J*dqdot_k,       J = A*M'
+     *
+     * The levels are weighted: the weight of level i is weight_ratio^(levels-1-i), on top of the weight of the task.
+     * The constraints and bounds of the actual cycle hold at every step. Joint position and velocity limits
+     * (see setJointLimits() and setVelocityLimits()) are instead imposed on the predicted state:
+     *
+     *      q_min <= q + (k+1)*dt*qdot + dq_{k+1} <= q_max,      |qdot + dqdot_{k+1}| <= qdot_max
+     *
+     * where q and qdot are the actual state (see setState()). Without feedback gains and state limits the steps
+     * do not depend on each other, and the horizon gives the same first step of the single instant problem.
+     *
+     * The equalities are removed by projecting x_k in their nullspace, the inequalities are handled by a
+     * primal-dual interior point method. Each Newton step is solved by a Riccati recursion on the banded
+     * structure of the horizon, so that the cost is linear in K. The previous solution, shifted by one step,
+     * warm starts the next cycle.
+     */
+    class RecedingHorizon: public Solver<Eigen::MatrixXd, Eigen::VectorXd>
+    {
+    public:
+        typedef boost::shared_ptr<RecedingHorizon> Ptr;
+
+        /**
+         * @brief RecedingHorizon constructor of the problem
+         * @param stack_of_tasks a vector of tasks
+         * @param qddot the joint accelerations as a function of the variable, M has to select them from x
+         * @param dt time step of the horizon
+         * @param horizon number of steps K
+         * @throw exception if the stack is empty or the parameters are not consistent
+         */
+        RecedingHorizon(Stack& stack_of_tasks, const AffineHelper& qddot, const double dt, const unsigned int horizon);
+
+        /**
+         * @brief RecedingHorizon constructor of the problem
+         * @param stack_of_tasks a vector of tasks
+         * @param bounds bounds on the variable, at every step
+         * @param qddot the joint accelerations as a function of the variable, M has to select them from x
+         * @param dt time step of the horizon
+         * @param horizon number of steps K
+         * @throw exception if the stack is empty or the parameters are not consistent
+         */
+        RecedingHorizon(Stack& stack_of_tasks, ConstraintPtr bounds,
+                        const AffineHelper& qddot, const double dt, const unsigned int horizon);
+
+        /**
+         * @brief RecedingHorizon constructor of the problem
+         * @param stack_of_tasks a vector of tasks
+         * @param bounds bounds on the variable, at every step
+         * @param globalConstraints constraints on the variable, at every step
+         * @param qddot the joint accelerations as a function of the variable, M has to select them from x
+         * @param dt time step of the horizon
+         * @param horizon number of steps K
+         * @throw exception if the stack is empty or the parameters are not consistent
+         */
+        RecedingHorizon(Stack& stack_of_tasks, ConstraintPtr bounds, ConstraintPtr globalConstraints,
+                        const AffineHelper& qddot, const double dt, const unsigned int horizon);
+
+        ~RecedingHorizon(){}
+
+        /**
+         * @brief solve solves the horizon
+         * @param solution the first step x_0
+         * @return false if a factorization fails or the interior point iterations do not converge
+         */
+        bool solve(Eigen::VectorXd& solution);
+
+        /**
+         * @brief setFeedbackGains sets how the reference of a level follows the predicted state,
+         * by default the gains are zero and the reference is the same at every step
+         * @param level level of the stack
+         * @param kp position gain
+         * @param kd velocity gain
+         * @return false if the level is not in the stack or the gains are negative
+         */
+        bool setFeedbackGains(const unsigned int level, const double kp, const double kd);
+
+        /**
+         * @brief setJointLimits sets the joint position limits imposed on the predicted state
+         * @param q_min lower limits, -1e20 or less for an unbounded joint
+         * @param q_max upper limits, 1e20 or more for an unbounded joint
+         * @return false if the sizes are not the number of joints or q_min > q_max
+         */
+        bool setJointLimits(const Eigen::VectorXd& q_min, const Eigen::VectorXd& q_max);
+
+        /**
+         * @brief setVelocityLimits sets the joint velocity limits imposed on the predicted state
+         * @param qdot_max the velocity of each joint is in [-qdot_max, qdot_max]
+         * @return false if the size is not the number of joints or a limit is negative
+         */
+        bool setVelocityLimits(const Eigen::VectorXd& qdot_max);
+
+        /**
+         * @brief setState sets the actual joint positions and velocities, the predicted state starts from them.
+         * It has to be called before each solve when joint or velocity limits are set (default zero)
+         * @param q joint positions
+         * @param qdot joint velocities
+         * @return false if the sizes are not the number of joints
+         */
+        bool setState(const Eigen::VectorXd& q, const Eigen::VectorXd& qdot);
+
+        /**
+         * @brief setWeightRatio
+         * @param weight_ratio ratio between the weights of two consecutive levels (default 1e2)
+         */
+        void setWeightRatio(const double weight_ratio){ _weight_ratio = weight_ratio; }
+        double getWeightRatio() const { return _weight_ratio; }
+
+        /**
+         * @brief setRegularisation
+         * @param regularisation weight of ||x_k||^2 (default 1e-6)
+         */
+        void setRegularisation(const double regularisation){ _regularisation = regularisation; }
+        double getRegularisation() const { return _regularisation; }
+
+        /**
+         * @brief setTolerance
+         * @param tolerance on the optimality conditions and on the rank of the equalities (default 1e-8)
+         */
+        void setTolerance(const double tolerance){ _tolerance = tolerance; }
+        double getTolerance() const { return _tolerance; }
+
+        /**
+         * @brief setMaxIterations
+         * @param max_iterations number of interior point iterations allowed (default 50)
+         */
+        void setMaxIterations(const unsigned int max_iterations){ _max_iterations = max_iterations; }
+        unsigned int getMaxIterations() const { return _max_iterations; }
+
+        /**
+         * @brief getNumberOfIterations
+         * @return the number of interior point iterations done in the last solve
+         */
+        unsigned int getNumberOfIterations() const { return _iterations; }
+
+        unsigned int getHorizon() const { return _horizon; }
+        double getDt() const { return _dt; }
+
+        /**
+         * @brief getTrajectory
+         * @return the variable at each step of the horizon in the last solve
+         */
+        const std::vector<Eigen::VectorXd>& getTrajectory() const { return _x; }
+
+        /**
+         * @brief getConstraints
+         * @return the constraints holding at every step, bounds included
+         */
+        OpenSoT::constraints::Aggregated::Ptr getConstraints() const { return _constraints; }
+
+    private:
+        unsigned int _x_size;
+        unsigned int _horizon;
+        double _dt;
+        AffineHelper _qddot;
+
+        OpenSoT::constraints::Aggregated::Ptr _constraints;
+
+        std::vector<double> _kp, _kd;
+
+        /**
+         * @brief _q_min, _q_max, _qdot_max limits on the predicted state, empty if not set
+         */
+        Eigen::VectorXd _q_min, _q_max, _qdot_max;
+        Eigen::VectorXd _q_actual, _qdot_actual;
+        bool _decoupled_warned;
+        double _weight_ratio;
+        double _regularisation;
+        double _tolerance;
+        unsigned int _max_iterations;
+        unsigned int _iterations;
+
+        /**
+         * @brief _G, _lG, _uG the rows of the constraints, bounds included
+         */
+        Eigen::MatrixXd _G;
+        Eigen::VectorXd _lG, _uG;
+
+        /**
+         * @brief _N basis of the nullspace of the equalities, x = _xp + _N*w
+         */
+        Eigen::MatrixXd _E, _N;
+        Eigen::VectorXd _e, _xp;
+
+        /**
+         * @brief _D, _Dz, _d the inequalities at step k, D*w_k + [0; Dz]*z_k <= d_k.
+         * The last _Dz.rows() rows are the state limits on z_{k+1} = Ad*z_k + Bw*w_k + cw:
+         * Hz*z_{k+1} <= _h - (k+1)*_hv
+         */
+        Eigen::MatrixXd _D, _Dz, _Hz;
+        Eigen::VectorXd _h, _hv;
+        std::vector<Eigen::VectorXd> _d;
+
+        /**
+         * @brief stage cost 1/2 [z;w]'[Q S;S' R][z;w] + q'z + r'w and dynamics z+ = Ad*z + Bw*w + cw
+         */
+        Eigen::MatrixXd _Q, _S, _R, _Ad, _Bx, _Bw;
+        Eigen::VectorXd _q, _r, _cx, _cw;
+        Eigen::MatrixXd _Rx, _Sx, _J, _C, _WA, _WC;
+        Eigen::VectorXd _rx, _qx;
+
+        /**
+         * @brief iterates of the interior point method at each step, _x the solution
+         */
+        std::vector<Eigen::VectorXd> _w, _z, _s, _lambda, _x;
+        std::vector<Eigen::VectorXd> _dw, _ds, _dlambda, _rp, _rc;
+        std::vector<Eigen::VectorXd> _gz, _gw;
+        Eigen::VectorXd _dz, _nu, _nu_next;
+
+        /**
+         * @brief Riccati recursion: value function 1/2 z'P z + p'z and policy w = K*z + k at each step
+         */
+        std::vector<Eigen::MatrixXd> _P, _K, _Shat;
+        std::vector<Eigen::VectorXd> _p, _k;
+        std::vector<Eigen::LLT<Eigen::MatrixXd> > _Rhat_llt;
+        Eigen::MatrixXd _Rhat, _PB, _PA;
+        Eigen::VectorXd _rhat, _sigma;
+
+        void init();
+
+        /**
+         * @brief generateProblem computes the equalities, inequalities, cost and dynamics of a step
+         * from the tasks and constraints of the actual cycle
+         */
+        void generateProblem();
+
+        /**
+         * @brief generateStateLimits computes the rows _Hz, _h, _hv of the limits on the predicted state
+         */
+        void generateStateLimits();
+
+        /**
+         * @brief initIterates shifts the previous solution by one step, or starts from the particular solution
+         */
+        void initIterates();
+
+        /**
+         * @brief simulate computes the states from the variables
+         */
+        void simulate();
+
+        /**
+         * @brief computeGradients computes the gradients of the cost w.r.t. z_k and w_k
+         * @return the infinity norm of the gradient of the Lagrangian, the dynamics eliminated by its costates
+         */
+        double computeGradients();
+
+        /**
+         * @brief factorize backward Riccati recursion for the actual barrier weights lambda/s
+         * @return false if a step is not positive definite
+         */
+        bool factorize();
+
+        /**
+         * @brief computeStep solves the Newton step for the actual complementarity residuals _rc
+         */
+        void computeStep();
+
+        /**
+         * @brief stepLength
+         * @return the largest step keeping s and lambda positive
+         */
+        double stepLength();
+    };
+
+    }
+}
+
+#endif
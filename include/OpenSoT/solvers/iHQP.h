@@ -25,7 +25,10 @@
 #include <OpenSoT/Solver.h>
 #include <OpenSoT/constraints/Aggregated.h>
 #include <OpenSoT/solvers/BackEndFactory.h>
+#include <OpenSoT/solvers/QPRecorder.h>
+#include <OpenSoT/solvers/Presolve.h>
 #include <OpenSoT/utils/Piler.h>
+#include <OpenSoT/utils/TripleBuffer.h>
 
 using namespace OpenSoT::utils;
 
@@ -87,12 +90,46 @@ namespace OpenSoT{
          */
         bool solve(Eigen::VectorXd& solution);
 
+        /**
+         * @brief The Output struct is the result of a solve, published for the threads monitoring the solver
+         */
+        struct Output
+        {
+            Output(): success(false), cycle(0){}
+
+            Eigen::VectorXd solution;
+            /**
+             * @brief objectives objective of each qp problem, NaN if it was not solved
+             */
+            Eigen::VectorXd objectives;
+            bool success;
+            /**
+             * @brief cycle number of the solve, starting from 1
+             */
+            unsigned long cycle;
+        };
+
+        /**
+         * @brief readOutput reads the result of the last solve from another thread, without locks:
+         * the thread calling solve() never waits for it. Only one thread can read the output.
+         * @param output the result of the last solve, unchanged if there was no solve since the last read
+         * @return true if there was a new solve since the last read
+         */
+        bool readOutput(Output& output){ return _output_port.read(output); }
+
         /**
          * @brief getNumberOfTasks
-         * @return lenght of the stack
+         * @return number of qp problems, less than the levels of the stack if some are weighted
+         * (see setSoftPriorities())
          */
         unsigned int getNumberOfTasks(){return _qp_stack_of_tasks.size();}
 
+        /**
+         * @brief getNumberOfLevels
+         * @return number of levels of the stack
+         */
+        unsigned int getNumberOfLevels() const {return _tasks.size();}
+
         /**
          * @brief setOptions set option to a particular task
          * @param i number of stack to set the option
@@ -131,8 +168,144 @@ namespace OpenSoT{
 
         std::string getBackEndName();
 
+        /**
+         * @brief getBackEndName
+         * @param i number of stack
+         * @return the name of the back-end of the i-th qp problem
+         */
+        std::string getBackEndName(const unsigned int i);
+
+        /**
+         * @brief setBackEnd changes the back-end of the i-th qp problem, which is initialized with the actual
+         * problem. It allocates: it is meant to be called before the control loop
+         * @param i number of stack
+         * @param be_solver the new back-end
+         * @param options if not empty, options of the new back-end
+         * @return false if i-th problem does not exists or the new back-end can not be initialized
+         */
+        bool setBackEnd(const unsigned int i, const solver_back_ends be_solver, const boost::any& options = boost::any());
+
+        /**
+         * @brief setSoftPriorities solves the levels from first to last with a single QP problem,
+         * minimizing the weighted sum of their cost functions: the weight of the level k is weight_ratio^(last-k),
+         * on top of the weights of the tasks. The levels above first and below last keep strict priorities.
+         * After this call the indices of setOptions(), setActiveStack(), setBackEnd()... are the ones
+         * of the QP problems. The QP problems are created again (options and back-ends set before are lost):
+         * it allocates and it is meant to be called before the control loop
+         * @param first first weighted level
+         * @param last last weighted level, first = last restores strict priorities
+         * @param weight_ratio ratio between the weights of two consecutive levels
+         * @return false if the levels are not in the stack or the problems can not be initialized
+         */
+        bool setSoftPriorities(const unsigned int first, const unsigned int last, const double weight_ratio = 1e2);
+
+        /**
+         * @brief setTask replaces the task at a level of the stack. Only the qp problem solving the level is
+         * built again, and the ones below if the rows of the task change: their back-ends are kept and
+         * warm started from the working set of the rows which did not change (see Constraint::getRowKeys()),
+         * the problems above are not touched. It allocates, like the other functions editing the stack.
+         * If the problems can not be initialized the stack is left as it was before the call.
+         * The solver edits its own copy of the stack: when the tasks are updated by an AutoStack,
+         * edit the stack through AutoStack::setTask(), insertTask() and removeTask()
+         * @param level level of the stack
+         * @param task the new task
+         * @return false if the level is not in the stack or the problems can not be initialized
+         */
+        bool setTask(const unsigned int level, TaskPtr task);
+
+        /**
+         * @brief insertTask inserts a task in the stack, the levels from level on are moved down.
+         * If level is inside the weighted levels (see setSoftPriorities()) the task is weighted too.
+         * The qp problems of the levels from level on are built again, as in setTask()
+         * @param level level of the new task, getNumberOfLevels() adds it at the bottom
+         * @param task the new task
+         * @return false if the level is not in the stack or the problems can not be initialized
+         */
+        bool insertTask(const unsigned int level, TaskPtr task);
+
+        /**
+         * @brief removeTask removes a task from the stack, the levels below are moved up.
+         * The qp problems of the levels from level on are built again, as in setTask()
+         * @param level level of the task
+         * @return false if the level is not in the stack, it is the only one or the problems can not be initialized
+         */
+        bool removeTask(const unsigned int level);
+
+        /**
+         * @brief addConstraint adds a constraint to the task at a level (see Task::getConstraints()),
+         * only the qp problem solving the level is built again
+         * @param level level of the stack
+         * @param constraint the new constraint
+         * @return false if the level is not in the stack or the problem can not be initialized
+         */
+        bool addConstraint(const unsigned int level, ConstraintPtr constraint);
+
+        /**
+         * @brief removeConstraint removes a constraint from the task at a level,
+         * only the qp problem solving the level is built again
+         * @param level level of the stack
+         * @param constraint the constraint
+         * @return false if the constraint is not in the task or the problem can not be initialized
+         */
+        bool removeConstraint(const unsigned int level, ConstraintPtr constraint);
+
+        /**
+         * @brief autotune selects for each qp problem the fastest among the available back-ends
+         * (see getBackEndCandidates()) and the actual one.
+         * During the next cycles calls to solve(), each problem is solved also by every candidate, which is discarded
+         * if it fails or its solution is farther than tolerance (infinity norm) from the one of the actual back-end.
+         * Then each problem keeps the candidate with the smallest mean solve time.
+         * It allocates and the cycles are slower: it is meant to be called at startup
+         * @param cycles number of cycles
+         * @param tolerance maximum distance from the solution of the actual back-end
+         */
+        void autotune(const unsigned int cycles, const double tolerance = 1e-6);
+
+        /**
+         * @brief autotune as autotune(cycles, tolerance), with a given set of candidates
+         * @param cycles number of cycles
+         * @param tolerance maximum distance from the solution of the actual back-end
+         * @param candidates back-ends with their options
+         */
+        void autotune(const unsigned int cycles, const double tolerance,
+                      const std::vector<BackEndCandidate>& candidates);
+
+        /**
+         * @brief isAutotuning
+         * @return true until the autotune cycles are done
+         */
+        bool isAutotuning() const { return _autotune_cycles > 0; }
+
+        /**
+         * @brief setRecorder records the QP problem of each stack, with the time spent solving it,
+         * to be replayed offline (see QPReplay). It allocates: it is meant to be called before the control loop
+         * @param recorder a QPRecorder, an empty pointer stops recording
+         */
+        void setRecorder(QPRecorder::Ptr recorder);
+
+        /**
+         * @brief setPresolve removes from each qp problem the rows of the constraints which can not be active
+         * within the bounds of this cycle, and takes them again when they get close (see Presolve).
+         * It works only on problems with bounds. When the number of constraints of a problem changes,
+         * its back-end is initialized again with the same options
+         * @param enable true to enable the presolve
+         * @param margin relative margin before a row is dropped, see Presolve
+         */
+        void setPresolve(const bool enable, const double margin = 0.1);
+
+        bool isPresolveEnabled() const { return _presolve_enabled; }
+
+        /**
+         * @brief getNumberOfDroppedConstraints
+         * @param i number of stack
+         * @return the number of rows dropped by the presolve from the i-th qp problem in the last solve
+         */
+        unsigned int getNumberOfDroppedConstraints(const unsigned int i) const;
+
     protected:
         virtual void _log(XBot::MatLogger::Ptr logger);
+        virtual void _registerLog(OpenSoT::utils::RTLogger::Ptr logger);
+        virtual void _log(OpenSoT::utils::RTLogger::Ptr logger);
 
         vector <OpenSoT::constraints::Aggregated> constraints_task;
         
@@ -154,6 +327,50 @@ namespace OpenSoT{
          */
         bool prepareSoT(const solver_back_ends be_solver);
 
+        /**
+         * @brief initProblem builds the constraints of the i-th problem and initializes its back-end
+         * @param i number of the QP problem
+         * @param previous if not empty, the back-end which solved the i-th problem before the stack changed,
+         * kept if it can be updated with the new problem
+         * @param previous_keys keys of the rows of the previous back-end
+         * @return false if the problem can not be initialized
+         */
+        bool initProblem(const unsigned int i, BackEnd::Ptr previous, const std::vector<std::size_t>& previous_keys);
+
+        /**
+         * @brief The StackState struct holds what an edit of the stack changes, so that the stack can be
+         * restored when the edited problems can not be initialized
+         */
+        struct StackState
+        {
+            Stack tasks;
+            vector<std::list<ConstraintPtr> > task_constraints;
+            vector<vector<unsigned int> > qp_levels;
+            vector<unsigned int> level_qp;
+            vector<double> level_weights;
+            unsigned int soft_first, soft_last;
+            double soft_ratio;
+            vector<bool> active_stacks;
+            vector<BackEnd::Ptr> qp_stack_of_tasks;
+            vector<vector<std::size_t> > row_keys;
+            vector<OpenSoT::constraints::Aggregated> constraints_task;
+            vector<solver_back_ends> be_solvers;
+            vector<Presolve> presolve;
+        };
+
+        void saveStackState(StackState& state) const;
+        void restoreStackState(const StackState& state);
+
+        /**
+         * @brief rebuildProblems builds again the problems from first to last (excluded) after the stack changed,
+         * the back-ends in _qp_stack_of_tasks are the previous ones.
+         * If a problem can not be initialized the stack is restored from state, and the problems from first on
+         * are updated again with the restored stack, since the previous back-ends may have been changed
+         * @param state the stack before the edit
+         * @return false if a problem can not be initialized
+         */
+        bool rebuildProblems(const unsigned int first, const unsigned int last, const StackState& state);
+
         /**
          * @brief computeCostFunction compute a cost function for velocity control:
          *          F = ||Jdq - v||
@@ -163,6 +380,43 @@ namespace OpenSoT{
          */
         void computeCostFunction(const TaskPtr& task, Eigen::MatrixXd& H, Eigen::VectorXd& g);
 
+        /**
+         * @brief computeCostFunction compute the cost function of the i-th QP problem, the weighted sum of the
+         * cost functions of its levels
+         * @param i number of the QP problem
+         * @param H Hessian matrix
+         * @param g reference vector
+         */
+        void computeCostFunction(const unsigned int i, Eigen::MatrixXd& H, Eigen::VectorXd& g);
+
+        /**
+         * @brief getHessianType
+         * @param i number of the QP problem
+         * @return the hessian type of the i-th QP problem
+         */
+        OpenSoT::HessianType getHessianType(const unsigned int i);
+
+        /**
+         * @brief initLevels assigns the levels to the QP problems, see setSoftPriorities()
+         */
+        void initLevels(const unsigned int first, const unsigned int last, const double weight_ratio);
+
+        /**
+         * @brief _qp_levels levels solved by each QP problem, _level_qp QP problem solving each level,
+         * _level_weights weight of each level in its QP problem
+         */
+        vector<vector<unsigned int> > _qp_levels;
+        vector<unsigned int> _level_qp;
+        vector<double> _level_weights;
+
+        /**
+         * @brief _soft_first, _soft_last, _soft_ratio the weighted levels, see setSoftPriorities()
+         */
+        unsigned int _soft_first, _soft_last;
+        double _soft_ratio;
+        Eigen::MatrixXd _H_level;
+        Eigen::VectorXd _g_level;
+
         /**
          * @brief computeOptimalityConstraint compute optimality constraint for velocity control:
          *      Jj*dqj = Jj*dqi
@@ -195,6 +449,99 @@ namespace OpenSoT{
 
         solver_back_ends _be_solver;
 
+        /**
+         * @brief _be_solvers back-end of each qp problem
+         */
+        vector<solver_back_ends> _be_solvers;
+
+        QPRecorder::Ptr _recorder;
+
+        /**
+         * @brief The AutotuneCandidate struct a back-end tried by autotune(), with its total solve time
+         */
+        struct AutotuneCandidate
+        {
+            AutotuneCandidate(const BackEndCandidate& be_candidate, BackEnd::Ptr be_problem):
+                candidate(be_candidate), problem(be_problem), solve_time(0.0), samples(0), valid(true){}
+
+            BackEndCandidate candidate;
+            BackEnd::Ptr problem;
+            double solve_time;
+            unsigned int samples;
+            bool valid;
+        };
+
+        /**
+         * @brief _autotune_candidates for each qp problem the candidates, the first one is the actual back-end
+         */
+        vector<vector<AutotuneCandidate> > _autotune_candidates;
+        unsigned int _autotune_cycles;
+        double _autotune_tolerance;
+
+        /**
+         * @brief autotuneProblem solves the i-th problem with all the candidates
+         * @param i number of stack
+         * @param success true if the actual back-end solved the problem
+         * @param solve_time time spent by the actual back-end
+         */
+        void autotuneProblem(const unsigned int i, const bool success, const double solve_time);
+
+        /**
+         * @brief selectBackEnds ends the autotune, keeping the fastest candidates
+         */
+        void selectBackEnds();
+
+        /**
+         * @brief _presolve presolve of each qp problem, used when _presolve_enabled
+         */
+        vector<Presolve> _presolve;
+        bool _presolve_enabled;
+        double _presolve_margin;
+
+        /**
+         * @brief resizeProblem initializes again the i-th problem with the actual H, g, A, lA, uA, when
+         * its number of constraints changed and its back-end can not change it in updateConstraints()
+         * (the back-ends which can, like QPOasesBackEnd, keep the working set of the remapped rows instead)
+         * @param i number of stack
+         * @param l lower bounds
+         * @param u upper bounds
+         * @return false if the problem can not be initialized
+         */
+        bool resizeProblem(const unsigned int i, const Eigen::VectorXd& l, const Eigen::VectorXd& u);
+
+        /**
+         * @brief _row_keys keys of the rows of the constraints of each qp problem at the last solve,
+         * see Constraint::getRowKeys()
+         */
+        vector<vector<std::size_t> > _row_keys;
+        vector<std::size_t> _keys;
+        vector<std::pair<std::size_t, int> > _sorted_keys;
+        vector<int> _row_map;
+
+        /**
+         * @brief remapConstraints maps the rows of the i-th problem of the last solve on the new ones
+         * (the constraints with keys _keys followed by the optimality constraints) and passes the map to its back-end
+         * @param i number of stack
+         * @param number_of_constraints number of rows of the new constraints, optimality constraints included
+         */
+        void remapConstraints(const unsigned int i, const unsigned int number_of_constraints);
+
+        /**
+         * @brief _output_port the result of each solve, for readOutput()
+         */
+        utils::TripleBuffer<Output> _output_port;
+        unsigned long _cycle;
+
+        /**
+         * @brief initOutputPort sizes the buffers of the output port, so that publishing does not allocate
+         */
+        void initOutputPort();
+
+        /**
+         * @brief solveProblems solves the qp problems of the stack
+         */
+        bool solveProblems(Eigen::VectorXd& solution);
+
 
     };
 
@@ -101,6 +101,8 @@ using namespace OpenSoT::utils;
             static const std::string concatenateTaskIds(const std::list<TaskPtr> tasks);
 
             virtual void _log(XBot::MatLogger::Ptr logger);
+            virtual void _registerLog(OpenSoT::utils::RTLogger::Ptr logger);
+            virtual void _log(OpenSoT::utils::RTLogger::Ptr logger);
 
         public:
             /**
@@ -137,6 +139,12 @@ using namespace OpenSoT::utils;
 
             void _update(const Eigen::VectorXd &x);
 
+            /**
+             * @brief applyReferences applies the references published on the ports of the aggregated tasks
+             * @return true if a new reference was applied on one of them
+             */
+            virtual bool applyReferences();
+
 
             /**
              * @brief getConstraints return a reference to the constraint list.
@@ -20,6 +20,7 @@
 
 #include <OpenSoT/Task.h>
 #include <OpenSoT/utils/Affine.h>
+#include <OpenSoT/utils/TripleBuffer.h>
 #include <XBotInterface/ModelInterface.h>
 #include <XBotInterface/Utils.h>
 
@@ -57,6 +58,18 @@ namespace OpenSoT { namespace tasks { namespace acceleration {
                           const Eigen::Vector6d& vel_ref,
                           const Eigen::Vector6d& acc_ref);
 
+        /**
+         * @brief setReferenceAsync publishes a new reference from another thread, without locks and allocations.
+         * The reference is applied by applyReferences(), called by the control thread before the update
+         * (see AutoStack::update()), as setReference(pose_ref, vel_ref, acc_ref).
+         * Only one thread can publish references on a task.
+         */
+        void setReferenceAsync(const Eigen::Affine3d& pose_ref,
+                               const Eigen::Vector6d& vel_ref = Eigen::Vector6d::Zero(),
+                               const Eigen::Vector6d& acc_ref = Eigen::Vector6d::Zero());
+
+        virtual bool applyReferences();
+
         void getReference(Eigen::Affine3d& ref);
         void getActualPose(Eigen::Affine3d& actual);
         
@@ -90,6 +103,13 @@ namespace OpenSoT { namespace tasks { namespace acceleration {
         double _orientation_gain;
 
         double _lambda2;
+
+        struct Reference
+        {
+            Eigen::Affine3d pose;
+            Eigen::Vector6d vel, acc;
+        };
+        utils::TripleBuffer<Reference> _reference_port;
         
     };
     
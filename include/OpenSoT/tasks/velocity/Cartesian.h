@@ -19,6 +19,7 @@
 #define __TASKS_VELOCITY_CARTESIAN_H__
 
  #include <OpenSoT/Task.h>
+ #include <OpenSoT/utils/TripleBuffer.h>
  #include <XBotInterface/ModelInterface.h>
  #include <kdl/frames.hpp>
  #include <Eigen/Dense>
@@ -82,6 +83,13 @@
 
                 Eigen::Affine3d _tmpMatrix, _tmpMatrix2;
 
+                struct Reference
+                {
+                    Eigen::Affine3d pose;
+                    Eigen::Vector6d twist;
+                };
+                utils::TripleBuffer<Reference> _reference_port;
+
             public:
 
                 Eigen::VectorXd positionError;
@@ -138,6 +146,19 @@
                 void setReference(const KDL::Frame& desiredPose,
                                   const KDL::Twist& desiredTwist);
 
+                /**
+                 * @brief setReferenceAsync publishes a new reference for the Cartesian task from another thread,
+                 * without locks and allocations. The reference is applied by applyReferences(), called by the control
+                 * thread before the update (see AutoStack::update()), as setReference(desiredPose, desiredTwist).
+                 * Only one thread can publish references on a task.
+                 * @param desiredPose the desired pose for the distal_link in the base_link frame of reference
+                 * @param desiredTwist the feed-forward velocity, in units/sample
+                 */
+                void setReferenceAsync(const Eigen::Affine3d& desiredPose,
+                                       const Eigen::Vector6d& desiredTwist = Eigen::Vector6d::Zero());
+
+                virtual bool applyReferences();
+
                 /**
                  * @brief getReference returns the Cartesian task reference
                  * @return the Cartesian task reference \f$R^{4x4}\f$ homogeneous transform matrix describing the desired pose
@@ -22,6 +22,8 @@
 #include <OpenSoT/tasks/velocity/Cartesian.h>
 #include <OpenSoT/tasks/velocity/CoM.h>
 #include <OpenSoT/utils/cartesian_utils.h>
+#include <OpenSoT/utils/ParallelDifferentiation.h>
+#include <map>
 
 
 
@@ -35,12 +37,14 @@ namespace OpenSoT {
              *              w = sqrt(det(J*W*J'))
              *
              * The gradient of w is then computed and projected using the gardient projection method.
-             * W is a CONSTANT weight matrix.
+             * W is a CONSTANT (symmetric) weight matrix.
              */
             class Manipulability : public Task < Eigen::MatrixXd, Eigen::VectorXd > {
             public:
                 typedef boost::shared_ptr<Manipulability> Ptr;
 
+                enum GradientType { GRADIENT_NUMERICAL, GRADIENT_ANALYTIC };
+
                 Manipulability(const Eigen::VectorXd& x, const XBot::ModelInterface& robot_model, const Cartesian::Ptr CartesianTask);
                 Manipulability(const Eigen::VectorXd& x, const XBot::ModelInterface& robot_model, const CoM::Ptr CartesianTask);
 
@@ -60,6 +64,8 @@ namespace OpenSoT {
                  */
                 void setW(const Eigen::MatrixXd& W){
                     _manipulabilityIndexGradientWorker.setW(W);
+                    for(unsigned int i = 0; i < _parallelManipulabilityIndexGradientWorkers.size(); ++i)
+                        _parallelManipulabilityIndexGradientWorkers[i]->setW(W);
                 }
 
                 /**
@@ -77,6 +83,29 @@ namespace OpenSoT {
                     }
                 }
 
+                /**
+                 * @brief setNumberOfThreads spreads the evaluations of the numerical gradient
+                 * over a pool of threads, each working on its own clone of the model
+                 * @param number_of_threads 1 to compute the gradient serially
+                 */
+                void setNumberOfThreads(const unsigned int number_of_threads);
+
+                /**
+                 * @brief setGradientType selects how the gradient of the manipulability index is computed:
+                 * GRADIENT_ANALYTIC uses AnalyticManipulabilityIndexGradient, GRADIENT_NUMERICAL uses finite
+                 * differences with ComputeManipulabilityIndexGradient (2n evaluations of the Jacobian).
+                 * The default is GRADIENT_ANALYTIC for fixed base models and GRADIENT_NUMERICAL for floating base
+                 * models, whose base entries are computed only by the numerical gradient consistently with q
+                 * @param gradient_type
+                 */
+                void setGradientType(const GradientType gradient_type)
+                {
+                    _gradient_type = gradient_type;
+                    this->_update(_x);
+                }
+
+                GradientType getGradientType() const { return _gradient_type; }
+
             protected:
 
                 Eigen::VectorXd _x;
@@ -141,6 +170,22 @@ namespace OpenSoT {
 
                     Eigen::MatrixXd& getW() {return _W;}
 
+                    /**
+                     * @brief clone creates a worker with the same task and weight, on a new clone of the model
+                     */
+                    boost::shared_ptr<ComputeManipulabilityIndexGradient> clone(const Eigen::VectorXd& q) const
+                    {
+                        boost::shared_ptr<ComputeManipulabilityIndexGradient> worker;
+                        Cartesian::Ptr cartesian = boost::dynamic_pointer_cast<Cartesian>(_CartesianTask);
+                        if(cartesian)
+                            worker.reset(new ComputeManipulabilityIndexGradient(q, _model, cartesian));
+                        else
+                            worker.reset(new ComputeManipulabilityIndexGradient(q, _model,
+                                            boost::dynamic_pointer_cast<OpenSoT::tasks::velocity::CoM>(_CartesianTask)));
+                        worker->setW(_W);
+                        return worker;
+                    }
+
                     double computeManipulabilityIndex()
                     {
                         Eigen::MatrixXd J = _CartesianTask->getA();
@@ -150,6 +195,124 @@ namespace OpenSoT {
                 };
 
                 ComputeManipulabilityIndexGradient _manipulabilityIndexGradientWorker;
+
+                /**
+                 * @brief The AnalyticManipulabilityIndexGradient class computes the gradient of the manipulability index
+                 * in closed form, from the partial derivatives of the Jacobian:
+                 * \f$\frac{\partial w}{\partial q_i} = \frac{w}{2} tr\left(A^{-1}\frac{\partial A}{\partial q_i}\right)
+                 * = w\, tr\left(\frac{\partial J}{\partial q_i} W J^T A^{-1}\right)\f$, with \f$A = JWJ^T\f$.
+                 * The columns of J are the twists of the joints (world orientation, w is invariant to the orientation of
+                 * the task frame), whose partial derivatives are cross products of twists: for joints a, d with
+                 * a ancestor of d (or a = d)
+                 * - Cartesian: \f$\frac{\partial J_d}{\partial q_a} = (\omega_a \times v_d, \omega_a \times \omega_d)\f$ and
+                 *   \f$\frac{\partial J_a}{\partial q_d} = (\omega_a \times v_d, 0)\f$, where \f$v_d\f$ is the velocity
+                 *   of the distal link induced by joint d. A relative Jacobian is handled as a serial chain from the base link
+                 *   to the distal link, where the joints between the base link and the common ancestor move in the opposite direction;
+                 * - CoM: \f$\frac{\partial J_d}{\partial q_a} = \omega_a \times J_d\f$ and
+                 *   \f$\frac{\partial J_a}{\partial q_d} = \omega_a \times J_d\f$.
+                 *
+                 * Everything comes from one forward kinematics and one pass over the chain (the kinematic tree for the CoM).
+                 * The floating base, if any, is handled as six joints preceding all the others.
+                 */
+                class AnalyticManipulabilityIndexGradient {
+                public:
+                    /**
+                     * @brief AnalyticManipulabilityIndexGradient for the manipulability of a Cartesian task
+                     * @param q the configuration
+                     * @param robot the model used for the computations (it is updated in compute())
+                     * @param distal_link distal link of the Cartesian task
+                     * @param base_link base link of the Cartesian task
+                     */
+                    AnalyticManipulabilityIndexGradient(const Eigen::VectorXd& q, XBot::ModelInterface::Ptr robot,
+                                                        const std::string& distal_link, const std::string& base_link);
+
+                    /**
+                     * @brief AnalyticManipulabilityIndexGradient for the manipulability of the CoM task
+                     * @param q the configuration
+                     * @param robot the model used for the computations (it is updated in compute())
+                     */
+                    AnalyticManipulabilityIndexGradient(const Eigen::VectorXd& q, XBot::ModelInterface::Ptr robot);
+
+                    /**
+                     * @brief compute the gradient of the manipulability index, updating the internal model in q.
+                     * The gradient is zero in singular configurations, where it is not defined
+                     * @param q the configuration
+                     * @param W the weight matrix of the manipulability index
+                     * @param jointMask gradient is zero for joints which are not active
+                     * @return the gradient
+                     */
+                    const Eigen::VectorXd& compute(const Eigen::VectorXd& q, const Eigen::MatrixXd& W,
+                                                   const std::vector<bool>& jointMask);
+
+                    /**
+                     * @brief getManipulabilityIndex
+                     * @return the manipulability index computed by the latest call to compute()
+                     */
+                    double getManipulabilityIndex() const { return _index; }
+
+                private:
+                    /**
+                     * @brief The Joint struct is a joint of the kinematic tree, described in the frame of its child link
+                     */
+                    struct Joint {
+                        std::string link_name;
+                        int dof;
+                        bool prismatic;
+                        Eigen::Vector3d axis;
+                    };
+
+                    XBot::ModelInterface::Ptr _robot;
+                    bool _com;
+                    std::string _distal_link;
+                    std::string _floating_base_link;
+
+                    std::vector<Joint> _joints;
+                    /**
+                     * @brief _parent_dof for each dof, the closest dof moving its joint (-1 if none)
+                     */
+                    std::vector<int> _parent_dof;
+                    /**
+                     * @brief _link_dof for each link, the closest dof moving it (-1 if none)
+                     */
+                    std::map<std::string, int> _link_dof;
+                    /**
+                     * @brief _chain, _chain_sign the dofs from the base link to the distal link of the Cartesian task
+                     */
+                    std::vector<int> _chain;
+                    std::vector<double> _chain_sign;
+
+                    double _index;
+                    Eigen::VectorXd _gradient;
+                    Eigen::Affine3d _T;
+                    Eigen::MatrixXd _J, _Jbase, _A, _B;
+                    Eigen::LDLT<Eigen::MatrixXd> _A_ldlt;
+                    /**
+                     * @brief _omega, _v per dof: twist of the joint in world frame (velocity of the world origin)
+                     */
+                    Eigen::Matrix3Xd _omega, _v;
+                    /**
+                     * @brief _chain_omega, _chain_v per joint of _chain: signed twist (velocity of the distal link)
+                     */
+                    Eigen::Matrix3Xd _chain_omega, _chain_v;
+
+                    void init(const Eigen::VectorXd& q);
+                    void addJoints(const std::string& link_name, const int parent_dof);
+                    void getDofs(const std::string& link_name, std::vector<int>& dofs) const;
+                    void computeTwists();
+                    bool computeIndex(const Eigen::MatrixXd& W);
+                };
+
+                AnalyticManipulabilityIndexGradient _analyticGradientWorker;
+
+                /**
+                 * @brief _parallelManipulabilityIndexGradientWorkers additional workers (each with its own model) used by
+                 * _parallelDifferentiation, together with _manipulabilityIndexGradientWorker
+                 */
+                std::vector<boost::shared_ptr<ComputeManipulabilityIndexGradient> > _parallelManipulabilityIndexGradientWorkers;
+                OpenSoT::utils::ParallelDifferentiation::Ptr _parallelDifferentiation;
+
+            private:
+                GradientType _gradient_type;
             };
         }
     }
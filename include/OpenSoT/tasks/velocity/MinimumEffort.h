@@ -22,6 +22,7 @@
  #include <OpenSoT/Task.h>
  #include <XBotInterface/ModelInterface.h>
  #include <OpenSoT/utils/cartesian_utils.h>
+ #include <OpenSoT/utils/ParallelDifferentiation.h>
 
 
 /**
@@ -111,7 +112,88 @@
 
                 ComputeGTauGradient _gTauGradientWorker;
 
+                /**
+                 * @brief The AnalyticGTauGradient class computes the gradient of the effort
+                 * \f$\tau_g^T W \tau_g\f$ analytically as \f$2\frac{\partial \tau_g}{\partial q}^T W \tau_g\f$.
+                 * Both \f$\tau_g\f$ and \f$\frac{\partial \tau_g}{\partial q}\f$ are computed with one forward kinematics
+                 * and one recursive pass over the kinematic tree, accumulating mass and first moment of mass of
+                 * the subtree of each joint: for joints a, d with a ancestor of d (or a = d)
+                 * \f$\frac{\partial \tau_{g,d}}{\partial q_a} = -g \cdot (\omega_a \times w_d)\f$, where
+                 * \f$w_d = M_d v_d + \omega_d \times S_d\f$, \f$(\omega_d, v_d)\f$ is the twist of joint d in world frame
+                 * (velocity of the world origin) and \f$M_d\f$, \f$S_d\f$ are mass and first moment of mass of its subtree.
+                 * The floating base, if any, is handled as six joints preceding all the others.
+                 */
+                class AnalyticGTauGradient {
+                public:
+                    AnalyticGTauGradient(const Eigen::VectorXd& q, XBot::ModelInterface::Ptr robot);
+
+                    /**
+                     * @brief compute the gradient of the effort, updating the internal model in q
+                     * @param q the configuration
+                     * @param W the weight matrix of the effort
+                     * @param jointMask gradient is zero for joints which are not active
+                     * @return the gradient
+                     */
+                    const Eigen::VectorXd& compute(const Eigen::VectorXd& q, const Eigen::MatrixXd& W,
+                                                   const std::vector<bool>& jointMask);
+
+                    /**
+                     * @brief getGravityTorques
+                     * @return the gravity torques computed by the latest call to compute()
+                     */
+                    const Eigen::VectorXd& getGravityTorques() const { return _tau; }
+
+                private:
+                    /**
+                     * @brief The Body struct is a link of the kinematic tree, with the joint moving it
+                     */
+                    struct Body {
+                        std::string link_name;
+                        int parent;
+                        int dof;
+                        bool prismatic;
+                        double mass;
+                        Eigen::Vector3d com;
+                        Eigen::Vector3d axis;
+                    };
+
+                    XBot::ModelInterface::Ptr _robot;
+                    /**
+                     * @brief _bodies links in topological order (parents before children)
+                     */
+                    std::vector<Body> _bodies;
+                    std::string _floating_base_link;
+
+                    Eigen::VectorXd _tau, _Wtau, _gradient;
+                    Eigen::Vector3d _g;
+                    Eigen::Affine3d _T;
+                    Eigen::MatrixXd _J;
+                    /**
+                     * @brief _M, _S, _omega, _v, _w, _u per body: subtree mass, subtree first moment of mass,
+                     * joint twist, \f$w\f$ and \f$w \times g\f$ (one column per body)
+                     */
+                    Eigen::VectorXd _M;
+                    Eigen::Matrix3Xd _S, _omega, _v, _w, _u;
+                    /**
+                     * @brief _base_omega, _base_u the same as above for the floating base joints
+                     */
+                    Eigen::Matrix<double, 3, 6> _base_omega, _base_u;
+
+                    void addBody(const std::string& link_name, const int parent);
+                    void accumulate(const int a, const int d, const double h);
+                };
+
+                AnalyticGTauGradient _analyticGradientWorker;
+
+                /**
+                 * @brief _parallelGTauGradientWorkers additional workers (each with its own model) used by
+                 * _parallelDifferentiation, together with _gTauGradientWorker
+                 */
+                std::vector<boost::shared_ptr<ComputeGTauGradient> > _parallelGTauGradientWorkers;
+                OpenSoT::utils::ParallelDifferentiation::Ptr _parallelDifferentiation;
+
             public:
+                enum GradientType { GRADIENT_NUMERICAL, GRADIENT_ANALYTIC };
 
                 MinimumEffort(const Eigen::VectorXd& x, const XBot::ModelInterface& robot_model);
 
@@ -137,6 +219,8 @@
                  */
                 void setW(const Eigen::MatrixXd& W){
                     _gTauGradientWorker.setW(W);
+                    for(unsigned int i = 0; i < _parallelGTauGradientWorkers.size(); ++i)
+                        _parallelGTauGradientWorkers[i]->setW(W);
                 }
 
                 /**
@@ -153,6 +237,32 @@
                         this->_update(_x);
                     }
                 }
+
+                /**
+                 * @brief setGradientType selects how the gradient of the effort is computed:
+                 * GRADIENT_ANALYTIC uses AnalyticGTauGradient, GRADIENT_NUMERICAL uses finite differences
+                 * with ComputeGTauGradient (2n evaluations of the gravity torques). The default is GRADIENT_ANALYTIC
+                 * for fixed base models and GRADIENT_NUMERICAL for floating base models, since the floating base
+                 * is parametrized differently by the two methods
+                 * @param gradient_type
+                 */
+                void setGradientType(const GradientType gradient_type)
+                {
+                    _gradient_type = gradient_type;
+                    this->_update(_x);
+                }
+
+                GradientType getGradientType() const { return _gradient_type; }
+
+                /**
+                 * @brief setNumberOfThreads spreads the evaluations of the numerical gradient (GRADIENT_NUMERICAL)
+                 * over a pool of threads, each working on its own clone of the model
+                 * @param number_of_threads 1 to compute the gradient serially
+                 */
+                void setNumberOfThreads(const unsigned int number_of_threads);
+
+            private:
+                GradientType _gradient_type;
             };
         }
     }
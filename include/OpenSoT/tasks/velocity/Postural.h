@@ -19,6 +19,7 @@
 #define __TASKS_VELOCITY_POSTURAL_H__
 
  #include <OpenSoT/Task.h>
+ #include <OpenSoT/utils/TripleBuffer.h>
 
  #include <kdl/frames.hpp>
 #include <Eigen/Dense>
@@ -43,6 +44,13 @@
                 Eigen::VectorXd _xdot_desired;
                 Eigen::VectorXd _x;
 
+                struct Reference
+                {
+                    Eigen::VectorXd x;
+                    Eigen::VectorXd xdot;
+                };
+                utils::TripleBuffer<Reference> _reference_port;
+
                 void update_b();
 
             public:
@@ -75,6 +83,20 @@
                 void setReference(const Eigen::VectorXd& x_desired,
                                   const Eigen::VectorXd& xdot_desired);
 
+                /**
+                 * @brief setReferenceAsync publishes a new reference for the Postural task from another thread,
+                 * without locks and allocations. The reference is applied by applyReferences(), called by the control
+                 * thread before the update (see AutoStack::update()), as setReference(x_desired, xdot_desired).
+                 * Only one thread can publish references on a task.
+                 * @param x_desired the \f$R^{n_x}\f$ vector of desired joint positions
+                 * @param xdot_desired the \f$R^{n_x}\f$ vector of feed-forward joint velocities, in rad/sample
+                 * @return false if the sizes are wrong
+                 */
+                bool setReferenceAsync(const Eigen::VectorXd& x_desired,
+                                       const Eigen::VectorXd& xdot_desired);
+
+                virtual bool applyReferences();
+
                 /**
                  * @brief getReference returns the Postural task reference
                  * @return the \f$R^{n_x}\f$ Postural task reference
@@ -56,6 +56,11 @@ namespace OpenSoT {
         std::vector<OpenSoT::solvers::iHQP::TaskPtr> flattenTask(
                 OpenSoT::solvers::iHQP::TaskPtr task);
 
+        /**
+         * @brief _slow_updates number of tasks and constraints with an update divider, used as their phase
+         */
+        unsigned int _slow_updates;
+
         protected:
             AutoStack(const double x_size);
 
@@ -70,10 +75,87 @@ namespace OpenSoT {
             /*AutoStack(OpenSoT::solvers::iHQP::Stack stack,
                       OpenSoT::constraints::Aggregated::ConstraintPtr bound);*/
 
+            /**
+             * @brief update applies the references published on the reference ports of the tasks
+             * (see Task::applyReferences()), then updates the bounds and the tasks of the stack.
+             * It is an update cycle (see utils::UpdateCycle): the tasks and constraints shared by several
+             * levels, aggregates, subtasks or constraints are updated once
+             * @param state the state
+             */
             void update(const Eigen::VectorXd & state);
 
+            /**
+             * @brief setUpdateDivider updates a task of the stack (also inside an Aggregated or a SubTask)
+             * once every divider calls of update(), for expensive tasks which do not need the rate of the control loop.
+             * In the other cycles A and b are held, or b is extrapolated from the state
+             * (see Task::setUpdateDivider()). The slow tasks and constraints of the stack are updated
+             * in different cycles, so that the cost of a cycle stays bounded.
+             * @param task a task
+             * @param divider number of cycles between two updates, 1 to update it at every cycle
+             * @param extrapolate true to extrapolate b between the updates
+             * @return false if divider is 0
+             */
+            bool setUpdateDivider(OpenSoT::solvers::iHQP::TaskPtr task, const unsigned int divider,
+                                  const bool extrapolate = false);
+
+            /**
+             * @brief setUpdateDivider updates a constraint or a bound of the stack once every divider calls of update(),
+             * in the other cycles it is held (see Constraint::setUpdateDivider())
+             * @param constraint a constraint
+             * @param divider number of cycles between two updates, 1 to update it at every cycle
+             * @return false if divider is 0
+             */
+            bool setUpdateDivider(OpenSoT::constraints::Aggregated::ConstraintPtr constraint,
+                                  const unsigned int divider);
+
+            /**
+             * @brief setTask replaces the task at a level of the stack and of a solver built on it,
+             * e.g. iHQP(getStack(), getBounds()), see iHQP::setTask(). The new task is updated by update()
+             * together with its constraints and it is solved under the bounds of the stack
+             * @param solver the solver of the stack
+             * @param level level of the stack
+             * @param task the new task
+             * @return false if the solver is not solving the stack, the level is not in the stack
+             * or the solver can not be initialized
+             */
+            bool setTask(OpenSoT::solvers::iHQP& solver, const unsigned int level,
+                         OpenSoT::solvers::iHQP::TaskPtr task);
+
+            /**
+             * @brief insertTask inserts a task in the stack and in a solver built on it, see iHQP::insertTask()
+             * @param solver the solver of the stack
+             * @param level level of the new task, the size of the stack adds it at the bottom
+             * @param task the new task
+             * @return false if the solver is not solving the stack, the level is not in the stack
+             * or the solver can not be initialized
+             */
+            bool insertTask(OpenSoT::solvers::iHQP& solver, const unsigned int level,
+                            OpenSoT::solvers::iHQP::TaskPtr task);
+
+            /**
+             * @brief removeTask removes a task from the stack and from a solver built on it, see iHQP::removeTask()
+             * @param solver the solver of the stack
+             * @param level level of the task
+             * @return false if the solver is not solving the stack, the level is not in the stack, it is the only one
+             * or the solver can not be initialized
+             */
+            bool removeTask(OpenSoT::solvers::iHQP& solver, const unsigned int level);
+
             void log(XBot::MatLogger::Ptr logger);
 
+            /**
+             * @brief registerLog registers the tasks and the bounds of the stack on a real-time logger.
+             * It allocates: it is meant to be called before the control loop
+             * @param logger a pointer to a RTLogger
+             */
+            void registerLog(OpenSoT::utils::RTLogger::Ptr logger);
+
+            /**
+             * @brief log logs the tasks and the bounds of the stack on a real-time logger
+             * @param logger a pointer to a RTLogger
+             */
+            void log(OpenSoT::utils::RTLogger::Ptr logger);
+
             OpenSoT::solvers::iHQP::Stack& getStack();
 
             std::list<OpenSoT::constraints::Aggregated::ConstraintPtr>& getBoundsList();
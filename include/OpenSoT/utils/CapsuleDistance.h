@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi
+ * email:  alessio.rocchi@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __CAPSULE_DISTANCE_H__
+#define __CAPSULE_DISTANCE_H__
+
+#include <Eigen/Dense>
+
+namespace OpenSoT
+{
+namespace utils
+{
+
+/**
+ * @brief The CapsuleDistanceBatch class computes in closed form the distance and the closest points
+ *        between a batch of capsule pairs. A capsule is described by the two endpoints of its axis
+ *        and by its radius: spheres are handled as capsules with coincident endpoints, so that the same
+ *        kernel covers the capsule-capsule, sphere-capsule and sphere-sphere cases.
+ *
+ *        Data is stored as structure of arrays (one contiguous array per coordinate),
+ *        so that the segment-segment kernel is evaluated on all pairs at once by Eigen array
+ *        expressions, which get vectorized.
+ *
+ *        Usage:
+ *              batch.resize(max_number_of_pairs);
+ *              batch.setPair(0, ...); ... batch.setPair(n-1, ...);
+ *              batch.compute(n);
+ *              batch.getDistance(i); batch.getClosestPoints(i, pA, pB);
+ */
+class CapsuleDistanceBatch
+{
+public:
+    typedef Eigen::Matrix<double, Eigen::Dynamic, 3> Points;
+
+    CapsuleDistanceBatch(const unsigned int number_of_pairs = 0);
+
+    /**
+     * @brief resize preallocates the memory for number_of_pairs pairs
+     * @param number_of_pairs maximum number of pairs in the batch
+     */
+    void resize(const unsigned int number_of_pairs);
+
+    /**
+     * @brief size
+     * @return the maximum number of pairs in the batch
+     */
+    unsigned int size() const;
+
+    /**
+     * @brief setPair sets the i-th pair of the batch. All the points have to be expressed in the same frame.
+     * @param i index of the pair
+     * @param A_ep1 first endpoint of the axis of capsule A
+     * @param A_ep2 second endpoint of the axis of capsule A (equal to A_ep1 for a sphere)
+     * @param A_radius radius of capsule A
+     * @param B_ep1 first endpoint of the axis of capsule B
+     * @param B_ep2 second endpoint of the axis of capsule B (equal to B_ep1 for a sphere)
+     * @param B_radius radius of capsule B
+     */
+    void setPair(const unsigned int i,
+                 const Eigen::Vector3d& A_ep1, const Eigen::Vector3d& A_ep2, const double A_radius,
+                 const Eigen::Vector3d& B_ep1, const Eigen::Vector3d& B_ep2, const double B_radius);
+
+    /**
+     * @brief compute computes distances and closest points for the first number_of_pairs pairs
+     * @param number_of_pairs number of pairs to compute, has to be lower or equal than size()
+     */
+    void compute(const unsigned int number_of_pairs);
+
+    /**
+     * @brief getDistance
+     * @param i index of the pair
+     * @return the distance between the surfaces of the two capsules (negative if they are penetrating)
+     */
+    double getDistance(const unsigned int i) const;
+
+    /**
+     * @brief getClosestPoints returns the closest points on the surfaces of the two capsules
+     * @param i index of the pair
+     * @param pA the closest point on capsule A
+     * @param pB the closest point on capsule B
+     */
+    void getClosestPoints(const unsigned int i, Eigen::Vector3d& pA, Eigen::Vector3d& pB) const;
+
+private:
+    /**
+     * @brief _A_p, _A_d origin and direction of the axis of capsule A: A(s) = _A_p + s*_A_d, s in [0,1]
+     */
+    Points _A_p, _A_d;
+    /**
+     * @brief _B_p, _B_d origin and direction of the axis of capsule B: B(t) = _B_p + t*_B_d, t in [0,1]
+     */
+    Points _B_p, _B_d;
+    Eigen::ArrayXd _A_radius, _B_radius;
+
+    /**
+     * @brief _cA, _cB closest points on the surfaces
+     */
+    Points _cA, _cB;
+    Eigen::ArrayXd _distance;
+
+    /**
+     * temporaries of the kernel
+     */
+    Eigen::ArrayXd _a, _b, _c, _e, _f, _denom, _s, _t, _axis_distance;
+    Eigen::ArrayXd _a_safe, _e_safe, _denom_safe, _axis_distance_safe, _direction;
+};
+
+}
+}
+
+#endif
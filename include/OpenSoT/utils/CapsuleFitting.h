@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi
+ * email:  alessio.rocchi@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __CAPSULE_FITTING_H__
+#define __CAPSULE_FITTING_H__
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <vector>
+
+namespace OpenSoT
+{
+namespace utils
+{
+
+/**
+ * @brief The CapsuleFitting class computes bounding capsules of point sets (typically the vertices of
+ *        collision meshes), to be used in place of the meshes for fast distance computations.
+ *        It is meant to be used offline, e.g. to generate the _capsules.urdf loaded by ComputeLinksDistance
+ */
+class CapsuleFitting
+{
+public:
+    typedef std::vector<Eigen::Vector3d> Points;
+
+    /**
+     * @brief The Capsule struct is a capsule described by the endpoints of its axis and its radius
+     */
+    struct Capsule
+    {
+        Eigen::Vector3d ep1, ep2;
+        double radius;
+
+        /**
+         * @brief getLength
+         * @return the length of the axis of the capsule
+         */
+        double getLength() const;
+
+        /**
+         * @brief getVolume
+         * @return the volume of the capsule
+         */
+        double getVolume() const;
+
+        /**
+         * @brief getCenterFrame
+         * @return a frame in the center of the capsule, with the z axis along the capsule axis
+         *         (this is the frame of a cylinder/capsule in URDF)
+         */
+        Eigen::Affine3d getCenterFrame() const;
+
+        /**
+         * @brief getDistance
+         * @param p a point
+         * @return the signed distance between p and the surface of the capsule (negative inside)
+         */
+        double getDistance(const Eigen::Vector3d& p) const;
+    };
+
+    /**
+     * @brief fit computes a bounding capsule of a point set. The axis of the capsule is chosen among the
+     *        principal axes of the points as the one which gives the capsule with minimum volume. For the chosen axis,
+     *        the capsule has the minimum radius (minimum enclosing circle of the points projected on the plane
+     *        orthogonal to the axis) and then the minimum length such that all the points are inside
+     * @param points the points to enclose, at least one
+     * @return the capsule
+     */
+    static Capsule fit(const Points& points);
+
+    /**
+     * @brief getApproximationError computes how much a bounding capsule overestimates the points,
+     *        as the maximum distance between the surface of the capsule (sampled) and the closest point.
+     *        When points are the vertices of a mesh, this is an upper bound of the distance between
+     *        the surface of the capsule and the mesh
+     * @param capsule the capsule
+     * @param points the points
+     * @param samples number of samples along the circumference of the capsule
+     * @return the approximation error
+     */
+    static double getApproximationError(const Capsule& capsule, const Points& points,
+                                        const unsigned int samples = 16);
+
+private:
+    /**
+     * @brief minimumEnclosingCircle computes the minimum circle enclosing a set of 2D points (Welzl algorithm)
+     * @param points the points
+     * @param center the center of the circle
+     * @return the radius of the circle
+     */
+    static double minimumEnclosingCircle(std::vector<Eigen::Vector2d> points, Eigen::Vector2d& center);
+
+    /**
+     * @brief fit computes the bounding capsule with a given axis direction
+     */
+    static Capsule fit(const Points& points, const Eigen::Vector3d& axis);
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi
+ * email:  alessio.rocchi@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __COLLISION_GEOMETRY_CACHE_H__
+#define __COLLISION_GEOMETRY_CACHE_H__
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace OpenSoT
+{
+namespace utils
+{
+
+/**
+ * @brief The CollisionGeometryCache class is a plain description of the collision geometry of a robot,
+ *        as parsed from its URDF/SRDF by ComputeLinksDistance: the shape of each link, with meshes already
+ *        loaded and scaled, its pose in link frame and the list of link pairs enabled for checking.
+ *
+ *        It can be saved to a binary file and loaded back, so that parsing of the robot model,
+ *        loading of meshes and generation of the allowed collision matrix are done only once.
+ *        Files are tagged with a key (see computeKey()), usually computed from the URDF/SRDF content:
+ *        load() fails if the key of the file is different, i.e. if the robot model changed.
+ */
+class CollisionGeometryCache
+{
+public:
+    enum ShapeType { SPHERE = 0, BOX = 1, CAPSULE = 2, MESH = 3 };
+
+    /**
+     * @brief The Shape struct describes the collision shape of a link
+     */
+    struct Shape
+    {
+        std::string link_name;
+        ShapeType type;
+        /**
+         * @brief size (radius, 0, 0) for spheres, the dimensions for boxes, (radius, length, 0) for capsules
+         */
+        Eigen::Vector3d size;
+        /**
+         * @brief position, orientation pose of the shape frame in link frame.
+         *        The orientation is not aligned, so that Shape can be stored in a std::vector
+         */
+        Eigen::Vector3d position;
+        Eigen::Quaternion<double, Eigen::DontAlign> orientation;
+        /**
+         * @brief vertices, triangles the mesh, as xyz triplets of scaled vertices
+         *        and triplets of vertex indices (empty for primitive shapes)
+         */
+        std::vector<double> vertices;
+        std::vector<int> triangles;
+    };
+
+    typedef std::pair<std::string, std::string> LinksPair;
+
+    std::vector<Shape> shapes;
+    std::vector<LinksPair> pairs;
+
+    /**
+     * @brief computeKey hashes (64 bit FNV-1a) a string, typically the content of URDF and SRDF
+     * @param data the string to hash
+     * @return the key
+     */
+    static uint64_t computeKey(const std::string& data);
+
+    /**
+     * @brief computeKey continues the hash of a key with more data, e.g. the content of the mesh files
+     * @param data the data to hash
+     * @param size the size of data in bytes
+     * @param key the key computed so far
+     * @return the key
+     */
+    static uint64_t computeKey(const char* data, const std::size_t size, const uint64_t key);
+
+    /**
+     * @brief save writes the cache to a binary file. The file is written to a unique temporary file which is then
+     *        renamed, so that processes saving or loading the same cache concurrently never see a partial file
+     * @param file_name path of the file
+     * @param key the key of the cache
+     * @return true on success
+     */
+    bool save(const std::string& file_name, const uint64_t key) const;
+
+    /**
+     * @brief load reads (memory-mapping it) a file previously written with save()
+     * @param file_name path of the file
+     * @param key the expected key
+     * @return false if the file does not exist, is corrupted or has a different key.
+     *         In that case the cache is left empty
+     */
+    bool load(const std::string& file_name, const uint64_t key);
+
+    void clear();
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi, Enrico Mingo
+ * email:  alessio.rocchi@iit.it, enrico.mingo@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __PARALLEL_DIFFERENTIATION_H__
+#define __PARALLEL_DIFFERENTIATION_H__
+
+#include <OpenSoT/utils/cartesian_utils.h>
+#include <boost/shared_ptr.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OpenSoT
+{
+namespace utils
+{
+
+/**
+ * @brief The ParallelDifferentiation class computes numerical gradients of a CostFunction (or Hessians, i.e.
+ * jacobians of a GradientVector) spreading the perturbed evaluations of the columns over a pool of threads.
+ *
+ * Each thread evaluates its own instance of the function, so that functions holding a state (e.g. a model of the robot)
+ * need no synchronization: the pool is built from one function per thread, usually each owning its own clone of the model.
+ * The thread calling computeGradient()/computeHessian() works with the first function, the others are evaluated by
+ * number_of_functions - 1 worker threads started on construction.
+ * Functions are not owned by the pool and must outlive it.
+ */
+class ParallelDifferentiation
+{
+public:
+    typedef boost::shared_ptr<ParallelDifferentiation> Ptr;
+
+    enum Scheme
+    {
+        /**
+         * @brief CENTRAL_DIFFERENCES (f(x+h) - f(x-h))/2h, truncation error O(h^2), 2 evaluations per column
+         */
+        CENTRAL_DIFFERENCES,
+        /**
+         * @brief FORWARD_DIFFERENCES (f(x+h) - f(x))/h, truncation error O(h), 1 evaluation per column (plus f(x))
+         */
+        FORWARD_DIFFERENCES,
+        /**
+         * @brief COMPLEX_STEP Im(f(x+ih))/h, truncation error O(h^2) and no cancellation error, so that h can be tiny.
+         * Only for gradients of functions implementing ComplexCostFunction
+         */
+        COMPLEX_STEP
+    };
+
+    /**
+     * @brief ParallelDifferentiation creates a pool for gradients
+     * @param functions one function per thread, at least one
+     */
+    ParallelDifferentiation(const std::vector<CostFunction*>& functions);
+
+    /**
+     * @brief ParallelDifferentiation creates a pool for Hessians
+     * @param functions one function per thread, at least one
+     */
+    ParallelDifferentiation(const std::vector<GradientVector*>& functions);
+
+    ~ParallelDifferentiation();
+
+    /**
+     * @brief computeGradient computes the gradient of the cost functions of the pool
+     * @param x point where the gradient is computed
+     * @param jointMask the gradient is computed only for true entries and is zero elsewhere (empty for all)
+     * @param scheme the differentiation scheme
+     * @param step step of gradient, 0 for the default step of the scheme (see getDefaultStep())
+     * @return the gradient (valid until the next call)
+     */
+    const Eigen::VectorXd& computeGradient(const Eigen::VectorXd& x,
+                                           const std::vector<bool>& jointMask = std::vector<bool>(),
+                                           const Scheme scheme = CENTRAL_DIFFERENCES,
+                                           const double step = 0.0);
+
+    /**
+     * @brief computeHessian computes the jacobian of the gradient vectors of the pool
+     * @param x point where the Hessian is computed
+     * @param jointMask columns are computed only for true entries and are zero elsewhere (empty for all)
+     * @param scheme the differentiation scheme, COMPLEX_STEP is not supported
+     * @param step step of Hessian, 0 for the default step of the scheme (see getDefaultStep())
+     * @return the Hessian (valid until the next call)
+     */
+    const Eigen::MatrixXd& computeHessian(const Eigen::VectorXd& x,
+                                          const std::vector<bool>& jointMask = std::vector<bool>(),
+                                          const Scheme scheme = CENTRAL_DIFFERENCES,
+                                          const double step = 0.0);
+
+    /**
+     * @brief getDefaultStep
+     * @param scheme the differentiation scheme
+     * @return 1E-3 for finite differences, 1E-20 for the complex step, whose error does not grow for tiny steps
+     */
+    static double getDefaultStep(const Scheme scheme);
+
+    unsigned int getNumberOfThreads() const;
+
+private:
+    std::vector<CostFunction*> _cost_functions;
+    std::vector<ComplexCostFunction*> _complex_cost_functions;
+    std::vector<GradientVector*> _gradient_vectors;
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _start;
+    std::condition_variable _done;
+    unsigned long _generation;
+    unsigned int _pending;
+    bool _quit;
+
+    /**
+     * @brief current job: the active columns are taken by the threads in order, through _next_column
+     */
+    std::vector<int> _columns;
+    unsigned int _next_column;
+    const Eigen::VectorXd* _x;
+    Scheme _scheme;
+    double _step;
+    double _f0;
+    Eigen::VectorXd _g0;
+
+    Eigen::VectorXd _gradient;
+    Eigen::MatrixXd _hessian;
+
+    /**
+     * @brief per thread storage of the perturbed points
+     */
+    std::vector<Eigen::VectorXd> _x_perturbed;
+    std::vector<Eigen::VectorXcd> _x_complex;
+
+    void startThreads(const unsigned int number_of_threads);
+    void threadLoop(const unsigned int thread);
+    void setColumns(const unsigned int size, const std::vector<bool>& jointMask);
+    /**
+     * @brief run evaluates all the columns of the current job, the calling thread working as thread 0
+     */
+    void run();
+    void work(const unsigned int thread);
+    void evaluateColumn(const unsigned int thread, const int column);
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi, Enrico Mingo
+ * email:  alessio.rocchi@iit.it, enrico.mingo@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __RT_LOGGER_H__
+#define __RT_LOGGER_H__
+
+#include <Eigen/Dense>
+#include <boost/shared_ptr.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OpenSoT
+{
+namespace utils
+{
+
+/**
+ * @brief The RTLogger class is a logger which can be used inside the control loop.
+ *
+ * Channels are registered once (this allocates) and are then identified by integer handles: logging a sample
+ * is a copy of the data in a lock-free single producer single consumer ring buffer, without allocations, locks or
+ * string manipulation. A background thread periodically drains the buffer into a compact binary file,
+ * which can be read with load() (or converted to a .mat file with the rt_log_to_mat tool).
+ *
+ * registerChannel() and add() have to be called by the same thread (the producer). When the buffer is full
+ * samples are dropped (and counted, see getDroppedSamples()): the producer never waits for the disk.
+ * Samples larger than their channel are dropped as well: channels are sized at registration (constraints whose
+ * number of rows changes declare it with Constraint::getMaxAineqRows()) and are never registered again by log().
+ */
+class RTLogger
+{
+public:
+    typedef boost::shared_ptr<RTLogger> Ptr;
+
+    /**
+     * @brief Handle identifies a channel, negative handles are not valid (samples on them are ignored)
+     */
+    typedef int Handle;
+
+    /**
+     * @brief RTLogger opens the log file and starts the thread writing it
+     * @param file_name the log file
+     * @param buffer_size size in bytes of the ring buffer (rounded up to a power of two)
+     * @param period_ms period of the thread writing the file
+     */
+    RTLogger(const std::string& file_name, const unsigned int buffer_size = 1 << 22,
+             const unsigned int period_ms = 10);
+
+    /**
+     * @brief ~RTLogger writes the samples still in the buffer and closes the file
+     */
+    ~RTLogger();
+
+    /**
+     * @brief registerChannel registers a channel. Registering again an existing channel returns its handle,
+     * eventually enlarging it. It allocates: it is meant to be called before the control loop
+     * @param name name of the channel
+     * @param rows, cols maximum size of the samples
+     * @return the handle of the channel, -1 if the logger is not valid
+     */
+    Handle registerChannel(const std::string& name, const unsigned int rows, const unsigned int cols = 1);
+
+    /**
+     * @brief getHandle
+     * @param name name of the channel
+     * @return the handle of a registered channel, -1 if not registered
+     */
+    Handle getHandle(const std::string& name) const;
+
+    /**
+     * @brief add logs a sample on a channel. Samples can be smaller than the size of the channel
+     * @param handle the channel
+     * @param data the sample, stored column major
+     * @return false if the sample is dropped (invalid handle, sample larger than the channel, buffer full)
+     */
+    bool add(const Handle handle, const Eigen::Ref<const Eigen::MatrixXd>& data);
+
+    bool add(const Handle handle, const double data);
+
+    /**
+     * @brief flush waits for the samples logged so far to be written in the file. It is not real-time
+     */
+    void flush();
+
+    /**
+     * @brief getDroppedSamples
+     * @return the number of samples which were not logged since the buffer was full
+     * or they were larger than their channel
+     */
+    unsigned int getDroppedSamples() const;
+
+    /**
+     * @brief isValid
+     * @return false if the file can not be opened
+     */
+    bool isValid() const { return _file != NULL; }
+
+    /**
+     * @brief load reads a log file
+     * @param file_name the log file
+     * @param data for each channel the samples, in order
+     * @return false if the file can not be read or it is not a log of RTLogger
+     */
+    static bool load(const std::string& file_name, std::map<std::string, std::vector<Eigen::MatrixXd> >& data);
+
+private:
+    enum RecordType { CHANNEL = 0, SAMPLE = 1 };
+
+    /**
+     * @brief The RecordHeader struct precedes every record in the buffer and in the file.
+     * A CHANNEL record is followed by the name of the channel, a SAMPLE record by rows*cols doubles
+     */
+    struct RecordHeader
+    {
+        uint32_t type;
+        uint32_t handle;
+        uint32_t rows;
+        uint32_t cols;
+        uint32_t bytes;
+    };
+
+    struct Channel
+    {
+        std::string name;
+        unsigned int size;
+    };
+
+    std::vector<Channel> _channels;
+    std::map<std::string, Handle> _handles;
+
+    std::FILE* _file;
+    std::vector<char> _buffer;
+    uint64_t _mask;
+    /**
+     * @brief _write, _read positions in the buffer (not wrapped): _write is moved only by the producer,
+     * _read only by the thread writing the file, once the data is in the file
+     */
+    std::atomic<uint64_t> _write, _read;
+    std::atomic<unsigned int> _dropped;
+    /**
+     * @brief _stop, _flush, _mutex, _wake_up stop and wake up the thread writing the file
+     */
+    bool _stop, _flush;
+    std::mutex _mutex;
+    std::condition_variable _wake_up;
+    unsigned int _period_ms;
+    std::thread _thread;
+
+    bool push(const RecordHeader& header, const void* payload);
+    void copyIn(const uint64_t position, const void* data, const std::size_t bytes);
+    void drain();
+    void run();
+};
+
+}
+}
+
+#endif
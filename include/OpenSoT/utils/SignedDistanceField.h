@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi
+ * email:  alessio.rocchi@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __SIGNED_DISTANCE_FIELD_H__
+#define __SIGNED_DISTANCE_FIELD_H__
+
+#include <Eigen/Dense>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <vector>
+
+namespace OpenSoT
+{
+namespace utils
+{
+
+/**
+ * @brief The SignedDistanceField class stores the signed distance from the environment sampled
+ *        on a regular voxel grid. Values are stored at the grid nodes, node (i,j,k) being at
+ *        origin + resolution*(i,j,k), and queries are trilinearly interpolated, so that distance
+ *        and gradient at any point are computed in constant time from 8 nodes.
+ *
+ *        Distances are positive outside obstacles and negative inside them. Points outside the grid
+ *        are clamped on its boundary.
+ *
+ *        The field is built (offline or at startup) from a point cloud or a triangle mesh, can be saved
+ *        to file and loaded back: loaded fields are memory-mapped, so that no copy of the grid is made
+ *        and only the pages which are actually queried get read from disk.
+ */
+class SignedDistanceField: private boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<SignedDistanceField> Ptr;
+    typedef std::vector<Eigen::Vector3d> Points;
+    typedef std::vector<Eigen::Vector3i> Triangles;
+
+    /**
+     * @brief fromPointCloud builds a field where every voxel containing at least one point is occupied
+     * @param points the point cloud, in world frame
+     * @param origin position of the first node of the grid
+     * @param resolution size of a voxel
+     * @param size number of nodes along x, y and z (at least 2 per axis)
+     * @return the signed distance field
+     */
+    static Ptr fromPointCloud(const Points& points,
+                              const Eigen::Vector3d& origin,
+                              const double resolution,
+                              const Eigen::Vector3i& size);
+
+    /**
+     * @brief fromMesh builds a field where every voxel crossed by a triangle of the mesh is occupied.
+     *        Triangles are sampled with a step smaller than the resolution, and the samples are used
+     *        as a point cloud
+     * @param vertices the vertices of the mesh, in world frame
+     * @param triangles indices of the vertices of each triangle
+     * @param origin position of the first node of the grid
+     * @param resolution size of a voxel
+     * @param size number of nodes along x, y and z (at least 2 per axis)
+     * @return the signed distance field
+     */
+    static Ptr fromMesh(const Points& vertices,
+                        const Triangles& triangles,
+                        const Eigen::Vector3d& origin,
+                        const double resolution,
+                        const Eigen::Vector3i& size);
+
+    /**
+     * @brief load memory-maps a field previously written with save()
+     * @param file_name path of the file
+     * @return the signed distance field, or an empty pointer on failure
+     */
+    static Ptr load(const std::string& file_name);
+
+    ~SignedDistanceField();
+
+    /**
+     * @brief save writes the field to a binary file
+     * @param file_name path of the file
+     * @return true on success
+     */
+    bool save(const std::string& file_name) const;
+
+    /**
+     * @brief getDistance
+     * @param p a point in world frame
+     * @return the interpolated signed distance at p
+     */
+    double getDistance(const Eigen::Vector3d& p) const;
+
+    /**
+     * @brief getDistance computes signed distance and its gradient
+     * @param p a point in world frame
+     * @param gradient the gradient of the interpolated signed distance at p
+     * @return the interpolated signed distance at p
+     */
+    double getDistance(const Eigen::Vector3d& p, Eigen::Vector3d& gradient) const;
+
+    const Eigen::Vector3d& getOrigin() const { return _origin; }
+    double getResolution() const { return _resolution; }
+    const Eigen::Vector3i& getSize() const { return _size; }
+
+    /**
+     * @brief getNodeDistance
+     * @return the signed distance stored at node (i,j,k)
+     */
+    double getNodeDistance(const int i, const int j, const int k) const
+    {
+        return _data[index(i,j,k)];
+    }
+
+    /**
+     * @brief isMapped
+     * @return true if the field has been loaded from file
+     */
+    bool isMapped() const { return _mapped != NULL; }
+
+private:
+    SignedDistanceField(const Eigen::Vector3d& origin,
+                        const double resolution,
+                        const Eigen::Vector3i& size);
+
+    std::size_t index(const int i, const int j, const int k) const
+    {
+        return (std::size_t(k)*_size[1] + j)*_size[0] + i;
+    }
+
+    /**
+     * @brief computeFromOccupancy fills the grid computing, for each node,
+     *        the euclidean distance from the closest occupied node (if free)
+     *        or minus the distance from the closest free node (if occupied)
+     * @param occupied one entry per node
+     */
+    void computeFromOccupancy(const std::vector<bool>& occupied);
+
+    Eigen::Vector3d _origin;
+    double _resolution;
+    Eigen::Vector3i _size;
+
+    /**
+     * @brief _storage holds the grid when the field is built in memory
+     */
+    std::vector<float> _storage;
+
+    /**
+     * @brief _mapped, _mapped_size memory-mapped file when the field is loaded from disk
+     */
+    void* _mapped;
+    std::size_t _mapped_size;
+
+    /**
+     * @brief _data points either to _storage or to the grid in the mapped file
+     */
+    const float* _data;
+};
+
+}
+}
+
+#endif
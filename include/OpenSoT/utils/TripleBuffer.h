@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi, Enrico Mingo
+ * email:  alessio.rocchi@iit.it, enrico.mingo@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __TRIPLE_BUFFER_H__
+#define __TRIPLE_BUFFER_H__
+
+#include <atomic>
+
+namespace OpenSoT
+{
+namespace utils
+{
+
+/**
+ * @brief The TripleBuffer class passes the last value written by a thread to another thread, without locks.
+ *
+ * The writer fills its own buffer (getWriteBuffer()) and publishes it, the reader takes the last published
+ * buffer (update()) and reads it (getReadBuffer()): the two threads never wait for each other and never work on
+ * the same buffer. Values published and not read are overwritten by the following ones.
+ * The buffers are copies of the value given to the constructor, so that writing a value of the same size
+ * does not allocate.
+ *
+ * There has to be a single writer thread and a single reader thread.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer(const T& value = T()):
+        _middle(1),
+        _write(0),
+        _read(2)
+    {
+        for(unsigned int i = 0; i < 3; ++i)
+            _buffers[i] = value;
+    }
+
+    /**
+     * @brief reset sets all the buffers to a value, nothing is published.
+     * It is not thread safe: it is meant to be called before the threads start
+     */
+    void reset(const T& value)
+    {
+        for(unsigned int i = 0; i < 3; ++i)
+            _buffers[i] = value;
+        _middle.store(_middle.load() & INDEX);
+    }
+
+    /**
+     * @brief getWriteBuffer
+     * @return the buffer owned by the writer, to be filled before publish()
+     */
+    T& getWriteBuffer(){ return _buffers[_write]; }
+
+    /**
+     * @brief publish makes the write buffer the last value, the writer gets a free buffer
+     */
+    void publish()
+    {
+        _write = _middle.exchange(_write | NEW_VALUE, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /**
+     * @brief write copies a value in the write buffer and publishes it
+     */
+    void write(const T& value)
+    {
+        getWriteBuffer() = value;
+        publish();
+    }
+
+    /**
+     * @brief update takes the last published value, if any
+     * @return true if a new value was published since the last update
+     */
+    bool update()
+    {
+        if(!(_middle.load(std::memory_order_relaxed) & NEW_VALUE))
+            return false;
+        _read = _middle.exchange(_read, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    /**
+     * @brief getReadBuffer
+     * @return the buffer owned by the reader, the last value taken by update()
+     */
+    const T& getReadBuffer() const { return _buffers[_read]; }
+
+    /**
+     * @brief read takes the last published value
+     * @param value the last value, unchanged if nothing new was published
+     * @return true if a new value was published since the last read
+     */
+    bool read(T& value)
+    {
+        if(!update())
+            return false;
+        value = getReadBuffer();
+        return true;
+    }
+
+private:
+    enum { INDEX = 3, NEW_VALUE = 4 };
+
+    T _buffers[3];
+    /**
+     * @brief _middle index of the buffer exchanged between the threads, with the NEW_VALUE flag
+     * if it was published and not taken yet. _write and _read are owned by their thread.
+     */
+    std::atomic<unsigned int> _middle;
+    unsigned int _write, _read;
+};
+
+}
+}
+
+#endif
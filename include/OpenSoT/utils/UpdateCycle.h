@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi, Enrico Mingo
+ * email:  alessio.rocchi@iit.it, enrico.mingo@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef __UPDATE_CYCLE_H__
+#define __UPDATE_CYCLE_H__
+
+#include <atomic>
+
+namespace OpenSoT
+{
+namespace utils
+{
+
+/**
+ * @brief The UpdateCycle class numbers the update cycles of the calling thread.
+ *
+ * While a Scope is alive (e.g. during AutoStack::update()) the tasks and the constraints updated more than once
+ * with the same state, because they are shared by several containers, are evaluated only the first time
+ * (see UpdateStamp). Outside of a Scope the current cycle is 0 and every update is evaluated.
+ */
+class UpdateCycle
+{
+public:
+    /**
+     * @brief The Scope class starts a new cycle, which ends when the Scope is destroyed.
+     * A Scope created inside another one does not start a new cycle
+     */
+    class Scope
+    {
+    public:
+        Scope(): _owner(current() == 0)
+        {
+            if(_owner)
+                currentCycle() = ++lastCycle();
+        }
+
+        ~Scope()
+        {
+            if(_owner)
+                currentCycle() = 0;
+        }
+
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+
+        bool _owner;
+    };
+
+    /**
+     * @brief current
+     * @return the actual cycle of the calling thread, 0 outside of a Scope
+     */
+    static unsigned long current(){ return currentCycle(); }
+
+private:
+    static unsigned long& currentCycle()
+    {
+        static thread_local unsigned long cycle = 0;
+        return cycle;
+    }
+
+    /**
+     * @brief lastCycle is shared by all the threads, so that two threads never get the same cycle number
+     * and the stamps left by one thread never hold the updates of another one
+     */
+    static std::atomic<unsigned long>& lastCycle()
+    {
+        static std::atomic<unsigned long> cycle(0);
+        return cycle;
+    }
+};
+
+/**
+ * @brief The UpdateStamp class records the cycle and the state of the last update of a task or a constraint
+ */
+template <class Vector_type>
+class UpdateStamp
+{
+public:
+    UpdateStamp(): _cycle(0){}
+
+    /**
+     * @brief isStamped
+     * @param x the state
+     * @return true if the object was already updated in the actual cycle with the same state
+     */
+    bool isStamped(const Vector_type& x) const
+    {
+        const unsigned long cycle = UpdateCycle::current();
+        return cycle != 0 && cycle == _cycle && x.size() == _x.size() && x == _x;
+    }
+
+    /**
+     * @brief stamp records an update in the actual cycle
+     * @param x the state
+     * @return false if the object was already updated in the actual cycle with the same state
+     */
+    bool stamp(const Vector_type& x)
+    {
+        if(isStamped(x))
+            return false;
+        _cycle = UpdateCycle::current();
+        if(_cycle != 0)
+            _x = x;
+        return true;
+    }
+
+private:
+    unsigned long _cycle;
+    Vector_type _x;
+};
+
+/**
+ * @brief The UpdateDivider class schedules the updates of a task or a constraint slower than the control loop.
+ *
+ * The cycles are counted once per UpdateCycle, however many containers update the object in that cycle.
+ * Outside of a Scope the control cycles can not be told apart: the divider is not applied and the object
+ * is updated at every call.
+ */
+class UpdateDivider
+{
+public:
+    UpdateDivider(): _divider(1), _phase(0), _count(0), _cycle(0), _scheduled(true){}
+
+    /**
+     * @brief set
+     * @param divider number of cycles between two updates, 1 to update at every cycle
+     * @param phase the first update is in the cycle divider - phase (0 updates at the first cycle)
+     * @return false if divider is 0
+     */
+    bool set(const unsigned int divider, const unsigned int phase)
+    {
+        if(divider == 0)
+            return false;
+        _divider = divider;
+        _phase = phase % divider;
+        _count = 0;
+        _cycle = 0;
+        _scheduled = true;
+        return true;
+    }
+
+    unsigned int get() const { return _divider; }
+
+    /**
+     * @brief isScheduled
+     * @return true if the actual cycle is one of the cycles where the object is updated,
+     * always true outside of a Scope
+     */
+    bool isScheduled()
+    {
+        const unsigned long cycle = UpdateCycle::current();
+        if(_divider == 1 || cycle == 0)
+            return true;
+        if(cycle != _cycle)
+        {
+            _cycle = cycle;
+            _scheduled = (_count++ + _phase) % _divider == 0;
+        }
+        return _scheduled;
+    }
+
+private:
+    unsigned int _divider, _phase, _count;
+    unsigned long _cycle;
+    bool _scheduled;
+};
+
+}
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include <urdf/model.h>
 #include <Eigen/Dense>
 #include <Eigen/Cholesky>
+#include <complex>
 
 /**
  * @brief The CostFunction class pure virtual function used to describe functions for computeGradient method.
@@ -41,6 +42,24 @@ public:
     virtual double compute(const Eigen::VectorXd &x) = 0;
 };
 
+/**
+ * @brief The ComplexCostFunction class pure virtual function used to describe functions which can be evaluated
+ * for complex arguments, to compute their gradient with the complex-step method (see OpenSoT::utils::ParallelDifferentiation).
+ * It is usually implemented together with CostFunction, templating the implementation on the scalar type.
+ */
+class ComplexCostFunction {
+public:
+    virtual ~ComplexCostFunction(){}
+
+    /**
+     * @brief compute value of function in x
+     * @param x
+     * @return complex scalar
+     */
+
+    virtual std::complex<double> compute(const Eigen::VectorXcd &x) = 0;
+};
+
 /**
  * @brief The GradientVector class pure virtual function used to describe functions for computeHessian method.
  */
@@ -25,12 +25,15 @@
 #include <list>
 #include <string>
 #include <utility>
+#include <vector>
 #include <XBotInterface/ModelInterface.h>
 #include <srdfdom_advr/model.h>
 #include <fcl/collision_object.h>
 #include <moveit/collision_detection/collision_matrix.h>
 #include <moveit/robot_model/robot_model.h>
 #include <urdf/model.h>
+#include <OpenSoT/utils/CapsuleDistance.h>
+#include <OpenSoT/utils/CollisionGeometryCache.h>
 
 #if FCL_MINOR_VERSION <= 3
     template <typename T>
@@ -115,6 +118,26 @@ public:
     bool operator <(const LinkPairDistance& second) const;
 };
 
+/**
+ * @brief The IndexedLinkPairDistance struct holds the same information of LinkPairDistance,
+ *        with links and pairs identified by integer ids (see ComputeLinksDistance::getLinkId()).
+ *        It is used to fill preallocated buffers, so that no memory is allocated at every query
+ */
+struct IndexedLinkPairDistance {
+    /**
+     * @brief pairId the index of the pair among the pairs enabled for checking
+     */
+    unsigned int pairId;
+    unsigned int linkAId;
+    unsigned int linkBId;
+    /**
+     * @brief linkA_T_closestPoint, linkB_T_closestPoint closest points in the respective link frames
+     */
+    KDL::Frame linkA_T_closestPoint;
+    KDL::Frame linkB_T_closestPoint;
+    double distance;
+};
+
 class ComputeLinksDistance {
 public:
     friend class TestCapsuleLinksDistance;
@@ -150,14 +173,40 @@ public:
     public:
         std::string linkA;
         std::string linkB;
+        unsigned int pairId;
+        unsigned int linkAId;
+        unsigned int linkBId;
         boost::shared_ptr<fcl::CollisionObject> collisionObjectA;
         boost::shared_ptr<fcl::CollisionObject> collisionObjectB;
         boost::shared_ptr<ComputeLinksDistance::Capsule> capsuleA;
         boost::shared_ptr<ComputeLinksDistance::Capsule> capsuleB;
+        /**
+         * @brief primitiveA, primitiveB are set when the link shape is a capsule or a sphere
+         *        (the latter as a capsule with zero length). When both are set, the distance is
+         *        computed in closed form instead of using fcl
+         */
+        boost::shared_ptr<ComputeLinksDistance::Capsule> primitiveA;
+        boost::shared_ptr<ComputeLinksDistance::Capsule> primitiveB;
 
-        LinksPair(ComputeLinksDistance* const father, std::string linkA, std::string linkB) :
-            linkA(linkA), linkB(linkB)
+        /**
+         * @brief cacheValid is true if cachedDistance and the cached transforms
+         *        hold a valid temporal coherence cache for this pair
+         */
+        bool cacheValid;
+        /**
+         * @brief cachedDistance a lower bound of the distance between the two shapes,
+         *        when they were placed in cachedTransformA and cachedTransformB
+         */
+        double cachedDistance;
+        fcl::Transform3f cachedTransformA;
+        fcl::Transform3f cachedTransformB;
+
+        LinksPair(ComputeLinksDistance* const father, std::string linkA, std::string linkB,
+                  const unsigned int pairId) :
+            linkA(linkA), linkB(linkB), pairId(pairId), cacheValid(false), cachedDistance(0.0)
         {
+            linkAId = father->link_ids_[linkA];
+            linkBId = father->link_ids_[linkB];
             collisionObjectA = father->collision_objects_[linkA];
             collisionObjectB = father->collision_objects_[linkB];
             if(father->custom_capsules_.count(linkA) > 0)
@@ -165,8 +214,16 @@ public:
 
             if(father->custom_capsules_.count(linkB) > 0)
                 capsuleB = father->custom_capsules_[linkB];
+
+            if(father->primitive_shapes_.count(linkA) > 0)
+                primitiveA = father->primitive_shapes_[linkA];
+
+            if(father->primitive_shapes_.count(linkB) > 0)
+                primitiveB = father->primitive_shapes_[linkB];
         }
 
+        bool isPrimitivePair() const { return primitiveA && primitiveB; }
+
     };
 
     friend class ComputeLinksDistance::LinksPair;
@@ -190,6 +247,19 @@ private:
      */
     srdf_advr::Model robot_srdf;
 
+    /**
+     * @brief urdf_to_load_, srdf_to_load_ paths of the robot model used for collision geometries
+     *        (the capsule version of the robot model, when available)
+     */
+    std::string urdf_to_load_;
+    std::string srdf_to_load_;
+
+    /**
+     * @brief geometry_cache_ description of the collision geometries and of the pairs to check
+     *        computed at construction, saved to file so that it can be reused at next construction
+     */
+    OpenSoT::utils::CollisionGeometryCache geometry_cache_;
+
     /**
      * @brief shapes_ is a map of collision geometries
      */
@@ -200,6 +270,12 @@ private:
      */
     std::map<std::string,boost::shared_ptr<ComputeLinksDistance::Capsule> > custom_capsules_;
 
+    /**
+     * @brief primitive_shapes_ is a map of capsules and spheres (as capsules with zero length)
+     *        specified as endpoints + radius in link frame, used by the closed form distance computation
+     */
+    std::map<std::string,boost::shared_ptr<ComputeLinksDistance::Capsule> > primitive_shapes_;
+
     /**
      * @brief collision_objects_ a map of collision objects
      */
@@ -207,11 +283,49 @@ private:
 
     /**
      * @brief link_T_shape a map of transforms from link frame to shape frame.
-     *        Notice how the shape frame is always the center of the shape,
-     *        except for the capsule, where it lies on one endpoint
+     *        Notice how the shape frame is always the center of the shape
      */
     std::map<std::string,KDL::Frame> link_T_shape;
 
+    /**
+     * @brief The LinkData struct gathers the data of a link with collision geometry
+     *        which is needed at every query, so that no lookup by name is done in getLinkDistances
+     */
+    struct LinkData {
+        std::string name;
+        fcl::CollisionObject* collisionObject;
+        const KDL::Frame* link_T_shape;
+        /**
+         * @brief w_T_link the link pose in world frame, updated in updateCollisionObjects()
+         */
+        KDL::Frame w_T_link;
+    };
+
+    /**
+     * @brief links_ the links with collision geometry, indexed by link id
+     */
+    std::vector<LinkData> links_;
+
+    /**
+     * @brief link_ids_ maps link names to link ids
+     */
+    std::map<std::string, unsigned int> link_ids_;
+
+    /**
+     * @brief indexed_results_ buffer used by the getLinkDistances() returning a list
+     */
+    std::vector<IndexedLinkPairDistance> indexed_results_;
+
+    /**
+     * @brief primitive_distances_ computes the distances of all the pairs of primitive shapes in one batch
+     */
+    OpenSoT::utils::CapsuleDistanceBatch primitive_distances_;
+
+    /**
+     * @brief primitive_pairs_ the pairs of primitive shapes in primitive_distances_ at the current query
+     */
+    std::vector<ComputeLinksDistance::LinksPair*> primitive_pairs_;
+
     /**
      * @brief globalToLinkCoordinates transforms a fcl::Transform3f frame to a KDL::Frame in the link reference frame
      * @param linkName the link name representing a link reference frame
@@ -234,6 +348,11 @@ private:
                                 const fcl::Transform3f &fcl_shape_T_f,
                                 KDL::Frame &link_T_f);
 
+    /**
+     * @brief generateLinkIds assigns an id to each link with collision geometry
+     */
+    void generateLinkIds();
+
 
     /* FOLLOWING FUNCTIONS WILL LOAD AND UPDATE GEOMETRIES. NOTICE THAT A VALID ALTERNATIVE TO THIS
        IS TO USE MOVEIT. Since Moveit does not support capsules ATM, one idea could be to update the interal
@@ -242,13 +361,35 @@ private:
        Still, just the getLinkDistances needs to be used, and moveit will take care of calling the
        moveit equivalents to parseCollisionObjects and updateCollisionObjects*/
     /**
-     * @brief parseCollisionObjects
+     * @brief parseCollisionObjects fills geometry_cache_ with the collision shapes of the robot
+     *        and creates the collision objects
      * @param robot_urdf_path a string representing the robot urdf with collision information
-     * @param robot_srdf_path a string representing the robot srdf with collision information (i.e. ACM)
      * @return true on success
      */
-    bool parseCollisionObjects(const std::string& robot_urdf_path,
-                               const std::string &robot_srdf_path);
+    bool parseCollisionObjects(const std::string& robot_urdf_path);
+
+    /**
+     * @brief createCollisionObjects creates collision objects, capsules and shape transforms
+     *        from a description of the collision geometries
+     * @param cache the collision geometries
+     * @return true on success
+     */
+    bool createCollisionObjects(const OpenSoT::utils::CollisionGeometryCache& cache);
+
+    /**
+     * @brief loadCollisionMatrixModels loads the moveit robot model and the robot srdf,
+     *        needed to generate the allowed collision matrix. When the collision geometries are loaded
+     *        from cache, this is done only if the white or black lists get modified
+     */
+    void loadCollisionMatrixModels();
+
+    /**
+     * @brief getCacheFile
+     * @param cache_directory the directory where cache files are stored
+     * @param key the key of the cache
+     * @return the path of the cache file for the given key
+     */
+    static std::string getCacheFile(const std::string& cache_directory, const uint64_t key);
 
     /**
      * @brief updateCollisionObjects updates all collision objects with correct transforms (link_T_shape)
@@ -271,20 +412,72 @@ private:
     KDL::Frame fcl2KDL(const fcl::Transform3f &in);
 
     /**
-     * @brief generateLinksToUpdate generates a list of links for which we query w_T_link
+     * @brief linksToUpdate a list of links to update
      */
-    void generateLinksToUpdate();
+    std::set<std::string> linksToUpdate;
 
     /**
-     * @brief linksToUpdate a list of links to update
+     * @brief linkIdsToUpdate the ids of the links in linksToUpdate
      */
-    std::set<std::string> linksToUpdate;
+    std::vector<unsigned int> linkIdsToUpdate;
+
+    /**
+     * @brief aabbDistance computes a lower bound on the distance between two collision objects,
+     *        as the distance between their world axis-aligned bounding boxes.
+     *        The AABBs are updated in updateCollisionObjects()
+     * @param collObjA the first collision object
+     * @param collObjB the second collision object
+     * @return the distance between the two AABBs (0 if they overlap)
+     */
+    static double aabbDistance(const fcl::CollisionObject& collObjA,
+                               const fcl::CollisionObject& collObjB);
+
+    /**
+     * @brief displacementBound computes an upper bound on the displacement of any point of a shape
+     *        moving from one pose to another, using the bounding sphere of the shape:
+     *        ||delta center|| + rotation angle * bounding sphere radius
+     * @param geometry the shape geometry
+     * @param w_T_from the initial shape pose
+     * @param w_T_to the final shape pose
+     * @return the maximum displacement of a point on the shape
+     */
+    static double displacementBound(const fcl::CollisionGeometry& geometry,
+                                    const fcl::Transform3f& w_T_from,
+                                    const fcl::Transform3f& w_T_to);
+
+    /**
+     * @brief canSkipByCoherence uses the temporal coherence cache of a pair to check whether
+     *        the pair can be within the detection threshold at the current pose.
+     *        The distance at the current pose is bounded by the cached distance minus the
+     *        displacement of both shapes since the cache was filled
+     * @param pair the link pair, with its collision objects already updated
+     * @param detectionThreshold the detection threshold
+     * @return true if the pair is certainly farther than detectionThreshold
+     */
+    static bool canSkipByCoherence(const ComputeLinksDistance::LinksPair& pair,
+                                   const double detectionThreshold);
 
     /**
-     * @brief generatePairsToCheck generates a list of pairs to check for distance
+     * @brief updateCoherenceCache stores a lower bound of the distance between
+     *        the shapes of the pair at the current pose
+     * @param pair the link pair
+     * @param distanceLowerBound the distance (or a lower bound of it) at the current pose
+     */
+    static void updateCoherenceCache(ComputeLinksDistance::LinksPair& pair,
+                                     const double distanceLowerBound);
+
+    /**
+     * @brief generatePairsToCheck generates a list of pairs to check for distance from the allowed collision matrix
      */
     void generatePairsToCheck();
 
+    /**
+     * @brief setPairsToCheck sets the list of pairs to check for distance,
+     *        and the list of links for which we query w_T_link
+     * @param pairs the pairs of links to check
+     */
+    void setPairsToCheck(const std::vector<OpenSoT::utils::CollisionGeometryCache::LinksPair>& pairs);
+
     /**
      * @brief pairsToCheck a list of pairs to check for collision detection
      */
@@ -304,17 +497,71 @@ private:
 public:
     /* NOTICE THAT BY USING MOVEIT WE CAN PASS JUST THE MOVEIT_COLLISION_ROBOT TO THE CONSTRUCTOR. At that point
        we must make sure that the collision robot has an updated state before calling getLinkDistances */
-    ComputeLinksDistance(XBot::ModelInterface& model);
+    /**
+     * @brief ComputeLinksDistance loads the collision geometries of the robot.
+     *        Parsing the robot model, loading meshes and generating the list of pairs to check
+     *        can take a long time on complex models, so their result can be cached to file, keyed by a hash
+     *        of the content of URDF, SRDF and of the mesh files of the collision model:
+     *        when the cache matches the robot model, it is used instead
+     * @param model the robot model
+     * @param cache_directory the directory where cache files are stored, if empty (default) no cache is used
+     */
+    ComputeLinksDistance(XBot::ModelInterface& model, const std::string& cache_directory = "");
 
     /**
      * @brief getLinkDistances returns a list of distances between all link pairs which are enabled for checking.
      *                         If detectionThreshold is not infinity, the list will be clamped to contain only
      *                         the pairs whose distance is smaller than the detection threshold.
+     *                         In that case a broad phase on the world AABBs of the collision objects
+     *                         is run first, so that the exact (narrow phase) distance is computed only
+     *                         for the pairs whose bounding boxes are closer than the detection threshold.
+     *                         Moreover, the last distance computed for each pair is cached together with the
+     *                         pose of the shapes: pairs which can not have moved closer than the detection
+     *                         threshold since the last computation are skipped as well.
+     *                         Distances between pairs of capsules and spheres are computed in closed form,
+     *                         all at once, while the other pairs are handled by fcl.
      * @param detectionThreshold the maximum distance which we use to look for link pairs.
      * @return a sorted list of linkPairDistances
      */
     std::list<LinkPairDistance> getLinkDistances(double detectionThreshold = std::numeric_limits<double>::infinity());
 
+    /**
+     * @brief getLinkDistances computes the distances between all link pairs which are enabled for checking,
+     *                         as the previous method, but writes them in a buffer which is reused between calls
+     *                         instead of allocating a new list. Results are not sorted.
+     * @param detectionThreshold the maximum distance which we use to look for link pairs.
+     * @param results the buffer, which gets resized (if needed) to getNumberOfPairs()
+     * @return the number of valid entries at the beginning of results
+     */
+    unsigned int getLinkDistances(const double detectionThreshold,
+                                  std::vector<IndexedLinkPairDistance>& results);
+
+    /**
+     * @brief getLinkId
+     * @param linkName the name of a link with collision geometry
+     * @return the id of the link, -1 if the link has no collision geometry
+     */
+    int getLinkId(const std::string& linkName) const;
+
+    /**
+     * @brief getLinkName
+     * @param linkId a link id
+     * @return the name of the link
+     */
+    const std::string& getLinkName(const unsigned int linkId) const;
+
+    /**
+     * @brief getNumberOfLinks
+     * @return the number of links with collision geometry
+     */
+    unsigned int getNumberOfLinks() const;
+
+    /**
+     * @brief getNumberOfPairs
+     * @return the number of link pairs enabled for checking
+     */
+    unsigned int getNumberOfPairs() const;
+
     /**
      * @brief setCollisionWhiteList resets the allowed collision matrix by setting all collision pairs as disabled.
      *        It then enables all collision pairs specified in the whiteList. Lastly it will disable all collision pairs
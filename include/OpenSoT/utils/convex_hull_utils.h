@@ -20,17 +20,17 @@
 #ifndef _CONVEX_HULL_H__
 #define _CONVEX_HULL_H__
 
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
 #include <kdl/frames.hpp>
-#include <pcl/ModelCoefficients.h>
-#include <pcl/sample_consensus/method_types.h>
-#include <pcl/sample_consensus/model_types.h>
-#include <pcl/filters/passthrough.h>
-#include <pcl/filters/project_inliers.h>
-#include <pcl/surface/concave_hull.h>
 #include <XBotInterface/ModelInterface.h>
+#include <list>
+#include <vector>
 
+/**
+ * @brief The convex_hull class computes the support polygon of a set of contact points,
+ *        as the 2D convex hull (Andrew's monotone chain, O(n log n)) of the points projected on the xy plane.
+ *        Internal storage is reused between calls, so that no allocation happens once the number of contacts
+ *        is stable.
+ */
 class convex_hull
 {
 public:
@@ -55,6 +55,14 @@ public:
                                  const XBot::ModelInterface& model,
                                  const std::string referenceFrame = "COM");
 
+    /**
+     * @brief getSupportPolygonPoints same as above, the points are appended to a vector
+     */
+    bool getSupportPolygonPoints(std::vector<KDL::Vector>& points,
+                                 const std::list<std::string>& links_in_contact,
+                                 const XBot::ModelInterface& model,
+                                 const std::string& referenceFrame = "COM");
+
     /**
      * @brief getConvexHull returns a minimum representation of the convex hull
      * @param points a list of points representing the convex hull
@@ -63,47 +71,25 @@ public:
      */
     bool getConvexHull(const std::list<KDL::Vector>& points,
                              std::vector<KDL::Vector>& ch);
-    //void setRansacDistanceThr(const double x){_ransac_distance_thr = x;}
 
-private:
-    double _ransac_distance_thr;
-    pcl::PointCloud<pcl::PointXYZ>::Ptr _pointCloud;
-    pcl::PointCloud<pcl::PointXYZ>::Ptr _projectedPointCloud;
-
-    /**
-     * @brief fromPCLPointXYZ2KDLVector converts a pcl::PointXZY to a KDL::Vector
-     * @param point the source point represented as pcl point
-     * @return a kdl vector representing the input point
-     */
-    static KDL::Vector fromPCLPointXYZ2KDLVector(const pcl::PointXYZ &point);
     /**
-     * @brief fromKDLVector2PCLPointXYZ converts a KDL::Vector to a pcl::PointXZY
-     * @param point he source point represented as kdl vector
-     * @return a pcl point representing the input vector
+     * @brief getConvexHull computes the convex hull of points projected on the plane z = 0
+     * @param points the points
+     * @param ch the vertices of the convex hull, counter-clockwise and without collinear vertices,
+     *        with z = 0. ch is overwritten
+     * @return false if the points do not span a polygon (less than three non collinear points)
      */
-    static pcl::PointXYZ fromKDLVector2PCLPointXYZ(const KDL::Vector& point);
+    bool getConvexHull(const std::vector<KDL::Vector>& points,
+                             std::vector<KDL::Vector>& ch);
 
-    /**
-     * @brief fromSTDList2PCLPointCloud converts a list of kdl vectors into a pointcloud
-     * @param points a list of kdl vectors
-     * @param point_cloud the equivalent point cloud
-     */
-    static void fromSTDList2PCLPointCloud(const std::list<KDL::Vector>& points,
-                                          pcl::PointCloud<pcl::PointXYZ>::Ptr point_cloud);
+private:
+    std::vector<KDL::Vector> _points;
+    std::vector<KDL::Vector> _sorted_points;
 
     /**
-     * @brief projectPCL2Plane projects a point cloud on a plane
-     * @param cloud the input cloud
-     * @param ransac_distance_thr threshold for the ransac algorithm to detect outliers
-     * @param projected_point_cloud the output (projected) point cloud
+     * @brief cross z component of (a - o) x (b - o)
      */
-    void projectPCL2Plane(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr cloud,
-                          const double ransac_distance_thr,
-                          pcl::PointCloud<pcl::PointXYZ>::Ptr projected_point_cloud);
-
-
-    void printIndexAndPointsInfo(const pcl::PointCloud<pcl::PointXYZ>& pointsInConvexHull,
-                                 const std::vector<pcl::Vertices>& indicesOfVertexes);
+    static double cross(const KDL::Vector& o, const KDL::Vector& a, const KDL::Vector& b);
 };
 
 #endif
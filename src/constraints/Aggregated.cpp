@@ -20,6 +20,7 @@
 #include <assert.h>
 #include <limits>
 #include <sstream>
+#include <boost/functional/hash.hpp>
 
 using namespace OpenSoT::constraints;
 
@@ -73,7 +74,7 @@ void Aggregated::update(const Eigen::VectorXd& x) {
 
         ConstraintPtr &b = *i;
         /* update bounds */
-        b->update(x);
+        b->scheduledUpdate(x);
     }
 
     this->generateAll();
@@ -95,11 +96,15 @@ void Aggregated::generateAll() {
         _number_of_bounds = _bounds.size();
         _constraint_id = concatenateConstraintsIds(getConstraintsList());}
 
+    _rowKeys.clear();
+    std::size_t constraint_index = 0;
+
     /* iterating on all bounds.. */
     for(typename std::list< ConstraintPtr >::iterator i = _bounds.begin();
-        i != _bounds.end(); i++) {
+        i != _bounds.end(); i++, constraint_index++) {
 
         ConstraintPtr &b = *i;
+        const unsigned int first_row = _tmpAineq.rows();
 
         Eigen::VectorXd boundUpperBound = b->getUpperBound();
         Eigen::VectorXd boundLowerBound = b->getLowerBound();
@@ -162,6 +167,8 @@ void Aggregated::generateAll() {
             }
         }
 
+        const unsigned int first_ineq_row = _tmpAineq.rows();
+
         /* copying Aineq, bUpperBound, bLowerBound*/
         if( boundAineq.rows() != 0 ||
             boundbUpperBound.rows() != 0 ||
@@ -211,6 +218,23 @@ void Aggregated::generateAll() {
             if(_aggregationPolicy & UNILATERAL_TO_BILATERAL)
                 _tmpbLowerBound.pile( boundbLowerBound);
         }
+
+        /* keys of the rows: the constraint they come from, and their key in the constraint
+           (their index if it has no keys) */
+        const std::vector<std::size_t>& rowKeys = b->getRowKeys();
+        for(unsigned int r = first_row; r < _tmpAineq.rows(); ++r) {
+            std::size_t key = constraint_index;
+            if(r < first_ineq_row) {
+                boost::hash_combine(key, 0);
+                boost::hash_combine(key, r - first_row);
+            } else {
+                const unsigned int k = (r - first_ineq_row)%boundAineq.rows();
+                /* the second half of the rows of a bilateral constraint made unilateral */
+                boost::hash_combine(key, 1 + (r - first_ineq_row)/boundAineq.rows());
+                boost::hash_combine(key, rowKeys.size() == boundAineq.rows() ? rowKeys[k] : k);
+            }
+            _rowKeys.push_back(key);
+        }
     }
 
     /* checking everything went fine */
@@ -260,8 +284,36 @@ const std::string Aggregated::concatenateConstraintsIds(const std::list<Constrai
     return concatenatedId;
 }
 
+unsigned int Aggregated::getMaxAineqRows()
+{
+    unsigned int max_rows = _Aineq.rows();
+    for(typename std::list< ConstraintPtr >::iterator i = _bounds.begin(); i != _bounds.end(); ++i)
+    {
+        ConstraintPtr &b = *i;
+        const unsigned int rows = b->getAineq().rows();
+        const unsigned int b_max_rows = std::max<unsigned int>(b->getMaxAineqRows(), rows);
+        // bilateral rows are split in two when only unilateral constraints are wanted
+        const unsigned int split = !(_aggregationPolicy & UNILATERAL_TO_BILATERAL) &&
+                                   b->getbLowerBound().size() > 0 && b->getbUpperBound().size() > 0 ? 2 : 1;
+        max_rows += split*(b_max_rows - rows);
+    }
+    return max_rows;
+}
+
 void Aggregated::_log(XBot::MatLogger::Ptr logger)
 {
     for(auto bound : _bounds)
         bound->log(logger);
 }
+
+void Aggregated::_registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+{
+    for(auto bound : _bounds)
+        bound->registerLog(logger);
+}
+
+void Aggregated::_log(OpenSoT::utils::RTLogger::Ptr logger)
+{
+    for(auto bound : _bounds)
+        bound->log(logger);
+}
@@ -57,7 +57,7 @@ void CapturePointConstraint::computeAngularMomentumCorrection(const bool compute
 
 void CapturePointConstraint::update(const Eigen::VectorXd &x)
 {
-    _cartesian_position_cstr->update(x);
+    _cartesian_position_cstr->scheduledUpdate(x);
     _cartesian_position_cstr->getCurrentPosition(com);
 
     w = sqrt(fabs(com[2])/9.81)*(1.0/_dT);
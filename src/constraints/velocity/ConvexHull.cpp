@@ -19,6 +19,7 @@
 #include <OpenSoT/utils/convex_hull_utils.h>
 #include <exception>
 #include <cmath>
+#include <limits>
 
 using namespace OpenSoT::constraints::velocity;
 
@@ -29,7 +30,9 @@ ConvexHull::ConvexHull(const Eigen::VectorXd& x,
     Constraint("convex_hull", x.size()),
     _links_in_contact(links_in_contact),_robot(robot),
     _boundScaling(safetyMargin),
-    _convex_hull(new convex_hull())
+    _convex_hull(new convex_hull()),
+    _hull_tolerance(1e-4),
+    _JCoM(3, x.size())
 {
 
     this->update(x);
@@ -39,46 +42,124 @@ void ConvexHull::update(const Eigen::VectorXd &x) {
 
     /************************ COMPUTING BOUNDS ****************************/
 
-    Eigen::MatrixXd JCoM(3,_x_size);
-    _robot.getCOMJacobian(JCoM);
+    _robot.getCOMJacobian(_JCoM);
 
-    if(getConvexHull(_ch))
-        this->getConstraints(_ch, _Aineq, _bUpperBound, _boundScaling);
+    if(updateSupportPolygon())
+    {
+        // the edges are cached in world frame: only the offsets depend on the CoM,
+        // as the COM frame is oriented like the world frame
+        _robot.getCOM(_world_CoM);
+
+        _A_ch.resize(_lines.rows(), 2);
+        _bUpperBound.resize(_lines.rows());
+        for(int z = 0; z < _lines.rows(); ++z)
+        {
+            double _a = _lines(z,0);
+            double _b = _lines(z,1);
+            double _c = _lines(z,2) + _a*_world_CoM.x() + _b*_world_CoM.y();
+
+            //Where is the line w.r.t. the robot?
+            //We consider that the constraint is feasable at the beginning (the robot is in the convex hull)
+            if(_c <= 0.0) { // c < 0 --> AJdq < -c w/ -c > 0
+                _A_ch(z,0) = + _a;
+                _A_ch(z,1) = + _b;
+                _bUpperBound(z) = - _c;
+            } else { // c > 0 --> -AJdq < c
+                _A_ch(z,0) = - _a;
+                _A_ch(z,1) = - _b;
+                _bUpperBound(z) = + _c;
+            }
+
+            double normalizedBoundScaling = _boundScaling * sqrt(_a*_a + _b*_b); //boundScaling Normalization
+            if(fabs(_c) <= normalizedBoundScaling)
+                _bUpperBound(z) = 0.0;
+            else
+                _bUpperBound(z) -= normalizedBoundScaling;
+        }
+    }
     else
     {
-        _Aineq.resize(0, 2);
+        _A_ch.resize(0, 2);
         _bUpperBound.resize(0);
+        _rowKeys.clear();
     }
 
+    _Aineq.resize(_A_ch.rows(), _x_size);
+    _Aineq.noalias() = _A_ch * _JCoM.topRows(2);
+    /**********************************************************************/
+}
 
+bool ConvexHull::updateSupportPolygon()
+{
+    _points.clear();
+    if(!_convex_hull->getSupportPolygonPoints(_points, _links_in_contact, _robot, "world"))
+    {
+        XBot::Logger::warning("in %s: problems getting points for Convex Hull computation!\n", __func__);
+        _contact_positions.clear();
+        _ch.clear();
+        return false;
+    }
 
+    bool moved = _points.size() != _contact_positions.size();
+    for(unsigned int i = 0; !moved && i < _points.size(); ++i)
+        moved = (_points[i] - _contact_positions[i]).Norm() > _hull_tolerance;
+    if(!moved)
+        return !_ch.empty();
 
-    //assert(JCoM.rows() == _Aineq.cols());
+    _contact_positions = _points;
+    if(_points.size() < 3 || !_convex_hull->getConvexHull(_points, _ch))
+    {
+        XBot::Logger::warning("in %s: too few points for Convex Hull computation!\n", __func__);
+        _ch.clear();
+        return false;
+    }
 
-    _Aineq = _Aineq * JCoM.block(0,0,2,_x_size);
-    /**********************************************************************/
+    // each edge is identified by the contact points it joins, whatever the order of the vertices
+    _vertices.resize(_ch.size());
+    for(unsigned int j = 0; j < _ch.size(); ++j)
+    {
+        double min_distance = std::numeric_limits<double>::infinity();
+        for(unsigned int i = 0; i < _points.size(); ++i)
+        {
+            double distance = std::hypot(_points[i].x() - _ch[j].x(), _points[i].y() - _ch[j].y());
+            if(distance < min_distance)
+            {
+                min_distance = distance;
+                _vertices[j] = i;
+            }
+        }
+    }
+
+    _lines.resize(_ch.size(), 3);
+    _rowKeys.resize(_ch.size());
+    for(unsigned int j = 0; j < _ch.size(); ++j)
+    {
+        unsigned int k = (j + 1)%_ch.size();
+        getLineCoefficients(_ch[j], _ch[k], _lines(j,0), _lines(j,1), _lines(j,2));
+        _rowKeys[j] = _vertices[j]*_points.size() + _vertices[k];
+    }
+    return true;
 }
 
 bool ConvexHull::getConvexHull(std::vector<KDL::Vector> &ch)
 {
-    std::list<KDL::Vector> points;
-    // get support polygon points w.r.t. COM
-    if(_convex_hull->getSupportPolygonPoints(points,_links_in_contact,_robot,"COM")){
-        if(points.size() > 2)
-        {
-            std::vector<KDL::Vector> tmp_ch;
-            if(_convex_hull->getConvexHull(points, tmp_ch)){
-                ch = tmp_ch;
-                return true;}
-            else
-                std::cout<<"Problems computing Convex Hull, old Convex Hull will be used"<<std::endl;
-        }
-        else
-            std::cout<<"Too few points for Convex Hull computation!, old Convex Hull will be used"<<std::endl;
+    if(!updateSupportPolygon())
+        return false;
+
+    // the convex hull is returned in COM frame
+    _robot.getCOM(_world_CoM);
+    ch = _ch;
+    for(unsigned int i = 0; i < ch.size(); ++i)
+    {
+        ch[i].x(ch[i].x() - _world_CoM.x());
+        ch[i].y(ch[i].y() - _world_CoM.y());
     }
-    else
-        std::cout<<"Problems getting Points for Convex Hull computation!, old Convex Hull will be used"<<std::endl;
-    return false;
+    return true;
+}
+
+void ConvexHull::setHullTolerance(const double hullTolerance)
+{
+    _hull_tolerance = hullTolerance;
 }
 
 
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi
+ * email:  alessio.rocchi@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <OpenSoT/constraints/velocity/EnvironmentCollisionAvoidance.h>
+#include <cmath>
+#include <stdexcept>
+
+using namespace OpenSoT::constraints::velocity;
+
+EnvironmentCollisionAvoidance::EnvironmentCollisionAvoidance(const Eigen::VectorXd& x,
+                                                             XBot::ModelInterface& robot,
+                                                             OpenSoT::utils::SignedDistanceField::Ptr sdf,
+                                                             const double detection_threshold,
+                                                             const double distance_threshold,
+                                                             const double boundScaling):
+    Constraint("environment_collision_avoidance", x.size()),
+    _robot(robot),
+    _sdf(sdf),
+    _detection_threshold(std::fabs(detection_threshold)),
+    _distance_threshold(std::fabs(distance_threshold)),
+    _boundScaling(boundScaling)
+{
+    if(!_sdf)
+        throw std::runtime_error("EnvironmentCollisionAvoidance: empty signed distance field");
+
+    update(x);
+}
+
+bool EnvironmentCollisionAvoidance::addControlSphere(const std::string& link_name,
+                                                     const Eigen::Vector3d& center,
+                                                     const double radius)
+{
+    return addControlCapsule(link_name, center, center, radius);
+}
+
+bool EnvironmentCollisionAvoidance::addControlCapsule(const std::string& link_name,
+                                                      const Eigen::Vector3d& ep1,
+                                                      const Eigen::Vector3d& ep2,
+                                                      const double radius)
+{
+    if(_robot.getLinkID(link_name) == -1)
+    {
+        XBot::Logger::error("in %s: link %s does not exist \n", __func__, link_name.c_str());
+        return false;
+    }
+
+    ControlShape shape;
+    shape.link_name = link_name;
+    shape.ep1 = ep1;
+    shape.ep2 = ep2;
+    shape.radius = std::fabs(radius);
+    shape.number_of_samples = 1 + std::ceil((ep2 - ep1).norm()/_sdf->getResolution());
+    _shapes.push_back(shape);
+
+    calculate_Aineq_bUpperB(_Aineq, _bUpperBound);
+    _bLowerBound = -1.0e20*_bLowerBound.setOnes(_bUpperBound.size());
+
+    return true;
+}
+
+void EnvironmentCollisionAvoidance::setDetectionThreshold(const double detection_threshold)
+{
+    _detection_threshold = std::fabs(detection_threshold);
+}
+
+void EnvironmentCollisionAvoidance::setDistanceThreshold(const double distance_threshold)
+{
+    _distance_threshold = std::fabs(distance_threshold);
+}
+
+void EnvironmentCollisionAvoidance::setBoundScaling(const double boundScaling)
+{
+    _boundScaling = boundScaling;
+}
+
+void EnvironmentCollisionAvoidance::update(const Eigen::VectorXd& x)
+{
+    calculate_Aineq_bUpperB(_Aineq, _bUpperBound);
+    _bLowerBound = -1.0e20*_bLowerBound.setOnes(_bUpperBound.size());
+}
+
+void EnvironmentCollisionAvoidance::calculate_Aineq_bUpperB(Eigen::MatrixXd& Aineq,
+                                                            Eigen::VectorXd& bUpperBound)
+{
+    if(Aineq.rows() != int(_shapes.size()) || Aineq.cols() != int(_x_size))
+        Aineq.setZero(_shapes.size(), _x_size);
+    if(bUpperBound.size() != int(_shapes.size()))
+        bUpperBound.setZero(_shapes.size());
+    if(_distances.size() != int(_shapes.size()))
+        _distances.setZero(_shapes.size());
+
+    Eigen::Vector3d w_p, gradient, closest_point, closest_gradient;
+    for(unsigned int i = 0; i < _shapes.size(); ++i)
+    {
+        const ControlShape& shape = _shapes[i];
+        _robot.getPose(shape.link_name, _w_T_link);
+
+        // closest sample of the axis to the environment
+        double distance = std::numeric_limits<double>::infinity();
+        for(unsigned int k = 0; k < shape.number_of_samples; ++k)
+        {
+            double s = shape.number_of_samples > 1 ? double(k)/(shape.number_of_samples - 1) : 0.0;
+            Eigen::Vector3d link_p = shape.ep1 + s*(shape.ep2 - shape.ep1);
+            w_p = _w_T_link*link_p;
+
+            double sample_distance = _sdf->getDistance(w_p, gradient);
+            if(sample_distance < distance)
+            {
+                distance = sample_distance;
+                closest_point = link_p;
+                closest_gradient = gradient;
+            }
+        }
+
+        distance -= shape.radius;
+        _distances[i] = distance;
+
+        if(distance < _detection_threshold)
+        {
+            _robot.getJacobian(shape.link_name, closest_point, _J);
+            Aineq.row(i) = -closest_gradient.transpose()*_J.topRows(3);
+            bUpperBound[i] = (distance - _distance_threshold)*_boundScaling;
+        }
+        else
+        {
+            Aineq.row(i).setZero();
+            bUpperBound[i] = 1.0e20;
+        }
+    }
+}
+
+void EnvironmentCollisionAvoidance::_log(XBot::MatLogger::Ptr logger)
+{
+    logger->add(_constraint_id + "_distances", _distances);
+}
@@ -37,11 +37,12 @@ SelfCollisionAvoidance::SelfCollisionAvoidance(const Eigen::VectorXd& x,
                                                std::string& base_link,
                                                double detection_threshold,
                                                double linkPair_threshold,
-                                               const double boundScaling):
+                                               const double boundScaling,
+                                               const std::string& cache_directory):
     Constraint("self_collision_avoidance", x.size()),
     _detection_threshold(detection_threshold),
     _linkPair_threshold(linkPair_threshold),
-    computeLinksDistance(robot),
+    computeLinksDistance(robot, cache_directory),
     robot_col(robot),
     _x_cache(x),
     _boundScaling(boundScaling),
@@ -49,6 +50,13 @@ SelfCollisionAvoidance::SelfCollisionAvoidance(const Eigen::VectorXd& x,
 {
 
     _J_transform.setZero(3,6);
+    _temp_trans_matrix.setZero(6,6);
+    _dir_T_J_transform.setZero(6);
+
+    _base_T_link.resize(computeLinksDistance.getNumberOfLinks());
+    _base_J_link.resize(computeLinksDistance.getNumberOfLinks());
+    _link_update_stamp.resize(computeLinksDistance.getNumberOfLinks(), 0);
+    _update_stamp = 0;
 
     update(x);
 
@@ -66,6 +74,11 @@ double SelfCollisionAvoidance::getDetectionThreshold()
     return _detection_threshold;
 }
 
+unsigned int SelfCollisionAvoidance::getMaxAineqRows()
+{
+    return computeLinksDistance.getNumberOfPairs();
+}
+
 
 void SelfCollisionAvoidance::setLinkPairThreshold(const double linkPair_threshold)
 {
@@ -122,99 +135,74 @@ void SelfCollisionAvoidance::skewSymmetricOperator (const Eigen::Vector3d & r_cp
 
 
 
-void SelfCollisionAvoidance::calculate_Aineq_bUpperB (Eigen::MatrixXd & Aineq_fc,
-                                                      Eigen::VectorXd & bUpperB_fc )
+void SelfCollisionAvoidance::updateLinkCache(const unsigned int link_id)
 {
+    if(_link_update_stamp[link_id] == _update_stamp)
+        return;
 
-//    robot_col.updateiDyn3Model(x, false);
-
-    std::list<LinkPairDistance> interested_LinkPairs;
-    std::list<LinkPairDistance>::iterator j;
-    interested_LinkPairs = computeLinksDistance.getLinkDistances(_detection_threshold);
-
-    /*//////////////////////////////////////////////////////////*/
+    const std::string& link_name = computeLinksDistance.getLinkName(link_id);
+    robot_col.getPose(link_name, base_name, _base_T_link[link_id]);
+    robot_col.getRelativeJacobian(link_name, base_name, _J_tmp);
+    _base_J_link[link_id].noalias() = _temp_trans_matrix * _J_tmp;
 
-    MatrixXd Aineq_fc_Eigen(interested_LinkPairs.size(), robot_col.getJointNum());
-    VectorXd bUpperB_fc_Eigen(interested_LinkPairs.size());
-
-    double Dm_LinkPair;
-    KDL::Frame Link1_T_CP,Link2_T_CP;
-    std::string Link1_name, Link2_name;
-
-    int Link1_index, Link2_index;
+    _link_update_stamp[link_id] = _update_stamp;
+}
 
-    KDL::Frame Waist_T_Link1, Waist_T_Link2, Waist_T_Link1_CP, Waist_T_Link2_CP;
-    KDL::Vector Link1_origin_kdl, Link2_origin_kdl, Link1_CP_kdl, Link2_CP_kdl;
-    Eigen::Matrix<double, 3, 1> Link1_origin, Link2_origin, Link1_CP, Link2_CP;
+void SelfCollisionAvoidance::calculate_Aineq_bUpperB (Eigen::MatrixXd & Aineq_fc,
+                                                      Eigen::VectorXd & bUpperB_fc )
+{
+    unsigned int number_of_pairs =
+        computeLinksDistance.getLinkDistances(_detection_threshold, _linkPairDistances);
 
-    Vector3d closepoint_dir;
+    // a new stamp invalidates the link cache
+    ++_update_stamp;
 
-    MatrixXd Link1_CP_Jaco, Link2_CP_Jaco;
+    Aineq_fc.resize(number_of_pairs, robot_col.getJointNum());
+    bUpperB_fc.resize(number_of_pairs);
+    // the pairs within the detection threshold change: each row is identified by its pair
+    _rowKeys.resize(number_of_pairs);
 
     Affine3d Waist_frame_world_Eigen;
     robot_col.getPose(base_name, Waist_frame_world_Eigen);
     Waist_frame_world_Eigen.inverse();
 
     Matrix3d Waist_frame_world_Eigen_Ro = Waist_frame_world_Eigen.matrix().block(0,0,3,3);
-    MatrixXd temp_trans_matrix(6,6); temp_trans_matrix.setZero(6,6);
-    temp_trans_matrix.block(0,0,3,3) = Waist_frame_world_Eigen_Ro;
-    temp_trans_matrix.block(3,3,3,3) = Waist_frame_world_Eigen_Ro;
-
-    int linkPairIndex = 0;
-    for (j = interested_LinkPairs.begin(); j != interested_LinkPairs.end(); ++j)
-    {
-
-        LinkPairDistance& linkPair(*j);
-
-        Dm_LinkPair = linkPair.getDistance();
-        Link1_T_CP = linkPair.getLink_T_closestPoint().first;
-        Link2_T_CP = linkPair.getLink_T_closestPoint().second;
-        Link1_name = linkPair.getLinkNames().first;
-        Link2_name = linkPair.getLinkNames().second;
+    _temp_trans_matrix.block(0,0,3,3) = Waist_frame_world_Eigen_Ro;
+    _temp_trans_matrix.block(3,3,3,3) = Waist_frame_world_Eigen_Ro;
 
+    Eigen::Matrix<double, 3, 1> Link1_origin, Link2_origin, Link1_CP, Link2_CP;
+    Vector3d closepoint_dir;
 
-        robot_col.getPose(Link1_name, base_name, Waist_T_Link1);
-        robot_col.getPose(Link2_name, base_name, Waist_T_Link2);
+    for (unsigned int linkPairIndex = 0; linkPairIndex < number_of_pairs; ++linkPairIndex)
+    {
+        const IndexedLinkPairDistance& linkPair = _linkPairDistances[linkPairIndex];
+        _rowKeys[linkPairIndex] = linkPair.pairId;
 
-        Waist_T_Link1_CP = Waist_T_Link1 * Link1_T_CP;
-        Waist_T_Link2_CP = Waist_T_Link2 * Link2_T_CP;
-        Link1_origin_kdl = Waist_T_Link1.p;
-        Link2_origin_kdl = Waist_T_Link2.p;
-        Link1_CP_kdl = Waist_T_Link1_CP.p;
-        Link2_CP_kdl = Waist_T_Link2_CP.p;
+        updateLinkCache(linkPair.linkAId);
+        updateLinkCache(linkPair.linkBId);
 
-        vectorKDLToEigen(Link1_origin_kdl, Link1_origin);
-        vectorKDLToEigen(Link2_origin_kdl, Link2_origin);
-        vectorKDLToEigen(Link1_CP_kdl, Link1_CP);
-        vectorKDLToEigen(Link2_CP_kdl, Link2_CP);
+        const KDL::Frame& Waist_T_Link1 = _base_T_link[linkPair.linkAId];
+        const KDL::Frame& Waist_T_Link2 = _base_T_link[linkPair.linkBId];
 
+        vectorKDLToEigen(Waist_T_Link1.p, Link1_origin);
+        vectorKDLToEigen(Waist_T_Link2.p, Link2_origin);
+        vectorKDLToEigen(Waist_T_Link1 * linkPair.linkA_T_closestPoint.p, Link1_CP);
+        vectorKDLToEigen(Waist_T_Link2 * linkPair.linkB_T_closestPoint.p, Link2_CP);
 
         closepoint_dir = Link2_CP - Link1_CP;
-        closepoint_dir = closepoint_dir / Dm_LinkPair;
+        closepoint_dir = closepoint_dir / linkPair.distance;
 
-        robot_col.getRelativeJacobian(Link1_name, base_name,Link1_CP_Jaco);
-
-        Link1_CP_Jaco = temp_trans_matrix * Link1_CP_Jaco;
+        // closepoint_dir^T * ( J_transform1 * J1 - J_transform2 * J2 )
         skewSymmetricOperator(Link1_CP - Link1_origin,_J_transform);
-        Link1_CP_Jaco = _J_transform * Link1_CP_Jaco;
-
-        robot_col.getRelativeJacobian(Link2_name, base_name, Link2_CP_Jaco);
+        _dir_T_J_transform.noalias() = closepoint_dir.transpose() * _J_transform;
+        Aineq_fc.row(linkPairIndex).noalias() = _dir_T_J_transform * _base_J_link[linkPair.linkAId];
 
-        Link2_CP_Jaco = temp_trans_matrix * Link2_CP_Jaco;
         skewSymmetricOperator(Link2_CP - Link2_origin,_J_transform);
-        Link2_CP_Jaco = _J_transform * Link2_CP_Jaco;
-
-
-        Aineq_fc_Eigen.row(linkPairIndex) = closepoint_dir.transpose() * ( Link1_CP_Jaco - Link2_CP_Jaco );
-        bUpperB_fc_Eigen(linkPairIndex) = (Dm_LinkPair - _linkPair_threshold) * _boundScaling;
-
-        ++linkPairIndex;
+        _dir_T_J_transform.noalias() = closepoint_dir.transpose() * _J_transform;
+        Aineq_fc.row(linkPairIndex).noalias() -= _dir_T_J_transform * _base_J_link[linkPair.linkBId];
 
+        bUpperB_fc(linkPairIndex) = (linkPair.distance - _linkPair_threshold) * _boundScaling;
     }
-
-    Aineq_fc = Aineq_fc_Eigen;
-    bUpperB_fc = bUpperB_fc_Eigen;
-
 }
 
 void SelfCollisionAvoidance::setBoundScaling(const double boundScaling)
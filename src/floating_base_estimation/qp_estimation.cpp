@@ -16,27 +16,18 @@ FloatingBaseEstimation(model, imu, contact_links, contact_matrix)
         _map_tasks[contact_links[i]] = i;
     }
 
-    _aggregated_tasks.reset(new tasks::Aggregated(_contact_tasks, 6));
-
     if(imu){
         _imu_task.reset(new OpenSoT::tasks::floating_base::IMU(*_model, imu));
         Eigen::MatrixXd W = 100.*Eigen::MatrixXd::Identity(3,3);
         _imu_task->setWeight(W);}
 
-    AffineHelper var = AffineHelper::Identity(6);
-    Eigen::VectorXd ub(6);
-    ub<<5.*Eigen::VectorXd::Ones(3),M_PI*Eigen::VectorXd::Ones(3);
-    Eigen::VectorXd lb = -ub;
-    _fb_limits.reset(new constraints::GenericConstraint("fb_limits", var, ub, lb,
-        constraints::GenericConstraint::Type::BOUND));
-
-    if(imu)
-        _autostack.reset(new AutoStack(_aggregated_tasks + _imu_task));
-    else
-        _autostack.reset(new AutoStack(_aggregated_tasks));
-    _autostack<<_fb_limits;
+    _ub<<5.*Eigen::Vector3d::Ones(),M_PI*Eigen::Vector3d::Ones();
+    _lb = -_ub;
+    _x.setZero();
 
-    _solver.reset(new solvers::iHQP(_autostack->getStack(), _autostack->getBounds()));
+    if(imu){
+        _model->setFloatingBaseState(imu);
+        _model->update();}
 
     _Qdot.setZero(6);
     _Q.setZero();
@@ -55,29 +46,74 @@ bool OpenSoT::floating_base_estimation::qp_estimation::setContactState(
     if(!OpenSoT::FloatingBaseEstimation::setContactState(contact_link, state))
         return false;
 
-    unsigned int i = _map_tasks[contact_link];
-    std::list<OpenSoT::tasks::Aggregated::TaskPtr>::iterator it =
-            std::next(_contact_tasks.begin(), i);
-    (*it)->setActive(state);
+    _contact_tasks[_map_tasks[contact_link]]->setActive(state);
     return true;
 }
 
-bool OpenSoT::floating_base_estimation::qp_estimation::update(double dT)
+void OpenSoT::floating_base_estimation::qp_estimation::addMeasurement(const Eigen::MatrixXd& A,
+                                                                      const Eigen::VectorXd& b,
+                                                                      const Eigen::MatrixXd& W)
 {
-    if(_imu){
-        _model->setFloatingBaseState(_imu);
-        _model->update();}
+    if(W.isIdentity())
+    {
+        _H.noalias() += A.transpose()*A;
+        _g.noalias() -= A.transpose()*b;
+    }
+    else
+    {
+        _WA.noalias() = W*A;
+        _H.noalias() += A.transpose()*_WA;
+        _g.noalias() -= _WA.transpose()*b;
+    }
+}
 
+bool OpenSoT::floating_base_estimation::qp_estimation::update(double dT)
+{
+    // the model holds the IMU orientation of the previous cycle, see the end of update()
     _model->getJointPosition(_q);
     _model->getJointVelocity(_qdot);
 
     _Q = _q.segment(0,6);
-    _autostack->update(Eigen::VectorXd::Zero(0));
 
-    if(!_solver->solve(_Qdot)){
+    // rotation of the whole robot from the previous to the actual IMU orientation
+    if(_imu)
+    {
+        _imu->getOrientation(_R_imu);
+        _model->getOrientation(_imu->getSensorName(), _R_previous);
+        _delta_R.noalias() = _R_imu*_R_previous.transpose();
+    }
+
+    // small regularisation: without contacts the velocities go to zero
+    _H = 1e-10*solvers::BoxQP<6>::MatrixN::Identity();
+    _g.setZero();
+    for(unsigned int i = 0; i < _contact_tasks.size(); ++i)
+    {
+        if(!_contact_tasks[i]->isActive())
+            continue;
+        _contact_tasks[i]->update(_dummy);
+        if(_imu)
+        {
+            // the Jacobians are in the frame of the contact: only the columns of the floating base
+            // translation, which is in world frame, change with the orientation
+            _A_translation.noalias() = _contact_tasks[i]->getA().leftCols(3)*_delta_R.transpose();
+            _A_contact = _contact_tasks[i]->getA();
+            _A_contact.leftCols(3) = _A_translation;
+            addMeasurement(_A_contact, _contact_tasks[i]->getb(), _contact_tasks[i]->getWeight());
+        }
+        else
+            addMeasurement(_contact_tasks[i]->getA(), _contact_tasks[i]->getb(), _contact_tasks[i]->getWeight());
+    }
+    if(_imu_task)
+    {
+        _imu_task->update(_dummy);
+        addMeasurement(_imu_task->getA(), _imu_task->getb(), _imu_task->getWeight());
+    }
+
+    if(!_qp.solve(_H, _g, _lb, _ub, _x)){
         XBot::Logger::error("Solver in floating base estimation return false!\n");
         return false;
     }
+    _Qdot = _x;
     
     if(!_imu)
     {
@@ -92,18 +128,33 @@ bool OpenSoT::floating_base_estimation::qp_estimation::update(double dT)
         _qdot.segment(0,3) = _Qdot.segment(0,3);
     }
 
-    
-
+    // a single model update per cycle, the IMU orientation is applied here for the next cycle
     _model->setJointPosition(_q);
     _model->setJointVelocity(_qdot);
+    if(_imu)
+        _model->setFloatingBaseState(_imu);
     _model->update();
+
+    if(_imu)
+    {
+        _model->getJointPosition(_q);
+        _Q.segment(3,3) = _q.segment(3,3);
+    }
     return true;
 }
 
 void OpenSoT::floating_base_estimation::qp_estimation::log(XBot::MatLogger::Ptr logger)
 {
-    _solver->log(logger);
-    _autostack->log(logger);
+    for(unsigned int i = 0; i < _contact_tasks.size(); ++i)
+        _contact_tasks[i]->log(logger);
+    if(_imu_task)
+        _imu_task->log(logger);
+
+    logger->add("qp_estimation_H", _H);
+    logger->add("qp_estimation_g", _g);
+    logger->add("qp_estimation_lb", _lb);
+    logger->add("qp_estimation_ub", _ub);
+    logger->add("qp_estimation_solution", _x);
     logger->add("qp_estimation_Q", _Q);
     logger->add("qp_estimation_Qdot", _Qdot);
 }
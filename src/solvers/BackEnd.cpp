@@ -2,7 +2,8 @@
 
 using namespace OpenSoT::solvers;
 
-BackEnd::BackEnd(const int number_of_variables, const int number_of_constraints)
+BackEnd::BackEnd(const int number_of_variables, const int number_of_constraints):
+    _rt_logger(NULL)
 {
     _solution.setZero(number_of_variables);
 
@@ -123,6 +124,47 @@ void BackEnd::log(XBot::MatLogger::Ptr logger, int i)
     _log(logger, i);
 }
 
+void BackEnd::registerLog(OpenSoT::utils::RTLogger::Ptr logger, int i)
+{
+    std::string index = "_"+std::to_string(i);
+
+    _rt_logger = logger.get();
+    _rt_log_handles.clear();
+    _rt_log_handles.push_back(logger->registerChannel("H"+index, _H.rows(), _H.cols()));
+    _rt_log_handles.push_back(logger->registerChannel("g"+index, _g.size()));
+    _rt_log_handles.push_back(logger->registerChannel("A"+index, _A.rows(), _A.cols()));
+    _rt_log_handles.push_back(logger->registerChannel("lA"+index, _lA.size()));
+    _rt_log_handles.push_back(logger->registerChannel("uA"+index, _uA.size()));
+    _rt_log_handles.push_back(logger->registerChannel("l"+index, _l.size()));
+    _rt_log_handles.push_back(logger->registerChannel("u"+index, _u.size()));
+    _rt_log_handles.push_back(logger->registerChannel("solution"+index, _solution.size()));
+
+    _registerLog(logger, i);
+}
+
+void BackEnd::log(OpenSoT::utils::RTLogger::Ptr logger, int i)
+{
+    if(_rt_logger != logger.get())
+        registerLog(logger, i);
+
+    logger->add(_rt_log_handles[0], _H);
+    logger->add(_rt_log_handles[1], _g);
+    if(_A.rows() > 0 && _A.cols() > 0)
+        logger->add(_rt_log_handles[2], _A);
+    if(_lA.size() > 0)
+        logger->add(_rt_log_handles[3], _lA);
+    if(_uA.size() > 0)
+        logger->add(_rt_log_handles[4], _uA);
+    if(_l.size() > 0)
+        logger->add(_rt_log_handles[5], _l);
+    if(_u.size() > 0)
+        logger->add(_rt_log_handles[6], _u);
+    if(_solution.size() > 0)
+        logger->add(_rt_log_handles[7], _solution);
+
+    _log(logger, i);
+}
+
 void BackEnd::printProblemInformation(const int problem_number, const std::string& problem_id,
                                       const std::string& constraints_id, const std::string& bounds_id)
 {
@@ -1,4 +1,5 @@
 #include <OpenSoT/solvers/BackEndFactory.h>
+#include <qpOASES.hpp>
 
 OpenSoT::solvers::BackEnd::Ptr OpenSoT::solvers::BackEndFactory(const solver_back_ends be_solver, const int number_of_variables,
                        const int number_of_constraints,
@@ -27,3 +28,21 @@ std::string OpenSoT::solvers::whichBackEnd(const solver_back_ends be_solver)
 }
 
 
+
+std::vector<OpenSoT::solvers::BackEndCandidate> OpenSoT::solvers::getBackEndCandidates()
+{
+    std::vector<BackEndCandidate> candidates;
+    candidates.push_back(BackEndCandidate(solver_back_ends::qpOASES, "qpOASES"));
+
+    qpOASES::Options opt;
+    opt.setToReliable();
+    opt.printLevel = qpOASES::PL_NONE;
+    candidates.push_back(BackEndCandidate(solver_back_ends::qpOASES, "qpOASES:reliable", opt));
+
+    opt.setToDefault();
+    opt.printLevel = qpOASES::PL_NONE;
+    candidates.push_back(BackEndCandidate(solver_back_ends::qpOASES, "qpOASES:default", opt));
+
+    candidates.push_back(BackEndCandidate(solver_back_ends::OSQP, "OSQP"));
+    return candidates;
+}
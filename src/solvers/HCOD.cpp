@@ -0,0 +1,545 @@
+#include <OpenSoT/solvers/HCOD.h>
+#include <XBotInterface/Logger.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace OpenSoT::solvers;
+
+HCOD::HCOD(Stack& stack_of_tasks):
+    Solver<Eigen::MatrixXd, Eigen::VectorXd>(stack_of_tasks),
+    _n(0), _m(0), _rank(0), _damping(0.0),
+    _tolerance(1e-9), _max_iterations(100), _iterations(0)
+{
+    init();
+}
+
+HCOD::HCOD(Stack& stack_of_tasks, ConstraintPtr bounds):
+    Solver<Eigen::MatrixXd, Eigen::VectorXd>(stack_of_tasks, bounds),
+    _n(0), _m(0), _rank(0), _damping(0.0),
+    _tolerance(1e-9), _max_iterations(100), _iterations(0)
+{
+    init();
+}
+
+HCOD::HCOD(Stack& stack_of_tasks, ConstraintPtr bounds, ConstraintPtr globalConstraints):
+    Solver<Eigen::MatrixXd, Eigen::VectorXd>(stack_of_tasks, bounds, globalConstraints),
+    _n(0), _m(0), _rank(0), _damping(0.0),
+    _tolerance(1e-9), _max_iterations(100), _iterations(0)
+{
+    init();
+}
+
+void HCOD::init()
+{
+    if(_tasks.empty())
+        throw std::runtime_error("HCOD: the stack is empty");
+    _x_size = _tasks[0]->getXSize();
+
+    // a constraint shared by more tasks is taken once
+    std::list<ConstraintPtr> constraints_list;
+    if(_bounds)
+        constraints_list.push_back(_bounds);
+    if(_globalConstraints)
+        constraints_list.push_back(_globalConstraints);
+    for(unsigned int i = 0; i < _tasks.size(); ++i)
+    {
+        for(std::list<ConstraintPtr>::iterator it = _tasks[i]->getConstraints().begin();
+            it != _tasks[i]->getConstraints().end(); ++it)
+        {
+            if(std::find(constraints_list.begin(), constraints_list.end(), *it) == constraints_list.end())
+                constraints_list.push_back(*it);
+        }
+    }
+    _constraints.reset(new OpenSoT::constraints::Aggregated(constraints_list, _x_size));
+
+    // the last level is the minimum norm solution
+    _active_sets.resize(_tasks.size() + 1);
+    generateConstraints();
+}
+
+void HCOD::generateConstraints()
+{
+    _constraints->generateAll();
+
+    const unsigned int n_ineq = _constraints->getAineq().rows();
+    const unsigned int n_bounds = _constraints->hasBounds() ? _x_size : 0;
+    _G.resize(n_ineq + n_bounds, _x_size);
+    _lG.resize(n_ineq + n_bounds);
+    _uG.resize(n_ineq + n_bounds);
+
+    if(n_ineq > 0)
+    {
+        _G.topRows(n_ineq) = _constraints->getAineq();
+        _lG.head(n_ineq) = _constraints->getbLowerBound();
+        _uG.head(n_ineq) = _constraints->getbUpperBound();
+    }
+    if(n_bounds > 0)
+    {
+        _G.bottomRows(n_bounds).setIdentity();
+        _lG.tail(n_bounds) = _constraints->getLowerBound();
+        _uG.tail(n_bounds) = _constraints->getUpperBound();
+    }
+}
+
+bool HCOD::solve(Eigen::VectorXd& solution)
+{
+    generateConstraints();
+    _iterations = 0;
+
+    if(solution.size() != _x_size)
+        solution.setZero(_x_size);
+    if(!findFeasiblePoint(solution))
+        return false;
+
+    _Z.setIdentity(_x_size, _x_size);
+    for(unsigned int i = 0; i <= _tasks.size(); ++i)
+    {
+        std::vector<int>& active = _active_sets[i];
+        // the guess is the active set of the previous cycle, or the one of the level above
+        if(active.size() != _G.rows() && i > 0)
+            active = _active_sets[i-1];
+
+        // the levels above fixed the solution
+        if(_Z.cols() == 0)
+        {
+            active = _active_sets[i-1];
+            continue;
+        }
+
+        if(i < _tasks.size())
+        {
+            _WChol.compute(_tasks[i]->getWeight());
+            _M = _WChol.matrixL().transpose()*_tasks[i]->getA();
+            _r = _WChol.matrixL().transpose()*_tasks[i]->getb() - _M*solution;
+            _MZ = _M*_Z;
+        }
+        else
+        {
+            _r = -_Z.transpose()*solution;
+            _MZ.setIdentity(_Z.cols(), _Z.cols());
+        }
+
+        _GZ = _G*_Z;
+        _lGz = _lG - _G*solution;
+        _uGz = _uG - _G*solution;
+        _z.setZero(_Z.cols());
+
+        if(!solveLSI(_MZ, _r, _GZ, _lGz, _uGz, _z, active))
+        {
+            XBot::Logger::error("in %s: level %i did not converge\n", __func__, i);
+            return false;
+        }
+        solution.noalias() += _Z*_z;
+
+        // the following levels keep A_i*x
+        if(i < _tasks.size() && _MZ.rows() > 0)
+        {
+            Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(_MZ.transpose());
+            qr.setThreshold(_tolerance);
+            const unsigned int rank = qr.rank();
+            Eigen::MatrixXd Q = qr.householderQ();
+            _Z = _Z*Q.rightCols(_Z.cols() - rank);
+        }
+    }
+    return true;
+}
+
+bool HCOD::findFeasiblePoint(Eigen::VectorXd& x)
+{
+    if(_G.rows() == 0)
+        return true;
+
+    if(_constraints->hasBounds())
+        x = x.cwiseMax(_lG.tail(_x_size)).cwiseMin(_uG.tail(_x_size));
+
+    Eigen::VectorXd v = _G*x;
+    std::vector<unsigned int> violated;
+    for(unsigned int j = 0; j < v.size(); ++j)
+    {
+        if(v[j] > _uG[j] + _tolerance || v[j] < _lG[j] - _tolerance)
+            violated.push_back(j);
+    }
+    if(violated.empty())
+        return true;
+
+    // the violated rows get a slack, whose norm is minimized: y = [x; w]
+    const unsigned int n_slack = violated.size();
+    Eigen::MatrixXd G(_G.rows(), _x_size + n_slack);
+    G.leftCols(_x_size) = _G;
+    G.rightCols(n_slack).setZero();
+    Eigen::VectorXd y(_x_size + n_slack);
+    y.head(_x_size) = x;
+    for(unsigned int k = 0; k < n_slack; ++k)
+    {
+        const unsigned int j = violated[k];
+        G(j, _x_size + k) = -1.0;
+        y[_x_size + k] = v[j] - std::min(std::max(v[j], _lG[j]), _uG[j]);
+    }
+
+    Eigen::MatrixXd M(n_slack, _x_size + n_slack);
+    M.leftCols(_x_size).setZero();
+    M.rightCols(n_slack).setIdentity();
+    Eigen::VectorXd r(n_slack);
+    r.setZero();
+
+    std::vector<int> active;
+    if(!solveLSI(M, r, G, _lG, _uG, y, active))
+    {
+        XBot::Logger::error("in %s: feasibility problem did not converge\n", __func__);
+        return false;
+    }
+    if(y.tail(n_slack).lpNorm<Eigen::Infinity>() > std::sqrt(_tolerance))
+    {
+        XBot::Logger::error("in %s: constraints are infeasible, violation %f\n", __func__,
+                            y.tail(n_slack).lpNorm<Eigen::Infinity>());
+        return false;
+    }
+    x = y.head(_x_size);
+    return true;
+}
+
+void HCOD::reserve(const unsigned int n, const unsigned int m, const unsigned int p)
+{
+    if(_Q.rows() < n)
+    {
+        _Q.resize(n, n);
+        _R.resize(n, n);
+        _T.resize(n, n);
+        _u.resize(n);
+        _y.resize(n);
+        _w.resize(n);
+        _step.resize(n);
+    }
+    if(_MQ.rows() < m || _MQ.cols() < n)
+        _MQ.resize(std::max<unsigned int>(m, _MQ.rows()), std::max<unsigned int>(n, _MQ.cols()));
+    if(_e.size() < m)
+    {
+        _e.resize(m);
+        _d.resize(m);
+    }
+    if(_v.size() < p)
+    {
+        _v.resize(p);
+        _dv.resize(p);
+    }
+    _factorized.reserve(n);
+}
+
+namespace{
+    /**
+     * @brief givens computes the rotation [c s; -s c] taking (a, b) to (r, 0)
+     * @return r
+     */
+    double givens(const double a, const double b, double& c, double& s)
+    {
+        const double r = std::sqrt(a*a + b*b);
+        if(r == 0.0){
+            c = 1.0; s = 0.0;}
+        else{
+            c = a/r; s = b/r;}
+        return r;
+    }
+
+    /**
+     * @brief rotate applies the rotation [c s; -s c] to the pairs (x[k], y[k])
+     */
+    template <typename X, typename Y>
+    void rotate(X x, Y y, const double c, const double s)
+    {
+        for(int k = 0; k < x.size(); ++k)
+        {
+            const double xk = x[k];
+            x[k] = c*xk + s*y[k];
+            y[k] = -s*xk + c*y[k];
+        }
+    }
+}
+
+void HCOD::initFactorization(const Eigen::MatrixXd& M, const unsigned int n)
+{
+    _n = n;
+    _m = M.rows();
+    _rank = 0;
+    _factorized.clear();
+    reserve(_n, _m, 0);
+
+    _Q.topLeftCorner(_n, _n).setIdentity();
+    _MQ.topLeftCorner(_m, _n) = M;
+
+    // T'T = J(M'M + mu*I)J with J the reversal: T starts from sqrt(mu)*I and the rows of MJ are added
+    _damping = _tolerance*std::max(1.0, _m > 0 ? M.colwise().squaredNorm().maxCoeff() : 0.0);
+    _T.topLeftCorner(_n, _n).setZero();
+    _T.diagonal().head(_n).setConstant(std::sqrt(_damping));
+    for(unsigned int i = 0; i < _m; ++i)
+    {
+        _w.head(_n) = M.row(i).reverse().transpose();
+        for(unsigned int c = 0; c < _n; ++c)
+        {
+            if(_w[c] == 0.0)
+                continue;
+            double cs, sn;
+            _T(c,c) = givens(_T(c,c), _w[c], cs, sn);
+            rotate(_T.row(c).segment(c+1, _n-c-1), _w.segment(c+1, _n-c-1), cs, sn);
+        }
+    }
+}
+
+bool HCOD::addToFactorization(const Eigen::MatrixXd& G, const unsigned int j)
+{
+    if(_rank == _n)
+        return false;
+
+    const unsigned int k = _n - _rank;
+    _w.head(_n).noalias() = _Q.topLeftCorner(_n, _n).transpose()*G.row(j).transpose();
+
+    // the nullspace components of the row are rotated on the first column of the nullspace
+    for(unsigned int i = _n-1; i > _rank; --i)
+    {
+        if(_w[i] == 0.0)
+            continue;
+        double c, s;
+        _w[i-1] = givens(_w[i-1], _w[i], c, s);
+        _w[i] = 0.0;
+        rotate(_Q.col(i-1).head(_n), _Q.col(i).head(_n), c, s);
+        rotate(_MQ.col(i-1).head(_m), _MQ.col(i).head(_m), c, s);
+
+        // the same rotation of the columns of N, in reverse order, makes T upper Hessenberg in column ci
+        const unsigned int ci = _n-1-i;
+        rotate(_T.col(ci+1).head(ci+2), _T.col(ci).head(ci+2), c, s);
+        double ct, st;
+        _T(ci,ci) = givens(_T(ci,ci), _T(ci+1,ci), ct, st);
+        _T(ci+1,ci) = 0.0;
+        rotate(_T.row(ci).segment(ci+1, k-ci-1), _T.row(ci+1).segment(ci+1, k-ci-1), ct, st);
+    }
+
+    if(std::fabs(_w[_rank]) <= _tolerance*std::max(1.0, G.row(j).norm()))
+        return false;
+
+    // the first column of the nullspace is the last one of N: T loses its last row and column
+    _R.col(_rank).head(_rank+1) = _w.head(_rank+1);
+    _factorized.push_back(j);
+    ++_rank;
+    return true;
+}
+
+void HCOD::removeFromFactorization(const unsigned int k)
+{
+    // R without the column k is upper Hessenberg from k on
+    for(unsigned int col = k; col+1 < _rank; ++col)
+        _R.col(col).head(col+2) = _R.col(col+1).head(col+2);
+    _factorized.erase(_factorized.begin() + k);
+    --_rank;
+    for(unsigned int i = k; i < _rank; ++i)
+    {
+        double c, s;
+        _R(i,i) = givens(_R(i,i), _R(i+1,i), c, s);
+        _R(i+1,i) = 0.0;
+        rotate(_R.row(i).segment(i+1, _rank-i-1), _R.row(i+1).segment(i+1, _rank-i-1), c, s);
+        rotate(_Q.col(i).head(_n), _Q.col(i+1).head(_n), c, s);
+        rotate(_MQ.col(i).head(_m), _MQ.col(i+1).head(_m), c, s);
+    }
+
+    // the column _rank of Q enters the nullspace as the last column of N: T is bordered
+    const unsigned int n_null = _n - _rank;
+    const unsigned int last = n_null-1;
+    for(unsigned int c = 0; c < last; ++c)
+        _T(c,last) = _MQ.col(_n-1-c).head(_m).dot(_MQ.col(_rank).head(_m));
+    Eigen::VectorBlock<Eigen::MatrixXd::ColXpr> t = _T.col(last).head(last);
+    _T.topLeftCorner(last, last).transpose().triangularView<Eigen::Lower>().solveInPlace(t);
+    const double t2 = _MQ.col(_rank).head(_m).squaredNorm() + _damping - t.squaredNorm();
+    _T(last,last) = std::sqrt(std::max(t2, _damping));
+    _T.row(last).head(last).setZero();
+}
+
+void HCOD::removeFromWorkingSet(const Eigen::MatrixXd& G, const unsigned int j, std::vector<int>& active)
+{
+    active[j] = INACTIVE;
+    std::vector<unsigned int>::iterator it = std::find(_factorized.begin(), _factorized.end(), j);
+    if(it == _factorized.end())
+        return;
+    removeFromFactorization(it - _factorized.begin());
+
+    for(unsigned int i = 0; i < active.size(); ++i)
+    {
+        if(active[i] != INACTIVE &&
+           std::find(_factorized.begin(), _factorized.end(), i) == _factorized.end())
+            addToFactorization(G, i);
+    }
+}
+
+bool HCOD::solveLSI(const Eigen::MatrixXd& M, const Eigen::VectorXd& r,
+                    const Eigen::MatrixXd& G, const Eigen::VectorXd& lG, const Eigen::VectorXd& uG,
+                    Eigen::VectorXd& x, std::vector<int>& active)
+{
+    const unsigned int n = x.size();
+    const unsigned int p = G.rows();
+    const unsigned int m = M.rows();
+    if(active.size() != p)
+        active.assign(p, INACTIVE);
+    reserve(n, m, p);
+
+    Eigen::VectorBlock<Eigen::VectorXd> v = _v.head(p);
+    Eigen::VectorBlock<Eigen::VectorXd> dv = _dv.head(p);
+    Eigen::VectorBlock<Eigen::VectorXd> step = _step.head(n);
+    Eigen::VectorBlock<Eigen::VectorXd> e = _e.head(m);
+    Eigen::VectorBlock<Eigen::VectorXd> d = _d.head(m);
+    v.noalias() = G*x;
+
+    // rows of the guess not active in x are reached with the first step
+    bool warm_start = false;
+    for(unsigned int j = 0; j < p; ++j)
+    {
+        if(uG[j] - lG[j] <= _tolerance)
+            active[j] = ACTIVE_EQUALITY;
+        else if(active[j] == ACTIVE_EQUALITY)
+            active[j] = INACTIVE;
+
+        // rows fixed by the levels above can not enter the working set
+        if(G.row(j).squaredNorm() <= _tolerance*_tolerance)
+            active[j] = INACTIVE;
+
+        if((active[j] == ACTIVE_LOWER && v[j] - lG[j] > _tolerance) ||
+           (active[j] == ACTIVE_UPPER && uG[j] - v[j] > _tolerance))
+            warm_start = true;
+    }
+
+    initFactorization(M, n);
+    for(unsigned int j = 0; j < p; ++j)
+    {
+        if(active[j] != INACTIVE)
+            addToFactorization(G, j);
+    }
+
+    for(unsigned int iteration = 0; iteration < _max_iterations; ++iteration)
+    {
+        ++_iterations;
+
+        // step to the minimum with the working set active: B*step = c, solved with the rows in the factorization
+        Eigen::VectorBlock<Eigen::VectorXd> u = _u.head(_rank);
+        for(unsigned int k = 0; k < _rank; ++k)
+        {
+            const unsigned int j = _factorized[k];
+            u[k] = (active[j] == ACTIVE_LOWER ? lG[j] : uG[j]) - v[j];
+        }
+        _R.topLeftCorner(_rank, _rank).transpose().triangularView<Eigen::Lower>().solveInPlace(u);
+        step.noalias() = _Q.topLeftCorner(n, _rank)*u;
+
+        bool consistent = true;
+        for(unsigned int j = 0; j < p && consistent; ++j)
+        {
+            if(active[j] != INACTIVE)
+                consistent = std::fabs(G.row(j).dot(step) - ((active[j] == ACTIVE_LOWER ? lG[j] : uG[j]) - v[j]))
+                        <= std::sqrt(_tolerance);
+        }
+        if(!consistent)
+        {
+            // the guess is not consistent: only the rows active in x are kept
+            if(!warm_start)
+                return false;
+            for(unsigned int j = 0; j < p; ++j)
+            {
+                if((active[j] == ACTIVE_LOWER && std::fabs(lG[j] - v[j]) > _tolerance) ||
+                   (active[j] == ACTIVE_UPPER && std::fabs(uG[j] - v[j]) > _tolerance))
+                    removeFromWorkingSet(G, j, active);
+            }
+            warm_start = false;
+            continue;
+        }
+
+        // minimum of ||M*x - r|| in the nullspace N: T'T y = N'M'd
+        e = r;
+        e.noalias() -= M*x;
+        d = e;
+        d.noalias() -= _MQ.topLeftCorner(m, _rank)*u;
+        const unsigned int n_null = n - _rank;
+        Eigen::VectorBlock<Eigen::VectorXd> y = _y.head(n_null);
+        for(unsigned int c = 0; c < n_null; ++c)
+            y[c] = _MQ.col(n-1-c).head(m).dot(d);
+        _T.topLeftCorner(n_null, n_null).transpose().triangularView<Eigen::Lower>().solveInPlace(y);
+        _T.topLeftCorner(n_null, n_null).triangularView<Eigen::Upper>().solveInPlace(y);
+        const double particular_step = step.lpNorm<Eigen::Infinity>();
+        d.setZero();
+        for(unsigned int c = 0; c < n_null; ++c)
+        {
+            step.noalias() += y[c]*_Q.col(n-1-c).head(n);
+            d.noalias() += y[c]*_MQ.col(n-1-c).head(m);
+        }
+
+        // a step in the nullspace which does not change M*x is left to the levels below (and it is only
+        // made of the round-off amplified by the damping)
+        if(step.lpNorm<Eigen::Infinity>() <= _tolerance ||
+           (particular_step <= _tolerance && d.lpNorm<Eigen::Infinity>() <= _tolerance))
+        {
+            if(_rank == 0)
+                return true;
+
+            // B'nu = -gradient, the multiplier of a row active on its lower bound is -nu
+            u.noalias() = _MQ.topLeftCorner(m, _rank).transpose()*e;
+            _R.topLeftCorner(_rank, _rank).triangularView<Eigen::Upper>().solveInPlace(u);
+            int to_remove = -1;
+            double min_multiplier = -_tolerance;
+            for(unsigned int k = 0; k < _rank; ++k)
+            {
+                const int status = active[_factorized[k]];
+                if(status == ACTIVE_EQUALITY)
+                    continue;
+                const double multiplier = status*u[k];
+                if(multiplier < min_multiplier)
+                {
+                    min_multiplier = multiplier;
+                    to_remove = _factorized[k];
+                }
+            }
+            if(to_remove < 0)
+                return true;
+            removeFromWorkingSet(G, to_remove, active);
+            warm_start = false;
+        }
+        else
+        {
+            // the first constraint blocking the step enters the working set
+            dv.noalias() = G*step;
+            double alpha = 1.0;
+            int blocking = -1;
+            int blocking_status = INACTIVE;
+            for(unsigned int j = 0; j < p; ++j)
+            {
+                if(active[j] != INACTIVE)
+                    continue;
+                double alpha_j = alpha;
+                if(dv[j] > _tolerance)
+                    alpha_j = std::max(uG[j] - v[j], 0.0)/dv[j];
+                else if(dv[j] < -_tolerance)
+                    alpha_j = std::max(v[j] - lG[j], 0.0)/-dv[j];
+                if(alpha_j < alpha)
+                {
+                    alpha = alpha_j;
+                    blocking = j;
+                    blocking_status = dv[j] > 0.0 ? ACTIVE_UPPER : ACTIVE_LOWER;
+                }
+            }
+
+            x.noalias() += alpha*step;
+            v.noalias() += alpha*dv;
+
+            if(warm_start)
+            {
+                for(unsigned int j = 0; j < p; ++j)
+                {
+                    if((active[j] == ACTIVE_LOWER && v[j] - lG[j] > _tolerance) ||
+                       (active[j] == ACTIVE_UPPER && uG[j] - v[j] > _tolerance))
+                        removeFromWorkingSet(G, j, active);
+                }
+                warm_start = false;
+            }
+
+            if(blocking >= 0)
+            {
+                active[blocking] = blocking_status;
+                addToFactorization(G, blocking);
+            }
+        }
+    }
+    return false;
+}
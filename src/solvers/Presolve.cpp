@@ -0,0 +1,70 @@
+#include <OpenSoT/solvers/Presolve.h>
+#include <algorithm>
+
+using namespace OpenSoT::solvers;
+
+Presolve::Presolve(const double margin):
+    _margin(margin)
+{
+
+}
+
+bool Presolve::compute(const Eigen::MatrixXd& A, const Eigen::VectorXd& lA, const Eigen::VectorXd& uA,
+                       const Eigen::VectorXd& l, const Eigen::VectorXd& u)
+{
+    bool changed = false;
+    if(_taken.size() != A.rows())
+    {
+        _taken.assign(A.rows(), true);
+        _rows.reserve(A.rows());
+        changed = true;
+    }
+
+    // zero entries are skipped, bounds can be infinite
+    _min.setZero(A.rows());
+    _max.setZero(A.rows());
+    for(unsigned int c = 0; c < A.cols(); ++c)
+    {
+        for(unsigned int r = 0; r < A.rows(); ++r)
+        {
+            const double a = A(r, c);
+            if(a > 0.0)
+            {
+                _min[r] += a*l[c];
+                _max[r] += a*u[c];
+            }
+            else if(a < 0.0)
+            {
+                _min[r] += a*u[c];
+                _max[r] += a*l[c];
+            }
+        }
+    }
+
+    _rows.clear();
+    for(unsigned int r = 0; r < A.rows(); ++r)
+    {
+        const double margin = std::min(_min[r] - lA[r], uA[r] - _max[r]);
+        // comparisons are false with NaN: the row is taken
+        const bool drop = _taken[r] ? margin > _margin*(_max[r] - _min[r]) && margin > 0.0 :
+                                      margin > 0.0;
+        if(drop == _taken[r])
+        {
+            _taken[r] = !drop;
+            changed = true;
+        }
+        if(_taken[r])
+            _rows.push_back(r);
+    }
+
+    _A.resize(_rows.size(), A.cols());
+    _lA.resize(_rows.size());
+    _uA.resize(_rows.size());
+    for(unsigned int k = 0; k < _rows.size(); ++k)
+    {
+        _A.row(k) = A.row(_rows[k]);
+        _lA[k] = lA[_rows[k]];
+        _uA[k] = uA[_rows[k]];
+    }
+    return changed;
+}
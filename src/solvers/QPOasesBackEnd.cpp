@@ -26,6 +26,7 @@ QPOasesBackEnd::QPOasesBackEnd(const int number_of_variables,
     _bounds(new qpOASES::Bounds()),
     _constraints(new qpOASES::Constraints()),
     _nWSR(132),
+    _remapped(false),
     _epsRegularisation(eps_regularisation),
     _dual_solution(number_of_variables),
     _opt(new qpOASES::Options())
@@ -92,6 +93,7 @@ bool QPOasesBackEnd::initProblem(const Eigen::MatrixXd &H, const Eigen::VectorXd
         return false;}
 
     int nWSR = _nWSR;
+    _remapped = false;
 
     /**
      * this typedef is needed since qpOASES wants RoWMajor organization
@@ -214,16 +216,65 @@ bool QPOasesBackEnd::updateConstraints(const Eigen::Ref<const Eigen::MatrixXd>&
                                                               number_of_constraints,
                                                               hessian_type));
         _problem->setOptions(*_opt.get());
+        // the next solve() initializes the problem from the remapped working set
+        if(_remapped)
+            return true;
         return initProblem(_H, _g, _A, _lA, _uA, _l, _u);
     }
 }
 
+void QPOasesBackEnd::remapConstraints(const std::vector<int>& row_map)
+{
+    const int number_of_variables = _H.cols();
+    const int number_of_constraints = _constraints->getNC();
+    if(_dual_solution.rows() != number_of_variables + number_of_constraints)
+        return;
+
+    boost::shared_ptr<qpOASES::Constraints> constraints(new qpOASES::Constraints());
+    constraints->init(row_map.size());
+    Eigen::VectorXd dual_solution(number_of_variables + row_map.size());
+    dual_solution.head(number_of_variables) = _dual_solution.head(number_of_variables);
+    for(unsigned int i = 0; i < row_map.size(); ++i)
+    {
+        qpOASES::SubjectToStatus status = qpOASES::ST_INACTIVE;
+        if(row_map[i] >= 0 && row_map[i] < number_of_constraints)
+            status = _constraints->getStatus(row_map[i]);
+        if(status == qpOASES::ST_LOWER || status == qpOASES::ST_UPPER)
+            dual_solution[number_of_variables + i] = _dual_solution[number_of_variables + row_map[i]];
+        else
+        {
+            status = qpOASES::ST_INACTIVE;
+            dual_solution[number_of_variables + i] = 0.0;
+        }
+        constraints->setupConstraint(i, status);
+    }
+
+    _constraints = constraints;
+    _dual_solution = dual_solution;
+    _remapped = true;
+}
 
 bool QPOasesBackEnd::solve()
 {
     int nWSR = _nWSR;
     checkINFTY();
 
+    if(_remapped)
+    {
+        // hotstart would take the working set of other rows
+        _remapped = false;
+        qpOASES::returnValue val =_problem->init(_H.data(),_g.data(),
+                           Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>(_A).data(),
+                           _l.data(), _u.data(),
+                           _lA.data(),_uA.data(),
+                           nWSR,0,
+                           _solution.data(), _dual_solution.data(),
+                           _bounds.get(), _constraints.get());
+        if(val != qpOASES::SUCCESSFUL_RETURN)
+            return initProblem(_H, _g, _A, _lA, _uA, _l ,_u);
+        return getSolutionAndWorkingSet();
+    }
+
     qpOASES::returnValue val =_problem->hotstart(_H.data(),_g.data(),
                        Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>(_A).data(),
                         _l.data(), _u.data(),
@@ -253,6 +304,11 @@ bool QPOasesBackEnd::solve()
             return initProblem(_H, _g, _A, _lA, _uA, _l ,_u);}
     }
 
+    return getSolutionAndWorkingSet();
+}
+
+bool QPOasesBackEnd::getSolutionAndWorkingSet()
+{
     // If solution has changed of size we update the size
     if(_solution.rows() != _problem->getNV())
         _solution.resize(_problem->getNV());
@@ -0,0 +1,178 @@
+#include <OpenSoT/solvers/QPRecorder.h>
+#include <XBotInterface/Logger.hpp>
+#include <algorithm>
+
+using namespace OpenSoT::solvers;
+
+namespace
+{
+
+const std::string CHANNEL_PREFIX = "qp_snapshot_";
+
+}
+
+QPRecorder::QPRecorder(const std::string& file_name, const unsigned int decimation, const unsigned int buffer_size):
+    _logger(new OpenSoT::utils::RTLogger(file_name, buffer_size)),
+    _decimation(std::max(decimation, 1u)),
+    _cycle(0),
+    _recording(false)
+{
+
+}
+
+std::string QPRecorder::channelName(const int i)
+{
+    return CHANNEL_PREFIX + std::to_string(i);
+}
+
+unsigned int QPRecorder::sampleSize(const BackEnd& problem)
+{
+    const unsigned int n = problem.getH().cols();
+    const unsigned int m = problem.getA().rows();
+    const unsigned int nb = problem.getl().size();
+    // H, g, A, lA, uA, l, u, warm start, solution
+    return HEADER_SIZE + n*n + n + m*n + 2*m + 2*nb + 2*n;
+}
+
+void QPRecorder::registerProblem(const int i, const BackEnd& problem, const solver_back_ends back_end,
+                                 const OpenSoT::HessianType hessian_type, const double eps_regularisation)
+{
+    if(i < 0)
+        return;
+    if(_problems.size() <= (unsigned int)i)
+    {
+        Problem empty;
+        empty.handle = -1;
+        empty.size = 0;
+        _problems.resize(i+1, empty);
+    }
+
+    Problem& p = _problems[i];
+    p.size = sampleSize(problem);
+    p.handle = _logger->registerChannel(channelName(i), p.size);
+    p.back_end = back_end;
+    p.hessian_type = hessian_type;
+    p.eps_regularisation = eps_regularisation;
+    if(p.warm_start.size() == 0)
+        p.warm_start = problem.getSolution();
+
+    if(_sample.size() < p.size)
+        _sample.resize(p.size);
+}
+
+void QPRecorder::startCycle()
+{
+    _recording = _cycle % _decimation == 0;
+    ++_cycle;
+}
+
+void QPRecorder::recordWarmStart(const int i, const BackEnd& problem)
+{
+    if(!_recording || i < 0 || (unsigned int)i >= _problems.size() || _problems[i].handle < 0)
+        return;
+
+    // it allocates only if the problem changed of size
+    _problems[i].warm_start = problem.getSolution();
+}
+
+bool QPRecorder::record(const int i, const BackEnd& problem, const bool success, const double solve_time)
+{
+    if(!_recording)
+        return true;
+    if(i < 0 || (unsigned int)i >= _problems.size() || _problems[i].handle < 0)
+    {
+        XBot::Logger::error("in %s: problem %i is not registered\n", __func__, i);
+        return false;
+    }
+
+    Problem& p = _problems[i];
+    const unsigned int size = sampleSize(problem);
+    if(size > p.size)
+        registerProblem(i, problem, p.back_end, p.hessian_type, p.eps_regularisation);
+
+    const unsigned int n = problem.getH().cols();
+    const unsigned int m = problem.getA().rows();
+    const unsigned int nb = problem.getl().size();
+    // the warm start has the size of the solution before the problem changed of size
+    const unsigned int nw = std::min<unsigned int>(p.warm_start.size(), n);
+
+    _sample.head<HEADER_SIZE>() << _cycle - 1, i, (double)p.back_end, (double)p.hessian_type,
+                                   p.eps_regularisation, n, m, nb, success ? 1.0 : 0.0, solve_time;
+
+    unsigned int k = HEADER_SIZE;
+    _sample.segment(k, n*n) = Eigen::Map<const Eigen::VectorXd>(problem.getH().data(), n*n); k += n*n;
+    _sample.segment(k, n) = problem.getg(); k += n;
+    _sample.segment(k, m*n) = Eigen::Map<const Eigen::VectorXd>(problem.getA().data(), m*n); k += m*n;
+    _sample.segment(k, m) = problem.getlA(); k += m;
+    _sample.segment(k, m) = problem.getuA(); k += m;
+    _sample.segment(k, nb) = problem.getl(); k += nb;
+    _sample.segment(k, nb) = problem.getu(); k += nb;
+    _sample.segment(k, n).setZero();
+    _sample.segment(k, nw) = p.warm_start.head(nw); k += n;
+    _sample.segment(k, n) = problem.getSolution().head(n); k += n;
+
+    return _logger->add(p.handle, _sample.head(k));
+}
+
+bool QPRecorder::load(const std::string& file_name, std::vector<QPSnapshot>& snapshots)
+{
+    snapshots.clear();
+
+    std::map<std::string, std::vector<Eigen::MatrixXd> > data;
+    bool ok = OpenSoT::utils::RTLogger::load(file_name, data);
+
+    for(std::map<std::string, std::vector<Eigen::MatrixXd> >::const_iterator it = data.begin(); it != data.end(); ++it)
+    {
+        if(it->first.compare(0, CHANNEL_PREFIX.size(), CHANNEL_PREFIX) != 0)
+            continue;
+
+        for(unsigned int j = 0; j < it->second.size(); ++j)
+        {
+            Eigen::Map<const Eigen::VectorXd> sample(it->second[j].data(), it->second[j].size());
+            if(sample.size() < HEADER_SIZE)
+            {
+                ok = false;
+                continue;
+            }
+
+            QPSnapshot s;
+            s.cycle = sample[0];
+            s.level = sample[1];
+            s.back_end = (solver_back_ends)(int)sample[2];
+            s.hessian_type = (OpenSoT::HessianType)(int)sample[3];
+            s.eps_regularisation = sample[4];
+            const unsigned int n = sample[5];
+            const unsigned int m = sample[6];
+            const unsigned int nb = sample[7];
+            s.success = sample[8] != 0.0;
+            s.solve_time = sample[9];
+
+            if((unsigned int)sample.size() != HEADER_SIZE + n*n + n + m*n + 2*m + 2*nb + 2*n)
+            {
+                ok = false;
+                continue;
+            }
+
+            unsigned int k = HEADER_SIZE;
+            s.H = Eigen::Map<const Eigen::MatrixXd>(sample.data() + k, n, n); k += n*n;
+            s.g = sample.segment(k, n); k += n;
+            s.A = Eigen::Map<const Eigen::MatrixXd>(sample.data() + k, m, n); k += m*n;
+            s.lA = sample.segment(k, m); k += m;
+            s.uA = sample.segment(k, m); k += m;
+            s.l = sample.segment(k, nb); k += nb;
+            s.u = sample.segment(k, nb); k += nb;
+            s.warm_start = sample.segment(k, n); k += n;
+            s.solution = sample.segment(k, n);
+
+            snapshots.push_back(s);
+        }
+    }
+
+    // samples of different channels are not ordered between them in the map
+    std::stable_sort(snapshots.begin(), snapshots.end(), [](const QPSnapshot& a, const QPSnapshot& b){
+        return a.cycle < b.cycle || (a.cycle == b.cycle && a.level < b.level); });
+
+    if(!ok)
+        XBot::Logger::error("in %s: some snapshots in %s are not valid\n", __func__, file_name.c_str());
+    return ok;
+}
@@ -0,0 +1,96 @@
+#include <OpenSoT/solvers/QPReplay.h>
+#include <XBotInterface/Logger.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace OpenSoT::solvers;
+
+double QPReplayResult::getMeanSolveTime() const
+{
+    if(solve_times.empty())
+        return 0.0;
+
+    double sum = 0.0;
+    for(unsigned int i = 0; i < solve_times.size(); ++i)
+        sum += solve_times[i];
+    return sum/solve_times.size();
+}
+
+double QPReplayResult::getSolveTimePercentile(const double p) const
+{
+    if(solve_times.empty())
+        return 0.0;
+
+    std::vector<double> sorted(solve_times);
+    std::sort(sorted.begin(), sorted.end());
+    // nearest rank
+    int rank = std::ceil(std::min(std::max(p, 0.0), 100.0)/100.0*sorted.size()) - 1;
+    return sorted[std::max(rank, 0)];
+}
+
+double QPReplayResult::getMaxSolutionError() const
+{
+    double max = 0.0;
+    for(unsigned int i = 0; i < solution_errors.size(); ++i)
+    {
+        if(solution_errors[i] > max)
+            max = solution_errors[i];
+    }
+    return max;
+}
+
+QPReplay::QPReplay(const std::vector<QPSnapshot>& snapshots):
+    _snapshots(snapshots)
+{
+
+}
+
+bool QPReplay::replay(const solver_back_ends be_solver, QPReplayResult& result, const boost::any& options)
+{
+    result.solve_times.clear();
+    result.solution_errors.clear();
+    result.failures = 0;
+
+    std::vector<BackEnd::Ptr> problems;
+    for(unsigned int i = 0; i < _snapshots.size(); ++i)
+    {
+        const QPSnapshot& s = _snapshots[i];
+        if(s.level < 0)
+            continue;
+        if(problems.size() <= (unsigned int)s.level)
+            problems.resize(s.level + 1);
+        BackEnd::Ptr& problem = problems[s.level];
+
+        // the problem is initialized again if it changed of size in a way the back-end does not handle
+        bool updated = problem && problem->getNumVariables() == s.H.cols() &&
+                problem->updateProblem(s.H, s.g, s.A, s.lA, s.uA, s.l, s.u);
+        if(!updated)
+        {
+            try{
+                problem = BackEndFactory(be_solver, s.H.cols(), s.A.rows(), s.hessian_type, s.eps_regularisation);
+            }
+            catch(const std::exception& e){
+                XBot::Logger::error("in %s: %s\n", __func__, e.what());
+                return false;
+            }
+            if(!options.empty())
+                problem->setOptions(options);
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool success = updated ? problem->solve() :
+                                 problem->initProblem(s.H, s.g, s.A, s.lA, s.uA, s.l, s.u);
+        result.solve_times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        if(!success)
+            ++result.failures;
+
+        if(s.success && problem->getSolution().size() == s.solution.size())
+            result.solution_errors.push_back((problem->getSolution() - s.solution).lpNorm<Eigen::Infinity>());
+        else
+            result.solution_errors.push_back(std::numeric_limits<double>::quiet_NaN());
+    }
+    return true;
+}
@@ -0,0 +1,553 @@
+#include <OpenSoT/solvers/RecedingHorizon.h>
+#include <XBotInterface/Logger.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace OpenSoT::solvers;
+
+namespace{
+    // bounds beyond this value are infinite, as in qpOASES
+    const double INFINITE_BOUND = 1e20;
+}
+
+RecedingHorizon::RecedingHorizon(Stack& stack_of_tasks, const AffineHelper& qddot,
+                                 const double dt, const unsigned int horizon):
+    Solver<Eigen::MatrixXd, Eigen::VectorXd>(stack_of_tasks),
+    _horizon(horizon), _dt(dt), _qddot(qddot),
+    _decoupled_warned(false),
+    _weight_ratio(1e2), _regularisation(1e-6), _tolerance(1e-8), _max_iterations(50), _iterations(0)
+{
+    init();
+}
+
+RecedingHorizon::RecedingHorizon(Stack& stack_of_tasks, ConstraintPtr bounds, const AffineHelper& qddot,
+                                 const double dt, const unsigned int horizon):
+    Solver<Eigen::MatrixXd, Eigen::VectorXd>(stack_of_tasks, bounds),
+    _horizon(horizon), _dt(dt), _qddot(qddot),
+    _decoupled_warned(false),
+    _weight_ratio(1e2), _regularisation(1e-6), _tolerance(1e-8), _max_iterations(50), _iterations(0)
+{
+    init();
+}
+
+RecedingHorizon::RecedingHorizon(Stack& stack_of_tasks, ConstraintPtr bounds, ConstraintPtr globalConstraints,
+                                 const AffineHelper& qddot, const double dt, const unsigned int horizon):
+    Solver<Eigen::MatrixXd, Eigen::VectorXd>(stack_of_tasks, bounds, globalConstraints),
+    _horizon(horizon), _dt(dt), _qddot(qddot),
+    _decoupled_warned(false),
+    _weight_ratio(1e2), _regularisation(1e-6), _tolerance(1e-8), _max_iterations(50), _iterations(0)
+{
+    init();
+}
+
+void RecedingHorizon::init()
+{
+    if(_tasks.empty())
+        throw std::runtime_error("RecedingHorizon: the stack is empty");
+    _x_size = _tasks[0]->getXSize();
+    if(_horizon == 0 || _dt <= 0.0 || _qddot.getM().cols() != _x_size)
+        throw std::runtime_error("RecedingHorizon: horizon, dt or qddot are not consistent with the stack");
+
+    // a constraint shared by more tasks is taken once
+    std::list<ConstraintPtr> constraints_list;
+    if(_bounds)
+        constraints_list.push_back(_bounds);
+    if(_globalConstraints)
+        constraints_list.push_back(_globalConstraints);
+    for(unsigned int i = 0; i < _tasks.size(); ++i)
+    {
+        for(std::list<ConstraintPtr>::iterator it = _tasks[i]->getConstraints().begin();
+            it != _tasks[i]->getConstraints().end(); ++it)
+        {
+            if(std::find(constraints_list.begin(), constraints_list.end(), *it) == constraints_list.end())
+                constraints_list.push_back(*it);
+        }
+    }
+    _constraints.reset(new OpenSoT::constraints::Aggregated(constraints_list, _x_size));
+
+    _kp.assign(_tasks.size(), 0.0);
+    _kd.assign(_tasks.size(), 0.0);
+
+    // double integrator of the joint accelerations
+    const unsigned int dofs = _qddot.getM().rows();
+    _Ad.setIdentity(2*dofs, 2*dofs);
+    _Ad.topRightCorner(dofs, dofs) = _dt*Eigen::MatrixXd::Identity(dofs, dofs);
+    _Bx.resize(2*dofs, _x_size);
+    _Bx.topRows(dofs) = 0.5*_dt*_dt*_qddot.getM();
+    _Bx.bottomRows(dofs) = _dt*_qddot.getM();
+    _cx.resize(2*dofs);
+    _cx.head(dofs) = 0.5*_dt*_dt*_qddot.getq();
+    _cx.tail(dofs) = _dt*_qddot.getq();
+    _q_actual.setZero(dofs);
+    _qdot_actual.setZero(dofs);
+
+    _w.resize(_horizon);
+    _z.resize(_horizon + 1);
+    _s.resize(_horizon);
+    _lambda.resize(_horizon);
+    _d.resize(_horizon);
+    _x.resize(_horizon);
+    _dw.resize(_horizon);
+    _ds.resize(_horizon);
+    _dlambda.resize(_horizon);
+    _rp.resize(_horizon);
+    _rc.resize(_horizon);
+    _gz.resize(_horizon);
+    _gw.resize(_horizon);
+    _P.resize(_horizon + 1);
+    _p.resize(_horizon + 1);
+    _K.resize(_horizon);
+    _k.resize(_horizon);
+    _Shat.resize(_horizon);
+    _Rhat_llt.resize(_horizon);
+}
+
+bool RecedingHorizon::setFeedbackGains(const unsigned int level, const double kp, const double kd)
+{
+    if(level >= _tasks.size() || kp < 0.0 || kd < 0.0){
+        XBot::Logger::error("in %s: gains %f, %f can not be set at level %i\n", __func__, kp, kd, level);
+        return false;}
+
+    _kp[level] = kp;
+    _kd[level] = kd;
+    return true;
+}
+
+bool RecedingHorizon::setJointLimits(const Eigen::VectorXd& q_min, const Eigen::VectorXd& q_max)
+{
+    if(q_min.size() != _q_actual.size() || q_max.size() != _q_actual.size() || (q_min.array() > q_max.array()).any()){
+        XBot::Logger::error("in %s: joint limits are not consistent with %i joints\n", __func__, (int)_q_actual.size());
+        return false;}
+
+    _q_min = q_min;
+    _q_max = q_max;
+    return true;
+}
+
+bool RecedingHorizon::setVelocityLimits(const Eigen::VectorXd& qdot_max)
+{
+    if(qdot_max.size() != _q_actual.size() || (qdot_max.array() < 0.0).any()){
+        XBot::Logger::error("in %s: velocity limits are not consistent with %i joints\n", __func__, (int)_q_actual.size());
+        return false;}
+
+    _qdot_max = qdot_max;
+    return true;
+}
+
+bool RecedingHorizon::setState(const Eigen::VectorXd& q, const Eigen::VectorXd& qdot)
+{
+    if(q.size() != _q_actual.size() || qdot.size() != _q_actual.size()){
+        XBot::Logger::error("in %s: state is not consistent with %i joints\n", __func__, (int)_q_actual.size());
+        return false;}
+
+    _q_actual = q;
+    _qdot_actual = qdot;
+    return true;
+}
+
+void RecedingHorizon::generateStateLimits()
+{
+    const unsigned int dofs = _q_actual.size();
+    unsigned int n_h = 0;
+    for(unsigned int j = 0; j < dofs; ++j)
+    {
+        if(_q_max.size() > 0 && _q_max[j] < INFINITE_BOUND)
+            ++n_h;
+        if(_q_min.size() > 0 && _q_min[j] > -INFINITE_BOUND)
+            ++n_h;
+        if(_qdot_max.size() > 0 && _qdot_max[j] < INFINITE_BOUND)
+            n_h += 2;
+    }
+
+    // the position at step k+1 is q + (k+1)*dt*qdot + dq_{k+1}, the velocity qdot + dqdot_{k+1}
+    _Hz.setZero(n_h, 2*dofs);
+    _h.resize(n_h);
+    _hv.resize(n_h);
+    unsigned int r = 0;
+    for(unsigned int j = 0; j < dofs; ++j)
+    {
+        if(_q_max.size() > 0 && _q_max[j] < INFINITE_BOUND)
+        {
+            _Hz(r, j) = 1.0;
+            _h[r] = _q_max[j] - _q_actual[j];
+            _hv[r++] = _dt*_qdot_actual[j];
+        }
+        if(_q_min.size() > 0 && _q_min[j] > -INFINITE_BOUND)
+        {
+            _Hz(r, j) = -1.0;
+            _h[r] = _q_actual[j] - _q_min[j];
+            _hv[r++] = -_dt*_qdot_actual[j];
+        }
+        if(_qdot_max.size() > 0 && _qdot_max[j] < INFINITE_BOUND)
+        {
+            _Hz(r, dofs + j) = 1.0;
+            _h[r] = _qdot_max[j] - _qdot_actual[j];
+            _hv[r++] = 0.0;
+            _Hz(r, dofs + j) = -1.0;
+            _h[r] = _qdot_max[j] + _qdot_actual[j];
+            _hv[r++] = 0.0;
+        }
+    }
+}
+
+void RecedingHorizon::generateProblem()
+{
+    _constraints->generateAll();
+
+    const unsigned int n_ineq = _constraints->getAineq().rows();
+    const unsigned int n_bounds = _constraints->hasBounds() ? _x_size : 0;
+    _G.resize(n_ineq + n_bounds, _x_size);
+    _lG.resize(n_ineq + n_bounds);
+    _uG.resize(n_ineq + n_bounds);
+    if(n_ineq > 0)
+    {
+        _G.topRows(n_ineq) = _constraints->getAineq();
+        _lG.head(n_ineq) = _constraints->getbLowerBound();
+        _uG.head(n_ineq) = _constraints->getbUpperBound();
+    }
+    if(n_bounds > 0)
+    {
+        _G.bottomRows(n_bounds).setIdentity();
+        _lG.tail(n_bounds) = _constraints->getLowerBound();
+        _uG.tail(n_bounds) = _constraints->getUpperBound();
+    }
+
+    // equalities: x = _xp + _N*w
+    std::vector<unsigned int> equalities, upper, lower;
+    for(unsigned int r = 0; r < _G.rows(); ++r)
+    {
+        if(_uG[r] - _lG[r] <= _tolerance)
+            equalities.push_back(r);
+        else
+        {
+            if(_uG[r] < INFINITE_BOUND)
+                upper.push_back(r);
+            if(_lG[r] > -INFINITE_BOUND)
+                lower.push_back(r);
+        }
+    }
+
+    if(!equalities.empty())
+    {
+        _E.resize(equalities.size(), _x_size);
+        _e.resize(equalities.size());
+        for(unsigned int k = 0; k < equalities.size(); ++k)
+        {
+            _E.row(k) = _G.row(equalities[k]);
+            _e[k] = 0.5*(_lG[equalities[k]] + _uG[equalities[k]]);
+        }
+        Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(_E.transpose());
+        qr.setThreshold(_tolerance);
+        const unsigned int rank = qr.rank();
+        Eigen::MatrixXd Q = qr.householderQ();
+        _N = Q.rightCols(_x_size - rank);
+        _xp = _E.completeOrthogonalDecomposition().solve(_e);
+    }
+    else
+    {
+        _N.setIdentity(_x_size, _x_size);
+        _xp.setZero(_x_size);
+    }
+
+    // one sided inequalities on w, followed by the state limits
+    generateStateLimits();
+    const unsigned int n_w = _N.cols();
+    const unsigned int n_dw = upper.size() + lower.size();
+    const unsigned int n_h = _Hz.rows();
+    _D.resize(n_dw + n_h, n_w);
+    _d[0].resize(n_dw + n_h);
+    for(unsigned int k = 0; k < upper.size(); ++k)
+    {
+        _D.row(k) = _G.row(upper[k])*_N;
+        _d[0][k] = _uG[upper[k]] - _G.row(upper[k]).dot(_xp);
+    }
+    for(unsigned int k = 0; k < lower.size(); ++k)
+    {
+        _D.row(upper.size() + k) = -_G.row(lower[k])*_N;
+        _d[0][upper.size() + k] = _G.row(lower[k]).dot(_xp) - _lG[lower[k]];
+    }
+
+    // weighted sum of the levels, the references follow the predicted state
+    const unsigned int n_z = _Ad.rows();
+    const unsigned int dofs = n_z/2;
+    _Rx.setZero(_x_size, _x_size);
+    _rx.setZero(_x_size);
+    _Q.setZero(n_z, n_z);
+    _Sx.setZero(n_z, _x_size);
+    _qx.setZero(n_z);
+    for(unsigned int i = 0; i < _tasks.size(); ++i)
+    {
+        const double weight = std::pow(_weight_ratio, (double)(_tasks.size() - 1 - i));
+        const Eigen::MatrixXd& A = _tasks[i]->getA();
+        const Eigen::VectorXd& b = _tasks[i]->getb();
+        const bool identity_weight = _tasks[i]->getWeight().isIdentity();
+        if(identity_weight)
+            _WA = weight*A;
+        else
+            _WA.noalias() = weight*_tasks[i]->getWeight()*A;
+        _Rx.noalias() += A.transpose()*_WA;
+        _rx.noalias() -= _WA.transpose()*b;
+
+        if(_kp[i] > 0.0 || _kd[i] > 0.0)
+        {
+            _J.noalias() = A*_qddot.getM().transpose();
+            _C.resize(A.rows(), n_z);
+            _C.leftCols(dofs) = _kp[i]*_J;
+            _C.rightCols(dofs) = _kd[i]*_J;
+            if(identity_weight)
+                _WC = weight*_C;
+            else
+                _WC.noalias() = weight*_tasks[i]->getWeight()*_C;
+            _Q.noalias() += _C.transpose()*_WC;
+            _Sx.noalias() += _WC.transpose()*A;
+            _qx.noalias() -= _WC.transpose()*b;
+        }
+    }
+    _Rx.diagonal().array() += _regularisation;
+
+    _R.noalias() = _N.transpose()*_Rx*_N;
+    _r.noalias() = _N.transpose()*(_Rx*_xp + _rx);
+    _S.noalias() = _Sx*_N;
+    _q.noalias() = _qx + _Sx*_xp;
+    _Bw.noalias() = _Bx*_N;
+    _cw.noalias() = _Bx*_xp + _cx;
+
+    // Hz*(Ad*z_k + Bw*w_k + cw) <= h - (k+1)*hv
+    _D.bottomRows(n_h).noalias() = _Hz*_Bw;
+    _Dz.noalias() = _Hz*_Ad;
+    _h.noalias() -= _Hz*_cw;
+    for(unsigned int k = 0; k < _horizon; ++k)
+    {
+        _d[k].resize(n_dw + n_h);
+        if(k > 0)
+            _d[k].head(n_dw) = _d[0].head(n_dw);
+        _d[k].tail(n_h) = _h - (k + 1)*_hv;
+    }
+}
+
+void RecedingHorizon::initIterates()
+{
+    const unsigned int n_w = _N.cols();
+    const unsigned int n_d = _D.rows();
+
+    // the previous solution, shifted by one step
+    const bool warm_start = _x[0].size() == _x_size;
+    for(unsigned int k = 0; k < _horizon; ++k)
+    {
+        const unsigned int h = std::min(k + 1, _horizon - 1);
+        if(warm_start)
+            _w[k].noalias() = _N.transpose()*(_x[h] - _xp);
+        else
+            _w[k].setZero(n_w);
+
+        if(!warm_start || _lambda[h].size() != n_d)
+            _lambda[k].setOnes(n_d);
+        else if(h != k)
+            _lambda[k] = _lambda[h];
+    }
+
+    simulate();
+    const unsigned int n_h = _Dz.rows();
+    const double margin = warm_start ? 1e-2 : 1.0;
+    for(unsigned int k = 0; k < _horizon; ++k)
+    {
+        _s[k] = _d[k] - _D*_w[k];
+        if(n_h > 0)
+            _s[k].tail(n_h).noalias() -= _Dz*_z[k];
+        _s[k] = _s[k].cwiseMax(margin);
+        _lambda[k] = _lambda[k].cwiseMax(margin);
+    }
+}
+
+void RecedingHorizon::simulate()
+{
+    _z[0].setZero(_Ad.rows());
+    for(unsigned int k = 0; k < _horizon; ++k)
+        _z[k+1].noalias() = _Ad*_z[k] + _Bw*_w[k] + _cw;
+}
+
+double RecedingHorizon::computeGradients()
+{
+    double stationarity = 0.0;
+    _nu_next.setZero(_Ad.rows());
+    for(int k = _horizon - 1; k >= 0; --k)
+    {
+        _gz[k].noalias() = _Q*_z[k] + _S*_w[k] + _q;
+        _gw[k].noalias() = _S.transpose()*_z[k] + _R*_w[k] + _r;
+
+        // the gradient of the Lagrangian w.r.t. w_k, the costate nu_{k+1} accounts for the following steps
+        _rhat.noalias() = _gw[k] + _D.transpose()*_lambda[k] + _Bw.transpose()*_nu_next;
+        if(_rhat.size() > 0)
+            stationarity = std::max(stationarity, _rhat.lpNorm<Eigen::Infinity>());
+        _nu.noalias() = _gz[k] + _Ad.transpose()*_nu_next;
+        if(_Dz.rows() > 0)
+            _nu.noalias() += _Dz.transpose()*_lambda[k].tail(_Dz.rows());
+        _nu_next.swap(_nu);
+    }
+    return stationarity;
+}
+
+bool RecedingHorizon::factorize()
+{
+    _P[_horizon].setZero(_Ad.rows(), _Ad.rows());
+    for(int k = _horizon - 1; k >= 0; --k)
+    {
+        _sigma = _lambda[k].cwiseQuotient(_s[k]);
+        _PB.noalias() = _P[k+1]*_Bw;
+        _PA.noalias() = _P[k+1]*_Ad;
+
+        _Rhat = _R;
+        _Rhat.noalias() += _D.transpose()*_sigma.asDiagonal()*_D;
+        _Rhat.noalias() += _Bw.transpose()*_PB;
+        _Shat[k] = _S.transpose();
+        _Shat[k].noalias() += _Bw.transpose()*_PA;
+
+        _Rhat_llt[k].compute(_Rhat);
+        if(_Rhat_llt[k].info() != Eigen::Success){
+            XBot::Logger::error("in %s: step %i is not positive definite\n", __func__, k);
+            return false;}
+
+        const unsigned int n_h = _Dz.rows();
+        if(n_h > 0)
+            _Shat[k].noalias() += _D.bottomRows(n_h).transpose()*_sigma.tail(n_h).asDiagonal()*_Dz;
+
+        _K[k] = -_Rhat_llt[k].solve(_Shat[k]);
+        _P[k] = _Q;
+        if(n_h > 0)
+            _P[k].noalias() += _Dz.transpose()*_sigma.tail(n_h).asDiagonal()*_Dz;
+        _P[k].noalias() += _Ad.transpose()*_PA;
+        _P[k].noalias() += _Shat[k].transpose()*_K[k];
+        _P[k] = 0.5*(_P[k] + _P[k].transpose());
+    }
+    return true;
+}
+
+void RecedingHorizon::computeStep()
+{
+    // Newton step of the barrier problem, the slacks and multipliers are eliminated at each step
+    const unsigned int n_h = _Dz.rows();
+    _p[_horizon].setZero(_Ad.rows());
+    for(int k = _horizon - 1; k >= 0; --k)
+    {
+        _sigma = (_lambda[k].cwiseProduct(_rp[k]) - _rc[k]).cwiseQuotient(_s[k]) + _lambda[k];
+        _rhat.noalias() = _gw[k] + _D.transpose()*_sigma + _Bw.transpose()*_p[k+1];
+        _k[k] = -_Rhat_llt[k].solve(_rhat);
+        _p[k].noalias() = _gz[k] + _Ad.transpose()*_p[k+1] + _Shat[k].transpose()*_k[k];
+        if(n_h > 0)
+            _p[k].noalias() += _Dz.transpose()*_sigma.tail(n_h);
+    }
+
+    _dz.setZero(_Ad.rows());
+    for(unsigned int k = 0; k < _horizon; ++k)
+    {
+        _dw[k].noalias() = _K[k]*_dz + _k[k];
+        _ds[k].noalias() = -_rp[k] - _D*_dw[k];
+        if(n_h > 0)
+            _ds[k].tail(n_h).noalias() -= _Dz*_dz;
+        _dz = _Ad*_dz + _Bw*_dw[k];
+        _dlambda[k] = -(_rc[k] + _lambda[k].cwiseProduct(_ds[k])).cwiseQuotient(_s[k]);
+    }
+}
+
+double RecedingHorizon::stepLength()
+{
+    double alpha = std::numeric_limits<double>::max();
+    for(unsigned int k = 0; k < _horizon; ++k)
+    {
+        for(unsigned int r = 0; r < _s[k].size(); ++r)
+        {
+            if(_ds[k][r] < 0.0)
+                alpha = std::min(alpha, -_s[k][r]/_ds[k][r]);
+            if(_dlambda[k][r] < 0.0)
+                alpha = std::min(alpha, -_lambda[k][r]/_dlambda[k][r]);
+        }
+    }
+    return alpha;
+}
+
+bool RecedingHorizon::solve(Eigen::VectorXd& solution)
+{
+    generateProblem();
+    initIterates();
+
+    const unsigned int n_d = _D.rows();
+    const unsigned int n_h = _Dz.rows();
+    if(_horizon > 1 && n_h == 0 && !_decoupled_warned &&
+       *std::max_element(_kp.begin(), _kp.end()) <= 0.0 && *std::max_element(_kd.begin(), _kd.end()) <= 0.0)
+    {
+        XBot::Logger::warning("in %s: no level has feedback gains and no state limits are set, "
+                              "the steps of the horizon are independent copies of the same problem\n", __func__);
+        _decoupled_warned = true;
+    }
+    bool converged = false;
+    for(_iterations = 0; _iterations < _max_iterations; ++_iterations)
+    {
+        simulate();
+        const double stationarity = computeGradients();
+
+        double mu = 0.0, feasibility = 0.0;
+        for(unsigned int k = 0; k < _horizon; ++k)
+        {
+            _rp[k].noalias() = _D*_w[k] + _s[k] - _d[k];
+            if(n_h > 0)
+                _rp[k].tail(n_h).noalias() += _Dz*_z[k];
+            mu += _s[k].dot(_lambda[k]);
+            if(n_d > 0)
+                feasibility = std::max(feasibility, _rp[k].lpNorm<Eigen::Infinity>());
+        }
+        if(n_d > 0)
+            mu /= _horizon*n_d;
+
+        if(stationarity <= _tolerance && feasibility <= _tolerance && mu <= _tolerance)
+        {
+            converged = true;
+            break;
+        }
+
+        if(!factorize())
+            return false;
+
+        // predictor
+        for(unsigned int k = 0; k < _horizon; ++k)
+            _rc[k] = _s[k].cwiseProduct(_lambda[k]);
+        computeStep();
+
+        // corrector, centering as in Mehrotra
+        if(n_d > 0)
+        {
+            const double alpha = std::min(1.0, stepLength());
+            double mu_affine = 0.0;
+            for(unsigned int k = 0; k < _horizon; ++k)
+                mu_affine += (_s[k] + alpha*_ds[k]).dot(_lambda[k] + alpha*_dlambda[k]);
+            mu_affine /= _horizon*n_d;
+            const double sigma = std::pow(mu_affine/mu, 3);
+
+            for(unsigned int k = 0; k < _horizon; ++k)
+            {
+                _rc[k] += _ds[k].cwiseProduct(_dlambda[k]);
+                _rc[k].array() -= sigma*mu;
+            }
+            computeStep();
+        }
+
+        const double alpha = n_d > 0 ? std::min(1.0, 0.995*stepLength()) : 1.0;
+        for(unsigned int k = 0; k < _horizon; ++k)
+        {
+            _w[k] += alpha*_dw[k];
+            _s[k] += alpha*_ds[k];
+            _lambda[k] += alpha*_dlambda[k];
+        }
+    }
+
+    if(!converged){
+        XBot::Logger::error("in %s: no convergence in %i iterations\n", __func__, _max_iterations);
+        _x[0].resize(0);
+        return false;}
+
+    for(unsigned int k = 0; k < _horizon; ++k)
+        _x[k].noalias() = _xp + _N*_w[k];
+    solution = _x[0];
+    return true;
+}
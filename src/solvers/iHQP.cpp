@@ -2,19 +2,30 @@
 #include <OpenSoT/solvers/iHQP.h>
 #include <OpenSoT/constraints/BilateralConstraint.h>
 #include <XBotInterface/Logger.hpp>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <cmath>
 
 using namespace OpenSoT::solvers;
 
 iHQP::iHQP(Stack &stack_of_tasks, const double eps_regularisation,const solver_back_ends be_solver):
     Solver(stack_of_tasks),
     _epsRegularisation(eps_regularisation),
-    _be_solver(be_solver)
+    _be_solver(be_solver),
+    _be_solvers(stack_of_tasks.size(), be_solver),
+    _autotune_cycles(0),
+    _autotune_tolerance(0.0),
+    _presolve_enabled(false),
+    _presolve_margin(0.1),
+    _cycle(0)
 {
-    for(unsigned int i = 0; i < stack_of_tasks.size(); ++i)
-        _active_stacks.push_back(true);
+    initLevels(0, 0, 1.0);
 
     if(!prepareSoT(be_solver))
         throw std::runtime_error("Can Not initizalize SoT!");
+
+    initOutputPort();
 }
 
 iHQP::iHQP(Stack &stack_of_tasks,
@@ -22,13 +33,20 @@ iHQP::iHQP(Stack &stack_of_tasks,
                          const double eps_regularisation,const solver_back_ends be_solver):
     Solver(stack_of_tasks, bounds),
     _epsRegularisation(eps_regularisation),
-    _be_solver(be_solver)
+    _be_solver(be_solver),
+    _be_solvers(stack_of_tasks.size(), be_solver),
+    _autotune_cycles(0),
+    _autotune_tolerance(0.0),
+    _presolve_enabled(false),
+    _presolve_margin(0.1),
+    _cycle(0)
 {
-    for(unsigned int i = 0; i < stack_of_tasks.size(); ++i)
-        _active_stacks.push_back(true);
+    initLevels(0, 0, 1.0);
 
     if(!prepareSoT(be_solver))
         throw std::runtime_error("Can Not initizalize SoT with bounds!");
+
+    initOutputPort();
 }
 
 iHQP::iHQP(Stack &stack_of_tasks,
@@ -37,13 +55,20 @@ iHQP::iHQP(Stack &stack_of_tasks,
                          const double eps_regularisation,const solver_back_ends be_solver):
     Solver(stack_of_tasks, bounds, globalConstraints),
     _epsRegularisation(eps_regularisation),
-    _be_solver(be_solver)
+    _be_solver(be_solver),
+    _be_solvers(stack_of_tasks.size(), be_solver),
+    _autotune_cycles(0),
+    _autotune_tolerance(0.0),
+    _presolve_enabled(false),
+    _presolve_margin(0.1),
+    _cycle(0)
 {
-    for(unsigned int i = 0; i < stack_of_tasks.size(); ++i)
-        _active_stacks.push_back(true);
+    initLevels(0, 0, 1.0);
 
     if(!prepareSoT(be_solver))
         throw std::runtime_error("Can Not initizalize SoT with bounds!");
+
+    initOutputPort();
 }
 
 void iHQP::computeCostFunction(const TaskPtr& task, Eigen::MatrixXd& H, Eigen::VectorXd& g)
@@ -67,6 +92,282 @@ void iHQP::computeCostFunction(const TaskPtr& task, Eigen::MatrixXd& H, Eigen::V
     }
 }
 
+void iHQP::computeCostFunction(const unsigned int i, Eigen::MatrixXd& H, Eigen::VectorXd& g)
+{
+    const vector<unsigned int>& levels = _qp_levels[i];
+    computeCostFunction(_tasks[levels[0]], H, g);
+    if(levels.size() == 1)
+        return;
+
+    H *= _level_weights[levels[0]];
+    g *= _level_weights[levels[0]];
+    for(unsigned int k = 1; k < levels.size(); ++k)
+    {
+        computeCostFunction(_tasks[levels[k]], _H_level, _g_level);
+        H += _level_weights[levels[k]]*_H_level;
+        g += _level_weights[levels[k]]*_g_level;
+    }
+}
+
+OpenSoT::HessianType iHQP::getHessianType(const unsigned int i)
+{
+    // a weighted sum of hessians is not an identity, qpOASES checks it
+    if(_qp_levels[i].size() > 1)
+        return OpenSoT::HST_UNKNOWN;
+    return (OpenSoT::HessianType)(_tasks[_qp_levels[i][0]]->getHessianAtype());
+}
+
+void iHQP::initLevels(const unsigned int first, const unsigned int last, const double weight_ratio)
+{
+    _soft_first = first;
+    _soft_last = last;
+    _soft_ratio = weight_ratio;
+
+    _qp_levels.clear();
+    _level_qp.resize(_tasks.size());
+    _level_weights.assign(_tasks.size(), 1.0);
+    for(unsigned int i = 0; i < _tasks.size(); ++i)
+    {
+        // the levels from first to last are solved by the same problem
+        if(i <= first || i > last)
+            _qp_levels.push_back(vector<unsigned int>());
+        _qp_levels.back().push_back(i);
+        _level_qp[i] = _qp_levels.size() - 1;
+    }
+
+    // the weights are scaled exponentially, the last weighted level has weight 1
+    for(unsigned int i = first; i <= last && i < _tasks.size(); ++i)
+        _level_weights[i] = std::pow(weight_ratio, (double)(last - i));
+
+    _active_stacks.assign(_qp_levels.size(), true);
+}
+
+bool iHQP::setSoftPriorities(const unsigned int first, const unsigned int last, const double weight_ratio)
+{
+    if(first > last || last >= _tasks.size() || weight_ratio <= 0.0){
+        XBot::Logger::error("in %s: levels %i to %i can not be weighted\n", __func__, first, last);
+        return false;}
+
+    initLevels(first, last, weight_ratio);
+
+    _qp_stack_of_tasks.clear();
+    constraints_task.clear();
+    _be_solvers.assign(_qp_levels.size(), _be_solver);
+    _autotune_candidates.clear();
+    _autotune_cycles = 0;
+    if(!prepareSoT(_be_solver))
+        return false;
+
+    if(_recorder)
+        setRecorder(_recorder);
+    return true;
+}
+
+bool iHQP::setTask(const unsigned int level, TaskPtr task)
+{
+    if(level >= _tasks.size() || !task || task->getXSize() != _tasks[level]->getXSize()){
+        XBot::Logger::error("in %s: task can not be set at level %i\n", __func__, level);
+        return false;}
+
+    StackState state;
+    saveStackState(state);
+
+    const unsigned int i = _level_qp[level];
+    const OpenSoT::HessianType hessian_type = getHessianType(i);
+    // the optimality constraints of the problems below change size only with the rows of the task
+    const bool resized = task->getA().rows() != _tasks[level]->getA().rows();
+    _tasks[level] = task;
+    if(getHessianType(i) != hessian_type)
+        _qp_stack_of_tasks[i].reset();
+
+    return rebuildProblems(i, resized ? _qp_levels.size() : i+1, state);
+}
+
+bool iHQP::insertTask(const unsigned int level, TaskPtr task)
+{
+    if(level > _tasks.size() || !task || task->getXSize() != _tasks[0]->getXSize()){
+        XBot::Logger::error("in %s: task can not be inserted at level %i\n", __func__, level);
+        return false;}
+
+    StackState state;
+    saveStackState(state);
+
+    const unsigned int i = level < _tasks.size() ? _level_qp[level] : _qp_levels.size();
+
+    // a level inserted after the first weighted level is weighted too
+    unsigned int first = _soft_first, last = _soft_last;
+    const bool weighted = first < last && level > first && level <= last;
+    if(first < last && level <= first){
+        ++first; ++last;}
+    else if(weighted)
+        ++last;
+
+    std::vector<bool> active_stacks = _active_stacks;
+    _tasks.insert(_tasks.begin() + level, task);
+    initLevels(first, last, _soft_ratio);
+
+    if(!weighted)
+    {
+        _qp_stack_of_tasks.insert(_qp_stack_of_tasks.begin() + i, BackEnd::Ptr());
+        _row_keys.insert(_row_keys.begin() + i, std::vector<std::size_t>());
+        constraints_task.insert(constraints_task.begin() + i, constraints_task[std::min<unsigned int>(i, constraints_task.size()-1)]);
+        _be_solvers.insert(_be_solvers.begin() + i, _be_solver);
+        active_stacks.insert(active_stacks.begin() + i, true);
+    }
+    _active_stacks = active_stacks;
+
+    return rebuildProblems(i, _qp_levels.size(), state);
+}
+
+bool iHQP::removeTask(const unsigned int level)
+{
+    if(level >= _tasks.size() || _tasks.size() == 1){
+        XBot::Logger::error("in %s: level %i can not be removed\n", __func__, level);
+        return false;}
+
+    StackState state;
+    saveStackState(state);
+
+    const unsigned int i = _level_qp[level];
+    const bool weighted = _qp_levels[i].size() > 1;
+    const OpenSoT::HessianType hessian_type = getHessianType(i);
+
+    unsigned int first = _soft_first, last = _soft_last;
+    if(first < last && level < first){
+        --first; --last;}
+    else if(weighted)
+        --last;
+    if(first == last)
+        first = last = 0;
+
+    std::vector<bool> active_stacks = _active_stacks;
+    _tasks.erase(_tasks.begin() + level);
+    initLevels(first, last, _soft_ratio);
+
+    if(!weighted)
+    {
+        _qp_stack_of_tasks.erase(_qp_stack_of_tasks.begin() + i);
+        _row_keys.erase(_row_keys.begin() + i);
+        constraints_task.erase(constraints_task.begin() + i);
+        _be_solvers.erase(_be_solvers.begin() + i);
+        active_stacks.erase(active_stacks.begin() + i);
+    }
+    else if(getHessianType(i) != hessian_type)
+        _qp_stack_of_tasks[i].reset();
+    _active_stacks = active_stacks;
+
+    return rebuildProblems(i, _qp_levels.size(), state);
+}
+
+bool iHQP::addConstraint(const unsigned int level, ConstraintPtr constraint)
+{
+    if(level >= _tasks.size() || !constraint || constraint->getXSize() != _tasks[level]->getXSize()){
+        XBot::Logger::error("in %s: constraint can not be added at level %i\n", __func__, level);
+        return false;}
+
+    StackState state;
+    saveStackState(state);
+
+    _tasks[level]->getConstraints().push_back(constraint);
+    return rebuildProblems(_level_qp[level], _level_qp[level]+1, state);
+}
+
+bool iHQP::removeConstraint(const unsigned int level, ConstraintPtr constraint)
+{
+    if(level >= _tasks.size()){
+        XBot::Logger::error("in %s: level %i is not in the stack\n", __func__, level);
+        return false;}
+
+    std::list<ConstraintPtr>& constraints = _tasks[level]->getConstraints();
+    std::list<ConstraintPtr>::iterator it = std::find(constraints.begin(), constraints.end(), constraint);
+    if(it == constraints.end()){
+        XBot::Logger::error("in %s: constraint is not at level %i\n", __func__, level);
+        return false;}
+
+    StackState state;
+    saveStackState(state);
+
+    constraints.erase(it);
+    return rebuildProblems(_level_qp[level], _level_qp[level]+1, state);
+}
+
+void iHQP::saveStackState(StackState& state) const
+{
+    state.tasks = _tasks;
+    state.task_constraints.resize(_tasks.size());
+    for(unsigned int i = 0; i < _tasks.size(); ++i)
+        state.task_constraints[i] = _tasks[i]->getConstraints();
+    state.qp_levels = _qp_levels;
+    state.level_qp = _level_qp;
+    state.level_weights = _level_weights;
+    state.soft_first = _soft_first;
+    state.soft_last = _soft_last;
+    state.soft_ratio = _soft_ratio;
+    state.active_stacks = _active_stacks;
+    state.qp_stack_of_tasks = _qp_stack_of_tasks;
+    state.row_keys = _row_keys;
+    state.constraints_task = constraints_task;
+    state.be_solvers = _be_solvers;
+    state.presolve = _presolve;
+}
+
+void iHQP::restoreStackState(const StackState& state)
+{
+    _tasks = state.tasks;
+    for(unsigned int i = 0; i < _tasks.size(); ++i)
+        _tasks[i]->getConstraints() = state.task_constraints[i];
+    _qp_levels = state.qp_levels;
+    _level_qp = state.level_qp;
+    _level_weights = state.level_weights;
+    _soft_first = state.soft_first;
+    _soft_last = state.soft_last;
+    _soft_ratio = state.soft_ratio;
+    _active_stacks = state.active_stacks;
+    _qp_stack_of_tasks = state.qp_stack_of_tasks;
+    _row_keys = state.row_keys;
+    constraints_task = state.constraints_task;
+    _be_solvers = state.be_solvers;
+    _presolve = state.presolve;
+}
+
+bool iHQP::rebuildProblems(const unsigned int first, const unsigned int last, const StackState& state)
+{
+    _autotune_candidates.clear();
+    _autotune_cycles = 0;
+
+    tmp_A.resize(_tasks.size());
+    tmp_lA.resize(_tasks.size());
+    tmp_uA.resize(_tasks.size());
+    _presolve.resize(_qp_levels.size(), Presolve(_presolve_margin));
+
+    std::vector<std::size_t> previous_keys;
+    for(unsigned int i = first; i < last; ++i)
+    {
+        _presolve[i] = Presolve(_presolve_margin);
+        previous_keys = _row_keys[i];
+        if(!initProblem(i, _qp_stack_of_tasks[i], previous_keys))
+        {
+            XBot::Logger::error("in %s: problem %i can not be initialized, the stack is restored\n", __func__, i);
+            restoreStackState(state);
+            tmp_A.resize(_tasks.size());
+            tmp_lA.resize(_tasks.size());
+            tmp_uA.resize(_tasks.size());
+            for(unsigned int k = first; k < _qp_levels.size(); ++k)
+            {
+                previous_keys = _row_keys[k];
+                initProblem(k, _qp_stack_of_tasks[k], previous_keys);
+            }
+            if(_recorder)
+                setRecorder(_recorder);
+            return false;
+        }
+    }
+
+    if(_recorder)
+        setRecorder(_recorder);
+    return true;
+}
+
 void iHQP::computeOptimalityConstraint(  const TaskPtr& task, BackEnd::Ptr& problem,
                                                 Eigen::MatrixXd& A, Eigen::VectorXd& lA, Eigen::VectorXd& uA)
 {
@@ -78,118 +379,229 @@ void iHQP::computeOptimalityConstraint(  const TaskPtr& task, BackEnd::Ptr& prob
 bool iHQP::prepareSoT(const solver_back_ends be_solver)
 {
     XBot::Logger::info("#USING BACK-END: %s\n", getBackEndName().c_str());
-    for(unsigned int i = 0; i < _tasks.size(); ++i)
+    tmp_A.resize(_tasks.size());
+    tmp_lA.resize(_tasks.size());
+    tmp_uA.resize(_tasks.size());
+    _presolve.assign(_qp_levels.size(), Presolve(_presolve_margin));
+    _row_keys.clear();
+    for(unsigned int i = 0; i < _qp_levels.size(); ++i)
     {
-        computeCostFunction(_tasks[i], H, g);
+        if(!initProblem(i, BackEnd::Ptr(), std::vector<std::size_t>()))
+            return false;
+    }
+    return true;
+}
 
-        OpenSoT::constraints::Aggregated constraints_task_i(_tasks[i]->getConstraints(), _tasks[i]->getXSize());
-        if(_globalConstraints){
-            constraints_task_i.getConstraintsList().push_back(_globalConstraints);
-            constraints_task_i.generateAll();}
-        else if(_bounds && _bounds->isConstraint())
-        {
-            constraints_task_i.getConstraintsList().push_back(_bounds);
-            constraints_task_i.generateAll();
-        }
+bool iHQP::initProblem(const unsigned int i, BackEnd::Ptr previous, const std::vector<std::size_t>& previous_keys)
+{
+    computeCostFunction(i, H, g);
 
-        std::string constraints_str = constraints_task_i.getConstraintID();
+    // the constraints of all the levels solved by the i-th problem
+    std::list<ConstraintPtr> constraints_list;
+    std::string problem_str = "";
+    for(unsigned int k = 0; k < _qp_levels[i].size(); ++k)
+    {
+        const TaskPtr& task = _tasks[_qp_levels[i][k]];
+        constraints_list.insert(constraints_list.end(), task->getConstraints().begin(), task->getConstraints().end());
+        if(k > 0)
+            problem_str = problem_str + "+";
+        problem_str = problem_str + task->getTaskID();
+    }
 
-        A.set(constraints_task_i.getAineq());
-        lA.set(constraints_task_i.getbLowerBound());
-        uA.set(constraints_task_i.getbUpperBound());
-        if(i > 0)
-        {
-            Eigen::MatrixXd _tmp_A;
-            Eigen::VectorXd _tmp_lA, _tmp_uA;
-            for(unsigned int j = 0; j < i; ++j)
-            {
-                computeOptimalityConstraint(_tasks[j], _qp_stack_of_tasks[j], _tmp_A, _tmp_lA, _tmp_uA);
+    OpenSoT::constraints::Aggregated constraints_task_i(constraints_list, _tasks[_qp_levels[i][0]]->getXSize());
+    if(_globalConstraints){
+        constraints_task_i.getConstraintsList().push_back(_globalConstraints);
+        constraints_task_i.generateAll();}
+    else if(_bounds && _bounds->isConstraint())
+    {
+        constraints_task_i.getConstraintsList().push_back(_bounds);
+        constraints_task_i.generateAll();
+    }
 
-                if( j == i-1)
-                {
-                    tmp_A.push_back(_tmp_A);
-                    tmp_lA.push_back(_tmp_lA);
-                    tmp_uA.push_back(_tmp_uA);
-                }
+    std::string constraints_str = constraints_task_i.getConstraintID();
 
-                if(!constraints_str.compare("") == 0)
-                    constraints_str = constraints_str + "+";
-                constraints_str = constraints_str + _tasks[j]->getTaskID() + "_optimality";
+    A.set(constraints_task_i.getAineq());
+    lA.set(constraints_task_i.getbLowerBound());
+    uA.set(constraints_task_i.getbUpperBound());
+    for(unsigned int j = 0; j < _qp_levels[i][0]; ++j)
+    {
+        computeOptimalityConstraint(_tasks[j], _qp_stack_of_tasks[_level_qp[j]], tmp_A[j], tmp_lA[j], tmp_uA[j]);
 
-                A.pile(tmp_A[j]);
-                lA.pile(tmp_lA[j]);
-                uA.pile(tmp_uA[j]);
-            }
-        }
+        if(!constraints_str.compare("") == 0)
+            constraints_str = constraints_str + "+";
+        constraints_str = constraints_str + _tasks[j]->getTaskID() + "_optimality";
 
-        if(_bounds && _bounds->isBound()){   // if it is a constraint, it has already been added in #74
-            constraints_task_i.getConstraintsList().push_back(_bounds);
-            constraints_task_i.generateAll();}
-        l = constraints_task_i.getLowerBound();
-        u = constraints_task_i.getUpperBound();
+        A.pile(tmp_A[j]);
+        lA.pile(tmp_lA[j]);
+        uA.pile(tmp_uA[j]);
+    }
 
-//        QPOasesBackEnd problem_i(_tasks[i]->getXSize(), A.rows(), (OpenSoT::HessianType)(_tasks[i]->getHessianAtype()),
-//                                 _epsRegularisation);
-        BackEnd::Ptr problem_i = BackEndFactory(be_solver,_tasks[i]->getXSize(), A.rows(), (OpenSoT::HessianType)(_tasks[i]->getHessianAtype()),
-                                           _epsRegularisation);
-
-        if(problem_i->initProblem(H, g, A.generate_and_get(), lA.generate_and_get(), uA.generate_and_get(), l, u)){
-            _qp_stack_of_tasks.push_back(problem_i);
-            std::string bounds_string = "";
-            if(_bounds)
-                bounds_string = _bounds->getConstraintID();
-            _qp_stack_of_tasks[i]->printProblemInformation(i, _tasks[i]->getTaskID(),
-                                                          constraints_str,
-                                                          bounds_string);}
-        else{
-            XBot::Logger::error("ERROR: INITIALIZING STACK %i \n", i);
-            return false;}
+    if(_bounds && _bounds->isBound()){   // if it is a constraint, it has already been added in #74
+        constraints_task_i.getConstraintsList().push_back(_bounds);
+        constraints_task_i.generateAll();}
+    l = constraints_task_i.getLowerBound();
+    u = constraints_task_i.getUpperBound();
 
+    if(i < constraints_task.size())
+        constraints_task[i] = constraints_task_i;
+    else
         constraints_task.push_back(constraints_task_i);
+    if(i >= _row_keys.size())
+        _row_keys.resize(i+1);
+    if(i >= _qp_stack_of_tasks.size())
+        _qp_stack_of_tasks.resize(i+1);
+
+    // the previous back-end keeps its working set on the rows with the same keys, see remapConstraints()
+    boost::any options;
+    if(previous)
+    {
+        _qp_stack_of_tasks[i] = previous;
+        _row_keys[i] = previous_keys;
+        _keys = constraints_task_i.getRowKeys();
+        remapConstraints(i, A.generate_and_get().rows());
+        if(previous->updateTask(H, g) &&
+           previous->updateConstraints(A.generate_and_get(), lA.generate_and_get(), uA.generate_and_get()) &&
+           (!constraints_task_i.hasBounds() || previous->updateBounds(l, u)))
+        {
+            _row_keys[i].swap(_keys);
+            return true;
+        }
+        options = previous->getOptions();
     }
+
+//        QPOasesBackEnd problem_i(_tasks[i]->getXSize(), A.rows(), getHessianType(i),
+//                                 _epsRegularisation);
+    BackEnd::Ptr problem_i = BackEndFactory(_be_solvers[i],_tasks[_qp_levels[i][0]]->getXSize(), A.rows(),
+                                       getHessianType(i), _epsRegularisation);
+    if(!options.empty())
+        problem_i->setOptions(options);
+
+    if(problem_i->initProblem(H, g, A.generate_and_get(), lA.generate_and_get(), uA.generate_and_get(), l, u)){
+        _qp_stack_of_tasks[i] = problem_i;
+        std::string bounds_string = "";
+        if(_bounds)
+            bounds_string = _bounds->getConstraintID();
+        _qp_stack_of_tasks[i]->printProblemInformation(i, problem_str,
+                                                      constraints_str,
+                                                      bounds_string);}
+    else{
+        XBot::Logger::error("ERROR: INITIALIZING STACK %i \n", i);
+        return false;}
+
+    _row_keys[i] = constraints_task_i.getRowKeys();
     return true;
 }
 
+void iHQP::initOutputPort()
+{
+    Output output;
+    output.solution.setZero(_tasks[0]->getXSize());
+    output.objectives.setZero(_qp_stack_of_tasks.size());
+    _output_port.reset(output);
+}
+
 bool iHQP::solve(Eigen::VectorXd &solution)
 {
-    for(unsigned int i = 0; i < _tasks.size(); ++i)
+    const bool success = solveProblems(solution);
+
+    Output& output = _output_port.getWriteBuffer();
+    output.solution = solution;
+    output.objectives.resize(_qp_stack_of_tasks.size());
+    for(unsigned int i = 0; i < _qp_stack_of_tasks.size(); ++i)
+        output.objectives[i] = success && _active_stacks[i] ? _qp_stack_of_tasks[i]->getObjective() :
+                                                              std::numeric_limits<double>::quiet_NaN();
+    output.success = success;
+    output.cycle = ++_cycle;
+    _output_port.publish();
+
+    return success;
+}
+
+bool iHQP::solveProblems(Eigen::VectorXd &solution)
+{
+    if(_recorder)
+        _recorder->startCycle();
+
+    for(unsigned int i = 0; i < _qp_levels.size(); ++i)
     {
         if(_active_stacks[i])
         {
-            computeCostFunction(_tasks[i], H, g);
+            if(!_qp_stack_of_tasks[i]){
+                XBot::Logger::error("in %s: problem %i has no back-end\n", __func__, i);
+                return false;}
+
+            computeCostFunction(i, H, g);
             if(!_qp_stack_of_tasks[i]->updateTask(H, g))
                 return false;
 
             OpenSoT::constraints::Aggregated& constraints_task_i = constraints_task[i];
             constraints_task_i.generateAll();
 
-            A.set(constraints_task_i.getAineq());
-            lA.set(constraints_task_i.getbLowerBound());
-            uA.set(constraints_task_i.getbUpperBound());
-            if(i > 0)
+            if(_presolve_enabled && constraints_task_i.hasBounds())
+            {
+                _presolve[i].compute(constraints_task_i.getAineq(), constraints_task_i.getbLowerBound(),
+                                     constraints_task_i.getbUpperBound(), constraints_task_i.getLowerBound(),
+                                     constraints_task_i.getUpperBound());
+                A.set(_presolve[i].getA());
+                lA.set(_presolve[i].getlA());
+                uA.set(_presolve[i].getuA());
+            }
+            else
+            {
+                A.set(constraints_task_i.getAineq());
+                lA.set(constraints_task_i.getbLowerBound());
+                uA.set(constraints_task_i.getbUpperBound());
+            }
+            for(unsigned int j = 0; j < _qp_levels[i][0]; ++j)
             {
-                for(unsigned int j = 0; j < i; ++j)
+                if(_active_stacks[_level_qp[j]])
+                    computeOptimalityConstraint(_tasks[j], _qp_stack_of_tasks[_level_qp[j]], tmp_A[j], tmp_lA[j], tmp_uA[j]);
+                else
                 {
-                    if(_active_stacks[j])
-                        computeOptimalityConstraint(_tasks[j], _qp_stack_of_tasks[j], tmp_A[j], tmp_lA[j], tmp_uA[j]);
-                    else
-                    {
-                        //Here we consider fake optimality constraints:
-                        //
-                        //    -1 <= 0x <= 1
-                        tmp_A[j].setZero(_tasks[j]->getA().rows(), _tasks[j]->getA().cols());
-                        tmp_lA[j].setConstant(_tasks[j]->getA().rows(), -1.0);
-                        tmp_uA[j].setConstant(_tasks[j]->getA().rows(), 1.0);
-                    }
-                    A.pile(tmp_A[j]);
-                    lA.pile(tmp_lA[j]);
-                    uA.pile(tmp_uA[j]);
+                    //Here we consider fake optimality constraints:
+                    //
+                    //    -1 <= 0x <= 1
+                    tmp_A[j].setZero(_tasks[j]->getA().rows(), _tasks[j]->getA().cols());
+                    tmp_lA[j].setConstant(_tasks[j]->getA().rows(), -1.0);
+                    tmp_uA[j].setConstant(_tasks[j]->getA().rows(), 1.0);
                 }
+                A.pile(tmp_A[j]);
+                lA.pile(tmp_lA[j]);
+                uA.pile(tmp_uA[j]);
+            }
+
+            // the keys of the rows passed to the back-end
+            const std::vector<std::size_t>& row_keys = constraints_task_i.getRowKeys();
+            if(_presolve_enabled && constraints_task_i.hasBounds())
+            {
+                _keys.clear();
+                for(unsigned int k = 0; k < _presolve[i].getRows().size(); ++k)
+                    _keys.push_back(row_keys[_presolve[i].getRows()[k]]);
+            }
+            else
+                _keys.assign(row_keys.begin(), row_keys.end());
+
+            const bool resized = A.generate_and_get().rows() != _qp_stack_of_tasks[i]->getNumConstraints();
+
+            // rows which appeared, disappeared or moved (also dropped by the presolve):
+            // the back-end keeps the working set of the same rows
+            if(_keys != _row_keys[i])
+            {
+                remapConstraints(i, A.generate_and_get().rows());
+                _row_keys[i].swap(_keys);
             }
 
             if(!_qp_stack_of_tasks[i]->updateConstraints(A.generate_and_get(),
                                     lA.generate_and_get(), uA.generate_and_get()))
-                return false;
+            {
+                // the back-ends which can not change their number of constraints are initialized again
+                if(!resized)
+                    return false;
+                if(!(constraints_task_i.hasBounds() ?
+                     resizeProblem(i, constraints_task_i.getLowerBound(), constraints_task_i.getUpperBound()) :
+                     resizeProblem(i, _qp_stack_of_tasks[i]->getl(), _qp_stack_of_tasks[i]->getu())))
+                    return false;
+            }
 
 
             if(constraints_task_i.hasBounds()) // bounds specified everywhere will work
@@ -198,7 +610,22 @@ bool iHQP::solve(Eigen::VectorXd &solution)
                     return false;
             }
 
-            if(!_qp_stack_of_tasks[i]->solve())
+            const bool recording = _recorder && _recorder->isRecording();
+            if(recording || _autotune_cycles > 0)
+            {
+                if(recording)
+                    _recorder->recordWarmStart(i, *_qp_stack_of_tasks[i]);
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                bool success = _qp_stack_of_tasks[i]->solve();
+                double solve_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if(recording)
+                    _recorder->record(i, *_qp_stack_of_tasks[i], success, solve_time);
+                if(_autotune_cycles > 0)
+                    autotuneProblem(i, success, solve_time);
+                if(!success)
+                    return false;
+            }
+            else if(!_qp_stack_of_tasks[i]->solve())
                 return false;
 
             solution = _qp_stack_of_tasks[i]->getSolution();
@@ -208,6 +635,9 @@ bool iHQP::solve(Eigen::VectorXd &solution)
             //Here we do nothing
         }
     }
+
+    if(_autotune_cycles > 0 && --_autotune_cycles == 0)
+        selectBackEnds();
     return true;
 }
 
@@ -260,7 +690,245 @@ void iHQP::_log(XBot::MatLogger::Ptr logger)
         _qp_stack_of_tasks[i]->log(logger,i);
 }
 
+void iHQP::_registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+{
+    for(unsigned int i = 0; i < _qp_stack_of_tasks.size(); ++i)
+        _qp_stack_of_tasks[i]->registerLog(logger,i);
+}
+
+void iHQP::_log(OpenSoT::utils::RTLogger::Ptr logger)
+{
+    for(unsigned int i = 0; i < _qp_stack_of_tasks.size(); ++i)
+        _qp_stack_of_tasks[i]->log(logger,i);
+}
+
+void iHQP::setRecorder(QPRecorder::Ptr recorder)
+{
+    _recorder = recorder;
+    if(!_recorder)
+        return;
+
+    for(unsigned int i = 0; i < _qp_stack_of_tasks.size(); ++i)
+        _recorder->registerProblem(i, *_qp_stack_of_tasks[i], _be_solvers[i],
+                                   getHessianType(i), _epsRegularisation);
+}
+
 std::string iHQP::getBackEndName()
 {
     return OpenSoT::solvers::whichBackEnd(_be_solver);
 }
+
+std::string iHQP::getBackEndName(const unsigned int i)
+{
+    if(i >= _be_solvers.size())
+        return "";
+    return OpenSoT::solvers::whichBackEnd(_be_solvers[i]);
+}
+
+bool iHQP::setBackEnd(const unsigned int i, const solver_back_ends be_solver, const boost::any& options)
+{
+    if(i >= _qp_stack_of_tasks.size()){
+        XBot::Logger::error("ERROR Index out of range! \n");
+        return false;}
+
+    const BackEnd::Ptr& actual = _qp_stack_of_tasks[i];
+    BackEnd::Ptr problem;
+    try{
+        problem = BackEndFactory(be_solver, actual->getNumVariables(), actual->getNumConstraints(),
+                                 getHessianType(i), _epsRegularisation);
+    }
+    catch(const std::exception& e){
+        XBot::Logger::error("in %s: %s\n", __func__, e.what());
+        return false;
+    }
+
+    if(!options.empty())
+        problem->setOptions(options);
+    if(!problem->initProblem(actual->getH(), actual->getg(), actual->getA(), actual->getlA(), actual->getuA(),
+                             actual->getl(), actual->getu())){
+        XBot::Logger::error("in %s: %s can not initialize stack %i\n", __func__, whichBackEnd(be_solver).c_str(), i);
+        return false;}
+
+    _qp_stack_of_tasks[i] = problem;
+    _be_solvers[i] = be_solver;
+    if(_recorder)
+        _recorder->registerProblem(i, *problem, be_solver, getHessianType(i),
+                                   _epsRegularisation);
+    return true;
+}
+
+void iHQP::autotune(const unsigned int cycles, const double tolerance)
+{
+    autotune(cycles, tolerance, getBackEndCandidates());
+}
+
+void iHQP::autotune(const unsigned int cycles, const double tolerance, const std::vector<BackEndCandidate>& candidates)
+{
+    _autotune_candidates.clear();
+    _autotune_cycles = cycles;
+    _autotune_tolerance = tolerance;
+    if(cycles == 0)
+        return;
+
+    _autotune_candidates.resize(_qp_stack_of_tasks.size());
+    for(unsigned int i = 0; i < _qp_stack_of_tasks.size(); ++i)
+    {
+        const BackEnd::Ptr& actual = _qp_stack_of_tasks[i];
+        _autotune_candidates[i].push_back(AutotuneCandidate(BackEndCandidate(_be_solvers[i], "actual "+getBackEndName(i)),
+                                                            actual));
+
+        for(unsigned int k = 0; k < candidates.size(); ++k)
+        {
+            BackEnd::Ptr problem;
+            try{
+                problem = BackEndFactory(candidates[k].back_end, actual->getNumVariables(), actual->getNumConstraints(),
+                                         getHessianType(i), _epsRegularisation);
+            }
+            catch(const std::exception& e){
+                XBot::Logger::warning("in %s: %s not available: %s\n", __func__, candidates[k].name.c_str(), e.what());
+                continue;
+            }
+
+            if(!candidates[k].options.empty())
+                problem->setOptions(candidates[k].options);
+            if(problem->initProblem(actual->getH(), actual->getg(), actual->getA(), actual->getlA(), actual->getuA(),
+                                    actual->getl(), actual->getu()))
+                _autotune_candidates[i].push_back(AutotuneCandidate(candidates[k], problem));
+        }
+    }
+}
+
+void iHQP::autotuneProblem(const unsigned int i, const bool success, const double solve_time)
+{
+    vector<AutotuneCandidate>& candidates = _autotune_candidates[i];
+    candidates[0].solve_time += solve_time;
+    ++candidates[0].samples;
+    candidates[0].valid = candidates[0].valid && success;
+    if(!success)
+        return;
+
+    // the candidates solve the same problems of the actual back-end, so that they are warm started in the same way
+    const BackEnd::Ptr& actual = _qp_stack_of_tasks[i];
+    for(unsigned int k = 1; k < candidates.size(); ++k)
+    {
+        AutotuneCandidate& candidate = candidates[k];
+        if(!candidate.valid)
+            continue;
+
+        if(!candidate.problem->updateProblem(actual->getH(), actual->getg(), actual->getA(), actual->getlA(),
+                                             actual->getuA(), actual->getl(), actual->getu()))
+        {
+            candidate.valid = false;
+            continue;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool candidate_success = candidate.problem->solve();
+        candidate.solve_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++candidate.samples;
+
+        candidate.valid = candidate_success &&
+                candidate.problem->getSolution().size() == actual->getSolution().size() &&
+                (candidate.problem->getSolution() - actual->getSolution()).lpNorm<Eigen::Infinity>() <= _autotune_tolerance;
+    }
+}
+
+void iHQP::selectBackEnds()
+{
+    for(unsigned int i = 0; i < _autotune_candidates.size(); ++i)
+    {
+        const vector<AutotuneCandidate>& candidates = _autotune_candidates[i];
+        int best = -1;
+        double best_time = 0.0;
+        for(unsigned int k = 0; k < candidates.size(); ++k)
+        {
+            if(!candidates[k].valid || candidates[k].samples == 0)
+                continue;
+            double mean_time = candidates[k].solve_time/candidates[k].samples;
+            XBot::Logger::info("Autotune stack %i: %s mean solve time %f us\n", i, candidates[k].candidate.name.c_str(),
+                               1e6*mean_time);
+            if(best < 0 || mean_time < best_time)
+            {
+                best = k;
+                best_time = mean_time;
+            }
+        }
+
+        if(best > 0)
+        {
+            _qp_stack_of_tasks[i] = candidates[best].problem;
+            _be_solvers[i] = candidates[best].candidate.back_end;
+            if(_recorder)
+                _recorder->registerProblem(i, *_qp_stack_of_tasks[i], _be_solvers[i],
+                                           getHessianType(i), _epsRegularisation);
+        }
+        if(best >= 0)
+            XBot::Logger::info("Autotune stack %i: using %s\n", i, candidates[best].candidate.name.c_str());
+    }
+    _autotune_candidates.clear();
+}
+
+void iHQP::setPresolve(const bool enable, const double margin)
+{
+    _presolve_enabled = enable;
+    _presolve_margin = margin;
+    _presolve.assign(_qp_levels.size(), Presolve(_presolve_margin));
+}
+
+unsigned int iHQP::getNumberOfDroppedConstraints(const unsigned int i) const
+{
+    if(!_presolve_enabled || i >= _presolve.size())
+        return 0;
+    return _presolve[i].getNumberOfDroppedRows();
+}
+
+bool iHQP::resizeProblem(const unsigned int i, const Eigen::VectorXd& l, const Eigen::VectorXd& u)
+{
+    const BackEnd::Ptr& actual = _qp_stack_of_tasks[i];
+    BackEnd::Ptr problem;
+    try{
+        problem = BackEndFactory(_be_solvers[i], actual->getNumVariables(), A.generate_and_get().rows(),
+                                 getHessianType(i), _epsRegularisation);
+    }
+    catch(const std::exception& e){
+        XBot::Logger::error("in %s: %s\n", __func__, e.what());
+        return false;
+    }
+
+    problem->setOptions(actual->getOptions());
+    if(!problem->initProblem(H, g, A.generate_and_get(), lA.generate_and_get(), uA.generate_and_get(), l, u)){
+        XBot::Logger::error("in %s: can not initialize stack %i with %i constraints\n", __func__, i,
+                            problem->getNumConstraints());
+        return false;}
+
+    _qp_stack_of_tasks[i] = problem;
+    if(_recorder)
+        _recorder->registerProblem(i, *problem, _be_solvers[i], getHessianType(i), _epsRegularisation);
+    return true;
+}
+
+void iHQP::remapConstraints(const unsigned int i, const unsigned int number_of_constraints)
+{
+    const std::vector<std::size_t>& actual_keys = _row_keys[i];
+    const int actual_constraints = _qp_stack_of_tasks[i]->getNumConstraints();
+
+    _sorted_keys.clear();
+    for(unsigned int k = 0; k < actual_keys.size(); ++k)
+        _sorted_keys.push_back(std::make_pair(actual_keys[k], k));
+    std::sort(_sorted_keys.begin(), _sorted_keys.end());
+
+    _row_map.assign(number_of_constraints, -1);
+    for(unsigned int k = 0; k < _keys.size(); ++k)
+    {
+        std::vector<std::pair<std::size_t, int> >::const_iterator it =
+                std::lower_bound(_sorted_keys.begin(), _sorted_keys.end(), std::make_pair(_keys[k], 0));
+        if(it != _sorted_keys.end() && it->first == _keys[k])
+            _row_map[k] = it->second;
+    }
+
+    // the optimality constraints follow the constraints
+    for(int k = _keys.size(), h = actual_keys.size(); k < number_of_constraints && h < actual_constraints; ++k, ++h)
+        _row_map[k] = h;
+
+    _qp_stack_of_tasks[i]->remapConstraints(_row_map);
+}
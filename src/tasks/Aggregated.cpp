@@ -77,11 +77,19 @@ void Aggregated::_update(const Eigen::VectorXd& x) {
     for(std::list< TaskPtr >::iterator i = _tasks.begin();
         i != _tasks.end(); ++i) {
         TaskPtr t = *i;
-        t->update(x);
+        t->scheduledUpdate(x);
     }
     this->generateAll();
 }
 
+bool Aggregated::applyReferences() {
+    bool applied = false;
+    for(std::list< TaskPtr >::iterator i = _tasks.begin();
+        i != _tasks.end(); ++i)
+        applied = (*i)->applyReferences() || applied;
+    return applied;
+}
+
 
 void Aggregated::checkSizes() {
     for(std::list< TaskPtr >::iterator i = _tasks.begin();
@@ -237,3 +245,15 @@ void OpenSoT::tasks::Aggregated::_log(XBot::MatLogger::Ptr logger)
     for(auto task : _tasks)
         task->log(logger);
 }
+
+void OpenSoT::tasks::Aggregated::_registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+{
+    for(auto task : _tasks)
+        task->registerLog(logger);
+}
+
+void OpenSoT::tasks::Aggregated::_log(OpenSoT::utils::RTLogger::Ptr logger)
+{
+    for(auto task : _tasks)
+        task->log(logger);
+}
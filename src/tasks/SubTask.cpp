@@ -102,7 +102,7 @@ const unsigned int OpenSoT::SubTask::getTaskSize() const
 
 void OpenSoT::SubTask::_update(const Eigen::VectorXd &x)
 {
-    _taskPtr->update(x);
+    _taskPtr->scheduledUpdate(x);
     this->generateA();
     this->generateb();
     this->generateHessianAtype();
@@ -119,7 +119,22 @@ bool OpenSoT::SubTask::setActiveJointsMask(const std::vector<bool> &active_joint
     return _taskPtr->setActiveJointsMask(active_joints_mask);
 }
 
+bool OpenSoT::SubTask::applyReferences()
+{
+    return _taskPtr->applyReferences();
+}
+
 void OpenSoT::SubTask::_log(XBot::MatLogger::Ptr logger)
 {
     _taskPtr->log(logger);
 }
+
+void OpenSoT::SubTask::_registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+{
+    _taskPtr->registerLog(logger);
+}
+
+void OpenSoT::SubTask::_log(OpenSoT::utils::RTLogger::Ptr logger)
+{
+    _taskPtr->log(logger);
+}
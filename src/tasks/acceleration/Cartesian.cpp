@@ -145,6 +145,27 @@ void OpenSoT::tasks::acceleration::Cartesian::setReference(const Eigen::Affine3d
     _acc_ref = acc_ref;
 }
 
+void OpenSoT::tasks::acceleration::Cartesian::setReferenceAsync(const Eigen::Affine3d& pose_ref,
+                                                                const Eigen::Vector6d& vel_ref,
+                                                                const Eigen::Vector6d& acc_ref)
+{
+    Reference& reference = _reference_port.getWriteBuffer();
+    reference.pose = pose_ref;
+    reference.vel = vel_ref;
+    reference.acc = acc_ref;
+    _reference_port.publish();
+}
+
+bool OpenSoT::tasks::acceleration::Cartesian::applyReferences()
+{
+    if(!_reference_port.update())
+        return false;
+
+    const Reference& reference = _reference_port.getReadBuffer();
+    setReference(reference.pose, reference.vel, reference.acc);
+    return true;
+}
+
 void OpenSoT::tasks::acceleration::Cartesian::setLambda(double lambda)
 {
     if(lambda < 0){
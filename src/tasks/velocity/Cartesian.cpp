@@ -124,6 +124,27 @@ void Cartesian::setReference(const Eigen::MatrixXd &desiredPose,
     this->update_b();
 }
 
+void Cartesian::setReferenceAsync(const Eigen::Affine3d& desiredPose,
+                                  const Eigen::Vector6d& desiredTwist)
+{
+    Reference& reference = _reference_port.getWriteBuffer();
+    reference.pose = desiredPose;
+    reference.twist = desiredTwist;
+    _reference_port.publish();
+}
+
+bool Cartesian::applyReferences()
+{
+    if(!_reference_port.update())
+        return false;
+
+    const Reference& reference = _reference_port.getReadBuffer();
+    _desiredPose = reference.pose;
+    _desiredTwist = reference.twist;
+    this->update_b();
+    return true;
+}
+
 void Cartesian::setReference(const KDL::Frame& desiredPose,
                   const KDL::Twist& desiredTwist)
 {
@@ -1,6 +1,9 @@
 #include <OpenSoT/tasks/velocity/Manipulability.h>
 #include <exception>
 #include <cmath>
+#include <urdf/model.h>
+#include <XBotInterface/Logger.hpp>
+#include <algorithm>
 
 using namespace OpenSoT::tasks::velocity;
 
@@ -8,7 +11,11 @@ Manipulability::Manipulability(const Eigen::VectorXd& x, const XBot::ModelInterf
                                const Cartesian::Ptr CartesianTask):
     Task("manipulability::"+CartesianTask->getTaskID(), x.size()),
     _manipulabilityIndexGradientWorker(x, robot_model, CartesianTask),
-    _x(x)
+    _x(x),
+    _analyticGradientWorker(x, _manipulabilityIndexGradientWorker._robot,
+                            CartesianTask->getDistalLink(), CartesianTask->getBaseLink()),
+    // the base columns of the analytic gradient are not validated against the numerical one
+    _gradient_type(robot_model.isFloatingBase() ? GRADIENT_NUMERICAL : GRADIENT_ANALYTIC)
 {
     _W.resize(_x_size, _x_size);
     _W.setIdentity(_x_size, _x_size);
@@ -27,7 +34,10 @@ Manipulability::Manipulability(const Eigen::VectorXd& x, const XBot::ModelInterf
                                const CoM::Ptr CartesianTask):
     Task("manipulability::"+CartesianTask->getTaskID(), x.size()),
     _manipulabilityIndexGradientWorker(x, robot_model,CartesianTask),
-    _x(x)
+    _x(x),
+    _analyticGradientWorker(x, _manipulabilityIndexGradientWorker._robot),
+    // the base columns of the analytic gradient are not validated against the numerical one
+    _gradient_type(robot_model.isFloatingBase() ? GRADIENT_NUMERICAL : GRADIENT_ANALYTIC)
 {
     _W.resize(_x_size, _x_size);
     _W.setIdentity(_x_size, _x_size);
@@ -52,7 +62,12 @@ void Manipulability::_update(const Eigen::VectorXd &x) {
     _x = x;
     /************************* COMPUTING TASK *****************************/
 
-    _b = _lambda*cartesian_utils::computeGradient(x, _manipulabilityIndexGradientWorker, this->getActiveJointsMask());
+    if(_gradient_type == GRADIENT_ANALYTIC)
+        _b = _lambda*_analyticGradientWorker.compute(x, _manipulabilityIndexGradientWorker.getW(), this->getActiveJointsMask());
+    else if(_parallelDifferentiation)
+        _b = _lambda*_parallelDifferentiation->computeGradient(x, this->getActiveJointsMask());
+    else
+        _b = _lambda*cartesian_utils::computeGradient(x, _manipulabilityIndexGradientWorker, this->getActiveJointsMask());
 
     /**********************************************************************/
 }
@@ -61,3 +76,264 @@ double Manipulability::ComputeManipulabilityIndex()
 {
     return _manipulabilityIndexGradientWorker.compute(_x);
 }
+
+void Manipulability::setNumberOfThreads(const unsigned int number_of_threads)
+{
+    _parallelDifferentiation.reset();
+    _parallelManipulabilityIndexGradientWorkers.clear();
+    if(number_of_threads <= 1)
+        return;
+
+    std::vector<CostFunction*> workers(1, &_manipulabilityIndexGradientWorker);
+    for(unsigned int i = 1; i < number_of_threads; ++i)
+    {
+        _parallelManipulabilityIndexGradientWorkers.push_back(_manipulabilityIndexGradientWorker.clone(_x));
+        workers.push_back(_parallelManipulabilityIndexGradientWorkers.back().get());
+    }
+    _parallelDifferentiation.reset(new OpenSoT::utils::ParallelDifferentiation(workers));
+}
+
+
+
+
+Manipulability::AnalyticManipulabilityIndexGradient::AnalyticManipulabilityIndexGradient(const Eigen::VectorXd& q,
+                                                                                        XBot::ModelInterface::Ptr robot,
+                                                                                        const std::string& distal_link,
+                                                                                        const std::string& base_link) :
+    _robot(robot),
+    _com(false),
+    _distal_link(distal_link)
+{
+    init(q);
+
+    // the relative Jacobian is the Jacobian of the serial chain base_link -> common ancestor -> distal_link:
+    // the joints moving base_link move the distal link in the opposite direction, the joints moving
+    // both the links do not contribute
+    std::vector<int> distal_dofs, base_dofs;
+    getDofs(_distal_link, distal_dofs);
+    if(base_link != "world")
+        getDofs(base_link, base_dofs);
+
+    unsigned int common = 0;
+    while(common < distal_dofs.size() && common < base_dofs.size() &&
+          distal_dofs[common] == base_dofs[common])
+        ++common;
+
+    for(int i = base_dofs.size()-1; i >= (int)common; --i)
+    {
+        _chain.push_back(base_dofs[i]);
+        _chain_sign.push_back(-1.0);
+    }
+    for(unsigned int i = common; i < distal_dofs.size(); ++i)
+    {
+        _chain.push_back(distal_dofs[i]);
+        _chain_sign.push_back(1.0);
+    }
+
+    // only the joints of the chain are needed
+    std::vector<Joint> joints;
+    for(unsigned int i = 0; i < _joints.size(); ++i)
+    {
+        if(std::find(_chain.begin(), _chain.end(), _joints[i].dof) != _chain.end())
+            joints.push_back(_joints[i]);
+    }
+    _joints.swap(joints);
+    if(std::find(_chain.begin(), _chain.end(), 0) == _chain.end())
+        _floating_base_link.clear();
+
+    _chain_omega.resize(3, _chain.size());
+    _chain_v.resize(3, _chain.size());
+}
+
+Manipulability::AnalyticManipulabilityIndexGradient::AnalyticManipulabilityIndexGradient(const Eigen::VectorXd& q,
+                                                                                        XBot::ModelInterface::Ptr robot) :
+    _robot(robot),
+    _com(true)
+{
+    init(q);
+}
+
+void Manipulability::AnalyticManipulabilityIndexGradient::init(const Eigen::VectorXd& q)
+{
+    _index = 0.0;
+    _gradient.setZero(q.size());
+    _omega.setZero(3, q.size());
+    _v.setZero(3, q.size());
+    _parent_dof.assign(q.size(), -1);
+
+    int root_dof = -1;
+    if(_robot->isFloatingBase())
+    {
+        _robot->getFloatingBaseLink(_floating_base_link);
+        for(unsigned int j = 1; j < 6; ++j)
+            _parent_dof[j] = j-1;
+        root_dof = 5;
+    }
+
+    addJoints(_robot->getUrdf().getRoot()->name, root_dof);
+}
+
+void Manipulability::AnalyticManipulabilityIndexGradient::addJoints(const std::string& link_name, const int parent_dof)
+{
+    boost::shared_ptr<const urdf::Link> link = _robot->getUrdf().getLink(link_name);
+
+    int dof = parent_dof;
+    // the frame of the joint is the frame of its child link
+    if(link->parent_joint && (link->parent_joint->type == urdf::Joint::REVOLUTE ||
+                              link->parent_joint->type == urdf::Joint::CONTINUOUS ||
+                              link->parent_joint->type == urdf::Joint::PRISMATIC))
+    {
+        Joint joint;
+        joint.link_name = link_name;
+        joint.dof = _robot->getDofIndex(link->parent_joint->name);
+        joint.prismatic = link->parent_joint->type == urdf::Joint::PRISMATIC;
+        joint.axis << link->parent_joint->axis.x,
+                      link->parent_joint->axis.y,
+                      link->parent_joint->axis.z;
+        if(joint.dof >= 0)
+        {
+            _joints.push_back(joint);
+            _parent_dof[joint.dof] = parent_dof;
+            dof = joint.dof;
+        }
+    }
+    _link_dof[link_name] = dof;
+
+    for(unsigned int i = 0; i < link->child_links.size(); ++i)
+        addJoints(link->child_links[i]->name, dof);
+}
+
+void Manipulability::AnalyticManipulabilityIndexGradient::getDofs(const std::string& link_name,
+                                                                  std::vector<int>& dofs) const
+{
+    dofs.clear();
+    std::map<std::string, int>::const_iterator it = _link_dof.find(link_name);
+    if(it == _link_dof.end())
+    {
+        XBot::Logger::error("in %s: link %s not found in the kinematic tree\n", __func__, link_name.c_str());
+        return;
+    }
+
+    for(int dof = it->second; dof >= 0; dof = _parent_dof[dof])
+        dofs.push_back(dof);
+    std::reverse(dofs.begin(), dofs.end());
+}
+
+void Manipulability::AnalyticManipulabilityIndexGradient::computeTwists()
+{
+    for(unsigned int i = 0; i < _joints.size(); ++i)
+    {
+        const Joint& joint = _joints[i];
+        _robot->getPose(joint.link_name, _T);
+
+        Eigen::Vector3d axis = _T.linear()*joint.axis;
+        if(joint.prismatic)
+        {
+            _omega.col(joint.dof).setZero();
+            _v.col(joint.dof) = axis;
+        }
+        else
+        {
+            _omega.col(joint.dof) = axis;
+            _v.col(joint.dof) = _T.translation().cross(axis);
+        }
+    }
+
+    // the floating base joints come from the jacobian of the floating base link
+    if(!_floating_base_link.empty())
+    {
+        _robot->getJacobian(_floating_base_link, _Jbase);
+        _robot->getPose(_floating_base_link, _T);
+        for(unsigned int j = 0; j < 6; ++j)
+        {
+            _omega.col(j) = _Jbase.block(3,j,3,1);
+            _v.col(j) = _Jbase.block(0,j,3,1) - _omega.col(j).cross(_T.translation());
+        }
+    }
+}
+
+bool Manipulability::AnalyticManipulabilityIndexGradient::computeIndex(const Eigen::MatrixXd& W)
+{
+    _A.noalias() = _J*W*_J.transpose();
+    //fabs is to avoid nan when we have -1e-18!
+    _index = std::sqrt(std::fabs(_A.determinant()));
+    if(_index < 1e-12)
+        return false;
+
+    // _B = A^-1 J W', column d of _B multiplies the partial derivatives of the column d of J
+    _A_ldlt.compute(_A);
+    _B.noalias() = _J*W.transpose();
+    _A_ldlt.solveInPlace(_B);
+    return true;
+}
+
+const Eigen::VectorXd& Manipulability::AnalyticManipulabilityIndexGradient::compute(const Eigen::VectorXd& q,
+                                                                                   const Eigen::MatrixXd& W,
+                                                                                   const std::vector<bool>& jointMask)
+{
+    _robot->setJointPosition(q);
+    _robot->update();
+
+    _gradient.setZero(q.size());
+
+    computeTwists();
+
+    if(_com)
+    {
+        _robot->getCOMJacobian(_J);
+        if(computeIndex(W))
+        {
+            // d J_d / d q_a = d J_a / d q_d = omega_a x J_d, for a ancestor of d
+            for(unsigned int d = 0; d < q.size(); ++d)
+            {
+                for(int a = d; a >= 0; a = _parent_dof[a])
+                {
+                    Eigen::Vector3d x = _omega.col(a).cross(_J.block<3,1>(0,d));
+                    _gradient[a] += _index*x.dot(_B.block<3,1>(0,d));
+                    if(a != (int)d)
+                        _gradient[d] += _index*x.dot(_B.block<3,1>(0,a));
+                }
+            }
+        }
+    }
+    else
+    {
+        _robot->getPose(_distal_link, _T);
+
+        _J.setZero(6, q.size());
+        for(unsigned int k = 0; k < _chain.size(); ++k)
+        {
+            const int d = _chain[k];
+            _chain_omega.col(k) = _chain_sign[k]*_omega.col(d);
+            _chain_v.col(k) = _chain_sign[k]*(_v.col(d) + _omega.col(d).cross(_T.translation()));
+            _J.block<3,1>(0,d) = _chain_v.col(k);
+            _J.block<3,1>(3,d) = _chain_omega.col(k);
+        }
+
+        if(computeIndex(W))
+        {
+            // d J_l / d q_k = (omega_k x v_l, omega_k x omega_l), d J_k / d q_l = (omega_k x v_l, 0), for k <= l
+            for(unsigned int l = 0; l < _chain.size(); ++l)
+            {
+                const int d = _chain[l];
+                for(unsigned int k = 0; k <= l; ++k)
+                {
+                    const int a = _chain[k];
+                    Eigen::Vector3d x = _chain_omega.col(k).cross(_chain_v.col(l));
+                    Eigen::Vector3d y = _chain_omega.col(k).cross(_chain_omega.col(l));
+                    _gradient[a] += _index*(x.dot(_B.block<3,1>(0,d)) + y.dot(_B.block<3,1>(3,d)));
+                    if(k != l)
+                        _gradient[d] += _index*x.dot(_B.block<3,1>(0,a));
+                }
+            }
+        }
+    }
+
+    for(unsigned int i = 0; i < _gradient.size(); ++i)
+    {
+        if(!jointMask[i])
+            _gradient[i] = 0.0;
+    }
+
+    return _gradient;
+}
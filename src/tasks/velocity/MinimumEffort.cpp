@@ -16,6 +16,7 @@
 */
 
 #include <OpenSoT/tasks/velocity/MinimumEffort.h>
+#include <urdf/model.h>
 #include <exception>
 #include <cmath>
 
@@ -23,7 +24,10 @@ using namespace OpenSoT::tasks::velocity;
 
 
 MinimumEffort::MinimumEffort(   const Eigen::VectorXd& x, const XBot::ModelInterface& robot_model) :
-    Task("min_effort", x.size()), _gTauGradientWorker(x, robot_model), _x(x)
+    Task("min_effort", x.size()), _gTauGradientWorker(x, robot_model), _x(x),
+    _analyticGradientWorker(x, _gTauGradientWorker._robot),
+    // the base columns of the analytic gradient are not validated against the numerical one
+    _gradient_type(robot_model.isFloatingBase() ? GRADIENT_NUMERICAL : GRADIENT_ANALYTIC)
 {
     _W.resize(_x_size, _x_size);
     _W.setIdentity(_x_size, _x_size);
@@ -47,7 +51,12 @@ void MinimumEffort::_update(const Eigen::VectorXd &x) {
     _x = x;
     /************************* COMPUTING TASK *****************************/
 
-    _b = -1.0 * _lambda * cartesian_utils::computeGradient(x, _gTauGradientWorker, this->getActiveJointsMask());
+    if(_gradient_type == GRADIENT_ANALYTIC)
+        _b = -1.0 * _lambda * _analyticGradientWorker.compute(x, _gTauGradientWorker.getW(), this->getActiveJointsMask());
+    else if(_parallelDifferentiation)
+        _b = -1.0 * _lambda * _parallelDifferentiation->computeGradient(x, this->getActiveJointsMask());
+    else
+        _b = -1.0 * _lambda * cartesian_utils::computeGradient(x, _gTauGradientWorker, this->getActiveJointsMask());
 
     /**********************************************************************/
 }
@@ -57,5 +66,191 @@ double MinimumEffort::computeEffort()
     return _gTauGradientWorker.compute(_x);
 }
 
+void MinimumEffort::setNumberOfThreads(const unsigned int number_of_threads)
+{
+    _parallelDifferentiation.reset();
+    _parallelGTauGradientWorkers.clear();
+    if(number_of_threads <= 1)
+        return;
+
+    std::vector<CostFunction*> workers(1, &_gTauGradientWorker);
+    for(unsigned int i = 1; i < number_of_threads; ++i)
+    {
+        _parallelGTauGradientWorkers.push_back(boost::shared_ptr<ComputeGTauGradient>(
+                                               new ComputeGTauGradient(_x, _gTauGradientWorker._model)));
+        _parallelGTauGradientWorkers.back()->setW(_gTauGradientWorker.getW());
+        workers.push_back(_parallelGTauGradientWorkers.back().get());
+    }
+    _parallelDifferentiation.reset(new OpenSoT::utils::ParallelDifferentiation(workers));
+}
+
+
+
+
+MinimumEffort::AnalyticGTauGradient::AnalyticGTauGradient(const Eigen::VectorXd& q, XBot::ModelInterface::Ptr robot) :
+    _robot(robot),
+    _tau(q.size()), _Wtau(q.size()), _gradient(q.size())
+{
+    if(_robot->isFloatingBase())
+        _robot->getFloatingBaseLink(_floating_base_link);
+
+    addBody(_robot->getUrdf().getRoot()->name, -1);
+
+    _M.resize(_bodies.size());
+    _S.resize(3, _bodies.size());
+    _omega.resize(3, _bodies.size());
+    _v.resize(3, _bodies.size());
+    _w.resize(3, _bodies.size());
+    _u.resize(3, _bodies.size());
+}
+
+void MinimumEffort::AnalyticGTauGradient::addBody(const std::string& link_name, const int parent)
+{
+    boost::shared_ptr<const urdf::Link> link = _robot->getUrdf().getLink(link_name);
+
+    Body body;
+    body.link_name = link_name;
+    body.parent = parent;
+    body.dof = -1;
+    body.prismatic = false;
+    body.mass = 0.0;
+    body.com.setZero();
+    body.axis.setZero();
+
+    if(link->inertial)
+    {
+        body.mass = link->inertial->mass;
+        body.com << link->inertial->origin.position.x,
+                    link->inertial->origin.position.y,
+                    link->inertial->origin.position.z;
+    }
+
+    // the frame of the joint is the frame of its child link
+    if(link->parent_joint && (link->parent_joint->type == urdf::Joint::REVOLUTE ||
+                              link->parent_joint->type == urdf::Joint::CONTINUOUS ||
+                              link->parent_joint->type == urdf::Joint::PRISMATIC))
+    {
+        body.dof = _robot->getDofIndex(link->parent_joint->name);
+        body.prismatic = link->parent_joint->type == urdf::Joint::PRISMATIC;
+        body.axis << link->parent_joint->axis.x,
+                     link->parent_joint->axis.y,
+                     link->parent_joint->axis.z;
+    }
+
+    int index = _bodies.size();
+    _bodies.push_back(body);
 
+    for(unsigned int i = 0; i < link->child_links.size(); ++i)
+        addBody(link->child_links[i]->name, index);
+}
+
+void MinimumEffort::AnalyticGTauGradient::accumulate(const int a, const int d, const double h)
+{
+    // the hessian of the gravitational potential is symmetric
+    _gradient[a] += 2.0*h*_Wtau[d];
+    if(a != d)
+        _gradient[d] += 2.0*h*_Wtau[a];
+}
+
+const Eigen::VectorXd& MinimumEffort::AnalyticGTauGradient::compute(const Eigen::VectorXd& q,
+                                                                    const Eigen::MatrixXd& W,
+                                                                    const std::vector<bool>& jointMask)
+{
+    _robot->setJointPosition(q);
+    _robot->update();
+    _robot->getGravity(_g);
+
+    _tau.setZero(q.size());
+    _gradient.setZero(q.size());
+
+    // forward pass: link poses, joint twists and mass properties of the links
+    Eigen::Vector3d v;
+    for(unsigned int i = 0; i < _bodies.size(); ++i)
+    {
+        const Body& body = _bodies[i];
+        _robot->getPose(body.link_name, _T);
+
+        _M[i] = body.mass;
+        _S.col(i) = body.mass*(_T*body.com);
+        _omega.col(i).setZero();
+        _v.col(i).setZero();
+        if(body.dof >= 0)
+        {
+            Eigen::Vector3d axis = _T.linear()*body.axis;
+            if(body.prismatic)
+                _v.col(i) = axis;
+            else
+            {
+                _omega.col(i) = axis;
+                _v.col(i) = _T.translation().cross(axis);
+            }
+        }
+    }
 
+    // backward pass: mass and first moment of mass of the subtrees
+    for(int i = _bodies.size()-1; i > 0; --i)
+    {
+        _M[_bodies[i].parent] += _M[i];
+        _S.col(_bodies[i].parent) += _S.col(i);
+    }
+
+    for(unsigned int i = 0; i < _bodies.size(); ++i)
+    {
+        if(_bodies[i].dof < 0)
+            continue;
+        _w.col(i) = _M[i]*_v.col(i) + _omega.col(i).cross(_S.col(i));
+        _u.col(i) = _w.col(i).cross(_g);
+        _tau[_bodies[i].dof] = -_g.dot(_w.col(i));
+    }
+
+    // the floating base joints come from the jacobian of the floating base link
+    bool floating_base = !_floating_base_link.empty();
+    if(floating_base)
+    {
+        _robot->getJacobian(_floating_base_link, _J);
+        _robot->getPose(_floating_base_link, _T);
+        for(unsigned int j = 0; j < 6; ++j)
+        {
+            _base_omega.col(j) = _J.block(3,j,3,1);
+            v = _J.block(0,j,3,1) - _base_omega.col(j).cross(_T.translation());
+            Eigen::Vector3d w = _M[0]*v + _base_omega.col(j).cross(_S.col(0));
+            _base_u.col(j) = w.cross(_g);
+            _tau[j] = -_g.dot(w);
+        }
+    }
+
+    _Wtau.noalias() = W*_tau;
+
+    // d tau_d / d q_a = -g . (omega_a x w_d) = -omega_a . (w_d x g), for a ancestor of d
+    if(floating_base)
+    {
+        for(unsigned int d = 0; d < 6; ++d)
+            for(unsigned int a = 0; a <= d; ++a)
+                accumulate(a, d, -_base_omega.col(a).dot(_base_u.col(d)));
+    }
+    for(unsigned int i = 0; i < _bodies.size(); ++i)
+    {
+        const int d = _bodies[i].dof;
+        if(d < 0)
+            continue;
+
+        for(int k = i; k >= 0; k = _bodies[k].parent)
+        {
+            if(_bodies[k].dof >= 0)
+                accumulate(_bodies[k].dof, d, -_omega.col(k).dot(_u.col(i)));
+        }
+        if(floating_base)
+        {
+            for(unsigned int a = 0; a < 6; ++a)
+                accumulate(a, d, -_base_omega.col(a).dot(_u.col(i)));
+        }
+    }
+
+    for(unsigned int i = 0; i < _gradient.size(); ++i)
+    {
+        if(!jointMask[i])
+            _gradient[i] = 0.0;
+    }
+
+    return _gradient;
+}
@@ -37,6 +37,11 @@ Postural::Postural(   const Eigen::VectorXd& x) :
     /* first update. Setting desired pose equal to the actual pose */
     this->setReference(x);
     this->_update(x);
+
+    Reference reference;
+    reference.x = _x_desired;
+    reference.xdot = _xdot_desired;
+    _reference_port.reset(reference);
 }
 
 Postural::~Postural()
@@ -75,6 +80,29 @@ void OpenSoT::tasks::velocity::Postural::setReference(const Eigen::VectorXd &x_d
     }
 }
 
+bool OpenSoT::tasks::velocity::Postural::setReferenceAsync(const Eigen::VectorXd &x_desired,
+                                                           const Eigen::VectorXd &xdot_desired)
+{
+    if(x_desired.size() != _x_size || xdot_desired.size() != _x_size)
+        return false;
+
+    Reference& reference = _reference_port.getWriteBuffer();
+    reference.x = x_desired;
+    reference.xdot = xdot_desired;
+    _reference_port.publish();
+    return true;
+}
+
+bool OpenSoT::tasks::velocity::Postural::applyReferences()
+{
+    if(!_reference_port.update())
+        return false;
+
+    const Reference& reference = _reference_port.getReadBuffer();
+    this->setReference(reference.x, reference.xdot);
+    return true;
+}
+
 Eigen::VectorXd OpenSoT::tasks::velocity::Postural::getReference() const
 {
     return _x_desired;
@@ -245,7 +245,8 @@ OpenSoT::AutoStack::AutoStack(const double x_size) :
     _boundsAggregated(
         new OpenSoT::constraints::Aggregated(
             std::list<OpenSoT::constraints::Aggregated::ConstraintPtr>(),
-            x_size))
+            x_size)),
+    _slow_updates(0)
 {
 
 }
@@ -254,7 +255,8 @@ OpenSoT::AutoStack::AutoStack(OpenSoT::tasks::Aggregated::TaskPtr task):
     _boundsAggregated(
         new OpenSoT::constraints::Aggregated(
             std::list<OpenSoT::constraints::Aggregated::ConstraintPtr>(),
-            task->getXSize()))
+            task->getXSize())),
+    _slow_updates(0)
 {
     _stack.push_back(task);
 }
@@ -264,7 +266,8 @@ OpenSoT::AutoStack::AutoStack(OpenSoT::solvers::iHQP::Stack stack) :
     _boundsAggregated(
         new OpenSoT::constraints::Aggregated(
             std::list<OpenSoT::constraints::Aggregated::ConstraintPtr>(),
-            stack.front()->getXSize()))
+            stack.front()->getXSize())),
+    _slow_updates(0)
 {
 
 }
@@ -275,19 +278,93 @@ OpenSoT::AutoStack::AutoStack(OpenSoT::solvers::iHQP::Stack stack,
     _boundsAggregated(
         new OpenSoT::constraints::Aggregated(
             bounds,
-            bounds.front()->getXSize()))
+            bounds.front()->getXSize())),
+    _slow_updates(0)
 {
 
 }
 
 void OpenSoT::AutoStack::update(const Eigen::VectorXd &state)
 {
-    _boundsAggregated->update(state);
+    // the tasks and constraints shared in the stack are updated once
+    OpenSoT::utils::UpdateCycle::Scope cycle;
+
     typedef std::vector<OpenSoT::tasks::Aggregated::TaskPtr>::iterator it_t;
+    // the references published by other threads are applied before any task is updated
     for(it_t task = _stack.begin();
         task != _stack.end();
         ++task)
-        (*task)->update(state);
+        (*task)->applyReferences();
+
+    _boundsAggregated->update(state);
+    for(it_t task = _stack.begin();
+        task != _stack.end();
+        ++task)
+        (*task)->scheduledUpdate(state);
+}
+
+bool OpenSoT::AutoStack::setUpdateDivider(OpenSoT::solvers::iHQP::TaskPtr task, const unsigned int divider,
+                                          const bool extrapolate)
+{
+    if(divider == 0){
+        XBot::Logger::error("in %s: divider of task %s has to be positive\n", __func__, task->getTaskID().c_str());
+        return false;}
+
+    // the slow tasks and constraints are updated in different cycles
+    return task->setUpdateDivider(divider, divider > 1 ? _slow_updates++ : 0, extrapolate);
+}
+
+bool OpenSoT::AutoStack::setUpdateDivider(OpenSoT::constraints::Aggregated::ConstraintPtr constraint,
+                                          const unsigned int divider)
+{
+    if(divider == 0){
+        XBot::Logger::error("in %s: divider of constraint %s has to be positive\n", __func__,
+                            constraint->getConstraintID().c_str());
+        return false;}
+
+    return constraint->setUpdateDivider(divider, divider > 1 ? _slow_updates++ : 0);
+}
+
+bool OpenSoT::AutoStack::setTask(OpenSoT::solvers::iHQP& solver, const unsigned int level,
+                                 OpenSoT::solvers::iHQP::TaskPtr task)
+{
+    // the checks of the solver are repeated, so that the two stacks stay the same
+    if(solver.getNumberOfLevels() != _stack.size() || level >= _stack.size() ||
+       !task || task->getXSize() != _stack[level]->getXSize()){
+        XBot::Logger::error("in %s: task can not be set at level %i\n", __func__, level);
+        return false;}
+
+    // the solver leaves its stack as it was when it fails, and so does the AutoStack
+    if(!solver.setTask(level, task))
+        return false;
+    _stack[level] = task;
+    return true;
+}
+
+bool OpenSoT::AutoStack::insertTask(OpenSoT::solvers::iHQP& solver, const unsigned int level,
+                                    OpenSoT::solvers::iHQP::TaskPtr task)
+{
+    if(solver.getNumberOfLevels() != _stack.size() || level > _stack.size() ||
+       !task || task->getXSize() != _stack.front()->getXSize()){
+        XBot::Logger::error("in %s: task can not be inserted at level %i\n", __func__, level);
+        return false;}
+
+    if(!solver.insertTask(level, task))
+        return false;
+    _stack.insert(_stack.begin() + level, task);
+    return true;
+}
+
+bool OpenSoT::AutoStack::removeTask(OpenSoT::solvers::iHQP& solver, const unsigned int level)
+{
+    if(solver.getNumberOfLevels() != _stack.size() || level >= _stack.size() || _stack.size() == 1){
+        XBot::Logger::error("in %s: level %i can not be removed\n", __func__, level);
+        return false;}
+
+    if(!solver.removeTask(level))
+        return false;
+    _stack.erase(_stack.begin() + level);
+    return true;
 }
 
 std::list<OpenSoT::constraints::Aggregated::ConstraintPtr>& OpenSoT::AutoStack::getBoundsList()
@@ -406,4 +483,20 @@ void OpenSoT::AutoStack::log(XBot::MatLogger::Ptr logger)
         _boundsAggregated->log(logger);
 }
 
+void OpenSoT::AutoStack::registerLog(OpenSoT::utils::RTLogger::Ptr logger)
+{
+    for(auto task : _stack)
+        task->registerLog(logger);
+    if(_boundsAggregated)
+        _boundsAggregated->registerLog(logger);
+}
+
+void OpenSoT::AutoStack::log(OpenSoT::utils::RTLogger::Ptr logger)
+{
+    for(auto task : _stack)
+        task->log(logger);
+    if(_boundsAggregated)
+        _boundsAggregated->log(logger);
+}
+
 
@@ -0,0 +1,129 @@
+#include <OpenSoT/utils/CapsuleDistance.h>
+#include <cassert>
+
+#define SMALL_NUM 1e-12
+
+using namespace OpenSoT::utils;
+
+CapsuleDistanceBatch::CapsuleDistanceBatch(const unsigned int number_of_pairs)
+{
+    resize(number_of_pairs);
+}
+
+void CapsuleDistanceBatch::resize(const unsigned int number_of_pairs)
+{
+    _A_p.setZero(number_of_pairs, 3); _A_d.setZero(number_of_pairs, 3);
+    _B_p.setZero(number_of_pairs, 3); _B_d.setZero(number_of_pairs, 3);
+    _A_radius.setZero(number_of_pairs); _B_radius.setZero(number_of_pairs);
+
+    _cA.setZero(number_of_pairs, 3); _cB.setZero(number_of_pairs, 3);
+    _distance.setZero(number_of_pairs);
+
+    _a.setZero(number_of_pairs); _b.setZero(number_of_pairs); _c.setZero(number_of_pairs);
+    _e.setZero(number_of_pairs); _f.setZero(number_of_pairs); _denom.setZero(number_of_pairs);
+    _s.setZero(number_of_pairs); _t.setZero(number_of_pairs);
+    _axis_distance.setZero(number_of_pairs);
+    _a_safe.setZero(number_of_pairs); _e_safe.setZero(number_of_pairs);
+    _denom_safe.setZero(number_of_pairs); _axis_distance_safe.setZero(number_of_pairs);
+    _direction.setZero(number_of_pairs);
+}
+
+unsigned int CapsuleDistanceBatch::size() const
+{
+    return _distance.size();
+}
+
+void CapsuleDistanceBatch::setPair(const unsigned int i,
+                                   const Eigen::Vector3d& A_ep1, const Eigen::Vector3d& A_ep2, const double A_radius,
+                                   const Eigen::Vector3d& B_ep1, const Eigen::Vector3d& B_ep2, const double B_radius)
+{
+    assert(i < size());
+
+    _A_p.row(i) = A_ep1.transpose();
+    _A_d.row(i) = (A_ep2 - A_ep1).transpose();
+    _A_radius[i] = A_radius;
+
+    _B_p.row(i) = B_ep1.transpose();
+    _B_d.row(i) = (B_ep2 - B_ep1).transpose();
+    _B_radius[i] = B_radius;
+}
+
+void CapsuleDistanceBatch::compute(const unsigned int number_of_pairs)
+{
+    assert(number_of_pairs <= size());
+    const unsigned int n = number_of_pairs;
+
+    Points::RowsBlockXpr A_p = _A_p.topRows(n), A_d = _A_d.topRows(n);
+    Points::RowsBlockXpr B_p = _B_p.topRows(n), B_d = _B_d.topRows(n);
+
+    // r = A_p - B_p is not stored, we expand the dot products instead
+    _a.head(n) = (A_d.array()*A_d.array()).rowwise().sum();
+    _e.head(n) = (B_d.array()*B_d.array()).rowwise().sum();
+    _b.head(n) = (A_d.array()*B_d.array()).rowwise().sum();
+    _c.head(n) = (A_d.array()*(A_p - B_p).array()).rowwise().sum();
+    _f.head(n) = (B_d.array()*(A_p - B_p).array()).rowwise().sum();
+    _denom.head(n) = _a.head(n)*_e.head(n) - _b.head(n)*_b.head(n);
+
+    Eigen::ArrayXd::SegmentReturnType a = _a.head(n), b = _b.head(n), c = _c.head(n),
+                                      e = _e.head(n), f = _f.head(n), denom = _denom.head(n),
+                                      s = _s.head(n), t = _t.head(n);
+
+    // safe denominators: where a (or e, or denom) vanish the corresponding branch is never selected
+    Eigen::ArrayXd::SegmentReturnType a_safe = _a_safe.head(n), e_safe = _e_safe.head(n),
+                                      denom_safe = _denom_safe.head(n);
+    a_safe = (a > SMALL_NUM).select(a, 1.0);
+    e_safe = (e > SMALL_NUM).select(e, 1.0);
+    denom_safe = (denom > SMALL_NUM*a*e).select(denom, 1.0);
+
+    // closest point on the infinite line A to the line B, clamped to the segment.
+    // If the lines are parallel we start from s = 0, if B is a point we project it on A
+    s = (denom > SMALL_NUM*a*e).select(((b*f - c*e)/denom_safe).max(0.0).min(1.0),
+            (e > SMALL_NUM).select(Eigen::ArrayXd::Zero(n),
+                (a > SMALL_NUM).select((-c/a_safe).max(0.0).min(1.0), 0.0)));
+
+    // closest point on the segment B to A(s)
+    t = (e > SMALL_NUM).select((b*s + f)/e_safe, 0.0);
+
+    // if t was clamped, recompute s for the new t
+    s = (t < 0.0).select((a > SMALL_NUM).select((-c/a_safe).max(0.0).min(1.0), 0.0),
+        (t > 1.0).select((a > SMALL_NUM).select(((b - c)/a_safe).max(0.0).min(1.0), 0.0),
+            s));
+    t = t.max(0.0).min(1.0);
+
+    // closest points on the axes, we temporarily store them in _cA and _cB
+    for(unsigned int k = 0; k < 3; ++k)
+    {
+        _cA.col(k).head(n).array() = A_p.col(k).array() + s*A_d.col(k).array();
+        _cB.col(k).head(n).array() = B_p.col(k).array() + t*B_d.col(k).array();
+    }
+
+    _axis_distance.head(n) = (_cB.topRows(n) - _cA.topRows(n)).rowwise().norm().array();
+    _distance.head(n) = _axis_distance.head(n) - _A_radius.head(n) - _B_radius.head(n);
+
+    // closest points on the surfaces, along the direction joining the closest points on the axes.
+    // If the axes intersect the direction is not defined, and we pick the x axis
+    Eigen::ArrayXd::SegmentReturnType axis_distance_safe = _axis_distance_safe.head(n),
+                                      direction = _direction.head(n);
+    axis_distance_safe = (_axis_distance.head(n) > SMALL_NUM).select(_axis_distance.head(n), 1.0);
+    for(unsigned int k = 0; k < 3; ++k)
+    {
+        direction = (_axis_distance.head(n) > SMALL_NUM).select(
+                    (_cB.col(k).head(n) - _cA.col(k).head(n)).array()/axis_distance_safe,
+                    k == 0 ? 1.0 : 0.0);
+        _cA.col(k).head(n).array() += _A_radius.head(n)*direction;
+        _cB.col(k).head(n).array() -= _B_radius.head(n)*direction;
+    }
+}
+
+double CapsuleDistanceBatch::getDistance(const unsigned int i) const
+{
+    assert(i < size());
+    return _distance[i];
+}
+
+void CapsuleDistanceBatch::getClosestPoints(const unsigned int i, Eigen::Vector3d& pA, Eigen::Vector3d& pB) const
+{
+    assert(i < size());
+    pA = _cA.row(i).transpose();
+    pB = _cB.row(i).transpose();
+}
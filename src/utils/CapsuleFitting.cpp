@@ -0,0 +1,246 @@
+#include <OpenSoT/utils/CapsuleFitting.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace OpenSoT::utils;
+
+namespace
+{
+
+const double EPS = 1e-12;
+
+bool isInside(const Eigen::Vector2d& p, const Eigen::Vector2d& center, const double radius)
+{
+    return (p - center).norm() <= radius + 1e-9;
+}
+
+/**
+ * @brief circumcircle computes the circle through three points. For (almost) collinear points
+ *        it returns the circle having the two farthest points as diameter
+ */
+double circumcircle(const Eigen::Vector2d& a, const Eigen::Vector2d& b, const Eigen::Vector2d& c,
+                    Eigen::Vector2d& center)
+{
+    Eigen::Vector2d ab = b - a;
+    Eigen::Vector2d ac = c - a;
+    double det = 2.0*(ab.x()*ac.y() - ab.y()*ac.x());
+    if(std::fabs(det) < EPS)
+    {
+        const Eigen::Vector2d* p[3] = {&a, &b, &c};
+        double best = -1.0;
+        for(unsigned int i = 0; i < 3; ++i)
+        {
+            for(unsigned int j = i+1; j < 3; ++j)
+            {
+                double d = (*p[i] - *p[j]).norm();
+                if(d > best)
+                {
+                    best = d;
+                    center = 0.5*(*p[i] + *p[j]);
+                }
+            }
+        }
+        return 0.5*best;
+    }
+
+    double ab2 = ab.squaredNorm();
+    double ac2 = ac.squaredNorm();
+    Eigen::Vector2d offset((ac.y()*ab2 - ab.y()*ac2)/det,
+                           (ab.x()*ac2 - ac.x()*ab2)/det);
+    center = a + offset;
+    return offset.norm();
+}
+
+}
+
+double CapsuleFitting::Capsule::getLength() const
+{
+    return (ep2 - ep1).norm();
+}
+
+double CapsuleFitting::Capsule::getVolume() const
+{
+    return M_PI*radius*radius*(getLength() + 4.0/3.0*radius);
+}
+
+Eigen::Affine3d CapsuleFitting::Capsule::getCenterFrame() const
+{
+    Eigen::Affine3d frame = Eigen::Affine3d::Identity();
+    Eigen::Vector3d axis = ep2 - ep1;
+    if(axis.norm() > EPS)
+        frame.linear() = Eigen::Quaterniond::FromTwoVectors(Eigen::Vector3d::UnitZ(), axis).toRotationMatrix();
+    frame.translation() = 0.5*(ep1 + ep2);
+    return frame;
+}
+
+double CapsuleFitting::Capsule::getDistance(const Eigen::Vector3d& p) const
+{
+    Eigen::Vector3d axis = ep2 - ep1;
+    double length2 = axis.squaredNorm();
+    double t = 0.0;
+    if(length2 > EPS)
+        t = std::min(1.0, std::max(0.0, (p - ep1).dot(axis)/length2));
+    return (p - (ep1 + t*axis)).norm() - radius;
+}
+
+double CapsuleFitting::minimumEnclosingCircle(std::vector<Eigen::Vector2d> points, Eigen::Vector2d& center)
+{
+    center.setZero();
+    if(points.empty())
+        return 0.0;
+
+    // Welzl algorithm is expected linear time on randomly ordered points: we shuffle them with a fixed
+    // generator, so that the result is reproducible
+    unsigned int seed = 12345;
+    for(std::size_t i = points.size()-1; i > 0; --i)
+    {
+        seed = seed*1103515245u + 12345u;
+        std::swap(points[i], points[(seed >> 8) % (i+1)]);
+    }
+
+    center = points[0];
+    double radius = 0.0;
+    for(std::size_t i = 1; i < points.size(); ++i)
+    {
+        if(isInside(points[i], center, radius))
+            continue;
+
+        center = points[i];
+        radius = 0.0;
+        for(std::size_t j = 0; j < i; ++j)
+        {
+            if(isInside(points[j], center, radius))
+                continue;
+
+            center = 0.5*(points[i] + points[j]);
+            radius = 0.5*(points[i] - points[j]).norm();
+            for(std::size_t k = 0; k < j; ++k)
+            {
+                if(!isInside(points[k], center, radius))
+                    radius = circumcircle(points[i], points[j], points[k], center);
+            }
+        }
+    }
+    return radius;
+}
+
+CapsuleFitting::Capsule CapsuleFitting::fit(const Points& points, const Eigen::Vector3d& axis)
+{
+    Eigen::Vector3d u = axis.unitOrthogonal();
+    Eigen::Vector3d v = axis.cross(u);
+
+    std::vector<Eigen::Vector2d> projections(points.size());
+    for(std::size_t i = 0; i < points.size(); ++i)
+        projections[i] << points[i].dot(u), points[i].dot(v);
+
+    Capsule capsule;
+    Eigen::Vector2d center;
+    capsule.radius = minimumEnclosingCircle(projections, center);
+    Eigen::Vector3d origin = center.x()*u + center.y()*v;
+
+    // a point at axial coordinate t and radial distance d is inside the capsule iff its distance from
+    // the axis segment [t1, t2] is within sqrt(r^2 - d^2): the shortest segment is then
+    // t1 = min(t + sqrt(r^2 - d^2)), t2 = max(t - sqrt(r^2 - d^2))
+    double t1 = std::numeric_limits<double>::max();
+    double t2 = -std::numeric_limits<double>::max();
+    for(std::size_t i = 0; i < points.size(); ++i)
+    {
+        double t = points[i].dot(axis);
+        double d2 = (projections[i] - center).squaredNorm();
+        double s = std::sqrt(std::max(capsule.radius*capsule.radius - d2, 0.0));
+        t1 = std::min(t1, t + s);
+        t2 = std::max(t2, t - s);
+    }
+
+    // if t1 > t2 every point of [t2, t1] works: the capsule degenerates to a sphere
+    if(t1 > t2)
+        t1 = t2 = 0.5*(t1 + t2);
+
+    capsule.ep1 = origin + t1*axis;
+    capsule.ep2 = origin + t2*axis;
+    return capsule;
+}
+
+CapsuleFitting::Capsule CapsuleFitting::fit(const Points& points)
+{
+    Capsule capsule;
+    capsule.ep1.setZero();
+    capsule.ep2.setZero();
+    capsule.radius = 0.0;
+    if(points.empty())
+        return capsule;
+
+    Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+    for(std::size_t i = 0; i < points.size(); ++i)
+        mean += points[i];
+    mean /= double(points.size());
+
+    Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+    for(std::size_t i = 0; i < points.size(); ++i)
+        covariance += (points[i] - mean)*(points[i] - mean).transpose();
+
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigen_solver(covariance);
+
+    double best_volume = std::numeric_limits<double>::max();
+    for(int k = 2; k >= 0; --k)
+    {
+        Capsule candidate = fit(points, eigen_solver.eigenvectors().col(k).normalized());
+        if(candidate.getVolume() < best_volume)
+        {
+            best_volume = candidate.getVolume();
+            capsule = candidate;
+        }
+    }
+    return capsule;
+}
+
+double CapsuleFitting::getApproximationError(const Capsule& capsule, const Points& points,
+                                             const unsigned int samples)
+{
+    if(points.empty())
+        return 0.0;
+
+    unsigned int n = std::max(samples, 4u);
+    Eigen::Affine3d frame = capsule.getCenterFrame();
+    double half_length = 0.5*capsule.getLength();
+    double r = capsule.radius;
+
+    Points surface;
+    // cylinder
+    unsigned int axial_samples = std::max(2u, static_cast<unsigned int>(
+                                 std::ceil(2.0*half_length/(2.0*M_PI*r/n + EPS))) + 1);
+    axial_samples = std::min(axial_samples, 4*n);
+    for(unsigned int i = 0; i < axial_samples; ++i)
+    {
+        double z = -half_length + 2.0*half_length*i/(axial_samples - 1);
+        for(unsigned int j = 0; j < n; ++j)
+        {
+            double theta = 2.0*M_PI*j/n;
+            surface.push_back(Eigen::Vector3d(r*std::cos(theta), r*std::sin(theta), z));
+        }
+    }
+    // hemispheres
+    for(unsigned int i = 1; i <= n/4; ++i)
+    {
+        double phi = 0.5*M_PI*i/(n/4);
+        for(unsigned int j = 0; j < n; ++j)
+        {
+            double theta = 2.0*M_PI*j/n;
+            Eigen::Vector3d p(r*std::cos(phi)*std::cos(theta), r*std::cos(phi)*std::sin(theta), r*std::sin(phi));
+            surface.push_back(p + half_length*Eigen::Vector3d::UnitZ());
+            surface.push_back(Eigen::Vector3d(p.x(), p.y(), -p.z()) - half_length*Eigen::Vector3d::UnitZ());
+        }
+    }
+
+    double error = 0.0;
+    for(std::size_t i = 0; i < surface.size(); ++i)
+    {
+        Eigen::Vector3d s = frame*surface[i];
+        double closest = std::numeric_limits<double>::max();
+        for(std::size_t k = 0; k < points.size(); ++k)
+            closest = std::min(closest, (s - points[k]).squaredNorm());
+        error = std::max(error, std::sqrt(closest));
+    }
+    return error;
+}
@@ -0,0 +1,279 @@
+#include <OpenSoT/utils/CollisionGeometryCache.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace OpenSoT::utils;
+
+namespace
+{
+
+const char CACHE_MAGIC[8] = {'O','S','O','T','C','G','C','\0'};
+const uint32_t CACHE_VERSION = 1;
+
+/**
+ * @brief The Writer class serializes plain data on a stream
+ */
+class Writer
+{
+public:
+    Writer(std::ostream& stream): _stream(stream) {}
+
+    template <typename T>
+    void write(const T& value)
+    {
+        _stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void write(const std::string& value)
+    {
+        write<uint32_t>(value.size());
+        _stream.write(value.data(), value.size());
+    }
+
+    template <typename T>
+    void write(const std::vector<T>& values)
+    {
+        write<uint32_t>(values.size());
+        if(!values.empty())
+            _stream.write(reinterpret_cast<const char*>(&values[0]), sizeof(T)*values.size());
+    }
+
+private:
+    std::ostream& _stream;
+};
+
+/**
+ * @brief The Reader class deserializes plain data from a memory buffer,
+ *        failing (instead of reading past the end) on truncated buffers
+ */
+class Reader
+{
+public:
+    Reader(const char* begin, const char* end): _current(begin), _end(end), _ok(true) {}
+
+    bool ok() const { return _ok; }
+    bool atEnd() const { return _current == _end; }
+
+    template <typename T>
+    void read(T& value)
+    {
+        if(!check(sizeof(T)))
+            return;
+        std::memcpy(&value, _current, sizeof(T));
+        _current += sizeof(T);
+    }
+
+    void read(std::string& value)
+    {
+        uint32_t size = 0;
+        read(size);
+        if(!check(size))
+            return;
+        value.assign(_current, size);
+        _current += size;
+    }
+
+    template <typename T>
+    void read(std::vector<T>& values)
+    {
+        uint32_t size = 0;
+        read(size);
+        if(!check(sizeof(T)*std::size_t(size)))
+            return;
+        values.resize(size);
+        if(size > 0)
+            std::memcpy(&values[0], _current, sizeof(T)*size);
+        _current += sizeof(T)*size;
+    }
+
+private:
+    bool check(const std::size_t size)
+    {
+        _ok = _ok && std::size_t(_end - _current) >= size;
+        return _ok;
+    }
+
+    const char* _current;
+    const char* _end;
+    bool _ok;
+};
+
+}
+
+uint64_t CollisionGeometryCache::computeKey(const std::string& data)
+{
+    return computeKey(data.data(), data.size(), 14695981039346656037ULL);
+}
+
+uint64_t CollisionGeometryCache::computeKey(const char* data, const std::size_t size, const uint64_t key)
+{
+    uint64_t hash = key;
+    for(std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void CollisionGeometryCache::clear()
+{
+    shapes.clear();
+    pairs.clear();
+}
+
+bool CollisionGeometryCache::save(const std::string& file_name, const uint64_t key) const
+{
+    // we write to a unique temporary file and rename it, so that a process loading the cache
+    // concurrently never sees a partially written file, and two processes saving it do not mix their files
+    std::vector<char> tmp_file_name(file_name.begin(), file_name.end());
+    const char suffix[] = ".XXXXXX";
+    tmp_file_name.insert(tmp_file_name.end(), suffix, suffix + sizeof(suffix));
+    int fd = mkstemp(tmp_file_name.data());
+    if(fd < 0)
+        return false;
+    fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    close(fd);
+    {
+        std::ofstream file(tmp_file_name.data(), std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+        {
+            std::remove(tmp_file_name.data());
+            return false;
+        }
+
+        Writer writer(file);
+        file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        writer.write(CACHE_VERSION);
+        writer.write(key);
+
+        writer.write<uint32_t>(shapes.size());
+        for(unsigned int i = 0; i < shapes.size(); ++i)
+        {
+            const Shape& shape = shapes[i];
+            writer.write(shape.link_name);
+            writer.write<int32_t>(shape.type);
+            for(unsigned int k = 0; k < 3; ++k)
+                writer.write(shape.size[k]);
+            for(unsigned int k = 0; k < 3; ++k)
+                writer.write(shape.position[k]);
+            writer.write(shape.orientation.x());
+            writer.write(shape.orientation.y());
+            writer.write(shape.orientation.z());
+            writer.write(shape.orientation.w());
+            writer.write(shape.vertices);
+            writer.write(shape.triangles);
+        }
+
+        writer.write<uint32_t>(pairs.size());
+        for(unsigned int i = 0; i < pairs.size(); ++i)
+        {
+            writer.write(pairs[i].first);
+            writer.write(pairs[i].second);
+        }
+
+        if(!file.good())
+        {
+            file.close();
+            std::remove(tmp_file_name.data());
+            return false;
+        }
+    }
+
+    if(std::rename(tmp_file_name.data(), file_name.c_str()) != 0)
+    {
+        std::remove(tmp_file_name.data());
+        return false;
+    }
+    return true;
+}
+
+bool CollisionGeometryCache::load(const std::string& file_name, const uint64_t key)
+{
+    clear();
+
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    std::size_t file_size = file_stat.st_size;
+    void* mapped = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED)
+        return false;
+
+    const char* data = static_cast<const char*>(mapped);
+    Reader reader(data, data + file_size);
+
+    char magic[sizeof(CACHE_MAGIC)];
+    uint32_t version = 0;
+    uint64_t file_key = 0;
+    reader.read(magic);
+    reader.read(version);
+    reader.read(file_key);
+
+    bool ok = reader.ok() &&
+              std::memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+              version == CACHE_VERSION &&
+              file_key == key;
+
+    uint32_t number_of_shapes = 0;
+    if(ok)
+        reader.read(number_of_shapes);
+    for(uint32_t i = 0; ok && i < number_of_shapes; ++i)
+    {
+        Shape shape;
+        int32_t type = 0;
+        double q[4];
+        reader.read(shape.link_name);
+        reader.read(type);
+        for(unsigned int k = 0; k < 3; ++k)
+            reader.read(shape.size[k]);
+        for(unsigned int k = 0; k < 3; ++k)
+            reader.read(shape.position[k]);
+        for(unsigned int k = 0; k < 4; ++k)
+            reader.read(q[k]);
+        reader.read(shape.vertices);
+        reader.read(shape.triangles);
+
+        ok = reader.ok() && type >= SPHERE && type <= MESH;
+        shape.type = ShapeType(type);
+        shape.orientation = Eigen::Quaterniond(q[3], q[0], q[1], q[2]);
+        if(ok)
+            shapes.push_back(shape);
+    }
+
+    uint32_t number_of_pairs = 0;
+    if(ok)
+        reader.read(number_of_pairs);
+    for(uint32_t i = 0; ok && i < number_of_pairs; ++i)
+    {
+        LinksPair pair;
+        reader.read(pair.first);
+        reader.read(pair.second);
+        ok = reader.ok();
+        if(ok)
+            pairs.push_back(pair);
+    }
+
+    ok = ok && reader.atEnd();
+
+    munmap(mapped, file_size);
+
+    if(!ok)
+        clear();
+    return ok;
+}
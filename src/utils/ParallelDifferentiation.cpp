@@ -0,0 +1,257 @@
+#include <OpenSoT/utils/ParallelDifferentiation.h>
+#include <XBotInterface/Logger.hpp>
+#include <stdexcept>
+
+using namespace OpenSoT::utils;
+
+ParallelDifferentiation::ParallelDifferentiation(const std::vector<CostFunction*>& functions):
+    _cost_functions(functions),
+    _generation(0), _pending(0), _quit(false),
+    _next_column(0), _x(NULL), _scheme(CENTRAL_DIFFERENCES), _step(1E-3), _f0(0.0)
+{
+    for(unsigned int i = 0; i < functions.size(); ++i)
+        _complex_cost_functions.push_back(dynamic_cast<ComplexCostFunction*>(functions[i]));
+
+    startThreads(functions.size());
+}
+
+ParallelDifferentiation::ParallelDifferentiation(const std::vector<GradientVector*>& functions):
+    _gradient_vectors(functions),
+    _generation(0), _pending(0), _quit(false),
+    _next_column(0), _x(NULL), _scheme(CENTRAL_DIFFERENCES), _step(1E-3), _f0(0.0)
+{
+    startThreads(functions.size());
+}
+
+ParallelDifferentiation::~ParallelDifferentiation()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _start.notify_all();
+
+    for(unsigned int i = 0; i < _threads.size(); ++i)
+        _threads[i].join();
+}
+
+unsigned int ParallelDifferentiation::getNumberOfThreads() const
+{
+    return _threads.size() + 1;
+}
+
+void ParallelDifferentiation::startThreads(const unsigned int number_of_threads)
+{
+    if(number_of_threads == 0)
+    {
+        XBot::Logger::error("in %s: at least one function is needed!\n", __func__);
+        throw std::invalid_argument("ParallelDifferentiation needs at least one function");
+    }
+
+    _x_perturbed.resize(number_of_threads);
+    _x_complex.resize(number_of_threads);
+
+    for(unsigned int i = 1; i < number_of_threads; ++i)
+        _threads.push_back(std::thread(&ParallelDifferentiation::threadLoop, this, i));
+}
+
+void ParallelDifferentiation::threadLoop(const unsigned int thread)
+{
+    unsigned long generation = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _start.wait(lock, [&]{ return _quit || _generation != generation; });
+            if(_quit)
+                return;
+            generation = _generation;
+        }
+
+        work(thread);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(--_pending == 0)
+                _done.notify_one();
+        }
+    }
+}
+
+void ParallelDifferentiation::setColumns(const unsigned int size, const std::vector<bool>& jointMask)
+{
+    bool use_mask = !jointMask.empty();
+    if(use_mask && jointMask.size() != size)
+    {
+        XBot::Logger::error("in %s: jointMask has size %u, expected %u: computing all the columns\n",
+                            __func__, (unsigned int)jointMask.size(), size);
+        use_mask = false;
+    }
+
+    _columns.clear();
+    for(unsigned int i = 0; i < size; ++i)
+    {
+        if(!use_mask || jointMask[i])
+            _columns.push_back(i);
+    }
+}
+
+void ParallelDifferentiation::run()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _next_column = 0;
+        _pending = _threads.size();
+        ++_generation;
+    }
+
+    if(!_threads.empty())
+        _start.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [&]{ return _pending == 0; });
+}
+
+void ParallelDifferentiation::work(const unsigned int thread)
+{
+    while(true)
+    {
+        unsigned int column;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            column = _next_column++;
+        }
+        if(column >= _columns.size())
+            return;
+
+        evaluateColumn(thread, _columns[column]);
+    }
+}
+
+void ParallelDifferentiation::evaluateColumn(const unsigned int thread, const int i)
+{
+    const double h = _step;
+    const double x_i = (*_x)[i];
+    Eigen::VectorXd& x = _x_perturbed[thread];
+
+    if(!_gradient_vectors.empty())
+    {
+        GradientVector& vec = *_gradient_vectors[thread];
+        x[i] = x_i + h;
+        if(_scheme == FORWARD_DIFFERENCES)
+            _hessian.col(i) = (vec.compute(x) - _g0)/h;
+        else
+        {
+            Eigen::VectorXd gradient_a = vec.compute(x);
+            x[i] = x_i - h;
+            _hessian.col(i) = (gradient_a - vec.compute(x))/(2.0*h);
+        }
+        x[i] = x_i;
+        return;
+    }
+
+    if(_scheme == COMPLEX_STEP)
+    {
+        Eigen::VectorXcd& x_complex = _x_complex[thread];
+        x_complex[i] = std::complex<double>(x_i, h);
+        _gradient[i] = _complex_cost_functions[thread]->compute(x_complex).imag()/h;
+        x_complex[i] = x_i;
+        return;
+    }
+
+    CostFunction& fun = *_cost_functions[thread];
+    x[i] = x_i + h;
+    if(_scheme == FORWARD_DIFFERENCES)
+        _gradient[i] = (fun.compute(x) - _f0)/h;
+    else
+    {
+        double fun_a = fun.compute(x);
+        x[i] = x_i - h;
+        _gradient[i] = (fun_a - fun.compute(x))/(2.0*h);
+    }
+    x[i] = x_i;
+}
+
+double ParallelDifferentiation::getDefaultStep(const Scheme scheme)
+{
+    return scheme == COMPLEX_STEP ? 1E-20 : 1E-3;
+}
+
+const Eigen::VectorXd& ParallelDifferentiation::computeGradient(const Eigen::VectorXd& x,
+                                                                const std::vector<bool>& jointMask,
+                                                                const Scheme scheme,
+                                                                const double step)
+{
+    _gradient.setZero(x.size());
+    if(_cost_functions.empty())
+    {
+        XBot::Logger::error("in %s: the pool has been created for Hessians!\n", __func__);
+        return _gradient;
+    }
+
+    _scheme = scheme;
+    if(_scheme == COMPLEX_STEP)
+    {
+        for(unsigned int i = 0; i < _complex_cost_functions.size(); ++i)
+        {
+            if(!_complex_cost_functions[i])
+            {
+                XBot::Logger::error("in %s: cost functions do not implement ComplexCostFunction, using central differences\n", __func__);
+                _scheme = CENTRAL_DIFFERENCES;
+                break;
+            }
+        }
+    }
+
+    _x = &x;
+    _step = step > 0.0 ? step : getDefaultStep(_scheme);
+    setColumns(x.size(), jointMask);
+    for(unsigned int t = 0; t < _x_perturbed.size(); ++t)
+    {
+        if(_scheme == COMPLEX_STEP)
+            _x_complex[t] = x.cast< std::complex<double> >();
+        else
+            _x_perturbed[t] = x;
+    }
+
+    if(_scheme == FORWARD_DIFFERENCES)
+        _f0 = _cost_functions[0]->compute(x);
+
+    run();
+    return _gradient;
+}
+
+const Eigen::MatrixXd& ParallelDifferentiation::computeHessian(const Eigen::VectorXd& x,
+                                                               const std::vector<bool>& jointMask,
+                                                               const Scheme scheme,
+                                                               const double step)
+{
+    if(_gradient_vectors.empty())
+    {
+        XBot::Logger::error("in %s: the pool has been created for gradients!\n", __func__);
+        _hessian.setZero(x.size(), x.size());
+        return _hessian;
+    }
+    _hessian.setZero(_gradient_vectors[0]->size(), x.size());
+
+    _scheme = scheme;
+    if(_scheme == COMPLEX_STEP)
+    {
+        XBot::Logger::error("in %s: complex step is not supported for Hessians, using central differences\n", __func__);
+        _scheme = CENTRAL_DIFFERENCES;
+    }
+
+    _x = &x;
+    _step = step > 0.0 ? step : getDefaultStep(_scheme);
+    setColumns(x.size(), jointMask);
+    for(unsigned int t = 0; t < _x_perturbed.size(); ++t)
+        _x_perturbed[t] = x;
+
+    if(_scheme == FORWARD_DIFFERENCES)
+        _g0 = _gradient_vectors[0]->compute(x);
+
+    run();
+    return _hessian;
+}
@@ -0,0 +1,274 @@
+#include <OpenSoT/utils/RTLogger.h>
+#include <XBotInterface/Logger.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace OpenSoT::utils;
+
+namespace
+{
+
+const char MAGIC[8] = {'O', 'S', 'O', 'T', 'L', 'O', 'G', '1'};
+
+}
+
+RTLogger::RTLogger(const std::string& file_name, const unsigned int buffer_size,
+                   const unsigned int period_ms) :
+    _file(NULL),
+    _write(0), _read(0),
+    _dropped(0),
+    _stop(false), _flush(false),
+    _period_ms(std::max(period_ms, 1u))
+{
+    uint64_t size = 1024;
+    while(size < buffer_size)
+        size *= 2;
+    _buffer.resize(size);
+    _mask = size - 1;
+
+    _file = std::fopen(file_name.c_str(), "wb");
+    if(!_file)
+    {
+        XBot::Logger::error("in %s: can not open %s, nothing will be logged\n", __func__, file_name.c_str());
+        return;
+    }
+    std::fwrite(MAGIC, 1, sizeof(MAGIC), _file);
+
+    _thread = std::thread(&RTLogger::run, this);
+}
+
+RTLogger::~RTLogger()
+{
+    if(!_file)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake_up.notify_one();
+    _thread.join();
+    std::fclose(_file);
+}
+
+RTLogger::Handle RTLogger::registerChannel(const std::string& name, const unsigned int rows, const unsigned int cols)
+{
+    if(!_file)
+        return -1;
+
+    Handle handle;
+    std::map<std::string, Handle>::const_iterator it = _handles.find(name);
+    if(it != _handles.end())
+    {
+        handle = it->second;
+        if(rows*cols <= _channels[handle].size)
+            return handle;
+        _channels[handle].size = rows*cols;
+    }
+    else
+    {
+        handle = _channels.size();
+        Channel channel;
+        channel.name = name;
+        channel.size = rows*cols;
+        _channels.push_back(channel);
+        _handles[name] = handle;
+    }
+
+    RecordHeader header;
+    header.type = CHANNEL;
+    header.handle = handle;
+    header.rows = rows;
+    header.cols = cols;
+    header.bytes = name.size();
+    // a channel definition can not be dropped: the samples would not be readable
+    while(!push(header, name.data()))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    return handle;
+}
+
+RTLogger::Handle RTLogger::getHandle(const std::string& name) const
+{
+    std::map<std::string, Handle>::const_iterator it = _handles.find(name);
+    return it == _handles.end() ? -1 : it->second;
+}
+
+bool RTLogger::add(const Handle handle, const Eigen::Ref<const Eigen::MatrixXd>& data)
+{
+    if(handle < 0 || handle >= (Handle)_channels.size())
+        return false;
+    if((unsigned int)data.size() > _channels[handle].size)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    RecordHeader header;
+    header.type = SAMPLE;
+    header.handle = handle;
+    header.rows = data.rows();
+    header.cols = data.cols();
+    header.bytes = data.size()*sizeof(double);
+
+    // Ref is contiguous in the columns, but there could be an outer stride
+    if(data.outerStride() == data.rows() || data.cols() == 1)
+    {
+        if(push(header, data.data()))
+            return true;
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const uint64_t write = _write.load(std::memory_order_relaxed);
+    const uint64_t free = _buffer.size() - (write - _read.load(std::memory_order_acquire));
+    if(sizeof(header) + header.bytes > free)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    copyIn(write, &header, sizeof(header));
+    uint64_t position = write + sizeof(header);
+    for(unsigned int j = 0; j < header.cols; ++j)
+    {
+        copyIn(position, data.col(j).data(), header.rows*sizeof(double));
+        position += header.rows*sizeof(double);
+    }
+    _write.store(position, std::memory_order_release);
+    return true;
+}
+
+bool RTLogger::add(const Handle handle, const double data)
+{
+    return add(handle, Eigen::Map<const Eigen::MatrixXd>(&data, 1, 1));
+}
+
+void RTLogger::flush()
+{
+    if(!_file)
+        return;
+
+    const uint64_t write = _write.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _flush = true;
+    }
+    _wake_up.notify_one();
+    while(_read.load(std::memory_order_acquire) < write)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+unsigned int RTLogger::getDroppedSamples() const
+{
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+bool RTLogger::push(const RecordHeader& header, const void* payload)
+{
+    const uint64_t write = _write.load(std::memory_order_relaxed);
+    const uint64_t free = _buffer.size() - (write - _read.load(std::memory_order_acquire));
+    if(sizeof(header) + header.bytes > free)
+        return false;
+
+    copyIn(write, &header, sizeof(header));
+    copyIn(write + sizeof(header), payload, header.bytes);
+    _write.store(write + sizeof(header) + header.bytes, std::memory_order_release);
+    return true;
+}
+
+void RTLogger::copyIn(const uint64_t position, const void* data, const std::size_t bytes)
+{
+    const std::size_t begin = position & _mask;
+    const std::size_t first = std::min(bytes, _buffer.size() - begin);
+    std::memcpy(&_buffer[begin], data, first);
+    if(first < bytes)
+        std::memcpy(&_buffer[0], static_cast<const char*>(data) + first, bytes - first);
+}
+
+void RTLogger::drain()
+{
+    const uint64_t read = _read.load(std::memory_order_relaxed);
+    const uint64_t write = _write.load(std::memory_order_acquire);
+    if(read == write)
+        return;
+
+    // records are written as they are in the buffer
+    const std::size_t begin = read & _mask;
+    const std::size_t bytes = write - read;
+    const std::size_t first = std::min(bytes, _buffer.size() - begin);
+    std::fwrite(&_buffer[begin], 1, first, _file);
+    if(first < bytes)
+        std::fwrite(&_buffer[0], 1, bytes - first, _file);
+    std::fflush(_file);
+
+    _read.store(write, std::memory_order_release);
+}
+
+void RTLogger::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(!_stop)
+    {
+        lock.unlock();
+        drain();
+        lock.lock();
+        // the producer never notifies: only flush() and the destructor do
+        _wake_up.wait_for(lock, std::chrono::milliseconds(_period_ms), [this]{ return _stop || _flush; });
+        _flush = false;
+    }
+    lock.unlock();
+    drain();
+}
+
+bool RTLogger::load(const std::string& file_name, std::map<std::string, std::vector<Eigen::MatrixXd> >& data)
+{
+    data.clear();
+
+    std::FILE* file = std::fopen(file_name.c_str(), "rb");
+    if(!file)
+    {
+        XBot::Logger::error("in %s: can not open %s\n", __func__, file_name.c_str());
+        return false;
+    }
+
+    char magic[sizeof(MAGIC)];
+    if(std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+       std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        XBot::Logger::error("in %s: %s is not a log file\n", __func__, file_name.c_str());
+        std::fclose(file);
+        return false;
+    }
+
+    std::vector<std::string> names;
+    RecordHeader header;
+    bool ok = true;
+    while(ok && std::fread(&header, sizeof(header), 1, file) == 1)
+    {
+        if(header.type == CHANNEL)
+        {
+            std::string name(header.bytes, ' ');
+            ok = std::fread(&name[0], 1, header.bytes, file) == header.bytes;
+            if(names.size() <= header.handle)
+                names.resize(header.handle + 1);
+            names[header.handle] = name;
+            data[name];
+        }
+        else if(header.type == SAMPLE && header.handle < names.size() &&
+                header.bytes == header.rows*header.cols*sizeof(double))
+        {
+            Eigen::MatrixXd sample(header.rows, header.cols);
+            ok = std::fread(sample.data(), 1, header.bytes, file) == header.bytes;
+            if(ok)
+                data[names[header.handle]].push_back(sample);
+        }
+        else
+            ok = false;
+    }
+    std::fclose(file);
+
+    if(!ok)
+        XBot::Logger::error("in %s: %s is truncated or corrupted\n", __func__, file_name.c_str());
+    return ok;
+}
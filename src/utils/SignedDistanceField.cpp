@@ -0,0 +1,310 @@
+#include <OpenSoT/utils/SignedDistanceField.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdint.h>
+
+using namespace OpenSoT::utils;
+
+namespace
+{
+
+/**
+ * @brief The FileHeader struct is written at the beginning of the file, followed by the grid
+ *        (x index running fastest). Its size is a multiple of 8 so that the grid is aligned.
+ */
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    int32_t size[3];
+    double origin[3];
+    double resolution;
+};
+
+const char SDF_MAGIC[8] = {'O','S','O','T','S','D','F','\0'};
+const uint32_t SDF_VERSION = 1;
+
+/**
+ * @brief squaredDistanceTransform1D computes the squared euclidean distance transform of a
+ *        sampled function (Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled Functions")
+ * @param f input function, of size n
+ * @param d output, of size n
+ * @param v, z temporaries of size n and n+1
+ */
+void squaredDistanceTransform1D(const std::vector<double>& f, std::vector<double>& d,
+                                std::vector<int>& v, std::vector<double>& z, const int n)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+
+    int k = 0;
+    v[0] = 0;
+    z[0] = -inf;
+    z[1] = inf;
+    for(int q = 1; q < n; ++q)
+    {
+        if(f[q] == inf)
+            continue;
+        if(f[v[k]] == inf)
+        {
+            v[k] = q;
+            continue;
+        }
+
+        double s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2.0*q - 2.0*v[k]);
+        while(s <= z[k])
+        {
+            --k;
+            s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2.0*q - 2.0*v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k+1] = inf;
+    }
+
+    k = 0;
+    for(int q = 0; q < n; ++q)
+    {
+        while(z[k+1] < q)
+            ++k;
+        d[q] = (f[v[k]] == inf) ? inf : (q - v[k])*(q - v[k]) + f[v[k]];
+    }
+}
+
+/**
+ * @brief squaredDistanceTransform computes in place the squared distance transform of a 3D grid,
+ *        one axis at a time
+ */
+void squaredDistanceTransform(std::vector<double>& grid, const Eigen::Vector3i& size)
+{
+    const int n_max = size.maxCoeff();
+    std::vector<double> f(n_max), d(n_max), z(n_max + 1);
+    std::vector<int> v(n_max);
+
+    const std::size_t stride[3] = {1,
+                                   std::size_t(size[0]),
+                                   std::size_t(size[0])*size[1]};
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        const int a1 = (axis + 1) % 3, a2 = (axis + 2) % 3;
+        for(int i2 = 0; i2 < size[a2]; ++i2)
+        {
+            for(int i1 = 0; i1 < size[a1]; ++i1)
+            {
+                const std::size_t start = i1*stride[a1] + i2*stride[a2];
+                for(int q = 0; q < size[axis]; ++q)
+                    f[q] = grid[start + q*stride[axis]];
+                squaredDistanceTransform1D(f, d, v, z, size[axis]);
+                for(int q = 0; q < size[axis]; ++q)
+                    grid[start + q*stride[axis]] = d[q];
+            }
+        }
+    }
+}
+
+}
+
+SignedDistanceField::SignedDistanceField(const Eigen::Vector3d& origin,
+                                         const double resolution,
+                                         const Eigen::Vector3i& size):
+    _origin(origin),
+    _resolution(resolution),
+    _size(size),
+    _mapped(NULL),
+    _mapped_size(0),
+    _data(NULL)
+{
+
+}
+
+SignedDistanceField::~SignedDistanceField()
+{
+    if(_mapped != NULL)
+        munmap(_mapped, _mapped_size);
+}
+
+SignedDistanceField::Ptr SignedDistanceField::fromPointCloud(const Points& points,
+                                                             const Eigen::Vector3d& origin,
+                                                             const double resolution,
+                                                             const Eigen::Vector3i& size)
+{
+    if(resolution <= 0.0 || (size.array() < 2).any())
+        return Ptr();
+
+    Ptr sdf(new SignedDistanceField(origin, resolution, size));
+
+    std::vector<bool> occupied(std::size_t(size[0])*size[1]*size[2], false);
+    for(unsigned int n = 0; n < points.size(); ++n)
+    {
+        Eigen::Vector3d g = (points[n] - origin)/resolution;
+        Eigen::Vector3i ijk(std::floor(g[0] + 0.5), std::floor(g[1] + 0.5), std::floor(g[2] + 0.5));
+        if((ijk.array() >= 0).all() && (ijk.array() < size.array()).all())
+            occupied[sdf->index(ijk[0], ijk[1], ijk[2])] = true;
+    }
+
+    sdf->computeFromOccupancy(occupied);
+
+    return sdf;
+}
+
+SignedDistanceField::Ptr SignedDistanceField::fromMesh(const Points& vertices,
+                                                       const Triangles& triangles,
+                                                       const Eigen::Vector3d& origin,
+                                                       const double resolution,
+                                                       const Eigen::Vector3i& size)
+{
+    Points samples;
+    for(unsigned int n = 0; n < triangles.size(); ++n)
+    {
+        const Eigen::Vector3d& a = vertices[triangles[n][0]];
+        const Eigen::Vector3d& b = vertices[triangles[n][1]];
+        const Eigen::Vector3d& c = vertices[triangles[n][2]];
+
+        // sampling with half the resolution along the two edges guarantees that
+        // every voxel crossed by the triangle contains at least one sample
+        double longest_edge = std::max((b - a).norm(), (c - a).norm());
+        int steps = std::max(1, int(std::ceil(2.0*longest_edge/resolution)));
+        for(int i = 0; i <= steps; ++i)
+            for(int j = 0; j <= steps - i; ++j)
+                samples.push_back(a + (double(i)/steps)*(b - a) + (double(j)/steps)*(c - a));
+    }
+
+    return fromPointCloud(samples, origin, resolution, size);
+}
+
+void SignedDistanceField::computeFromOccupancy(const std::vector<bool>& occupied)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    const std::size_t number_of_nodes = occupied.size();
+
+    std::vector<double> distance_from_occupied(number_of_nodes), distance_from_free(number_of_nodes);
+    for(std::size_t n = 0; n < number_of_nodes; ++n)
+    {
+        distance_from_occupied[n] = occupied[n] ? 0.0 : inf;
+        distance_from_free[n] = occupied[n] ? inf : 0.0;
+    }
+
+    squaredDistanceTransform(distance_from_occupied, _size);
+    squaredDistanceTransform(distance_from_free, _size);
+
+    // an empty (or completely full) grid has no boundary: we saturate to the grid diagonal
+    const double max_distance = _resolution*_size.cast<double>().norm();
+
+    _storage.resize(number_of_nodes);
+    for(std::size_t n = 0; n < number_of_nodes; ++n)
+    {
+        double d = occupied[n] ? -std::sqrt(distance_from_free[n]) : std::sqrt(distance_from_occupied[n]);
+        _storage[n] = std::max(-max_distance, std::min(max_distance, _resolution*d));
+    }
+    _data = _storage.data();
+}
+
+bool SignedDistanceField::save(const std::string& file_name) const
+{
+    std::ofstream file(file_name.c_str(), std::ios::binary | std::ios::trunc);
+    if(!file.is_open())
+        return false;
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SDF_MAGIC, sizeof(SDF_MAGIC));
+    header.version = SDF_VERSION;
+    for(unsigned int i = 0; i < 3; ++i)
+    {
+        header.size[i] = _size[i];
+        header.origin[i] = _origin[i];
+    }
+    header.resolution = _resolution;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(_data),
+               sizeof(float)*std::size_t(_size[0])*_size[1]*_size[2]);
+
+    return file.good();
+}
+
+SignedDistanceField::Ptr SignedDistanceField::load(const std::string& file_name)
+{
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if(fd < 0)
+        return Ptr();
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 || std::size_t(file_stat.st_size) < sizeof(FileHeader))
+    {
+        close(fd);
+        return Ptr();
+    }
+
+    std::size_t file_size = file_stat.st_size;
+    void* mapped = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED)
+        return Ptr();
+
+    const FileHeader* header = static_cast<const FileHeader*>(mapped);
+    Eigen::Vector3i size(header->size[0], header->size[1], header->size[2]);
+    if(std::memcmp(header->magic, SDF_MAGIC, sizeof(SDF_MAGIC)) != 0 ||
+       header->version != SDF_VERSION ||
+       (size.array() < 2).any() ||
+       file_size != sizeof(FileHeader) + sizeof(float)*std::size_t(size[0])*size[1]*size[2])
+    {
+        munmap(mapped, file_size);
+        return Ptr();
+    }
+
+    Ptr sdf(new SignedDistanceField(Eigen::Vector3d(header->origin[0], header->origin[1], header->origin[2]),
+                                    header->resolution, size));
+    sdf->_mapped = mapped;
+    sdf->_mapped_size = file_size;
+    sdf->_data = reinterpret_cast<const float*>(static_cast<const char*>(mapped) + sizeof(FileHeader));
+
+    return sdf;
+}
+
+double SignedDistanceField::getDistance(const Eigen::Vector3d& p) const
+{
+    Eigen::Vector3d gradient;
+    return getDistance(p, gradient);
+}
+
+double SignedDistanceField::getDistance(const Eigen::Vector3d& p, Eigen::Vector3d& gradient) const
+{
+    // grid coordinates of p, clamped inside the grid
+    Eigen::Vector3d g = (p - _origin)/_resolution;
+    Eigen::Vector3i ijk;
+    Eigen::Vector3d w;
+    for(unsigned int a = 0; a < 3; ++a)
+    {
+        g[a] = std::max(0.0, std::min(double(_size[a] - 1), g[a]));
+        ijk[a] = std::min(int(g[a]), _size[a] - 2);
+        w[a] = g[a] - ijk[a];
+    }
+
+    const int i = ijk[0], j = ijk[1], k = ijk[2];
+    const double c000 = _data[index(i,   j,   k  )], c100 = _data[index(i+1, j,   k  )];
+    const double c010 = _data[index(i,   j+1, k  )], c110 = _data[index(i+1, j+1, k  )];
+    const double c001 = _data[index(i,   j,   k+1)], c101 = _data[index(i+1, j,   k+1)];
+    const double c011 = _data[index(i,   j+1, k+1)], c111 = _data[index(i+1, j+1, k+1)];
+
+    // interpolation along x
+    const double c00 = c000 + w[0]*(c100 - c000), c10 = c010 + w[0]*(c110 - c010);
+    const double c01 = c001 + w[0]*(c101 - c001), c11 = c011 + w[0]*(c111 - c011);
+    // along y
+    const double c0 = c00 + w[1]*(c10 - c00), c1 = c01 + w[1]*(c11 - c01);
+
+    gradient[0] = ((1.0 - w[2])*((1.0 - w[1])*(c100 - c000) + w[1]*(c110 - c010)) +
+                          w[2] *((1.0 - w[1])*(c101 - c001) + w[1]*(c111 - c011)))/_resolution;
+    gradient[1] = ((1.0 - w[2])*(c10 - c00) + w[2]*(c11 - c01))/_resolution;
+    gradient[2] = (c1 - c0)/_resolution;
+
+    return c0 + w[2]*(c1 - c0);
+}
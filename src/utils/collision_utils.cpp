@@ -8,8 +8,57 @@
 #include <fcl/shape/geometric_shapes.h>
 #include <geometric_shapes/shapes.h>
 #include <geometric_shapes/shape_operations.h>
+#include <resource_retriever/retriever.h>
 #include <boost/make_shared.hpp>
 #include <fcl/config.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+// read the whole content of a file, empty if it can not be read
+std::string readFile(const std::string& file_name)
+{
+    std::ifstream file(file_name.c_str());
+    std::stringstream content;
+    if(file.is_open())
+        content << file.rdbuf();
+    return content.str();
+}
+
+// continue the key of the collision cache with the content of the mesh files referenced by the collision model
+uint64_t hashMeshResources(const std::string& urdf_file, uint64_t key)
+{
+    urdf::Model robot_urdf;
+    if(!robot_urdf.initFile(urdf_file))
+        return key;
+
+    std::vector<boost::shared_ptr<urdf::Link> > links;
+    robot_urdf.getLinks(links);
+    resource_retriever::Retriever retriever;
+    for(unsigned int i = 0; i < links.size(); ++i)
+    {
+        if(!links[i]->collision || !links[i]->collision->geometry ||
+           links[i]->collision->geometry->type != urdf::Geometry::MESH)
+            continue;
+
+        const std::string& file_name =
+                boost::dynamic_pointer_cast< ::urdf::Mesh>(links[i]->collision->geometry)->filename;
+        key = OpenSoT::utils::CollisionGeometryCache::computeKey(file_name.data(), file_name.size(), key);
+        try
+        {
+            resource_retriever::MemoryResource resource = retriever.get(file_name);
+            key = OpenSoT::utils::CollisionGeometryCache::computeKey(
+                        reinterpret_cast<const char*>(resource.data.get()), resource.size, key);
+        }
+        catch(const resource_retriever::Exception& e)
+        {
+            // missing meshes are reported when the collision model is parsed
+        }
+    }
+    return key;
+}
 
 // construct vector
 KDL::Vector toKdl(urdf::Vector3 v)
@@ -53,14 +102,13 @@ bool ComputeLinksDistance::shapeToLinkCoordinates(const std::string& linkName,
     return true;
 }
 
-bool ComputeLinksDistance::parseCollisionObjects(const std::string &robot_urdf_path,
-                                                 const std::string &robot_srdf_path)
+bool ComputeLinksDistance::parseCollisionObjects(const std::string &robot_urdf_path)
 {
     urdf::Model robot_urdf;
 
     robot_urdf.initFile(robot_urdf_path);
-    robot_srdf.initFile(robot_urdf, robot_srdf_path);
 
+    geometry_cache_.shapes.clear();
 
     std::vector<boost::shared_ptr<urdf::Link> > links;
     robot_urdf.getLinks(links);
@@ -77,55 +125,43 @@ bool ComputeLinksDistance::parseCollisionObjects(const std::string &robot_urdf_p
                 link->collision->geometry->type == urdf::Geometry::BOX      ||
                 link->collision->geometry->type == urdf::Geometry::MESH) {
 
-
-                shared_ptr<fcl::CollisionGeometry> shape;
-                KDL::Frame shape_origin;
+                OpenSoT::utils::CollisionGeometryCache::Shape shape;
+                shape.link_name = link->name;
+                shape.size.setZero();
+                shape.position = Eigen::Vector3d(link->collision->origin.position.x,
+                                                 link->collision->origin.position.y,
+                                                 link->collision->origin.position.z);
+                shape.orientation = Eigen::Quaterniond(link->collision->origin.rotation.w,
+                                                       link->collision->origin.rotation.x,
+                                                       link->collision->origin.rotation.y,
+                                                       link->collision->origin.rotation.z);
 
                 if (link->collision->geometry->type == urdf::Geometry::CYLINDER) {
-                    std::cout << "adding capsule for " << link->name << std::endl;
-
                     boost::shared_ptr<urdf::Cylinder> collisionGeometry =
                             boost::dynamic_pointer_cast<urdf::Cylinder>(
                                     link->collision->geometry);
 
-                    shape.reset(new fcl::Capsule(collisionGeometry->radius,
-                                                 collisionGeometry->length));
-
-                    shape_origin = toKdl(link->collision->origin);
-                    shape_origin.p -= collisionGeometry->length/2.0 * shape_origin.M.UnitZ();
-
-                    custom_capsules_[link->name] =
-                        boost::shared_ptr<ComputeLinksDistance::Capsule>(
-                            new ComputeLinksDistance::Capsule(shape_origin,
-                                                              collisionGeometry->radius,
-                                                              collisionGeometry->length));
+                    shape.type = OpenSoT::utils::CollisionGeometryCache::CAPSULE;
+                    shape.size[0] = collisionGeometry->radius;
+                    shape.size[1] = collisionGeometry->length;
                 } else if (link->collision->geometry->type == urdf::Geometry::SPHERE) {
-                    std::cout << "adding sphere for " << link->name << std::endl;
-
                     boost::shared_ptr<urdf::Sphere> collisionGeometry =
                             boost::dynamic_pointer_cast<urdf::Sphere>(
                                     link->collision->geometry);
 
-                    shape.reset(new fcl::Sphere(collisionGeometry->radius));
-                    shape_origin = toKdl(link->collision->origin);
+                    shape.type = OpenSoT::utils::CollisionGeometryCache::SPHERE;
+                    shape.size[0] = collisionGeometry->radius;
                 } else if (link->collision->geometry->type == urdf::Geometry::BOX) {
-                    std::cout << "adding box for " << link->name << std::endl;
-
                     boost::shared_ptr<urdf::Box> collisionGeometry =
                             boost::dynamic_pointer_cast<urdf::Box>(
                                     link->collision->geometry);
 
-                    shape.reset(new fcl::Box(collisionGeometry->dim.x,
-                                             collisionGeometry->dim.y,
-                                             collisionGeometry->dim.z));
-                    shape_origin = toKdl(link->collision->origin);
-                    std::cout << "Box has size " << collisionGeometry->dim.x <<
-                                 ", " << collisionGeometry->dim.y <<
-                                 ", " << collisionGeometry->dim.z << std::endl;
+                    shape.type = OpenSoT::utils::CollisionGeometryCache::BOX;
+                    shape.size = Eigen::Vector3d(collisionGeometry->dim.x,
+                                                 collisionGeometry->dim.y,
+                                                 collisionGeometry->dim.z);
                 }
                 else if(link->collision->geometry->type == urdf::Geometry::MESH){
-                    std::cout << "adding mesh for " << link->name << std::endl;
-
                     boost::shared_ptr< ::urdf::Mesh> collisionGeometry = boost::dynamic_pointer_cast< ::urdf::Mesh> (link->collision->geometry);
 
                     shapes::Mesh *mesh = shapes::createMeshFromResource(collisionGeometry->filename);
@@ -135,44 +171,20 @@ bool ComputeLinksDistance::parseCollisionObjects(const std::string &robot_urdf_p
                         continue;
                     }
 
-                    std::vector<fcl::Vec3f> vertices;
-                    std::vector<fcl::Triangle> triangles;
-
+                    shape.type = OpenSoT::utils::CollisionGeometryCache::MESH;
+                    shape.vertices.reserve(3*mesh->vertex_count);
                     for(unsigned int i=0; i < mesh->vertex_count; ++i){
-                        fcl::Vec3f v(mesh->vertices[3*i]*collisionGeometry->scale.x,
-                                     mesh->vertices[3*i + 1]*collisionGeometry->scale.y,
-                                     mesh->vertices[3*i + 2]*collisionGeometry->scale.z);
-
-                        vertices.push_back(v);
+                        shape.vertices.push_back(mesh->vertices[3*i]*collisionGeometry->scale.x);
+                        shape.vertices.push_back(mesh->vertices[3*i + 1]*collisionGeometry->scale.y);
+                        shape.vertices.push_back(mesh->vertices[3*i + 2]*collisionGeometry->scale.z);
                     }
 
-                    for(unsigned int i=0; i< mesh->triangle_count; ++i){
-                        fcl::Triangle t(mesh->triangles[3*i],
-                                        mesh->triangles[3*i + 1],
-                                        mesh->triangles[3*i + 2]);
-                        triangles.push_back(t);
-                    }
-
-                    // add the mesh data into the BVHModel structure
-                    shape.reset(new fcl::BVHModel<fcl::OBBRSS>);
-                    fcl::BVHModel<fcl::OBBRSS>* bvhModel = (fcl::BVHModel<fcl::OBBRSS>*)shape.get();
-                    bvhModel->beginModel();
-                    bvhModel->addSubModel(vertices, triangles);
-                    bvhModel->endModel();
+                    shape.triangles.assign(mesh->triangles, mesh->triangles + 3*mesh->triangle_count);
 
-                    shape_origin = toKdl(link->collision->origin);
+                    delete mesh;
                 }
 
-                boost::shared_ptr<fcl::CollisionObject> collision_object(
-                        new fcl::CollisionObject(shape));
-
-
-                collision_objects_[link->name] = collision_object;
-                shapes_[link->name] = shape;
-
-                /* Store the transformation of the CollisionShape from URDF
-                 * that is, we store link_T_shape for the actual link */
-                link_T_shape[link->name] = shape_origin;
+                geometry_cache_.shapes.push_back(shape);
             } else {
                 std::cout << "Collision type unknown for link " << link->name << std::endl;
             }
@@ -180,28 +192,158 @@ bool ComputeLinksDistance::parseCollisionObjects(const std::string &robot_urdf_p
             std::cout << "Collision not defined for link " << link->name << std::endl;
         }
     }
+
+    return createCollisionObjects(geometry_cache_);
+}
+
+bool ComputeLinksDistance::createCollisionObjects(const OpenSoT::utils::CollisionGeometryCache& cache)
+{
+    typedef OpenSoT::utils::CollisionGeometryCache::Shape CacheShape;
+
+    for(unsigned int n = 0; n < cache.shapes.size(); ++n)
+    {
+        const CacheShape& cache_shape = cache.shapes[n];
+        const std::string& link_name = cache_shape.link_name;
+
+        shared_ptr<fcl::CollisionGeometry> shape;
+        KDL::Frame shape_origin(KDL::Rotation::Quaternion(cache_shape.orientation.x(),
+                                                          cache_shape.orientation.y(),
+                                                          cache_shape.orientation.z(),
+                                                          cache_shape.orientation.w()),
+                                KDL::Vector(cache_shape.position.x(),
+                                            cache_shape.position.y(),
+                                            cache_shape.position.z()));
+
+        if (cache_shape.type == OpenSoT::utils::CollisionGeometryCache::CAPSULE) {
+            std::cout << "adding capsule for " << link_name << std::endl;
+
+            double radius = cache_shape.size[0], length = cache_shape.size[1];
+            shape.reset(new fcl::Capsule(radius, length));
+
+            // fcl capsules are centered in the shape frame,
+            // while the custom capsule frame lies on its first endpoint
+            KDL::Frame capsule_origin = shape_origin;
+            capsule_origin.p -= length/2.0 * capsule_origin.M.UnitZ();
+
+            custom_capsules_[link_name] =
+                boost::shared_ptr<ComputeLinksDistance::Capsule>(
+                    new ComputeLinksDistance::Capsule(capsule_origin, radius, length));
+            primitive_shapes_[link_name] = custom_capsules_[link_name];
+        } else if (cache_shape.type == OpenSoT::utils::CollisionGeometryCache::SPHERE) {
+            std::cout << "adding sphere for " << link_name << std::endl;
+
+            shape.reset(new fcl::Sphere(cache_shape.size[0]));
+
+            primitive_shapes_[link_name] =
+                boost::shared_ptr<ComputeLinksDistance::Capsule>(
+                    new ComputeLinksDistance::Capsule(shape_origin, cache_shape.size[0], 0.0));
+        } else if (cache_shape.type == OpenSoT::utils::CollisionGeometryCache::BOX) {
+            std::cout << "adding box for " << link_name << std::endl;
+
+            shape.reset(new fcl::Box(cache_shape.size[0], cache_shape.size[1], cache_shape.size[2]));
+            std::cout << "Box has size " << cache_shape.size[0] <<
+                         ", " << cache_shape.size[1] <<
+                         ", " << cache_shape.size[2] << std::endl;
+        } else {
+            std::cout << "adding mesh for " << link_name << std::endl;
+
+            std::vector<fcl::Vec3f> vertices;
+            std::vector<fcl::Triangle> triangles;
+
+            for(unsigned int i=0; i + 2 < cache_shape.vertices.size(); i += 3)
+                vertices.push_back(fcl::Vec3f(cache_shape.vertices[i],
+                                              cache_shape.vertices[i + 1],
+                                              cache_shape.vertices[i + 2]));
+
+            for(unsigned int i=0; i + 2 < cache_shape.triangles.size(); i += 3)
+                triangles.push_back(fcl::Triangle(cache_shape.triangles[i],
+                                                  cache_shape.triangles[i + 1],
+                                                  cache_shape.triangles[i + 2]));
+
+            // add the mesh data into the BVHModel structure
+            shape.reset(new fcl::BVHModel<fcl::OBBRSS>);
+            fcl::BVHModel<fcl::OBBRSS>* bvhModel = (fcl::BVHModel<fcl::OBBRSS>*)shape.get();
+            bvhModel->beginModel();
+            bvhModel->addSubModel(vertices, triangles);
+            bvhModel->endModel();
+        }
+
+        boost::shared_ptr<fcl::CollisionObject> collision_object(
+                new fcl::CollisionObject(shape));
+
+        collision_objects_[link_name] = collision_object;
+        shapes_[link_name] = shape;
+
+        /* Store the transformation of the CollisionShape from URDF
+         * that is, we store link_T_shape for the actual link */
+        link_T_shape[link_name] = shape_origin;
+    }
+
+    generateLinkIds();
+
     return true;
 }
 
-bool ComputeLinksDistance::updateCollisionObjects()
+void ComputeLinksDistance::loadCollisionMatrixModels()
+{
+    if(moveit_robot_model)
+        return;
+
+    boost::shared_ptr<urdf::Model> urdf_model_ptr =
+            boost::shared_ptr<urdf::Model>(new urdf::Model());
+    urdf_model_ptr->initString(model.getUrdfString());
+
+    boost::shared_ptr<srdf::Model> srdf_model_ptr =
+            boost::shared_ptr<srdf::Model>(new srdf::Model());
+    srdf_model_ptr->initString(*urdf_model_ptr, model.getSrdfString());
+
+    moveit_robot_model.reset(new robot_model::RobotModel(urdf_model_ptr, srdf_model_ptr));
+
+    urdf::Model robot_urdf;
+    robot_urdf.initFile(urdf_to_load_);
+    robot_srdf.initFile(robot_urdf, srdf_to_load_);
+}
+
+std::string ComputeLinksDistance::getCacheFile(const std::string& cache_directory, const uint64_t key)
+{
+    boost::filesystem::path directory(cache_directory);
+
+    std::stringstream file_name;
+    file_name << "collision_geometry_" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+
+    return (directory / file_name.str()).string();
+}
+
+void ComputeLinksDistance::generateLinkIds()
 {
-    typedef std::set<std::string>::iterator it_links;
+    links_.clear();
+    link_ids_.clear();
+
     typedef std::map<std::string,boost::shared_ptr<fcl::CollisionObject> >::iterator it_co;
+    for(it_co it = collision_objects_.begin(); it != collision_objects_.end(); ++it)
+    {
+        LinkData link_data;
+        link_data.name = it->first;
+        link_data.collisionObject = it->second.get();
+        link_data.link_T_shape = &link_T_shape[it->first];
 
-//    for(it_type it = collision_objects_.begin();
-//        it != collision_objects_.end(); ++it)
-    for(it_links it = linksToUpdate.begin();
-        it != linksToUpdate.end(); ++it)
+        link_ids_[it->first] = links_.size();
+        links_.push_back(link_data);
+    }
+}
+
+bool ComputeLinksDistance::updateCollisionObjects()
+{
+    for(unsigned int i = 0; i < linkIdsToUpdate.size(); ++i)
     {
-//        std::string link_name = it->first;
-        std::string link_name = *it;
-        KDL::Frame w_T_link, w_T_shape;
-        model.getPose(link_name, w_T_link);
-        w_T_shape = w_T_link * link_T_shape[link_name];
+        LinkData& link = links_[linkIdsToUpdate[i]];
+        model.getPose(link.name, link.w_T_link);
+        KDL::Frame w_T_shape = link.w_T_link * (*link.link_T_shape);
 
         fcl::Transform3f fcl_w_T_shape = KDL2fcl(w_T_shape);
-        fcl::CollisionObject* collObj_shape = collision_objects_[link_name].get();
+        fcl::CollisionObject* collObj_shape = link.collisionObject;
         collObj_shape->setTransform(fcl_w_T_shape);
+        collObj_shape->computeAABB();
     }
     return true;
 }
@@ -230,48 +372,70 @@ KDL::Frame ComputeLinksDistance::fcl2KDL(const fcl::Transform3f &in)
     return f;
 }
 
-void ComputeLinksDistance::generateLinksToUpdate()
+double ComputeLinksDistance::aabbDistance(const fcl::CollisionObject& collObjA,
+                                          const fcl::CollisionObject& collObjB)
 {
-    linksToUpdate.clear();
-    std::vector<std::string> collisionEntries;
-    // TODO isn't the result of
-    // model.moveit_robot_model->getLinkModelNamesWithCollisionGeometry()
-    // exactly what we are looking for?
-    allowed_collision_matrix->getAllEntryNames(collisionEntries);
-    typedef std::vector<std::string>::iterator iter_link;
-    typedef std::list<std::pair<std::string,std::string> >::iterator iter_pair;
+    const fcl::AABB& aabbA = collObjA.getAABB();
+    const fcl::AABB& aabbB = collObjB.getAABB();
 
-    for(iter_link it_A = collisionEntries.begin();
-        it_A != collisionEntries.end();
-        ++it_A)
+    double squared_distance = 0.0;
+    for(unsigned int i = 0; i < 3; ++i)
     {
-        for(iter_link it_B = collisionEntries.begin();
-            it_B != collisionEntries.end();
-            ++it_B)
-        {
-            if(it_B <= it_A)
-                continue;
-            else
-            {
-                collision_detection::AllowedCollision::Type collisionType;
-                if(allowed_collision_matrix->getAllowedCollision(*it_A,*it_B,collisionType) &&
-                   collisionType == collision_detection::AllowedCollision::NEVER)
-                {
-                    linksToUpdate.insert(*it_A);
-                    linksToUpdate.insert(*it_B);
-                }
-            }
-        }
+        double gap = std::max(aabbA.min_[i] - aabbB.max_[i],
+                              aabbB.min_[i] - aabbA.max_[i]);
+        if(gap > 0.0)
+            squared_distance += gap*gap;
     }
+
+    return std::sqrt(squared_distance);
+}
+
+double ComputeLinksDistance::displacementBound(const fcl::CollisionGeometry& geometry,
+                                               const fcl::Transform3f& w_T_from,
+                                               const fcl::Transform3f& w_T_to)
+{
+    fcl::Vec3f center_displacement = w_T_to.transform(geometry.aabb_center) -
+                                     w_T_from.transform(geometry.aabb_center);
+
+    fcl::Quaternion3f q_from = w_T_from.getQuatRotation();
+    fcl::Quaternion3f q_to = w_T_to.getQuatRotation();
+    double cos_half_angle = std::fabs(q_from.getW()*q_to.getW() + q_from.getX()*q_to.getX() +
+                                      q_from.getY()*q_to.getY() + q_from.getZ()*q_to.getZ());
+    double angle = 2.0*std::acos(std::min(cos_half_angle, 1.0));
+
+    return std::sqrt(center_displacement.dot(center_displacement)) + angle*geometry.aabb_radius;
+}
+
+bool ComputeLinksDistance::canSkipByCoherence(const ComputeLinksDistance::LinksPair& pair,
+                                              const double detectionThreshold)
+{
+    if(!pair.cacheValid)
+        return false;
+
+    double distance_lower_bound = pair.cachedDistance -
+        displacementBound(*pair.collisionObjectA->collisionGeometry(),
+                          pair.cachedTransformA, pair.collisionObjectA->getTransform()) -
+        displacementBound(*pair.collisionObjectB->collisionGeometry(),
+                          pair.cachedTransformB, pair.collisionObjectB->getTransform());
+
+    return distance_lower_bound >= detectionThreshold;
+}
+
+void ComputeLinksDistance::updateCoherenceCache(ComputeLinksDistance::LinksPair& pair,
+                                                const double distanceLowerBound)
+{
+    pair.cachedDistance = distanceLowerBound;
+    pair.cachedTransformA = pair.collisionObjectA->getTransform();
+    pair.cachedTransformB = pair.collisionObjectB->getTransform();
+    pair.cacheValid = true;
 }
 
 void ComputeLinksDistance::generatePairsToCheck()
 {
-    pairsToCheck.clear();
+    std::vector<OpenSoT::utils::CollisionGeometryCache::LinksPair> pairs;
     std::vector<std::string> collisionEntries;
     allowed_collision_matrix->getAllEntryNames(collisionEntries);
     typedef std::vector<std::string>::iterator iter_link;
-    typedef std::list<std::pair<std::string,std::string> >::iterator iter_pair;
 
     for(iter_link it_A = collisionEntries.begin();
         it_A != collisionEntries.end();
@@ -288,25 +452,49 @@ void ComputeLinksDistance::generatePairsToCheck()
                 collision_detection::AllowedCollision::Type collisionType;
                 if(allowed_collision_matrix->getAllowedCollision(*it_A,*it_B,collisionType) &&
                    collisionType == collision_detection::AllowedCollision::NEVER)
-                pairsToCheck.push_back(ComputeLinksDistance::LinksPair(this,*it_A,*it_B));
+                pairs.push_back(OpenSoT::utils::CollisionGeometryCache::LinksPair(*it_A,*it_B));
             }
         }
     }
-    std::cout << "Checking " << pairsToCheck.size() << " pairs for collision" << std::endl;
+
+    setPairsToCheck(pairs);
 }
 
-ComputeLinksDistance::ComputeLinksDistance(XBot::ModelInterface &model) : model(model)
+void ComputeLinksDistance::setPairsToCheck(const std::vector<OpenSoT::utils::CollisionGeometryCache::LinksPair>& pairs)
 {
-    boost::shared_ptr<urdf::Model> urdf_model_ptr =
-            boost::shared_ptr<urdf::Model>(new urdf::Model());
-    urdf_model_ptr->initString(model.getUrdfString());
+    pairsToCheck.clear();
+    linksToUpdate.clear();
 
-    boost::shared_ptr<srdf::Model> srdf_model_ptr =
-            boost::shared_ptr<srdf::Model>(new srdf::Model());
-    srdf_model_ptr->initString(*urdf_model_ptr, model.getSrdfString());
+    for(unsigned int i = 0; i < pairs.size(); ++i)
+    {
+        pairsToCheck.push_back(ComputeLinksDistance::LinksPair(this, pairs[i].first, pairs[i].second,
+                                                               pairsToCheck.size()));
+        linksToUpdate.insert(pairs[i].first);
+        linksToUpdate.insert(pairs[i].second);
+    }
 
-    moveit_robot_model.reset(new robot_model::RobotModel(urdf_model_ptr, srdf_model_ptr));
+    linkIdsToUpdate.clear();
+    for(std::set<std::string>::iterator it = linksToUpdate.begin();
+        it != linksToUpdate.end(); ++it)
+        linkIdsToUpdate.push_back(link_ids_[*it]);
+
+    unsigned int number_of_primitive_pairs = 0;
+    for(std::list< ComputeLinksDistance::LinksPair >::iterator it = pairsToCheck.begin();
+        it != pairsToCheck.end(); ++it)
+        if(it->isPrimitivePair())
+            ++number_of_primitive_pairs;
+
+    primitive_distances_.resize(number_of_primitive_pairs);
+    primitive_pairs_.clear();
+    primitive_pairs_.reserve(number_of_primitive_pairs);
+    indexed_results_.resize(pairsToCheck.size());
+
+    std::cout << "Checking " << pairsToCheck.size() << " pairs for collision" << std::endl;
+}
 
+ComputeLinksDistance::ComputeLinksDistance(XBot::ModelInterface &model,
+                                           const std::string& cache_directory) : model(model)
+{
     boost::filesystem::path original_urdf(model.getUrdfPath());
     std::string capsule_model_urdf_filename = std::string(original_urdf.stem().c_str()) + std::string("_capsules.urdf");
     boost::filesystem::path capsule_urdf(original_urdf.parent_path() /
@@ -317,44 +505,145 @@ ComputeLinksDistance::ComputeLinksDistance(XBot::ModelInterface &model) : model(
     boost::filesystem::path capsule_srdf(original_srdf.parent_path() /
                                           capsule_model_srdf_filename);
 
-    std::string urdf_to_load, srdf_to_load;
-
     if(boost::filesystem::exists(capsule_urdf))
-        urdf_to_load = capsule_urdf.c_str();
+        urdf_to_load_ = capsule_urdf.c_str();
     else
-        urdf_to_load = original_urdf.c_str();
+        urdf_to_load_ = original_urdf.c_str();
 
     if(boost::filesystem::exists(capsule_srdf))
-        srdf_to_load = capsule_srdf.c_str();
+        srdf_to_load_ = capsule_srdf.c_str();
+    else
+        srdf_to_load_ = original_srdf.c_str();
+
+
+    std::cout<<"srdf_to_load: "<<srdf_to_load_<<std::endl;
+    std::cout<<"urdf_to_load: "<<urdf_to_load_<<std::endl;
+
+    // the pairs to check depend on both the robot model and the collision model
+    uint64_t key = 0;
+    std::string cache_file;
+    if(!cache_directory.empty())
+    {
+        key = OpenSoT::utils::CollisionGeometryCache::computeKey(
+                    model.getUrdfString() + model.getSrdfString() +
+                    readFile(urdf_to_load_) + readFile(srdf_to_load_));
+        key = hashMeshResources(urdf_to_load_, key);
+        cache_file = getCacheFile(cache_directory, key);
+    }
+
+    if(!cache_file.empty() && geometry_cache_.load(cache_file, key))
+    {
+        std::cout << "loading collision geometries from cache " << cache_file << std::endl;
+
+        this->createCollisionObjects(geometry_cache_);
+        this->setPairsToCheck(geometry_cache_.pairs);
+    }
     else
-        srdf_to_load = original_srdf.c_str();
+    {
+        this->loadCollisionMatrixModels();
 
+        this->parseCollisionObjects(urdf_to_load_);
 
-    std::cout<<"srdf_to_load: "<<srdf_to_load<<std::endl;
-    std::cout<<"urdf_to_load: "<<urdf_to_load<<std::endl;
+        this->setCollisionBlackList(std::list<LinkPairDistance::LinksPair>());
 
-    this->parseCollisionObjects(urdf_to_load, srdf_to_load);
+        geometry_cache_.pairs.clear();
+        for(std::list< ComputeLinksDistance::LinksPair >::iterator it = pairsToCheck.begin();
+            it != pairsToCheck.end(); ++it)
+            geometry_cache_.pairs.push_back(
+                OpenSoT::utils::CollisionGeometryCache::LinksPair(it->linkA, it->linkB));
 
-    this->setCollisionBlackList(std::list<LinkPairDistance::LinksPair>());
+        if(!cache_file.empty())
+        {
+            boost::system::error_code error;
+            boost::filesystem::create_directories(boost::filesystem::path(cache_file).parent_path(), error);
+            if(!geometry_cache_.save(cache_file, key))
+                std::cout << "Could not write collision geometries cache " << cache_file << std::endl;
+        }
+    }
 }
 
 std::list<LinkPairDistance> ComputeLinksDistance::getLinkDistances(double detectionThreshold)
 {
     std::list<LinkPairDistance> results;
 
+    unsigned int number_of_results = getLinkDistances(detectionThreshold, indexed_results_);
+    for(unsigned int i = 0; i < number_of_results; ++i)
+    {
+        const IndexedLinkPairDistance& result = indexed_results_[i];
+        results.push_back(LinkPairDistance(links_[result.linkAId].name,
+                                           links_[result.linkBId].name,
+                                           result.linkA_T_closestPoint,
+                                           result.linkB_T_closestPoint,
+                                           result.distance));
+    }
+
+    results.sort();
+
+    return results;
+}
+
+unsigned int ComputeLinksDistance::getLinkDistances(const double detectionThreshold,
+                                                    std::vector<IndexedLinkPairDistance>& results)
+{
+    if(results.size() < pairsToCheck.size())
+        results.resize(pairsToCheck.size());
+    unsigned int number_of_results = 0;
+
     updateCollisionObjects();
 
     typedef std::list< ComputeLinksDistance::LinksPair >::iterator iter_pair;
 
+    primitive_pairs_.clear();
+
     for(iter_pair it = pairsToCheck.begin();
         it != pairsToCheck.end();
         ++it)
     {
-        std::string linkA = it->linkA;
-        std::string linkB = it->linkB;
+        const LinkData& linkA = links_[it->linkAId];
+        const LinkData& linkB = links_[it->linkBId];
+
+        fcl::CollisionObject* collObj_shapeA = linkA.collisionObject;
+        fcl::CollisionObject* collObj_shapeB = linkB.collisionObject;
+
+        if(detectionThreshold < std::numeric_limits<double>::infinity())
+        {
+            // temporal coherence: the pair was far enough last time it was checked,
+            // and the shapes did not move enough to get within the threshold
+            if(canSkipByCoherence(*it, detectionThreshold))
+                continue;
+
+            // broad phase: the distance between the AABBs is a lower bound of the
+            // distance between the shapes, so we can skip the narrow phase if the
+            // boxes are already farther than the detection threshold
+            double aabb_distance = aabbDistance(*collObj_shapeA, *collObj_shapeB);
+            if(aabb_distance >= detectionThreshold)
+            {
+                updateCoherenceCache(*it, aabb_distance);
+                continue;
+            }
+        }
 
-        fcl::CollisionObject* collObj_shapeA = it->collisionObjectA.get();
-        fcl::CollisionObject* collObj_shapeB = it->collisionObjectB.get();
+        // capsules and spheres are computed all together after this loop
+        if(it->isPrimitivePair())
+        {
+            KDL::Vector A_ep1, A_ep2, B_ep1, B_ep2;
+            it->primitiveA->getEndPoints(A_ep1, A_ep2);
+            it->primitiveB->getEndPoints(B_ep1, B_ep2);
+            const KDL::Frame& w_T_linkA = linkA.w_T_link;
+            const KDL::Frame& w_T_linkB = linkB.w_T_link;
+            A_ep1 = w_T_linkA * A_ep1; A_ep2 = w_T_linkA * A_ep2;
+            B_ep1 = w_T_linkB * B_ep1; B_ep2 = w_T_linkB * B_ep2;
+
+            primitive_distances_.setPair(primitive_pairs_.size(),
+                Eigen::Vector3d(A_ep1.x(), A_ep1.y(), A_ep1.z()),
+                Eigen::Vector3d(A_ep2.x(), A_ep2.y(), A_ep2.z()),
+                it->primitiveA->getRadius(),
+                Eigen::Vector3d(B_ep1.x(), B_ep1.y(), B_ep1.z()),
+                Eigen::Vector3d(B_ep2.x(), B_ep2.y(), B_ep2.z()),
+                it->primitiveB->getRadius());
+            primitive_pairs_.push_back(&(*it));
+            continue;
+        }
 
         fcl::DistanceRequest request;
 #if FCL_MINOR_VERSION > 2
@@ -368,33 +657,85 @@ std::list<LinkPairDistance> ComputeLinksDistance::getLinkDistances(double detect
         // perform distance test
         fcl::distance(collObj_shapeA, collObj_shapeB, request, result);
 
-        // p1Homo, p2Homo newly computed points by FCL
-        // absolutely computed w.r.t. base-frame
-        KDL::Frame linkA_pA, linkB_pB;
+        updateCoherenceCache(*it, result.min_distance);
 
-        if(collObj_shapeA->getNodeType() == fcl::GEOM_CAPSULE &&
-           collObj_shapeB->getNodeType() == fcl::GEOM_CAPSULE)
+        if(result.min_distance < detectionThreshold)
         {
-            globalToLinkCoordinates(linkA, result.nearest_points[0], linkA_pA);
-            globalToLinkCoordinates(linkB, result.nearest_points[1], linkB_pB);
-        } else {
-            shapeToLinkCoordinates(linkA, result.nearest_points[0], linkA_pA);
-            shapeToLinkCoordinates(linkB, result.nearest_points[1], linkB_pB);
+            IndexedLinkPairDistance& linkPairDistance = results[number_of_results++];
+            linkPairDistance.pairId = it->pairId;
+            linkPairDistance.linkAId = it->linkAId;
+            linkPairDistance.linkBId = it->linkBId;
+            linkPairDistance.distance = result.min_distance;
+
+            // nearest points computed by fcl are expressed in world frame for capsule pairs,
+            // in shape frame otherwise
+            fcl::Transform3f fcl_pA(result.nearest_points[0]), fcl_pB(result.nearest_points[1]);
+            if(collObj_shapeA->getNodeType() == fcl::GEOM_CAPSULE &&
+               collObj_shapeB->getNodeType() == fcl::GEOM_CAPSULE)
+            {
+                fcl_pA = collObj_shapeA->getTransform().inverseTimes(fcl_pA);
+                fcl_pB = collObj_shapeB->getTransform().inverseTimes(fcl_pB);
+            }
+            linkPairDistance.linkA_T_closestPoint = (*linkA.link_T_shape) * fcl2KDL(fcl_pA);
+            linkPairDistance.linkB_T_closestPoint = (*linkB.link_T_shape) * fcl2KDL(fcl_pB);
         }
+    }
 
-        if(result.min_distance < detectionThreshold)
-            results.push_back(LinkPairDistance(linkA, linkB,
-                                               linkA_pA, linkB_pB,
-                                               result.min_distance));
+    primitive_distances_.compute(primitive_pairs_.size());
+    for(unsigned int i = 0; i < primitive_pairs_.size(); ++i)
+    {
+        ComputeLinksDistance::LinksPair& pair = *primitive_pairs_[i];
+        double distance = primitive_distances_.getDistance(i);
+
+        updateCoherenceCache(pair, distance);
+
+        if(distance < detectionThreshold)
+        {
+            Eigen::Vector3d w_pA, w_pB;
+            primitive_distances_.getClosestPoints(i, w_pA, w_pB);
+
+            IndexedLinkPairDistance& linkPairDistance = results[number_of_results++];
+            linkPairDistance.pairId = pair.pairId;
+            linkPairDistance.linkAId = pair.linkAId;
+            linkPairDistance.linkBId = pair.linkBId;
+            linkPairDistance.distance = distance;
+            linkPairDistance.linkA_T_closestPoint = links_[pair.linkAId].w_T_link.Inverse() *
+                                  KDL::Frame(KDL::Vector(w_pA.x(), w_pA.y(), w_pA.z()));
+            linkPairDistance.linkB_T_closestPoint = links_[pair.linkBId].w_T_link.Inverse() *
+                                  KDL::Frame(KDL::Vector(w_pB.x(), w_pB.y(), w_pB.z()));
+        }
     }
 
-    results.sort();
+    return number_of_results;
+}
 
-    return results;
+int ComputeLinksDistance::getLinkId(const std::string& linkName) const
+{
+    std::map<std::string, unsigned int>::const_iterator it = link_ids_.find(linkName);
+    if(it == link_ids_.end())
+        return -1;
+    return it->second;
+}
+
+const std::string& ComputeLinksDistance::getLinkName(const unsigned int linkId) const
+{
+    return links_[linkId].name;
+}
+
+unsigned int ComputeLinksDistance::getNumberOfLinks() const
+{
+    return links_.size();
+}
+
+unsigned int ComputeLinksDistance::getNumberOfPairs() const
+{
+    return pairsToCheck.size();
 }
 
 bool ComputeLinksDistance::setCollisionWhiteList(std::list<LinkPairDistance::LinksPair> whiteList)
 {
+    loadCollisionMatrixModels();
+
     allowed_collision_matrix.reset(
         new collision_detection::AllowedCollisionMatrix(
             moveit_robot_model->getLinkModelNamesWithCollisionGeometry(), true));
@@ -426,7 +767,6 @@ bool ComputeLinksDistance::setCollisionWhiteList(std::list<LinkPairDistance::Lin
 
     loadDisabledCollisionsFromSRDF(this->robot_srdf, allowed_collision_matrix);
 
-    this->generateLinksToUpdate();
     this->generatePairsToCheck();
 
     //allowed_collision_matrix->print(std::cout);
@@ -435,6 +775,8 @@ bool ComputeLinksDistance::setCollisionWhiteList(std::list<LinkPairDistance::Lin
 
 bool ComputeLinksDistance::setCollisionBlackList(std::list<LinkPairDistance::LinksPair> blackList)
 {
+    loadCollisionMatrixModels();
+
     allowed_collision_matrix.reset(
         new collision_detection::AllowedCollisionMatrix(
             moveit_robot_model->getLinkModelNamesWithCollisionGeometry(), true));
@@ -453,7 +795,6 @@ bool ComputeLinksDistance::setCollisionBlackList(std::list<LinkPairDistance::Lin
 
     loadDisabledCollisionsFromSRDF(model.getSrdf(),allowed_collision_matrix);
 
-    this->generateLinksToUpdate();
     this->generatePairsToCheck();
 
     //allowed_collision_matrix->print(std::cout);
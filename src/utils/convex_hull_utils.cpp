@@ -18,139 +18,106 @@
 */
 
 #include <OpenSoT/utils/convex_hull_utils.h>
-#include <pcl/surface/convex_hull.h>
+#include <XBotInterface/Logger.hpp>
+#include <algorithm>
 
-convex_hull::convex_hull():
-    _ransac_distance_thr(0.001),
-    _pointCloud(new pcl::PointCloud<pcl::PointXYZ>()),
-    _projectedPointCloud(new pcl::PointCloud<pcl::PointXYZ>())
+namespace
 {
 
-}
-
-convex_hull::~convex_hull()
+bool lexicographicLess(const KDL::Vector& a, const KDL::Vector& b)
 {
+    return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+}
 
 }
 
-bool convex_hull::getConvexHull(const std::list<KDL::Vector>& points,
-                                      std::vector<KDL::Vector>& convex_hull)
+convex_hull::convex_hull()
 {
-    fromSTDList2PCLPointCloud(points, _pointCloud);
-
-    //Filtering
-    projectPCL2Plane(_pointCloud, _ransac_distance_thr, _projectedPointCloud);
 
-
-    pcl::PointCloud<pcl::PointXYZ> pointsInConvexHull;
-    std::vector<pcl::Vertices> indicesOfVertexes;
-
-    // hullVertices.vertices is the list of vertices...
-    // by taking each point and the consequent in the list
-    // (i.e. vertices[1]-vertices[0] it is possible to compute
-    // bounding segments for the hull
-    pcl::ConvexHull<pcl::PointXYZ> huller;
-    huller.setInputCloud (_projectedPointCloud);
-    huller.reconstruct(pointsInConvexHull, indicesOfVertexes);
-    if(indicesOfVertexes.size() != 1) {
-        std::cout<<"Error: more than one polygon found!"<<std::endl;
-    }
-    pcl::Vertices hullVertices = indicesOfVertexes[0];
-
-    //printIndexAndPointsInfo(pointsInConvexHull, indicesOfVertexes);
-
-    const pcl::Vertices& vs = indicesOfVertexes[0];
-    for(unsigned int j = 0; j < vs.vertices.size(); ++j)
-    {
-        pcl::PointXYZ pointXYZ = pointsInConvexHull.at(vs.vertices[j]);
-        convex_hull.push_back(fromPCLPointXYZ2KDLVector(pointXYZ));
-    }
-
-    _pointCloud->clear();
-    _projectedPointCloud->clear();
-
-    return true;
 }
 
-pcl::PointXYZ convex_hull::fromKDLVector2PCLPointXYZ(const KDL::Vector &point)
+convex_hull::~convex_hull()
 {
-    pcl::PointXYZ p;
-    p.x = point.x();
-    p.y = point.y();
-    p.z = point.z();
-    return p;
+
 }
 
-KDL::Vector convex_hull::fromPCLPointXYZ2KDLVector(const pcl::PointXYZ &point)
+double convex_hull::cross(const KDL::Vector& o, const KDL::Vector& a, const KDL::Vector& b)
 {
-    return KDL::Vector(point.x,point.y,point.z);
+    return (a.x() - o.x())*(b.y() - o.y()) - (a.y() - o.y())*(b.x() - o.x());
 }
 
-void convex_hull::fromSTDList2PCLPointCloud(const std::list<KDL::Vector> &points, pcl::PointCloud<pcl::PointXYZ>::Ptr point_cloud)
+bool convex_hull::getConvexHull(const std::list<KDL::Vector>& points,
+                                      std::vector<KDL::Vector>& convex_hull)
 {
-    for(std::list<KDL::Vector>::const_iterator i = points.begin(); i != points.end(); ++i)
-        point_cloud->push_back(fromKDLVector2PCLPointXYZ(*i));
+    _points.assign(points.begin(), points.end());
+    return getConvexHull(_points, convex_hull);
 }
 
-
-
-void convex_hull::projectPCL2Plane(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr cloud, const double ransac_distance_thr,
-                                   pcl::PointCloud<pcl::PointXYZ>::Ptr projected_point_cloud)
+bool convex_hull::getConvexHull(const std::vector<KDL::Vector>& points,
+                                      std::vector<KDL::Vector>& convex_hull)
 {
-    pcl::ModelCoefficients::Ptr coefficients (new pcl::ModelCoefficients);
-
     //We projects ALL the points in the plane (0 0 1)
-    coefficients->values.clear();
-    coefficients->values.resize(4, 0.0);
-    coefficients->values[0] = 0.0;
-    coefficients->values[1] = 0.0;
-    coefficients->values[2] = 1.0;
-    coefficients->values[3] = 0.0;
-
-//    pcl::PointIndices::Ptr inliers (new pcl::PointIndices);
-//    // Create the segmentation object
-//    pcl::SACSegmentation<pcl::PointXYZ> seg;
-//    // Optional
-//    seg.setOptimizeCoefficients (true);
-//    // Mandatory
-//    seg.setModelType (pcl::SACMODEL_PLANE);
-//    seg.setMethodType (pcl::SAC_RANSAC);
-//    seg.setDistanceThreshold (ransac_distance_thr);
-//    seg.setInputCloud (cloud);
-//    seg.segment (*inliers, *coefficients);
-
-
-    pcl::ProjectInliers<pcl::PointXYZ> proj;
-    proj.setModelType (pcl::SACMODEL_PLANE);
-    proj.setInputCloud (cloud);
-    proj.setModelCoefficients (coefficients);
-    proj.filter (*projected_point_cloud);
-}
+    _sorted_points.assign(points.begin(), points.end());
+    for(unsigned int i = 0; i < _sorted_points.size(); ++i)
+        _sorted_points[i].z(0.0);
+    std::sort(_sorted_points.begin(), _sorted_points.end(), lexicographicLess);
+
+    const int n = _sorted_points.size();
+    convex_hull.resize(std::max(2*n, 1));
+    if(n < 3)
+    {
+        convex_hull.clear();
+        return false;
+    }
 
-void convex_hull::printIndexAndPointsInfo(const pcl::PointCloud<pcl::PointXYZ>& pointsInConvexHull, const std::vector<pcl::Vertices>& indicesOfVertexes)
-{
-    std::cout<<"Indices of vertex has size "<<indicesOfVertexes.size()<<std::endl;
-    for(unsigned int i = 0; i < indicesOfVertexes.size(); ++i){
-        pcl::Vertices vertices = indicesOfVertexes[i];
-        for(unsigned int ii = 0; ii < vertices.vertices.size(); ++ii)
-            std::cout<<"vertex" <<ii<<" ("<<pointsInConvexHull.at(vertices.vertices[ii]).x<<", "<<
-                       pointsInConvexHull.at(vertices.vertices[ii]).y<<", "<<
-                       pointsInConvexHull.at(vertices.vertices[ii]).z<<") has index "<<vertices.vertices[ii]<<std::endl;
+    // Andrew's monotone chain: lower hull from left to right, then upper hull from right to left.
+    // Collinear and duplicated points are discarded (cross <= 0)
+    int k = 0;
+    for(int i = 0; i < n; ++i)
+    {
+        while(k >= 2 && cross(convex_hull[k-2], convex_hull[k-1], _sorted_points[i]) <= 0.0)
+            --k;
+        convex_hull[k++] = _sorted_points[i];
     }
+    for(int i = n-2, t = k+1; i >= 0; --i)
+    {
+        while(k >= t && cross(convex_hull[k-2], convex_hull[k-1], _sorted_points[i]) <= 0.0)
+            --k;
+        convex_hull[k++] = _sorted_points[i];
+    }
+
+    // the last point is equal to the first one
+    convex_hull.resize(k-1);
+    if(convex_hull.size() < 3)
+    {
+        convex_hull.clear();
+        return false;
+    }
+    return true;
 }
 
 bool convex_hull::getSupportPolygonPoints(std::list<KDL::Vector>& points,
                                           const std::list<std::string> links_in_contact,
                                           const XBot::ModelInterface& model,
                                           const std::string referenceFrame)
+{
+    _points.clear();
+    if(!getSupportPolygonPoints(_points, links_in_contact, model, referenceFrame))
+        return false;
+    points.insert(points.end(), _points.begin(), _points.end());
+    return true;
+}
+
+bool convex_hull::getSupportPolygonPoints(std::vector<KDL::Vector>& points,
+                                          const std::list<std::string>& links_in_contact,
+                                          const XBot::ModelInterface& model,
+                                          const std::string& referenceFrame)
 {
     if(referenceFrame != "COM" &&
        referenceFrame != "world" &&
        model.getLinkID(referenceFrame) < 0)
-        std::cerr << "ERROR: "
-                  << "trying to get support polygon points in "
-                  << "unknown reference frame "
-                  << referenceFrame << std::endl;
+        XBot::Logger::error("in %s: trying to get support polygon points in unknown reference frame %s\n",
+                            __func__, referenceFrame.c_str());
 
     if(links_in_contact.empty() ||
        (referenceFrame != "COM" &&
@@ -158,30 +125,30 @@ bool convex_hull::getSupportPolygonPoints(std::list<KDL::Vector>& points,
         model.getLinkID(referenceFrame) < 0))
         return false;
 
-    KDL::Frame world_T_CoM;
+    KDL::Vector world_CoM;
+    if(referenceFrame == "COM")
+        // get CoM in the world frame
+        model.getCOM(world_CoM);
+
     KDL::Frame world_T_point;
     KDL::Frame referenceFrame_T_point;
-    KDL::Frame CoM_T_point;
     for(std::list<std::string>::const_iterator it = links_in_contact.begin(); it != links_in_contact.end(); it++)
     {
         if(referenceFrame == "COM" ||
            referenceFrame == "world")
+        {
             // get points in world frame
             model.getPose(*it, world_T_point);
-        else
-            model.getPose(*it, referenceFrame, referenceFrame_T_point);
-
-        if(referenceFrame == "COM")
-        {
-            // get CoM in the world frame
-            model.getCOM(world_T_CoM.p);
-
-            CoM_T_point = world_T_CoM.Inverse() * world_T_point;
-            points.push_back(CoM_T_point.p);
-        } else if(referenceFrame == "world")
+            // the COM frame is oriented like the world frame
+            if(referenceFrame == "COM")
+                world_T_point.p -= world_CoM;
             points.push_back(world_T_point.p);
+        }
         else
+        {
+            model.getPose(*it, referenceFrame, referenceFrame_T_point);
             points.push_back(referenceFrame_T_point.p);
+        }
     }
     return true;
 }
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <OpenSoT/constraints/velocity/EnvironmentCollisionAvoidance.h>
+#include <XBotInterface/ModelInterface.h>
+#include <cmath>
+
+std::string robotology_root = std::getenv("ROBOTOLOGY_ROOT");
+std::string relative_path = "/external/OpenSoT/tests/configs/coman/configs/config_coman_RBDL.yaml";
+std::string _path_to_cfg = robotology_root + relative_path;
+
+using namespace OpenSoT::constraints::velocity;
+using OpenSoT::utils::SignedDistanceField;
+
+namespace {
+
+class testEnvironmentCollisionAvoidance: public ::testing::Test
+{
+protected:
+
+    testEnvironmentCollisionAvoidance():
+        resolution(0.05),
+        plane_distance(0.2)
+    {
+        _model_ptr = XBot::ModelInterface::getModel(_path_to_cfg);
+
+        q.setConstant(_model_ptr->getJointNum(), 1E-4);
+        q[_model_ptr->getDofIndex("LShSag")] =  20.0*M_PI/180.0;
+        q[_model_ptr->getDofIndex("LShLat")] = 10.0*M_PI/180.0;
+        q[_model_ptr->getDofIndex("LShYaw")] = -15.0*M_PI/180.0;
+        q[_model_ptr->getDofIndex("LElbj")] = -80.0*M_PI/180.0;
+
+        _model_ptr->setJointPosition(q);
+        _model_ptr->update();
+
+        // an horizontal plane plane_distance below l_wrist, with the grid centered below the wrist
+        _model_ptr->getPose("l_wrist", w_T_wrist);
+        Eigen::Vector3d center = w_T_wrist.translation() - plane_distance*Eigen::Vector3d::UnitZ();
+
+        SignedDistanceField::Points vertices;
+        vertices.push_back(center + Eigen::Vector3d(-1.0, -1.0, 0.0));
+        vertices.push_back(center + Eigen::Vector3d( 1.0, -1.0, 0.0));
+        vertices.push_back(center + Eigen::Vector3d( 1.0,  1.0, 0.0));
+        vertices.push_back(center + Eigen::Vector3d(-1.0,  1.0, 0.0));
+        SignedDistanceField::Triangles triangles;
+        triangles.push_back(Eigen::Vector3i(0, 1, 2));
+        triangles.push_back(Eigen::Vector3i(0, 2, 3));
+
+        sdf = SignedDistanceField::fromMesh(vertices, triangles,
+                                            center - Eigen::Vector3d::Ones(), resolution,
+                                            Eigen::Vector3i(41, 41, 41));
+    }
+
+    virtual ~testEnvironmentCollisionAvoidance() {
+
+    }
+
+    virtual void SetUp() {
+
+    }
+
+    virtual void TearDown() {
+
+    }
+
+    XBot::ModelInterface::Ptr _model_ptr;
+    Eigen::VectorXd q;
+    Eigen::Affine3d w_T_wrist;
+    SignedDistanceField::Ptr sdf;
+    double resolution;
+    double plane_distance;
+};
+
+TEST_F(testEnvironmentCollisionAvoidance, testSphere)
+{
+    ASSERT_TRUE(bool(sdf));
+
+    const double radius = 0.05;
+    const double distance_threshold = 0.02;
+    const double bound_scaling = 0.5;
+
+    EnvironmentCollisionAvoidance environment(q, *_model_ptr, sdf,
+                                              std::numeric_limits<double>::infinity(),
+                                              distance_threshold, bound_scaling);
+    EXPECT_FALSE(environment.addControlSphere("not_existing_link", Eigen::Vector3d::Zero(), radius));
+    ASSERT_TRUE(environment.addControlSphere("l_wrist", Eigen::Vector3d::Zero(), radius));
+    ASSERT_EQ(environment.getNumberOfControlShapes(), 1);
+
+    environment.update(q);
+    ASSERT_EQ(environment.getAineq().rows(), 1);
+    ASSERT_EQ(environment.getAineq().cols(), q.size());
+
+    // the gradient of the plane is the z axis: -n^T*J_p is minus the z row of the jacobian
+    Eigen::MatrixXd J;
+    _model_ptr->getJacobian("l_wrist", Eigen::Vector3d(0.0, 0.0, 0.0), J);
+
+    const double d = plane_distance - radius;
+    EXPECT_NEAR(environment.getDistances()[0], d, 1E-5);
+    EXPECT_TRUE(environment.getAineq().row(0).isApprox(-J.row(2), 1E-5));
+    EXPECT_NEAR(environment.getbUpperBound()[0], (d - distance_threshold)*bound_scaling, 1E-5);
+    EXPECT_LE(environment.getbLowerBound()[0], -1E20);
+
+    // beyond the detection threshold the row is empty and the bound infinite
+    environment.setDetectionThreshold(0.5*d);
+    environment.update(q);
+    ASSERT_EQ(environment.getAineq().rows(), 1);
+    EXPECT_TRUE(environment.getAineq().row(0).isZero());
+    EXPECT_DOUBLE_EQ(environment.getbUpperBound()[0], 1E20);
+
+    environment.setDetectionThreshold(2.0*d);
+    environment.update(q);
+    EXPECT_TRUE(environment.getAineq().row(0).isApprox(-J.row(2), 1E-5));
+}
+
+TEST_F(testEnvironmentCollisionAvoidance, testCapsule)
+{
+    ASSERT_TRUE(bool(sdf));
+
+    // a vertical capsule centered in the wrist: the closest point is its lower endpoint
+    const double radius = 0.02;
+    const double half_length = 0.1;
+    Eigen::Vector3d ep1 = w_T_wrist.linear().transpose()*Eigen::Vector3d(0.0, 0.0, half_length);
+    Eigen::Vector3d ep2 = -ep1;
+
+    EnvironmentCollisionAvoidance environment(q, *_model_ptr, sdf);
+    ASSERT_TRUE(environment.addControlSphere("l_wrist", Eigen::Vector3d::Zero(), radius));
+    ASSERT_TRUE(environment.addControlCapsule("l_wrist", ep1, ep2, radius));
+    ASSERT_EQ(environment.getNumberOfControlShapes(), 2);
+
+    environment.update(q);
+    ASSERT_EQ(environment.getAineq().rows(), 2);
+    ASSERT_EQ(environment.getbUpperBound().size(), 2);
+
+    Eigen::MatrixXd J;
+    _model_ptr->getJacobian("l_wrist", ep2, J);
+
+    const double d = plane_distance - half_length - radius;
+    EXPECT_NEAR(environment.getDistances()[1], d, 1E-5);
+    EXPECT_TRUE(environment.getAineq().row(1).isApprox(-J.row(2), 1E-5));
+    EXPECT_NEAR(environment.getbUpperBound()[1], d, 1E-5);
+
+    // the detection threshold only empties the shape farther from the environment
+    environment.setDetectionThreshold(0.5*(d + plane_distance - radius));
+    environment.update(q);
+    EXPECT_TRUE(environment.getAineq().row(0).isZero());
+    EXPECT_DOUBLE_EQ(environment.getbUpperBound()[0], 1E20);
+    EXPECT_TRUE(environment.getAineq().row(1).isApprox(-J.row(2), 1E-5));
+    EXPECT_NEAR(environment.getbUpperBound()[1], d, 1E-5);
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
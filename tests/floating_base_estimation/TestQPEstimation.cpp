@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <OpenSoT/floating_base_estimation/qp_estimation.h>
+#include <OpenSoT/tasks/Aggregated.h>
+#include <OpenSoT/constraints/GenericConstraint.h>
+#include <OpenSoT/utils/AutoStack.h>
+#include <OpenSoT/solvers/iHQP.h>
+#include <XBotInterface/ModelInterface.h>
+#include <cmath>
+
+std::string robotology_root = std::getenv("ROBOTOLOGY_ROOT");
+std::string relative_path = "/external/OpenSoT/tests/configs/coman/configs/config_coman_floating_base.yaml";
+std::string _path_to_cfg = robotology_root + relative_path;
+
+namespace {
+
+/**
+ * @brief The iHQPEstimation class is the estimator solved with iHQP, updating the model with
+ * the IMU orientation before computing the Jacobians
+ */
+class iHQPEstimation
+{
+public:
+    iHQPEstimation(XBot::ModelInterface::Ptr model, XBot::ImuSensor::ConstPtr imu,
+                   std::vector<std::string> contact_links):
+        _model(model), _imu(imu)
+    {
+        std::list<OpenSoT::tasks::Aggregated::TaskPtr> contact_tasks;
+        for(unsigned int i = 0; i < contact_links.size(); ++i)
+            contact_tasks.push_back(OpenSoT::tasks::Aggregated::TaskPtr(
+                new OpenSoT::tasks::floating_base::Contact(*_model, contact_links[i],
+                                                           Eigen::MatrixXd::Identity(6,6))));
+        OpenSoT::tasks::Aggregated::Ptr aggregated(new OpenSoT::tasks::Aggregated(contact_tasks, 6));
+
+        OpenSoT::tasks::floating_base::IMU::Ptr imu_task(new OpenSoT::tasks::floating_base::IMU(*_model, imu));
+        imu_task->setWeight(100.*Eigen::MatrixXd::Identity(3,3));
+
+        Eigen::VectorXd ub(6);
+        ub<<5.*Eigen::VectorXd::Ones(3),M_PI*Eigen::VectorXd::Ones(3);
+        OpenSoT::constraints::GenericConstraint::Ptr fb_limits(
+            new OpenSoT::constraints::GenericConstraint("fb_limits", OpenSoT::AffineHelper::Identity(6), ub, -ub,
+                                                        OpenSoT::constraints::GenericConstraint::Type::BOUND));
+
+        _autostack.reset(new OpenSoT::AutoStack(aggregated + imu_task));
+        _autostack<<fb_limits;
+        _solver.reset(new OpenSoT::solvers::iHQP(_autostack->getStack(), _autostack->getBounds()));
+    }
+
+    bool update(double dT)
+    {
+        _model->setFloatingBaseState(_imu);
+        _model->update();
+
+        _model->getJointPosition(_q);
+        _model->getJointVelocity(_qdot);
+        _autostack->update(Eigen::VectorXd::Zero(0));
+        if(!_solver->solve(_Qdot))
+            return false;
+
+        _q.segment(0,3) += _Qdot.segment(0,3)*dT;
+        _qdot.segment(0,3) = _Qdot.segment(0,3);
+        _model->setJointPosition(_q);
+        _model->setJointVelocity(_qdot);
+        _model->update();
+        return true;
+    }
+
+    const Eigen::VectorXd& getFloatingBaseVelocity() const { return _Qdot; }
+
+private:
+    XBot::ModelInterface::Ptr _model;
+    XBot::ImuSensor::ConstPtr _imu;
+    OpenSoT::AutoStack::Ptr _autostack;
+    OpenSoT::solvers::iHQP::Ptr _solver;
+    Eigen::VectorXd _q, _qdot, _Qdot;
+};
+
+class testQPEstimation: public ::testing::Test
+{
+protected:
+
+    testQPEstimation()
+    {
+        _model = XBot::ModelInterface::getModel(_path_to_cfg);
+        _model_reference = XBot::ModelInterface::getModel(_path_to_cfg);
+
+        _imu.reset(new XBot::ImuSensor(_model->getUrdf().getLink("imu_link"), 0));
+
+        _contact_links.push_back("l_sole");
+        _contact_links.push_back("r_sole");
+    }
+
+    virtual ~testQPEstimation() {
+
+    }
+
+    virtual void SetUp() {
+
+    }
+
+    virtual void TearDown() {
+
+    }
+
+    /**
+     * @brief setJoints sets the actuated joints of a model, keeping its floating base state
+     */
+    void setJoints(XBot::ModelInterface& model, const Eigen::VectorXd& q, const Eigen::VectorXd& qdot)
+    {
+        Eigen::VectorXd tmp;
+        model.getJointPosition(tmp);
+        tmp.tail(tmp.size()-6) = q.tail(tmp.size()-6);
+        model.setJointPosition(tmp);
+        model.getJointVelocity(tmp);
+        tmp.tail(tmp.size()-6) = qdot.tail(tmp.size()-6);
+        model.setJointVelocity(tmp);
+        model.update();
+    }
+
+    XBot::ModelInterface::Ptr _model, _model_reference;
+    XBot::ImuSensor::Ptr _imu;
+    std::vector<std::string> _contact_links;
+};
+
+TEST_F(testQPEstimation, testIMUOrientationLag)
+{
+    const double dT = 0.001;
+    const double pitch_amplitude = 0.1;
+    const double omega = 2.0*M_PI;
+
+    // the base pitches with the IMU while the legs bend, the feet stay on the ground
+    Eigen::VectorXd q(_model->getJointNum()), qdot(_model->getJointNum());
+    std::vector<std::string> legs;
+    legs.push_back("RHipSag"); legs.push_back("RKneeSag"); legs.push_back("RAnkSag");
+    legs.push_back("LHipSag"); legs.push_back("LKneeSag"); legs.push_back("LAnkSag");
+    const double gains[6] = {-1.0, 2.0, -1.0, -1.0, 2.0, -1.0};
+
+    double t = 0.0;
+    Eigen::Vector3d angular_velocity(0.0, pitch_amplitude*omega, 0.0);
+    _imu->setImuData(Eigen::Quaterniond::Identity(), Eigen::Vector3d::Zero(), angular_velocity);
+
+    q.setZero(); qdot.setZero();
+    for(unsigned int j = 0; j < legs.size(); ++j)
+        q[_model->getDofIndex(legs[j])] = 0.3*gains[j];
+    setJoints(*_model, q, qdot);
+    setJoints(*_model_reference, q, qdot);
+
+    OpenSoT::floating_base_estimation::qp_estimation estimation(_model, _imu, _contact_links);
+    iHQPEstimation reference(_model_reference, _imu, _contact_links);
+
+    double max_deviation = 0.0, max_velocity = 0.0;
+    for(unsigned int k = 1; k <= 1000; ++k)
+    {
+        t = k*dT;
+        const double pitch = pitch_amplitude*std::sin(omega*t);
+        angular_velocity[1] = pitch_amplitude*omega*std::cos(omega*t);
+        _imu->setImuData(Eigen::Quaterniond(Eigen::AngleAxisd(pitch, Eigen::Vector3d::UnitY())),
+                         Eigen::Vector3d::Zero(), angular_velocity);
+
+        for(unsigned int j = 0; j < legs.size(); ++j)
+        {
+            q[_model->getDofIndex(legs[j])] = gains[j]*(0.3 + 0.1*std::sin(omega*t));
+            qdot[_model->getDofIndex(legs[j])] = gains[j]*0.1*omega*std::cos(omega*t);
+        }
+        setJoints(*_model, q, qdot);
+        setJoints(*_model_reference, q, qdot);
+
+        ASSERT_TRUE(estimation.update(dT));
+        ASSERT_TRUE(reference.update(dT));
+
+        // same orientation, the one of the actual IMU sample
+        Eigen::Affine3d pose, pose_reference;
+        _model->getFloatingBasePose(pose);
+        _model_reference->getFloatingBasePose(pose_reference);
+        EXPECT_TRUE(pose.linear().isApprox(pose_reference.linear(), 1e-9)) << "cycle " << k;
+
+        const Eigen::Vector3d v = estimation.getFloatingBaseVelocity().head(3);
+        const Eigen::Vector3d v_reference = reference.getFloatingBaseVelocity().head(3);
+        max_deviation = std::max(max_deviation, (v - v_reference).norm());
+        max_velocity = std::max(max_velocity, v_reference.norm());
+    }
+
+    // the Jacobians of the contacts are rotated to the actual IMU orientation: without the rotation the
+    // deviation would be of the order of the angle covered by the IMU in one sample times the velocity
+    EXPECT_GT(max_velocity, 1e-2);
+    EXPECT_LE(max_deviation, 1e-2*pitch_amplitude*omega*dT*max_velocity);
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
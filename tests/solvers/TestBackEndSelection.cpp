@@ -0,0 +1,120 @@
+#include <OpenSoT/solvers/iHQP.h>
+#include <qpOASES.hpp>
+#include <OpenSoT/tasks/velocity/Postural.h>
+#include <OpenSoT/tasks/velocity/MinimumVelocity.h>
+#include <OpenSoT/constraints/velocity/JointLimits.h>
+#include <OpenSoT/SubTask.h>
+#include <gtest/gtest.h>
+
+using namespace OpenSoT::solvers;
+
+namespace{
+
+class testBackEndSelection: public ::testing::Test
+{
+protected:
+    testBackEndSelection() :
+        q(6), q_ref(6), q_max(6), q_min(6)
+    {
+        q.setZero();
+        q_ref << 0.5, -0.5, 1.0, 2.0, -2.0, 0.1;
+        q_max.setConstant(1.0);
+        q_min.setConstant(-1.0);
+
+        OpenSoT::tasks::velocity::Postural::Ptr postural(new OpenSoT::tasks::velocity::Postural(q));
+        postural->setReference(q_ref);
+        std::list<unsigned int> indices = {0, 1, 2};
+        OpenSoT::tasks::velocity::MinimumVelocity::Ptr min_vel(new OpenSoT::tasks::velocity::MinimumVelocity(q.size()));
+        joint_limits.reset(new OpenSoT::constraints::velocity::JointLimits(q, q_max, q_min));
+
+        stack.push_back(iHQP::TaskPtr(new OpenSoT::SubTask(postural, indices)));
+        stack.push_back(min_vel);
+
+        // only qpOASES is always available
+        std::vector<BackEndCandidate> all = getBackEndCandidates();
+        for(unsigned int i = 0; i < all.size(); ++i)
+        {
+            if(all[i].back_end == solver_back_ends::qpOASES)
+                candidates.push_back(all[i]);
+        }
+    }
+
+    void update()
+    {
+        joint_limits->update(q);
+        for(unsigned int i = 0; i < stack.size(); ++i)
+            stack[i]->update(q);
+    }
+
+    Eigen::VectorXd q, q_ref, q_max, q_min;
+    OpenSoT::constraints::velocity::JointLimits::Ptr joint_limits;
+    iHQP::Stack stack;
+    std::vector<BackEndCandidate> candidates;
+};
+
+TEST_F(testBackEndSelection, testSetBackEnd)
+{
+    iHQP reference(stack, joint_limits, 1e6);
+    iHQP sot(stack, joint_limits, 1e6);
+
+    ASSERT_GE(candidates.size(), 2);
+    EXPECT_TRUE(sot.setBackEnd(1, candidates[1].back_end, candidates[1].options));
+    EXPECT_FALSE(sot.setBackEnd(2, solver_back_ends::qpOASES));
+    EXPECT_EQ(sot.getBackEndName(0), "qpOASES");
+    EXPECT_EQ(sot.getBackEndName(1), "qpOASES");
+
+    boost::any opt;
+    ASSERT_TRUE(sot.getOptions(1, opt));
+    EXPECT_EQ(boost::any_cast<qpOASES::Options>(opt).enableRamping,
+              boost::any_cast<qpOASES::Options>(candidates[1].options).enableRamping);
+
+    Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+    for(unsigned int k = 0; k < 20; ++k)
+    {
+        update();
+        ASSERT_TRUE(reference.solve(dq_reference));
+        ASSERT_TRUE(sot.solve(dq));
+        EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+        q += dq;
+    }
+}
+
+TEST_F(testBackEndSelection, testAutotune)
+{
+    iHQP reference(stack, joint_limits, 1e6);
+    iHQP sot(stack, joint_limits, 1e6);
+
+    EXPECT_FALSE(sot.isAutotuning());
+    sot.autotune(10, 1e-6, candidates);
+    EXPECT_TRUE(sot.isAutotuning());
+
+    Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+    for(unsigned int k = 0; k < 20; ++k)
+    {
+        update();
+        ASSERT_TRUE(reference.solve(dq_reference));
+        ASSERT_TRUE(sot.solve(dq));
+        EXPECT_EQ(sot.isAutotuning(), k < 9);
+        EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+        q += dq;
+    }
+
+    // no candidate can be selected: the actual back-ends are kept
+    sot.autotune(2, -1.0, candidates);
+    for(unsigned int k = 0; k < 2; ++k)
+    {
+        update();
+        ASSERT_TRUE(sot.solve(dq));
+    }
+    EXPECT_FALSE(sot.isAutotuning());
+
+    sot.autotune(0);
+    EXPECT_FALSE(sot.isAutotuning());
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,101 @@
+#include <OpenSoT/solvers/BoxQP.h>
+#include <gtest/gtest.h>
+
+using namespace OpenSoT::solvers;
+
+namespace{
+
+typedef BoxQP<6> BoxQP6;
+
+/**
+ * @brief checkKKT the gradient is zero on the free variables and pushes against the active bounds
+ */
+void checkKKT(const BoxQP6::MatrixN& H, const BoxQP6::VectorN& g,
+              const BoxQP6::VectorN& l, const BoxQP6::VectorN& u, const BoxQP6::VectorN& x)
+{
+    BoxQP6::VectorN gradient = H*x + g;
+    for(unsigned int i = 0; i < 6; ++i)
+    {
+        EXPECT_GE(x[i], l[i] - 1e-12);
+        EXPECT_LE(x[i], u[i] + 1e-12);
+        if(l[i] >= u[i])
+            continue;
+        if(x[i] > l[i] + 1e-9 && x[i] < u[i] - 1e-9)
+            EXPECT_NEAR(gradient[i], 0.0, 1e-8);
+        else if(x[i] <= l[i] + 1e-9)
+            EXPECT_GE(gradient[i], -1e-8);
+        else
+            EXPECT_LE(gradient[i], 1e-8);
+    }
+}
+
+TEST(testBoxQP, testUnconstrained)
+{
+    BoxQP6::MatrixN M = BoxQP6::MatrixN::Random();
+    BoxQP6::MatrixN H = M.transpose()*M + BoxQP6::MatrixN::Identity();
+    BoxQP6::VectorN g = BoxQP6::VectorN::Random();
+    BoxQP6::VectorN l = -1e3*BoxQP6::VectorN::Ones(), u = 1e3*BoxQP6::VectorN::Ones();
+
+    BoxQP6 qp;
+    BoxQP6::VectorN x = BoxQP6::VectorN::Zero();
+    ASSERT_TRUE(qp.solve(H, g, l, u, x));
+    EXPECT_TRUE((x - H.llt().solve(-g)).lpNorm<Eigen::Infinity>() < 1e-12);
+    EXPECT_EQ(qp.getNumberOfIterations(), 0);
+    EXPECT_EQ(qp.getActiveSet().cwiseAbs().sum(), 0);
+}
+
+TEST(testBoxQP, testRandomProblems)
+{
+    std::srand(0);
+    BoxQP6 qp;
+    unsigned int active = 0;
+    for(unsigned int k = 0; k < 200; ++k)
+    {
+        BoxQP6::MatrixN M = BoxQP6::MatrixN::Random();
+        BoxQP6::MatrixN H = M.transpose()*M + 1e-3*BoxQP6::MatrixN::Identity();
+        BoxQP6::VectorN g = 5.0*BoxQP6::VectorN::Random();
+        BoxQP6::VectorN l = -BoxQP6::VectorN::Random().cwiseAbs(), u = BoxQP6::VectorN::Random().cwiseAbs();
+        // a variable fixed by its bounds
+        if(k % 10 == 0)
+            u[k % 6] = l[k % 6];
+
+        BoxQP6::VectorN x = BoxQP6::VectorN::Random();
+        ASSERT_TRUE(qp.solve(H, g, l, u, x));
+        checkKKT(H, g, l, u, x);
+        active += qp.getActiveSet().cwiseAbs().sum();
+    }
+    EXPECT_GT(active, 0);
+}
+
+TEST(testBoxQP, testWarmStart)
+{
+    BoxQP6::MatrixN M = BoxQP6::MatrixN::Random();
+    BoxQP6::MatrixN H = M.transpose()*M + 1e-2*BoxQP6::MatrixN::Identity();
+    BoxQP6::VectorN g = 10.0*BoxQP6::VectorN::Random();
+    BoxQP6::VectorN l = -BoxQP6::VectorN::Ones(), u = BoxQP6::VectorN::Ones();
+
+    BoxQP6 qp;
+    BoxQP6::VectorN x = BoxQP6::VectorN::Zero();
+    ASSERT_TRUE(qp.solve(H, g, l, u, x));
+    checkKKT(H, g, l, u, x);
+    const unsigned int cold_iterations = qp.getNumberOfIterations();
+    ASSERT_GT(cold_iterations, 0);
+
+    // the same active set solves a close problem in one step
+    g += 1e-6*BoxQP6::VectorN::Random();
+    ASSERT_TRUE(qp.solve(H, g, l, u, x));
+    checkKKT(H, g, l, u, x);
+    EXPECT_EQ(qp.getNumberOfIterations(), 0);
+
+    qp.resetActiveSet();
+    x.setZero();
+    ASSERT_TRUE(qp.solve(H, g, l, u, x));
+    EXPECT_EQ(qp.getNumberOfIterations(), cold_iterations);
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,216 @@
+#include <OpenSoT/solvers/HCOD.h>
+#include <OpenSoT/solvers/iHQP.h>
+#include <OpenSoT/tasks/velocity/Postural.h>
+#include <OpenSoT/tasks/velocity/MinimumVelocity.h>
+#include <OpenSoT/constraints/velocity/JointLimits.h>
+#include <OpenSoT/constraints/BilateralConstraint.h>
+#include <OpenSoT/SubTask.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+
+using namespace OpenSoT::solvers;
+
+namespace{
+
+class testHCOD: public ::testing::Test
+{
+protected:
+    testHCOD() :
+        q(6), q_ref(6), q_max(6), q_min(6)
+    {
+        q.setZero();
+        q_ref << 0.5, -0.5, 1.0, 2.0, -2.0, 0.1;
+        q_max.setConstant(1.0);
+        q_min.setConstant(-1.0);
+
+        postural.reset(new OpenSoT::tasks::velocity::Postural(q));
+        postural->setReference(q_ref);
+        std::list<unsigned int> indices = {0, 1, 2};
+        OpenSoT::tasks::velocity::MinimumVelocity::Ptr min_vel(new OpenSoT::tasks::velocity::MinimumVelocity(q.size()));
+        joint_limits.reset(new OpenSoT::constraints::velocity::JointLimits(q, q_max, q_min));
+
+        stack.push_back(iHQP::TaskPtr(new OpenSoT::SubTask(postural, indices)));
+        stack.push_back(min_vel);
+    }
+
+    void update()
+    {
+        joint_limits->update(q);
+        for(unsigned int i = 0; i < stack.size(); ++i)
+            stack[i]->update(q);
+    }
+
+    Eigen::VectorXd q, q_ref, q_max, q_min;
+    OpenSoT::tasks::velocity::Postural::Ptr postural;
+    OpenSoT::constraints::velocity::JointLimits::Ptr joint_limits;
+    iHQP::Stack stack;
+};
+
+TEST_F(testHCOD, testEqualities)
+{
+    update();
+    iHQP reference(stack);
+    HCOD sot(stack);
+    EXPECT_EQ(sot.getNumberOfLevels(), 3);
+
+    Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+    ASSERT_TRUE(reference.solve(dq_reference));
+    ASSERT_TRUE(sot.solve(dq));
+    EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+    EXPECT_EQ(sot.getActiveSet(0).size(), 0);
+}
+
+TEST_F(testHCOD, testJointLimits)
+{
+    // two joints of the subtask are driven out of the limits
+    q_ref << 2.0, -2.0, 0.5, 0.0, 0.0, 0.0;
+    postural->setReference(q_ref);
+    update();
+    iHQP reference(stack, joint_limits, 1e6);
+    HCOD sot(stack, joint_limits);
+    ASSERT_EQ(sot.getConstraints()->getLowerBound().size(), q.size());
+
+    Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+    dq.setZero();
+    unsigned int active_limits = 0;
+    for(unsigned int k = 0; k < 50; ++k)
+    {
+        update();
+        ASSERT_TRUE(reference.solve(dq_reference));
+        ASSERT_TRUE(sot.solve(dq));
+        EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+        q += dq;
+
+        active_limits = 0;
+        for(unsigned int j = 0; j < q.size(); ++j)
+            active_limits += sot.getActiveSet(0)[j] != HCOD::INACTIVE;
+    }
+    EXPECT_NEAR(q[0], q_max[0], 1e-6);
+    EXPECT_NEAR(q[1], q_min[1], 1e-6);
+    EXPECT_NEAR(q[2], q_ref[2], 1e-6);
+    EXPECT_EQ(active_limits, 2);
+
+    // same problem: the active set of the previous cycle is optimal
+    update();
+    ASSERT_TRUE(sot.solve(dq));
+    EXPECT_LE(sot.getNumberOfIterations(), sot.getNumberOfLevels());
+}
+
+TEST_F(testHCOD, testGlobalConstraints)
+{
+    // |dq_0 + dq_1 + dq_2| <= 0.1
+    Eigen::MatrixXd A(1, q.size());
+    A << 1., 1., 1., 0., 0., 0.;
+    Eigen::VectorXd lA(1), uA(1);
+    lA << -0.1;
+    uA << 0.1;
+    OpenSoT::constraints::BilateralConstraint::Ptr constraint(
+                new OpenSoT::constraints::BilateralConstraint("sum", A, lA, uA));
+
+    update();
+    iHQP reference(stack, joint_limits, constraint, 1e6);
+    HCOD sot(stack, joint_limits, constraint);
+
+    Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+    // infeasible starting point
+    dq.setConstant(0.5);
+    for(unsigned int k = 0; k < 20; ++k)
+    {
+        update();
+        ASSERT_TRUE(reference.solve(dq_reference));
+        ASSERT_TRUE(sot.solve(dq));
+        EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+        EXPECT_LE((A*dq)[0], uA[0] + 1e-9);
+        EXPECT_GE((A*dq)[0], lA[0] - 1e-9);
+        q += dq;
+    }
+}
+
+TEST_F(testHCOD, testInfeasible)
+{
+    // 5 <= dq_0 is out of the joint limits
+    Eigen::MatrixXd A(1, q.size());
+    A.setZero();
+    A(0,0) = 1.;
+    Eigen::VectorXd lA(1), uA(1);
+    lA << 5.;
+    uA << 6.;
+    OpenSoT::constraints::BilateralConstraint::Ptr constraint(
+                new OpenSoT::constraints::BilateralConstraint("infeasible", A, lA, uA));
+
+    update();
+    HCOD sot(stack, joint_limits, constraint);
+    Eigen::VectorXd dq(q.size());
+    EXPECT_FALSE(sot.solve(dq));
+}
+
+TEST(testHCODTiming, testTimingAgainstiHQP)
+{
+    // 30 joints: half of them are driven out of the joint limits and 10 random rows couple them
+    const unsigned int n = 30;
+    Eigen::VectorXd q(n), q_ref(n), q_max(n), q_min(n);
+    q.setZero();
+    q_ref.setLinSpaced(n, -3.0, 3.0);
+    q_max.setConstant(1.0);
+    q_min.setConstant(-1.0);
+
+    OpenSoT::tasks::velocity::Postural::Ptr postural(new OpenSoT::tasks::velocity::Postural(q));
+    postural->setReference(q_ref);
+    std::list<unsigned int> indices;
+    for(unsigned int i = 0; i < n; i += 2)
+        indices.push_back(i);
+    OpenSoT::constraints::velocity::JointLimits::Ptr joint_limits(
+                new OpenSoT::constraints::velocity::JointLimits(q, q_max, q_min));
+
+    std::srand(0);
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(10, n);
+    Eigen::VectorXd lA(10), uA(10);
+    lA.setConstant(-0.5);
+    uA.setConstant(0.5);
+    OpenSoT::constraints::BilateralConstraint::Ptr constraint(
+                new OpenSoT::constraints::BilateralConstraint("coupling", A, lA, uA));
+
+    iHQP::Stack stack;
+    stack.push_back(iHQP::TaskPtr(new OpenSoT::SubTask(postural, indices)));
+    stack.push_back(iHQP::TaskPtr(new OpenSoT::tasks::velocity::MinimumVelocity(n)));
+    for(unsigned int i = 0; i < stack.size(); ++i)
+        stack[i]->update(q);
+    joint_limits->update(q);
+
+    iHQP reference(stack, joint_limits, constraint, 1e6);
+    HCOD sot(stack, joint_limits, constraint);
+
+    Eigen::VectorXd dq_reference(n), dq(n);
+    dq.setZero();
+    std::chrono::duration<double> hcod_time(0.0), ihqp_time(0.0);
+    const unsigned int cycles = 100;
+    for(unsigned int k = 0; k < cycles; ++k)
+    {
+        joint_limits->update(q);
+        for(unsigned int i = 0; i < stack.size(); ++i)
+            stack[i]->update(q);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ASSERT_TRUE(reference.solve(dq_reference));
+        std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+        ASSERT_TRUE(sot.solve(dq));
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        ihqp_time += middle - start;
+        hcod_time += end - middle;
+
+        // the regularisation of iHQP moves its solution by a few 1e-6 on this problem
+        EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-5) << "cycle " << k;
+        q += dq;
+    }
+
+    std::cout << "average solve time iHQP: " << 1e6*ihqp_time.count()/cycles << " us, "
+              << "HCOD: " << 1e6*hcod_time.count()/cycles << " us" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,179 @@
+#include <OpenSoT/solvers/Presolve.h>
+#include <OpenSoT/solvers/iHQP.h>
+#include <OpenSoT/tasks/velocity/Postural.h>
+#include <OpenSoT/tasks/velocity/MinimumVelocity.h>
+#include <OpenSoT/constraints/velocity/JointLimits.h>
+#include <OpenSoT/constraints/BilateralConstraint.h>
+#include <OpenSoT/SubTask.h>
+#include <gtest/gtest.h>
+#include <limits>
+
+using namespace OpenSoT::solvers;
+
+namespace{
+
+class testPresolve: public ::testing::Test
+{
+protected:
+    testPresolve() :
+        q(6), q_ref(6), q_max(6), q_min(6)
+    {
+        q.setZero();
+        q_ref << 0.5, -0.5, 1.0, 2.0, -2.0, 0.1;
+        q_max.setConstant(1.0);
+        q_min.setConstant(-1.0);
+
+        OpenSoT::tasks::velocity::Postural::Ptr postural(new OpenSoT::tasks::velocity::Postural(q));
+        postural->setReference(q_ref);
+        std::list<unsigned int> indices = {0, 1, 2};
+        OpenSoT::tasks::velocity::MinimumVelocity::Ptr min_vel(new OpenSoT::tasks::velocity::MinimumVelocity(q.size()));
+        joint_limits.reset(new OpenSoT::constraints::velocity::JointLimits(q, q_max, q_min));
+
+        stack.push_back(iHQP::TaskPtr(new OpenSoT::SubTask(postural, indices)));
+        stack.push_back(min_vel);
+    }
+
+    void update()
+    {
+        joint_limits->update(q);
+        for(unsigned int i = 0; i < stack.size(); ++i)
+            stack[i]->update(q);
+    }
+
+    Eigen::VectorXd q, q_ref, q_max, q_min;
+    OpenSoT::constraints::velocity::JointLimits::Ptr joint_limits;
+    iHQP::Stack stack;
+};
+
+TEST_F(testPresolve, testRows)
+{
+    Eigen::MatrixXd A(4, 2);
+    A << 1., 0.,
+         1., 1.,
+         0., -1.,
+         1., 0.;
+    Eigen::VectorXd lA(4), uA(4);
+    lA << -10., -1.5, -1.05, -std::numeric_limits<double>::infinity();
+    uA << 10., 1.5, 1.05, 0.0;
+    Eigen::VectorXd l(2), u(2);
+    l.setConstant(-1.0);
+    u.setConstant(1.0);
+
+    Presolve presolve(0.1);
+    EXPECT_TRUE(presolve.compute(A, lA, uA, l, u));
+    // the third row is inactive, but too close to be dropped
+    ASSERT_EQ(presolve.getRows().size(), 3);
+    EXPECT_EQ(presolve.getRows()[0], 1);
+    EXPECT_EQ(presolve.getRows()[1], 2);
+    EXPECT_EQ(presolve.getRows()[2], 3);
+    EXPECT_EQ(presolve.getNumberOfDroppedRows(), 1);
+    EXPECT_EQ(presolve.getA().row(0), A.row(1));
+    EXPECT_EQ(presolve.getlA()[1], lA[2]);
+    EXPECT_EQ(presolve.getuA()[2], uA[3]);
+
+    l.setConstant(-0.5);
+    u.setConstant(0.5);
+    EXPECT_TRUE(presolve.compute(A, lA, uA, l, u));
+    ASSERT_EQ(presolve.getRows().size(), 1);
+    EXPECT_EQ(presolve.getRows()[0], 3);
+
+    // a dropped row is taken again only when it can be active
+    l.setConstant(-1.04);
+    u.setConstant(1.04);
+    presolve.compute(A, lA, uA, l, u);
+    ASSERT_EQ(presolve.getRows().size(), 2);
+    EXPECT_EQ(presolve.getRows()[0], 1);
+    EXPECT_EQ(presolve.getRows()[1], 3);
+
+    l.setConstant(-1.1);
+    u.setConstant(1.1);
+    EXPECT_TRUE(presolve.compute(A, lA, uA, l, u));
+    ASSERT_EQ(presolve.getRows().size(), 3);
+    EXPECT_EQ(presolve.getRows()[1], 2);
+
+    // infinite bounds
+    u[0] = std::numeric_limits<double>::infinity();
+    presolve.compute(A, lA, uA, l, u);
+    EXPECT_EQ(presolve.getRows().size(), 4);
+}
+
+TEST_F(testPresolve, testiHQP)
+{
+    // only the last row can be active: |dq_0 + dq_1 + dq_2| <= 0.1
+    Eigen::MatrixXd A(4, q.size());
+    A << 1., 0., 0., 0., 0., 0.,
+         0., 1., 1., 0., 0., 0.,
+         1., -1., 1., 1., -1., 1.,
+         1., 1., 1., 0., 0., 0.;
+    Eigen::VectorXd lA(4), uA(4);
+    lA << -5., -5., -20., -0.1;
+    uA << 5., 5., 20., 0.1;
+    OpenSoT::constraints::BilateralConstraint::Ptr constraint(
+                new OpenSoT::constraints::BilateralConstraint("far_rows", A, lA, uA));
+
+    update();
+    iHQP reference(stack, joint_limits, constraint, 1e6);
+    iHQP sot(stack, joint_limits, constraint, 1e6);
+    EXPECT_FALSE(sot.isPresolveEnabled());
+    sot.setPresolve(true);
+    EXPECT_TRUE(sot.isPresolveEnabled());
+
+    Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+    for(unsigned int k = 0; k < 20; ++k)
+    {
+        update();
+        ASSERT_TRUE(reference.solve(dq_reference));
+        ASSERT_TRUE(sot.solve(dq));
+        EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+        EXPECT_EQ(sot.getNumberOfDroppedConstraints(0), 3);
+        EXPECT_EQ(sot.getNumberOfDroppedConstraints(1), 3);
+        q += dq;
+    }
+    EXPECT_NEAR(std::fabs(dq.head(3).sum()), 0.0, 1e-6);
+
+    sot.setPresolve(false);
+    update();
+    ASSERT_TRUE(reference.solve(dq_reference));
+    ASSERT_TRUE(sot.solve(dq));
+    EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+    EXPECT_EQ(sot.getNumberOfDroppedConstraints(0), 0);
+}
+
+TEST_F(testPresolve, testDroppedRowsChanging)
+{
+    // |dq_0| <= 1.45 can be active only when q_0 moves toward the reference
+    Eigen::MatrixXd A(2, q.size());
+    A << 1., 0., 0., 0., 0., 0.,
+         1., 1., 1., 0., 0., 0.;
+    Eigen::VectorXd lA(2), uA(2);
+    lA << -1.45, -0.1;
+    uA << 1.45, 0.1;
+    OpenSoT::constraints::BilateralConstraint::Ptr constraint(
+                new OpenSoT::constraints::BilateralConstraint("changing_rows", A, lA, uA));
+
+    update();
+    iHQP reference(stack, joint_limits, constraint, 1e6);
+    iHQP sot(stack, joint_limits, constraint, 1e6);
+    sot.setPresolve(true);
+
+    Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+    std::vector<unsigned int> dropped;
+    for(unsigned int k = 0; k < 20; ++k)
+    {
+        update();
+        ASSERT_TRUE(reference.solve(dq_reference));
+        ASSERT_TRUE(sot.solve(dq));
+        EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+        dropped.push_back(sot.getNumberOfDroppedConstraints(0));
+        q += dq;
+    }
+    EXPECT_EQ(dropped.front(), 1);
+    EXPECT_EQ(dropped.back(), 0);
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,102 @@
+#include <OpenSoT/solvers/iHQP.h>
+#include <OpenSoT/tasks/velocity/Postural.h>
+#include <OpenSoT/tasks/velocity/MinimumVelocity.h>
+#include <OpenSoT/constraints/velocity/JointLimits.h>
+#include <OpenSoT/SubTask.h>
+#include <gtest/gtest.h>
+
+using namespace OpenSoT::solvers;
+
+namespace{
+
+class testSoftPriorities: public ::testing::Test
+{
+protected:
+    testSoftPriorities() :
+        q(6), q_ref0(6), q_ref1(6), q_max(6), q_min(6)
+    {
+        q.setZero();
+        q_ref0 << 0.5, -0.5, 0.8, 0.0, 0.0, 0.0;
+        q_ref1 << 0.0, 0.0, -0.4, 0.3, 0.2, 0.0;
+        q_max.setConstant(1.0);
+        q_min.setConstant(-1.0);
+
+        postural0.reset(new OpenSoT::tasks::velocity::Postural(q));
+        postural0->setReference(q_ref0);
+        postural1.reset(new OpenSoT::tasks::velocity::Postural(q));
+        postural1->setReference(q_ref1);
+        std::list<unsigned int> indices0 = {0, 1, 2};
+        std::list<unsigned int> indices1 = {2, 3, 4};
+        joint_limits.reset(new OpenSoT::constraints::velocity::JointLimits(q, q_max, q_min));
+
+        // the two posturals are in conflict on the third joint
+        stack.push_back(iHQP::TaskPtr(new OpenSoT::SubTask(postural0, indices0)));
+        stack.push_back(iHQP::TaskPtr(new OpenSoT::SubTask(postural1, indices1)));
+        stack.push_back(iHQP::TaskPtr(new OpenSoT::tasks::velocity::MinimumVelocity(q.size())));
+
+        joint_limits->update(q);
+        for(unsigned int i = 0; i < stack.size(); ++i)
+            stack[i]->update(q);
+    }
+
+    Eigen::VectorXd q, q_ref0, q_ref1, q_max, q_min;
+    OpenSoT::tasks::velocity::Postural::Ptr postural0, postural1;
+    OpenSoT::constraints::velocity::JointLimits::Ptr joint_limits;
+    iHQP::Stack stack;
+};
+
+TEST_F(testSoftPriorities, testStrictPriorities)
+{
+    iHQP reference(stack, joint_limits, 1e6);
+    iHQP sot(stack, joint_limits, 1e6);
+    EXPECT_FALSE(sot.setSoftPriorities(1, 3));
+    EXPECT_FALSE(sot.setSoftPriorities(2, 1));
+    ASSERT_TRUE(sot.setSoftPriorities(1, 1));
+    EXPECT_EQ(sot.getNumberOfTasks(), 3);
+
+    Eigen::VectorXd dq_reference, dq;
+    ASSERT_TRUE(reference.solve(dq_reference));
+    ASSERT_TRUE(sot.solve(dq));
+    EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-9);
+
+    // the first level is solved exactly
+    EXPECT_NEAR(dq[2], postural0->getb()[2], 1e-6);
+}
+
+TEST_F(testSoftPriorities, testWeightedLevels)
+{
+    iHQP sot(stack, joint_limits, 1e6);
+    ASSERT_TRUE(sot.setSoftPriorities(0, 1, 100.0));
+    EXPECT_EQ(sot.getNumberOfTasks(), 2);
+
+    Eigen::VectorXd dq;
+    ASSERT_TRUE(sot.solve(dq));
+
+    // the conflict on the third joint is solved by the weighted mean of the two references
+    double b0 = postural0->getb()[2];
+    double b1 = postural1->getb()[2];
+    EXPECT_NEAR(dq[2], (100.0*b0 + b1)/101.0, 1e-6);
+    EXPECT_NEAR(dq[0], postural0->getb()[0], 1e-6);
+    EXPECT_NEAR(dq[3], postural1->getb()[3], 1e-6);
+    EXPECT_NEAR(dq[4], postural1->getb()[4], 1e-6);
+    EXPECT_NEAR(dq[5], 0.0, 1e-6);
+
+    // the weighted problem can be deactivated as a whole
+    sot.setActiveStack(0, false);
+    ASSERT_TRUE(sot.solve(dq));
+    EXPECT_NEAR(dq.norm(), 0.0, 1e-6);
+    sot.activateAllStacks();
+
+    // the hierarchy is restored
+    ASSERT_TRUE(sot.setSoftPriorities(0, 0));
+    EXPECT_EQ(sot.getNumberOfTasks(), 3);
+    ASSERT_TRUE(sot.solve(dq));
+    EXPECT_NEAR(dq[2], b0, 1e-6);
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,176 @@
+#include <OpenSoT/solvers/QPReplay.h>
+#include <OpenSoT/solvers/iHQP.h>
+#include <OpenSoT/tasks/velocity/Postural.h>
+#include <OpenSoT/tasks/velocity/MinimumVelocity.h>
+#include <OpenSoT/constraints/velocity/JointLimits.h>
+#include <OpenSoT/SubTask.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+
+using namespace OpenSoT::solvers;
+
+namespace{
+
+class testQPRecorder: public ::testing::Test
+{
+protected:
+    testQPRecorder() : _file_name("/tmp/testQPRecorder.log"),
+        q(6), q_ref(6), q_max(6), q_min(6)
+    {
+        q.setZero();
+        q_ref << 0.5, -0.5, 1.0, 2.0, -2.0, 0.1;
+        q_max.setConstant(1.0);
+        q_min.setConstant(-1.0);
+
+        postural.reset(new OpenSoT::tasks::velocity::Postural(q));
+        postural->setReference(q_ref);
+        std::list<unsigned int> indices = {0, 1, 2};
+        OpenSoT::tasks::velocity::MinimumVelocity::Ptr min_vel(new OpenSoT::tasks::velocity::MinimumVelocity(q.size()));
+        joint_limits.reset(new OpenSoT::constraints::velocity::JointLimits(q, q_max, q_min));
+
+        stack.push_back(iHQP::TaskPtr(new OpenSoT::SubTask(postural, indices)));
+        stack.push_back(min_vel);
+    }
+
+    virtual ~testQPRecorder() {
+        std::remove(_file_name.c_str());
+    }
+
+    void update()
+    {
+        joint_limits->update(q);
+        for(unsigned int i = 0; i < stack.size(); ++i)
+            stack[i]->update(q);
+    }
+
+    std::string _file_name;
+    Eigen::VectorXd q, q_ref, q_max, q_min;
+    OpenSoT::tasks::velocity::Postural::Ptr postural;
+    OpenSoT::constraints::velocity::JointLimits::Ptr joint_limits;
+    iHQP::Stack stack;
+};
+
+TEST_F(testQPRecorder, testRecordAndReplay)
+{
+    iHQP sot(stack, joint_limits, 1e6);
+
+    std::vector<Eigen::VectorXd> solutions;
+    {
+        QPRecorder::Ptr recorder(new QPRecorder(_file_name, 2));
+        sot.setRecorder(recorder);
+
+        Eigen::VectorXd dq(q.size());
+        for(unsigned int k = 0; k < 20; ++k)
+        {
+            update();
+            ASSERT_TRUE(sot.solve(dq));
+            solutions.push_back(dq);
+            q += dq;
+        }
+        EXPECT_EQ(recorder->getLogger()->getDroppedSamples(), 0);
+        // the solver keeps the recorder alive
+        recorder->getLogger()->flush();
+    }
+
+    std::vector<QPSnapshot> snapshots;
+    ASSERT_TRUE(QPRecorder::load(_file_name, snapshots));
+    // one cycle every two, two levels per cycle
+    ASSERT_EQ(snapshots.size(), 20);
+
+    for(unsigned int i = 0; i < snapshots.size(); ++i)
+    {
+        const QPSnapshot& s = snapshots[i];
+        EXPECT_EQ(s.cycle, 2*(i/2));
+        EXPECT_EQ(s.level, (int)(i%2));
+        EXPECT_TRUE(s.back_end == solver_back_ends::qpOASES);
+        EXPECT_DOUBLE_EQ(s.eps_regularisation, 1e6);
+        EXPECT_TRUE(s.success);
+        EXPECT_GE(s.solve_time, 0.0);
+
+        ASSERT_EQ(s.H.rows(), q.size());
+        ASSERT_EQ(s.H.cols(), q.size());
+        ASSERT_EQ(s.g.size(), q.size());
+        ASSERT_EQ(s.l.size(), q.size());
+        ASSERT_EQ(s.solution.size(), q.size());
+        ASSERT_EQ(s.warm_start.size(), q.size());
+        // the second level has the optimality constraints of the first one
+        EXPECT_EQ(s.A.rows(), s.level == 0 ? 0 : 3);
+        EXPECT_EQ(s.lA.size(), s.A.rows());
+
+        if(s.level == 1)
+        {
+            EXPECT_TRUE(s.solution.isApprox(solutions[s.cycle], 1e-12));
+            EXPECT_TRUE(s.H.isIdentity());
+            if(s.cycle > 0){
+                EXPECT_TRUE(s.warm_start.isApprox(solutions[s.cycle - 1], 1e-12));}
+        }
+    }
+
+    // the problems are strictly convex: the solutions do not depend on the warm start
+    QPReplay replay(snapshots);
+    QPReplayResult result;
+    ASSERT_TRUE(replay.replay(solver_back_ends::qpOASES, result));
+    EXPECT_EQ(result.failures, 0);
+    ASSERT_EQ(result.solve_times.size(), snapshots.size());
+    ASSERT_EQ(result.solution_errors.size(), snapshots.size());
+    EXPECT_LT(result.getMaxSolutionError(), 1e-6);
+    EXPECT_LE(result.getSolveTimePercentile(50.0), result.getSolveTimePercentile(100.0));
+    EXPECT_GT(result.getMeanSolveTime(), 0.0);
+}
+
+TEST_F(testQPRecorder, testRecordBackEnd)
+{
+    Eigen::MatrixXd H(2,2);
+    H.setIdentity();
+    Eigen::VectorXd g(2);
+    g << -5.0, 5.0;
+    Eigen::MatrixXd A(0,2);
+    Eigen::VectorXd lA(0), uA(0);
+    Eigen::VectorXd l(2), u(2);
+    l.setConstant(-2.0);
+    u.setConstant(2.0);
+
+    QPOasesBackEnd problem(2, 0, OpenSoT::HST_IDENTITY);
+    ASSERT_TRUE(problem.initProblem(H, g, A, lA, uA, l, u));
+
+    {
+        QPRecorder recorder(_file_name);
+        recorder.registerProblem(0, problem, solver_back_ends::qpOASES, OpenSoT::HST_IDENTITY, 1.0);
+
+        // a problem solved outside a cycle is not recorded
+        EXPECT_TRUE(recorder.record(0, problem, true, 0.0));
+
+        for(unsigned int k = 0; k < 3; ++k)
+        {
+            recorder.startCycle();
+            EXPECT_TRUE(recorder.isRecording());
+            g[0] = -1.0*k;
+            ASSERT_TRUE(problem.updateTask(H, g));
+            recorder.recordWarmStart(0, problem);
+            bool success = problem.solve();
+            EXPECT_TRUE(recorder.record(0, problem, success, 0.0));
+        }
+        EXPECT_FALSE(recorder.record(1, problem, true, 0.0));
+    }
+
+    std::vector<QPSnapshot> snapshots;
+    ASSERT_TRUE(QPRecorder::load(_file_name, snapshots));
+    ASSERT_EQ(snapshots.size(), 3);
+    EXPECT_EQ(snapshots[2].cycle, 2);
+    EXPECT_EQ(snapshots[2].g, g);
+    EXPECT_EQ(snapshots[2].l, l);
+    EXPECT_EQ(snapshots[2].A.rows(), 0);
+    EXPECT_TRUE(snapshots[2].hessian_type == OpenSoT::HST_IDENTITY);
+    EXPECT_EQ(snapshots[2].solution, problem.getSolution());
+    EXPECT_EQ(snapshots[2].warm_start, snapshots[1].solution);
+
+    Eigen::Vector2d x(2.0, -2.0);
+    EXPECT_TRUE(snapshots[2].solution.isApprox(x));
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,274 @@
+#include <OpenSoT/solvers/RecedingHorizon.h>
+#include <OpenSoT/solvers/QPOasesBackEnd.h>
+#include <OpenSoT/tasks/GenericTask.h>
+#include <OpenSoT/constraints/GenericConstraint.h>
+#include <OpenSoT/constraints/BilateralConstraint.h>
+#include <gtest/gtest.h>
+
+using namespace OpenSoT::solvers;
+
+namespace{
+
+/**
+ * The variable is x = [qddot; f], 3 joint accelerations and 2 forces
+ */
+class testRecedingHorizon: public ::testing::Test
+{
+protected:
+    testRecedingHorizon() :
+        x_size(5), dofs(3), dt(0.01), horizon(20),
+        kp(100.0), kd(20.0)
+    {
+        Eigen::MatrixXd M(dofs, x_size);
+        M.setZero();
+        M.leftCols(dofs).setIdentity();
+        qddot = OpenSoT::AffineHelper(M, Eigen::VectorXd::Zero(dofs));
+
+        Eigen::MatrixXd A(2, x_size);
+        A << 1.0, 0.5, 0.0, 0.0, 0.0,
+             0.0, 1.0, -1.0, 0.0, 0.0;
+        Eigen::VectorXd b(2);
+        b << 20.0, -30.0;
+        cartesian.reset(new OpenSoT::tasks::GenericTask("cartesian", A, b));
+
+        min_effort.reset(new OpenSoT::tasks::GenericTask("min_effort",
+                                                         Eigen::MatrixXd::Identity(x_size, x_size),
+                                                         Eigen::VectorXd::Zero(x_size)));
+
+        // qddot_0 + f_0 - f_1 = 1
+        Eigen::MatrixXd E(1, x_size);
+        E << 1.0, 0.0, 0.0, 1.0, -1.0;
+        Eigen::VectorXd e(1);
+        e << 1.0;
+        dynamics.reset(new OpenSoT::constraints::BilateralConstraint("dynamics", E, e, e));
+
+        Eigen::VectorXd upper(x_size), lower(x_size);
+        upper << 8.0, 8.0, 8.0, 50.0, 50.0;
+        lower << -8.0, -8.0, -8.0, 0.0, 0.0;
+        bounds.reset(new OpenSoT::constraints::GenericConstraint("bounds",
+                                                                 OpenSoT::AffineHelper::Identity(x_size),
+                                                                 upper, lower,
+                                                                 OpenSoT::constraints::GenericConstraint::Type::BOUND));
+
+        stack.push_back(cartesian);
+        stack.push_back(min_effort);
+
+        q.setZero(dofs);
+        qdot.resize(dofs);
+        qdot << 0.3, -0.2, 0.0;
+        q_min = Eigen::VectorXd::Constant(dofs, -1.0);
+        q_max = Eigen::VectorXd::Constant(dofs, 1.0);
+        q_max[0] = 0.05;
+        qdot_max = Eigen::VectorXd::Constant(dofs, 0.5);
+    }
+
+    /**
+     * @brief solveDense solves the horizon as a single dense QP, the states are eliminated
+     * @param state_limits if true the limits q_min, q_max, qdot_max hold on the predicted state,
+     * starting from q, qdot
+     */
+    std::vector<Eigen::VectorXd> solveDense(const double weight_ratio, const double regularisation,
+                                            const bool state_limits = false)
+    {
+        const unsigned int n = horizon*x_size;
+        Eigen::MatrixXd Ad = Eigen::MatrixXd::Identity(2*dofs, 2*dofs);
+        Ad.topRightCorner(dofs, dofs) = dt*Eigen::MatrixXd::Identity(dofs, dofs);
+        Eigen::MatrixXd Bx(2*dofs, x_size);
+        Bx.topRows(dofs) = 0.5*dt*dt*qddot.getM();
+        Bx.bottomRows(dofs) = dt*qddot.getM();
+
+        Eigen::MatrixXd H = regularisation*Eigen::MatrixXd::Identity(n, n);
+        Eigen::VectorXd g = Eigen::VectorXd::Zero(n);
+
+        // z_k = Phi*X
+        Eigen::MatrixXd Phi = Eigen::MatrixXd::Zero(2*dofs, n);
+        const unsigned int n_state = state_limits ? 2*dofs : 0;
+        Eigen::MatrixXd Z(horizon*n_state, n);
+        Eigen::VectorXd lZ(horizon*n_state), uZ(horizon*n_state);
+        for(unsigned int k = 0; k < horizon; ++k)
+        {
+            for(unsigned int i = 0; i < stack.size(); ++i)
+            {
+                const double weight = std::pow(weight_ratio, (double)(stack.size() - 1 - i));
+                const Eigen::MatrixXd& A = stack[i]->getA();
+                Eigen::MatrixXd J = A*qddot.getM().transpose();
+                Eigen::MatrixXd C(A.rows(), 2*dofs);
+                C << (i == 0 ? kp : 0.0)*J, (i == 0 ? kd : 0.0)*J;
+
+                Eigen::MatrixXd residual = C*Phi;
+                residual.middleCols(k*x_size, x_size) += A;
+                H += weight*residual.transpose()*residual;
+                g -= weight*residual.transpose()*stack[i]->getb();
+            }
+            Phi = Ad*Phi;
+            Phi.middleCols(k*x_size, x_size) += Bx;
+
+            if(state_limits)
+            {
+                Z.middleRows(k*n_state, n_state) = Phi;
+                lZ.segment(k*n_state, dofs) = q_min - q - (k + 1)*dt*qdot;
+                uZ.segment(k*n_state, dofs) = q_max - q - (k + 1)*dt*qdot;
+                lZ.segment(k*n_state + dofs, dofs) = -qdot_max - qdot;
+                uZ.segment(k*n_state + dofs, dofs) = qdot_max - qdot;
+            }
+        }
+
+        Eigen::MatrixXd A = Eigen::MatrixXd::Zero(horizon + Z.rows(), n);
+        Eigen::VectorXd lA(A.rows()), uA(A.rows()), l(n), u(n);
+        A.bottomRows(Z.rows()) = Z;
+        lA.tail(Z.rows()) = lZ;
+        uA.tail(Z.rows()) = uZ;
+        for(unsigned int k = 0; k < horizon; ++k)
+        {
+            A.block(k, k*x_size, 1, x_size) = dynamics->getAineq();
+            lA.segment(k, 1) = dynamics->getbLowerBound();
+            uA.segment(k, 1) = dynamics->getbUpperBound();
+            l.segment(k*x_size, x_size) = bounds->getLowerBound();
+            u.segment(k*x_size, x_size) = bounds->getUpperBound();
+        }
+
+        QPOasesBackEnd qp(n, A.rows(), OpenSoT::HST_POSDEF, 1.0);
+        qp.setnWSR(10*(n + A.rows()));
+        EXPECT_TRUE(qp.initProblem(H, g, A, lA, uA, l, u));
+
+        std::vector<Eigen::VectorXd> trajectory(horizon);
+        for(unsigned int k = 0; k < horizon; ++k)
+            trajectory[k] = qp.getSolution().segment(k*x_size, x_size);
+        return trajectory;
+    }
+
+    unsigned int x_size, dofs;
+    double dt;
+    unsigned int horizon;
+    double kp, kd;
+    OpenSoT::AffineHelper qddot;
+    OpenSoT::tasks::GenericTask::Ptr cartesian, min_effort;
+    OpenSoT::constraints::BilateralConstraint::Ptr dynamics;
+    OpenSoT::constraints::GenericConstraint::Ptr bounds;
+    RecedingHorizon::Stack stack;
+    Eigen::VectorXd q, qdot, q_min, q_max, qdot_max;
+};
+
+TEST_F(testRecedingHorizon, testDenseSolution)
+{
+    RecedingHorizon horizon_solver(stack, bounds, dynamics, qddot, dt, horizon);
+    EXPECT_FALSE(horizon_solver.setFeedbackGains(2, kp, kd));
+    EXPECT_FALSE(horizon_solver.setFeedbackGains(0, -kp, kd));
+    ASSERT_TRUE(horizon_solver.setFeedbackGains(0, kp, kd));
+    horizon_solver.setTolerance(1e-9);
+
+    Eigen::VectorXd x;
+    ASSERT_TRUE(horizon_solver.solve(x));
+    std::vector<Eigen::VectorXd> dense = solveDense(horizon_solver.getWeightRatio(),
+                                                    horizon_solver.getRegularisation());
+
+    ASSERT_EQ(horizon_solver.getTrajectory().size(), horizon);
+    for(unsigned int k = 0; k < horizon; ++k)
+        EXPECT_TRUE((horizon_solver.getTrajectory()[k] - dense[k]).lpNorm<Eigen::Infinity>() < 1e-5) << "step " << k;
+    EXPECT_TRUE((x - dense[0]).lpNorm<Eigen::Infinity>() < 1e-5);
+
+    // the bounds are active in the first steps
+    EXPECT_NEAR(x[0], 8.0, 1e-6);
+    EXPECT_NEAR(x[0] + x[3] - x[4], 1.0, 1e-9);
+}
+
+TEST_F(testRecedingHorizon, testStateLimits)
+{
+    RecedingHorizon horizon_solver(stack, bounds, dynamics, qddot, dt, horizon);
+    ASSERT_TRUE(horizon_solver.setFeedbackGains(0, kp, kd));
+    EXPECT_FALSE(horizon_solver.setJointLimits(q_max, q_min));
+    EXPECT_FALSE(horizon_solver.setVelocityLimits(-qdot_max));
+    EXPECT_FALSE(horizon_solver.setState(q, Eigen::VectorXd::Zero(x_size)));
+    ASSERT_TRUE(horizon_solver.setJointLimits(q_min, q_max));
+    ASSERT_TRUE(horizon_solver.setVelocityLimits(qdot_max));
+    ASSERT_TRUE(horizon_solver.setState(q, qdot));
+    horizon_solver.setTolerance(1e-9);
+
+    Eigen::VectorXd x;
+    ASSERT_TRUE(horizon_solver.solve(x));
+    std::vector<Eigen::VectorXd> dense = solveDense(horizon_solver.getWeightRatio(),
+                                                    horizon_solver.getRegularisation(), true);
+    for(unsigned int k = 0; k < horizon; ++k)
+        EXPECT_TRUE((horizon_solver.getTrajectory()[k] - dense[k]).lpNorm<Eigen::Infinity>() < 1e-5) << "step " << k;
+
+    // the predicted state respects the limits, and reaches them
+    Eigen::VectorXd position = q, velocity = qdot;
+    double max_position = position[0], max_velocity = velocity.cwiseAbs().maxCoeff();
+    for(unsigned int k = 0; k < horizon; ++k)
+    {
+        const Eigen::VectorXd qddot_k = qddot.getM()*horizon_solver.getTrajectory()[k] + qddot.getq();
+        position += dt*velocity + 0.5*dt*dt*qddot_k;
+        velocity += dt*qddot_k;
+        EXPECT_TRUE(((position - q_min).array() >= -1e-6).all()) << "step " << k;
+        EXPECT_TRUE(((q_max - position).array() >= -1e-6).all()) << "step " << k;
+        EXPECT_TRUE(((qdot_max - velocity.cwiseAbs()).array() >= -1e-6).all()) << "step " << k;
+        max_position = std::max(max_position, position[0]);
+        max_velocity = std::max(max_velocity, velocity.cwiseAbs().maxCoeff());
+    }
+    EXPECT_NEAR(max_position, q_max[0], 1e-4);
+    EXPECT_NEAR(max_velocity, qdot_max[0], 1e-4);
+
+    // the unlimited solution goes beyond them
+    RecedingHorizon unlimited(stack, bounds, dynamics, qddot, dt, horizon);
+    ASSERT_TRUE(unlimited.setFeedbackGains(0, kp, kd));
+    Eigen::VectorXd x_unlimited;
+    ASSERT_TRUE(unlimited.solve(x_unlimited));
+    EXPECT_GT((x_unlimited - x).lpNorm<Eigen::Infinity>(), 1e-3);
+}
+
+TEST_F(testRecedingHorizon, testUnconstrained)
+{
+    RecedingHorizon horizon_solver(stack, qddot, dt, horizon);
+    ASSERT_TRUE(horizon_solver.setFeedbackGains(0, kp, kd));
+
+    Eigen::VectorXd x;
+    ASSERT_TRUE(horizon_solver.solve(x));
+    // without inequalities a single Newton step is exact
+    EXPECT_EQ(horizon_solver.getNumberOfIterations(), 1);
+
+    // without feedback the horizon is the single instant problem at every step
+    RecedingHorizon instant(stack, qddot, dt, 1);
+    Eigen::VectorXd x_instant;
+    ASSERT_TRUE(instant.solve(x_instant));
+    Eigen::MatrixXd H = 1e2*cartesian->getA().transpose()*cartesian->getA() +
+                        (1.0 + instant.getRegularisation())*Eigen::MatrixXd::Identity(x_size, x_size);
+    Eigen::VectorXd x_expected = H.ldlt().solve(1e2*cartesian->getA().transpose()*cartesian->getb());
+    EXPECT_TRUE((x_instant - x_expected).lpNorm<Eigen::Infinity>() < 1e-9);
+}
+
+TEST_F(testRecedingHorizon, testWarmStart)
+{
+    RecedingHorizon cold(stack, bounds, dynamics, qddot, dt, horizon);
+    RecedingHorizon warm(stack, bounds, dynamics, qddot, dt, horizon);
+    ASSERT_TRUE(cold.setFeedbackGains(0, kp, kd));
+    ASSERT_TRUE(warm.setFeedbackGains(0, kp, kd));
+
+    Eigen::VectorXd x_cold, x_warm, b = cartesian->getb();
+    unsigned int cold_iterations = 0, warm_iterations = 0;
+    for(unsigned int k = 0; k < 20; ++k)
+    {
+        // the reference moves slowly, the previous solution is a good guess
+        b[0] = 20.0 + 0.1*k;
+        ASSERT_TRUE(cartesian->setb(b));
+
+        RecedingHorizon restart(stack, bounds, dynamics, qddot, dt, horizon);
+        ASSERT_TRUE(restart.setFeedbackGains(0, kp, kd));
+        ASSERT_TRUE(restart.solve(x_cold));
+        ASSERT_TRUE(warm.solve(x_warm));
+        EXPECT_TRUE((x_warm - x_cold).lpNorm<Eigen::Infinity>() < 1e-6);
+
+        if(k > 0)
+        {
+            cold_iterations += restart.getNumberOfIterations();
+            warm_iterations += warm.getNumberOfIterations();
+        }
+    }
+    EXPECT_LE(warm_iterations, cold_iterations);
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
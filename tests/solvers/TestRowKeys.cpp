@@ -0,0 +1,207 @@
+#include <OpenSoT/solvers/iHQP.h>
+#include <OpenSoT/solvers/QPOasesBackEnd.h>
+#include <OpenSoT/tasks/velocity/Postural.h>
+#include <OpenSoT/tasks/velocity/MinimumVelocity.h>
+#include <OpenSoT/constraints/velocity/JointLimits.h>
+#include <OpenSoT/constraints/BilateralConstraint.h>
+#include <OpenSoT/SubTask.h>
+#include <qpOASES.hpp>
+#include <gtest/gtest.h>
+
+using namespace OpenSoT::solvers;
+
+namespace{
+
+/**
+ * @brief The ShuffledConstraint class has the rows of a BilateralConstraint in a different order at every update,
+ * the last one is missing every other update
+ */
+class ShuffledConstraint: public OpenSoT::Constraint<Eigen::MatrixXd, Eigen::VectorXd>
+{
+public:
+    typedef boost::shared_ptr<ShuffledConstraint> Ptr;
+
+    ShuffledConstraint(const Eigen::MatrixXd& A, const Eigen::VectorXd& lA, const Eigen::VectorXd& uA):
+        Constraint("shuffled", A.cols()), _A(A), _lA(lA), _uA(uA), _shift(0), _missing(false)
+    {
+        update(Eigen::VectorXd());
+    }
+
+    void update(const Eigen::VectorXd& x)
+    {
+        const unsigned int m = _A.rows() - (_missing ? 1 : 0);
+        _Aineq.resize(m, _A.cols());
+        _bLowerBound.resize(m);
+        _bUpperBound.resize(m);
+        _rowKeys.resize(m);
+        for(unsigned int k = 0, r = 0; r < _A.rows(); ++r)
+        {
+            unsigned int row = (r + _shift)%_A.rows();
+            if(_missing && row == _A.rows() - 1)
+                continue;
+            _Aineq.row(k) = _A.row(row);
+            _bLowerBound[k] = _lA[row];
+            _bUpperBound[k] = _uA[row];
+            _rowKeys[k] = 100 + row;
+            ++k;
+        }
+        ++_shift;
+        _missing = !_missing;
+    }
+
+private:
+    Eigen::MatrixXd _A;
+    Eigen::VectorXd _lA, _uA;
+    unsigned int _shift;
+    bool _missing;
+};
+
+class testRowKeys: public ::testing::Test
+{
+protected:
+    testRowKeys() :
+        q(6), q_ref(6), q_max(6), q_min(6), A(3, 6), lA(3), uA(3)
+    {
+        q.setZero();
+        q_ref << 0.5, -0.5, 1.0, 2.0, -2.0, 0.1;
+        q_max.setConstant(1.0);
+        q_min.setConstant(-1.0);
+
+        OpenSoT::tasks::velocity::Postural::Ptr postural(new OpenSoT::tasks::velocity::Postural(q));
+        postural->setReference(q_ref);
+        std::list<unsigned int> indices = {0, 1, 2};
+        OpenSoT::tasks::velocity::MinimumVelocity::Ptr min_vel(new OpenSoT::tasks::velocity::MinimumVelocity(q.size()));
+        joint_limits.reset(new OpenSoT::constraints::velocity::JointLimits(q, q_max, q_min));
+
+        stack.push_back(iHQP::TaskPtr(new OpenSoT::SubTask(postural, indices)));
+        stack.push_back(min_vel);
+
+        // the last row is redundant: it can be missing
+        A << 1., 1., 1., 0., 0., 0.,
+             1., -1., 0., 0., 0., 0.,
+             1., 1., 1., 0., 0., 0.;
+        lA << -0.1, -0.05, -1.;
+        uA << 0.1, 0.05, 1.;
+    }
+
+    void update()
+    {
+        joint_limits->update(q);
+        for(unsigned int i = 0; i < stack.size(); ++i)
+            stack[i]->update(q);
+    }
+
+    Eigen::VectorXd q, q_ref, q_max, q_min;
+    OpenSoT::constraints::velocity::JointLimits::Ptr joint_limits;
+    iHQP::Stack stack;
+    Eigen::MatrixXd A;
+    Eigen::VectorXd lA, uA;
+};
+
+TEST_F(testRowKeys, testAggregatedKeys)
+{
+    ShuffledConstraint::Ptr shuffled(new ShuffledConstraint(A, lA, uA));
+    OpenSoT::constraints::BilateralConstraint::Ptr bilateral(
+                new OpenSoT::constraints::BilateralConstraint("bilateral", A, lA, uA));
+    std::list<OpenSoT::constraints::Aggregated::ConstraintPtr> constraints = {bilateral, shuffled};
+    OpenSoT::constraints::Aggregated aggregated(constraints, q.size());
+
+    std::vector<std::size_t> keys = aggregated.getRowKeys();
+    ASSERT_EQ(keys.size(), aggregated.getAineq().rows());
+    ASSERT_EQ(keys.size(), 6);
+    for(unsigned int i = 0; i < keys.size(); ++i)
+        EXPECT_EQ(std::count(keys.begin(), keys.end(), keys[i]), 1);
+
+    // the same rows keep the same keys when they move
+    shuffled->update(q);
+    aggregated.generateAll();
+    const std::vector<std::size_t>& new_keys = aggregated.getRowKeys();
+    ASSERT_EQ(new_keys.size(), 5);
+    for(unsigned int i = 0; i < new_keys.size(); ++i)
+    {
+        std::vector<std::size_t>::iterator it = std::find(keys.begin(), keys.end(), new_keys[i]);
+        ASSERT_TRUE(it != keys.end());
+        EXPECT_EQ(aggregated.getAineq().row(i), A.row((it - keys.begin())%3));
+        if(i < 3)
+            EXPECT_EQ(it - keys.begin(), i);
+    }
+}
+
+TEST_F(testRowKeys, testRemapConstraints)
+{
+    Eigen::MatrixXd H(2,2);
+    H.setIdentity();
+    Eigen::VectorXd g(2);
+    g << -5.0, 5.0;
+    Eigen::MatrixXd A(2,2);
+    A.setIdentity();
+    Eigen::VectorXd lA(2), uA(2);
+    lA << -10., -10.;
+    uA << 1., 10.;
+    Eigen::VectorXd l(2), u(2);
+    l.setConstant(-20.0);
+    u.setConstant(20.0);
+
+    QPOasesBackEnd problem(2, 2, OpenSoT::HST_IDENTITY);
+    ASSERT_TRUE(problem.initProblem(H, g, A, lA, uA, l, u));
+    Eigen::Vector2d x(1.0, -5.0);
+    EXPECT_TRUE(problem.getSolution().isApprox(x));
+    EXPECT_EQ(problem.getActiveConstraints().getStatus(0), qpOASES::ST_UPPER);
+    EXPECT_EQ(problem.getActiveConstraints().getStatus(1), qpOASES::ST_INACTIVE);
+
+    // same rows, swapped
+    problem.remapConstraints({1, 0});
+    EXPECT_EQ(problem.getActiveConstraints().getStatus(0), qpOASES::ST_INACTIVE);
+    EXPECT_EQ(problem.getActiveConstraints().getStatus(1), qpOASES::ST_UPPER);
+    Eigen::MatrixXd A_swap = A.colwise().reverse();
+    Eigen::VectorXd lA_swap = lA.reverse(), uA_swap = uA.reverse();
+    ASSERT_TRUE(problem.updateConstraints(A_swap, lA_swap, uA_swap));
+    ASSERT_TRUE(problem.solve());
+    EXPECT_TRUE(problem.getSolution().isApprox(x));
+    EXPECT_EQ(problem.getActiveConstraints().getStatus(1), qpOASES::ST_UPPER);
+
+    // a new row
+    Eigen::MatrixXd A_new(3,2);
+    A_new << 0., 1.,
+             0., -1.,
+             1., 0.;
+    Eigen::VectorXd lA_new(3), uA_new(3);
+    lA_new << -10., -10., -10.;
+    uA_new << 10., 2., 1.;
+    problem.remapConstraints({0, -1, 1});
+    EXPECT_EQ(problem.getActiveConstraints().getStatus(2), qpOASES::ST_UPPER);
+    ASSERT_TRUE(problem.updateConstraints(A_new, lA_new, uA_new));
+    ASSERT_TRUE(problem.solve());
+    x << 1.0, -2.0;
+    EXPECT_TRUE(problem.getSolution().isApprox(x));
+    EXPECT_EQ(problem.getNumConstraints(), 3);
+}
+
+TEST_F(testRowKeys, testiHQP)
+{
+    OpenSoT::constraints::BilateralConstraint::Ptr bilateral(
+                new OpenSoT::constraints::BilateralConstraint("bilateral", A, lA, uA));
+    ShuffledConstraint::Ptr shuffled(new ShuffledConstraint(A, lA, uA));
+
+    update();
+    iHQP reference(stack, joint_limits, bilateral, 1e6);
+    iHQP sot(stack, joint_limits, shuffled, 1e6);
+
+    Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+    for(unsigned int k = 0; k < 20; ++k)
+    {
+        update();
+        shuffled->update(q);
+        ASSERT_TRUE(reference.solve(dq_reference));
+        ASSERT_TRUE(sot.solve(dq));
+        EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+        q += dq;
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,272 @@
+#include <OpenSoT/solvers/iHQP.h>
+#include <qpOASES.hpp>
+#include <OpenSoT/tasks/velocity/Postural.h>
+#include <OpenSoT/tasks/velocity/MinimumVelocity.h>
+#include <OpenSoT/constraints/velocity/JointLimits.h>
+#include <OpenSoT/constraints/BilateralConstraint.h>
+#include <OpenSoT/SubTask.h>
+#include <OpenSoT/utils/AutoStack.h>
+#include <gtest/gtest.h>
+
+using namespace OpenSoT::solvers;
+
+namespace{
+
+class testStackEditing: public ::testing::Test
+{
+protected:
+    testStackEditing() :
+        q(6), q_ref(6), q_max(6), q_min(6)
+    {
+        q.setZero();
+        q_ref << 0.5, -0.5, 1.0, 2.0, -2.0, 0.1;
+        q_max.setConstant(1.0);
+        q_min.setConstant(-1.0);
+
+        postural.reset(new OpenSoT::tasks::velocity::Postural(q));
+        postural->setReference(q_ref);
+        std::list<unsigned int> first = {0, 1, 2};
+        std::list<unsigned int> second = {2, 3, 4};
+        first_joints.reset(new OpenSoT::SubTask(postural, first));
+        second_joints.reset(new OpenSoT::SubTask(postural, second));
+        min_vel.reset(new OpenSoT::tasks::velocity::MinimumVelocity(q.size()));
+        joint_limits.reset(new OpenSoT::constraints::velocity::JointLimits(q, q_max, q_min));
+
+        stack.push_back(first_joints);
+        stack.push_back(min_vel);
+    }
+
+    void update(iHQP::Stack& tasks)
+    {
+        joint_limits->update(q);
+        postural->update(q);
+        for(unsigned int i = 0; i < tasks.size(); ++i)
+            tasks[i]->update(q);
+    }
+
+    /**
+     * @brief compare solves a few cycles with sot and with a solver built from scratch on reference_stack
+     */
+    void compare(iHQP& sot, iHQP::Stack& reference_stack)
+    {
+        iHQP reference(reference_stack, joint_limits, 1e6);
+        Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+        for(unsigned int k = 0; k < 10; ++k)
+        {
+            update(reference_stack);
+            ASSERT_TRUE(reference.solve(dq_reference));
+            ASSERT_TRUE(sot.solve(dq));
+            EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+            q += dq;
+        }
+    }
+
+    Eigen::VectorXd q, q_ref, q_max, q_min;
+    OpenSoT::tasks::velocity::Postural::Ptr postural;
+    iHQP::TaskPtr first_joints, second_joints, min_vel;
+    OpenSoT::constraints::velocity::JointLimits::Ptr joint_limits;
+    iHQP::Stack stack;
+};
+
+TEST_F(testStackEditing, testSetTask)
+{
+    iHQP sot(stack, joint_limits, 1e6);
+
+    qpOASES::Options opt;
+    opt.enableRamping = qpOASES::BT_FALSE;
+    ASSERT_TRUE(sot.setOptions(1, opt));
+
+    Eigen::VectorXd dq(q.size());
+    update(stack);
+    ASSERT_TRUE(sot.solve(dq));
+
+    EXPECT_FALSE(sot.setTask(2, second_joints));
+    EXPECT_FALSE(sot.setTask(0, iHQP::TaskPtr(new OpenSoT::tasks::velocity::MinimumVelocity(3))));
+    ASSERT_TRUE(sot.setTask(0, second_joints));
+    EXPECT_EQ(sot.getNumberOfTasks(), 2);
+
+    // the back-end of the level below is kept
+    boost::any options;
+    ASSERT_TRUE(sot.getOptions(1, options));
+    EXPECT_EQ(boost::any_cast<qpOASES::Options>(options).enableRamping, qpOASES::BT_FALSE);
+
+    iHQP::Stack reference_stack = {second_joints, min_vel};
+    compare(sot, reference_stack);
+}
+
+TEST_F(testStackEditing, testInsertRemoveTask)
+{
+    iHQP sot(stack, joint_limits, 1e6);
+
+    Eigen::VectorXd dq(q.size());
+    update(stack);
+    ASSERT_TRUE(sot.solve(dq));
+
+    EXPECT_FALSE(sot.insertTask(3, second_joints));
+    ASSERT_TRUE(sot.insertTask(1, second_joints));
+    EXPECT_EQ(sot.getNumberOfTasks(), 3);
+
+    iHQP::Stack inserted = {first_joints, second_joints, min_vel};
+    compare(sot, inserted);
+
+    ASSERT_TRUE(sot.removeTask(0));
+    EXPECT_EQ(sot.getNumberOfTasks(), 2);
+
+    iHQP::Stack removed = {second_joints, min_vel};
+    compare(sot, removed);
+
+    ASSERT_TRUE(sot.removeTask(1));
+    EXPECT_FALSE(sot.removeTask(0));
+    EXPECT_EQ(sot.getNumberOfTasks(), 1);
+
+    iHQP::Stack last = {second_joints};
+    compare(sot, last);
+}
+
+TEST_F(testStackEditing, testInsertWeightedTask)
+{
+    iHQP::Stack weighted_stack = {first_joints, min_vel};
+    iHQP sot(weighted_stack, joint_limits, 1e6);
+    ASSERT_TRUE(sot.setSoftPriorities(0, 1, 1e2));
+    EXPECT_EQ(sot.getNumberOfTasks(), 1);
+
+    // a task inserted inside the weighted levels is weighted too
+    ASSERT_TRUE(sot.insertTask(1, second_joints));
+    EXPECT_EQ(sot.getNumberOfTasks(), 1);
+
+    iHQP::Stack inserted = {first_joints, second_joints, min_vel};
+    iHQP reference(inserted, joint_limits, 1e6);
+    ASSERT_TRUE(reference.setSoftPriorities(0, 2, 1e2));
+    Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+    for(unsigned int k = 0; k < 10; ++k)
+    {
+        update(inserted);
+        ASSERT_TRUE(reference.solve(dq_reference));
+        ASSERT_TRUE(sot.solve(dq));
+        EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+        q += dq;
+    }
+
+    // removing a weighted level leaves strict priorities when only one is left
+    ASSERT_TRUE(sot.removeTask(1));
+    ASSERT_TRUE(sot.removeTask(1));
+    EXPECT_EQ(sot.getNumberOfTasks(), 1);
+}
+
+TEST_F(testStackEditing, testAddRemoveConstraint)
+{
+    iHQP sot(stack, joint_limits, 1e6);
+
+    Eigen::VectorXd dq(q.size());
+    update(stack);
+    ASSERT_TRUE(sot.solve(dq));
+
+    // dq0 + dq1 <= 0.1
+    Eigen::MatrixXd A(1, q.size());
+    A << 1.0, 1.0, 0.0, 0.0, 0.0, 0.0;
+    Eigen::VectorXd lA(1), uA(1);
+    lA << -1e9;
+    uA << 0.1;
+    OpenSoT::constraints::BilateralConstraint::Ptr constraint(new OpenSoT::constraints::BilateralConstraint(A, lA, uA));
+
+    EXPECT_FALSE(sot.addConstraint(2, constraint));
+    ASSERT_TRUE(sot.addConstraint(0, constraint));
+    compare(sot, stack);
+    update(stack);
+    ASSERT_TRUE(sot.solve(dq));
+    EXPECT_TRUE(dq[0] + dq[1] <= 0.1 + 1e-6);
+
+    EXPECT_FALSE(sot.removeConstraint(1, constraint));
+    ASSERT_TRUE(sot.removeConstraint(0, constraint));
+    EXPECT_TRUE(first_joints->getConstraints().empty());
+    compare(sot, stack);
+}
+
+TEST_F(testStackEditing, testFailedEditing)
+{
+    iHQP sot(stack, joint_limits, 1e6);
+
+    Eigen::VectorXd dq(q.size());
+    update(stack);
+    ASSERT_TRUE(sot.solve(dq));
+
+    // dq0 = 0.1 and dq0 = 0.2: the problem of the new level can not be initialized
+    Eigen::MatrixXd A(2, q.size());
+    A.setZero();
+    A(0,0) = A(1,0) = 1.0;
+    Eigen::VectorXd b(2);
+    b << 0.1, 0.2;
+    OpenSoT::constraints::BilateralConstraint::Ptr infeasible(new OpenSoT::constraints::BilateralConstraint(A, b, b));
+    iHQP::TaskPtr infeasible_task(new OpenSoT::tasks::velocity::MinimumVelocity(q.size()));
+    infeasible_task->getConstraints().push_back(infeasible);
+
+    EXPECT_FALSE(sot.insertTask(1, infeasible_task));
+    EXPECT_EQ(sot.getNumberOfLevels(), 2);
+    // the Hessian type of the first level changes: its back-end is created again and fails
+    EXPECT_FALSE(sot.setTask(0, infeasible_task));
+    EXPECT_EQ(sot.getNumberOfLevels(), 2);
+
+    // the solver keeps the stack it had
+    compare(sot, stack);
+
+    OpenSoT::AutoStack::Ptr autostack(new OpenSoT::AutoStack(stack));
+    autostack<<joint_limits;
+    iHQP auto_sot(autostack->getStack(), autostack->getBounds(), 1e6);
+    EXPECT_FALSE(autostack->insertTask(auto_sot, 0, infeasible_task));
+    EXPECT_FALSE(autostack->setTask(auto_sot, 0, infeasible_task));
+    EXPECT_EQ(autostack->getStack().size(), 2);
+    EXPECT_TRUE(autostack->getStack()[0] == first_joints);
+    EXPECT_EQ(auto_sot.getNumberOfLevels(), 2);
+    compare(auto_sot, stack);
+}
+
+TEST_F(testStackEditing, testAutoStackEditing)
+{
+    OpenSoT::AutoStack::Ptr autostack(new OpenSoT::AutoStack(stack));
+    autostack<<joint_limits;
+    iHQP sot(autostack->getStack(), autostack->getBounds(), 1e6);
+
+    // the new tasks are updated only by the AutoStack
+    OpenSoT::tasks::velocity::Postural::Ptr other(new OpenSoT::tasks::velocity::Postural(q));
+    other->setReference(-q_ref);
+    OpenSoT::tasks::velocity::Postural::Ptr last(new OpenSoT::tasks::velocity::Postural(q));
+    last->setReference(0.5*q_ref);
+
+    EXPECT_FALSE(autostack->insertTask(sot, 3, other));
+    ASSERT_TRUE(autostack->insertTask(sot, 1, other));
+    ASSERT_TRUE(autostack->removeTask(sot, 0));
+    ASSERT_TRUE(autostack->setTask(sot, 1, last));
+    EXPECT_FALSE(autostack->setTask(sot, 2, last));
+    EXPECT_EQ(autostack->getStack().size(), 2);
+    EXPECT_EQ(sot.getNumberOfLevels(), 2);
+
+    // the reference solver has its own tasks
+    OpenSoT::tasks::velocity::Postural::Ptr other_reference(new OpenSoT::tasks::velocity::Postural(q));
+    other_reference->setReference(-q_ref);
+    OpenSoT::tasks::velocity::Postural::Ptr last_reference(new OpenSoT::tasks::velocity::Postural(q));
+    last_reference->setReference(0.5*q_ref);
+    OpenSoT::constraints::velocity::JointLimits::Ptr joint_limits_reference(
+                new OpenSoT::constraints::velocity::JointLimits(q, q_max, q_min));
+    iHQP::Stack reference_stack = {other_reference, last_reference};
+    iHQP reference(reference_stack, joint_limits_reference, 1e6);
+
+    Eigen::VectorXd dq_reference(q.size()), dq(q.size());
+    for(unsigned int k = 0; k < 10; ++k)
+    {
+        autostack->update(q);
+        joint_limits_reference->update(q);
+        other_reference->update(q);
+        last_reference->update(q);
+        ASSERT_TRUE(reference.solve(dq_reference));
+        ASSERT_TRUE(sot.solve(dq));
+        EXPECT_TRUE((dq - dq_reference).lpNorm<Eigen::Infinity>() < 1e-6);
+        q += dq;
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -45,6 +45,63 @@ double computeManipIndex(const Eigen::MatrixXd& A)
     return sqrt((A*A.transpose()).determinant());
 }
 
+void checkAnalyticGradient(Manipulability& manipulability_task, const XBot::ModelInterface& model)
+{
+    const Manipulability::GradientType gradient_type = manipulability_task.getGradientType();
+    EXPECT_EQ(gradient_type, model.isFloatingBase() ?
+                  Manipulability::GRADIENT_NUMERICAL : Manipulability::GRADIENT_ANALYTIC);
+
+    manipulability_task.setGradientType(Manipulability::GRADIENT_ANALYTIC);
+    Eigen::VectorXd b_analytic = manipulability_task.getb();
+
+    manipulability_task.setGradientType(Manipulability::GRADIENT_NUMERICAL);
+    Eigen::VectorXd b_numerical = manipulability_task.getb();
+    manipulability_task.setGradientType(gradient_type);
+
+    // the floating base is parametrized differently by the two methods
+    int nJ = b_numerical.size();
+    int first_joint = model.isFloatingBase() ? 6 : 0;
+    ASSERT_GT(b_numerical.tail(nJ - first_joint).norm(), 0.0);
+    for(int i = first_joint; i < nJ; ++i)
+        EXPECT_NEAR(b_analytic[i], b_numerical[i], 1e-3*b_numerical.tail(nJ - first_joint).norm()) << "joint " << i;
+}
+
+TEST_F(testManipolability, testAnalyticGradient)
+{
+    std::string robotology_root = std::getenv("ROBOTOLOGY_ROOT");
+    std::string relative_path = "/external/OpenSoT/tests/configs/coman/configs/config_coman_RBDL.yaml";
+
+    XBot::ModelInterface::Ptr _model_ptr = XBot::ModelInterface::getModel(robotology_root + relative_path);
+
+    Eigen::VectorXd q(_model_ptr->getJointNum());
+    q.setZero(q.size());
+    q[_model_ptr->getDofIndex("LShSag")] = -0.4;
+    q[_model_ptr->getDofIndex("LShLat")] = 0.3;
+    q[_model_ptr->getDofIndex("LElbj")] = -0.8;
+    q[_model_ptr->getDofIndex("RShSag")] = -0.2;
+    q[_model_ptr->getDofIndex("RElbj")] = -0.6;
+    q[_model_ptr->getDofIndex("RHipSag")] = -0.3;
+    q[_model_ptr->getDofIndex("RKneeSag")] = 0.6;
+    q[_model_ptr->getDofIndex("WaistLat")] = 0.2;
+
+    _model_ptr->setJointPosition(q);
+    _model_ptr->update();
+
+    Cartesian::Ptr cartesian_task_L(new Cartesian("cartesian::left_wrist",
+        q, *(_model_ptr.get()),"l_wrist", "Waist"));
+    Manipulability manipulability_task_L(q, *(_model_ptr.get()), cartesian_task_L);
+    checkAnalyticGradient(manipulability_task_L, *_model_ptr);
+
+    Cartesian::Ptr cartesian_task_R(new Cartesian("cartesian::right_wrist",
+        q, *(_model_ptr.get()),"r_wrist", "world"));
+    Manipulability manipulability_task_R(q, *(_model_ptr.get()), cartesian_task_R);
+    checkAnalyticGradient(manipulability_task_R, *_model_ptr);
+
+    CoM::Ptr com_task(new CoM(q, *(_model_ptr.get())));
+    Manipulability manipulability_task_CoM(q, *(_model_ptr.get()), com_task);
+    checkAnalyticGradient(manipulability_task_CoM, *_model_ptr);
+}
+
 TEST_F(testManipolability, testManipolabilityTask)
 {
     XBot::ModelInterface::Ptr _model_ptr;
@@ -55,6 +55,39 @@ protected:
 
 };
 
+TEST_F(testMinimumEffortTask, testAnalyticGradient)
+{
+    Eigen::VectorXd q_whole(nJ); q_whole.setZero(nJ);
+    q_whole[_model_ptr->getDofIndex("RShSag")] = -0.6;
+    q_whole[_model_ptr->getDofIndex("RElbj")] = -0.8;
+    q_whole[_model_ptr->getDofIndex("LShSag")] = 0.3;
+    q_whole[_model_ptr->getDofIndex("LShLat")] = 0.4;
+    q_whole[_model_ptr->getDofIndex("LElbj")] = -0.5;
+    q_whole[_model_ptr->getDofIndex("RHipSag")] = -0.3;
+    q_whole[_model_ptr->getDofIndex("RKneeSag")] = 0.6;
+    q_whole[_model_ptr->getDofIndex("WaistLat")] = 0.2;
+
+    _model_ptr->setJointPosition(q_whole);
+    _model_ptr->update();
+
+    OpenSoT::tasks::velocity::MinimumEffort minimumEffort(q_whole, *(_model_ptr.get()));
+    EXPECT_EQ(minimumEffort.getGradientType(), _model_ptr->isFloatingBase() ?
+                  OpenSoT::tasks::velocity::MinimumEffort::GRADIENT_NUMERICAL :
+                  OpenSoT::tasks::velocity::MinimumEffort::GRADIENT_ANALYTIC);
+
+    minimumEffort.setGradientType(OpenSoT::tasks::velocity::MinimumEffort::GRADIENT_ANALYTIC);
+    Eigen::VectorXd b_analytic = minimumEffort.getb();
+
+    minimumEffort.setGradientType(OpenSoT::tasks::velocity::MinimumEffort::GRADIENT_NUMERICAL);
+    Eigen::VectorXd b_numerical = minimumEffort.getb();
+
+    // the floating base is parametrized differently by the two methods
+    int first_joint = _model_ptr->isFloatingBase() ? 6 : 0;
+    ASSERT_GT(b_numerical.tail(nJ - first_joint).norm(), 0.0);
+    for(int i = first_joint; i < nJ; ++i)
+        EXPECT_NEAR(b_analytic[i], b_numerical[i], 1e-3*b_numerical.tail(nJ - first_joint).norm()) << "joint " << i;
+}
+
 TEST_F(testMinimumEffortTask, testMinimumEffortTask_)
 {
     boost::shared_ptr<ros::NodeHandle> _n;
@@ -2,6 +2,7 @@
 #include <OpenSoT/utils/AutoStack.h>
 #include <OpenSoT/utils/DefaultHumanoidStack.h>
 #include <gtest/gtest.h>
+#include <thread>
 
 std::string robotology_root = std::getenv("ROBOTOLOGY_ROOT");
 std::string relative_path = "/external/OpenSoT/tests/configs/coman/configs/config_coman_RBDL.yaml";
@@ -9,6 +10,148 @@ std::string _path_to_cfg = robotology_root + relative_path;
 
 namespace {
 
+/**
+ * @brief The CountingTask class counts its updates, A = I and b = x
+ */
+class CountingTask: public OpenSoT::Task<Eigen::MatrixXd, Eigen::VectorXd>
+{
+public:
+    typedef boost::shared_ptr<CountingTask> Ptr;
+
+    CountingTask(const unsigned int x_size): Task("counting", x_size), updates(0)
+    {
+        _A.setIdentity(x_size, x_size);
+        _W.setIdentity(x_size, x_size);
+        _b.setZero(x_size);
+        _hessianType = OpenSoT::HST_IDENTITY;
+    }
+
+    void _update(const Eigen::VectorXd& x)
+    {
+        _b = x;
+        ++updates;
+    }
+
+    unsigned int updates;
+};
+
+/**
+ * @brief The CountingConstraint class counts its updates
+ */
+class CountingConstraint: public OpenSoT::Constraint<Eigen::MatrixXd, Eigen::VectorXd>
+{
+public:
+    typedef boost::shared_ptr<CountingConstraint> Ptr;
+
+    CountingConstraint(const unsigned int x_size): Constraint("counting_constraint", x_size), updates(0)
+    {
+        _upperBound.setOnes(x_size);
+        _lowerBound = -_upperBound;
+    }
+
+    void update(const Eigen::VectorXd& x){ ++updates; }
+
+    unsigned int updates;
+};
+
+TEST(testUpdateCycle, testSharedTasksUpdatedOnce)
+{
+    const unsigned int x_size = 4;
+    CountingTask::Ptr task(new CountingTask(x_size));
+    CountingConstraint::Ptr constraint(new CountingConstraint(x_size));
+    task->getConstraints().push_back(constraint);
+
+    std::list<unsigned int> first, second;
+    first.push_back(0); first.push_back(1);
+    second.push_back(2); second.push_back(3);
+
+    // the task is in the first level through two subtasks, and in the second level
+    OpenSoT::AutoStack::Ptr stack = ((task%first) + (task%second)) / task;
+    stack<<constraint;
+
+    Eigen::VectorXd x = Eigen::VectorXd::Constant(x_size, 1.0);
+    task->updates = 0;
+    constraint->updates = 0;
+    stack->update(x);
+    EXPECT_EQ(task->updates, 1);
+    EXPECT_EQ(constraint->updates, 1);
+    EXPECT_TRUE((stack->getStack()[0]->getb() - x).norm() < 1e-12);
+
+    x.setConstant(2.0);
+    stack->update(x);
+    EXPECT_EQ(task->updates, 2);
+    EXPECT_EQ(constraint->updates, 2);
+    EXPECT_TRUE((stack->getStack()[0]->getb() - x).norm() < 1e-12);
+    EXPECT_TRUE((stack->getStack()[1]->getb() - x).norm() < 1e-12);
+
+    // outside of an update cycle every update is evaluated
+    task->update(x);
+    task->update(x);
+    EXPECT_EQ(task->updates, 4);
+}
+
+TEST(testUpdateCycle, testSharedSlowTasks)
+{
+    const unsigned int x_size = 4;
+    CountingTask::Ptr task(new CountingTask(x_size));
+    CountingConstraint::Ptr constraint(new CountingConstraint(x_size));
+    ASSERT_TRUE(task->setUpdateDivider(3));
+    ASSERT_TRUE(constraint->setUpdateDivider(3));
+
+    std::list<unsigned int> first, second;
+    first.push_back(0); first.push_back(1);
+    second.push_back(2); second.push_back(3);
+    OpenSoT::SubTask::Ptr first_joints(new OpenSoT::SubTask(task, first));
+    OpenSoT::SubTask::Ptr second_joints(new OpenSoT::SubTask(task, second));
+    std::list<OpenSoT::constraints::Aggregated::ConstraintPtr> bounds(1, constraint);
+    OpenSoT::constraints::Aggregated first_bounds(bounds, x_size);
+    OpenSoT::constraints::Aggregated second_bounds(bounds, x_size);
+
+    // a cycle is counted once, however many containers share the task or the constraint
+    task->updates = 0;
+    constraint->updates = 0;
+    for(unsigned int k = 0; k < 9; ++k)
+    {
+        OpenSoT::utils::UpdateCycle::Scope cycle;
+        Eigen::VectorXd x = Eigen::VectorXd::Constant(x_size, k);
+        first_joints->update(x);
+        second_joints->update(x);
+        first_bounds.update(x);
+        second_bounds.update(x);
+    }
+    EXPECT_EQ(task->updates, 3);
+    EXPECT_EQ(constraint->updates, 3);
+
+    // outside of an update cycle the divider is not applied
+    task->updates = 0;
+    first_joints->update(Eigen::VectorXd::Constant(x_size, 1.0));
+    second_joints->update(Eigen::VectorXd::Constant(x_size, 1.0));
+    EXPECT_EQ(task->updates, 2);
+}
+
+TEST(testUpdateCycle, testCyclesOfDifferentThreads)
+{
+    const unsigned int x_size = 4;
+    CountingTask::Ptr task(new CountingTask(x_size));
+    Eigen::VectorXd x = Eigen::VectorXd::Constant(x_size, 1.0);
+    task->updates = 0;
+
+    // the stamp left by a thread does not hold the update of another thread
+    unsigned long cycles[2];
+    for(unsigned int i = 0; i < 2; ++i)
+    {
+        std::thread worker([&task, &x, &cycles, i]()
+        {
+            OpenSoT::utils::UpdateCycle::Scope scope;
+            cycles[i] = OpenSoT::utils::UpdateCycle::current();
+            task->update(x);
+        });
+        worker.join();
+    }
+    EXPECT_NE(cycles[0], cycles[1]);
+    EXPECT_EQ(task->updates, 2);
+}
+
 class testAutoStack: public ::testing::Test
 {
 protected:
@@ -385,6 +528,45 @@ TEST_F(testAutoStack, testOperatorTimes)
 
 }
 
+TEST_F(testAutoStack, testUpdateDivider)
+{
+    Eigen::VectorXd q = Eigen::VectorXd::Zero(_robot->getJointNum());
+    Eigen::VectorXd q_ref = Eigen::VectorXd::Constant(q.size(), 0.1);
+    DHS->postural->setReference(q_ref);
+
+    OpenSoT::AutoStack::Ptr stack(new OpenSoT::AutoStack(DHS->postural));
+    stack<<DHS->jointLimits;
+    EXPECT_FALSE(stack->setUpdateDivider(DHS->postural, 0));
+    ASSERT_TRUE(stack->setUpdateDivider(DHS->postural, 3, true));
+    ASSERT_TRUE(stack->setUpdateDivider(DHS->jointLimits, 3));
+
+    const double lambda = DHS->postural->getLambda();
+    Eigen::VectorXd upper = DHS->jointLimits->getUpperBound();
+    for(unsigned int k = 0; k < 7; ++k)
+    {
+        q.setConstant(0.01*k);
+        stack->update(q);
+
+        // the postural is updated in the cycles 0, 3, 6 and its b is extrapolated in between:
+        // for the postural the extrapolation is exact
+        EXPECT_TRUE((DHS->postural->getb() - lambda*(q_ref - q)).norm() < 1e-12);
+
+        // the joint limits are updated in the cycles 2, 5 (the phase of the second slow update is 1)
+        if(k % 3 == 2)
+            upper = DHS->jointLimits->getUpperBound();
+        EXPECT_TRUE((DHS->jointLimits->getUpperBound() - upper).norm() < 1e-12);
+        if(k == 2)
+        {
+            // the bounds were computed with the state of the cycle
+            DHS->jointLimits->update(q);
+            EXPECT_TRUE((DHS->jointLimits->getUpperBound() - upper).norm() < 1e-12);
+        }
+    }
+
+    ASSERT_TRUE(stack->setUpdateDivider(DHS->postural, 1));
+    ASSERT_TRUE(stack->setUpdateDivider(DHS->jointLimits, 1));
+}
+
 }
 
 int main(int argc, char **argv) {
@@ -0,0 +1,140 @@
+#include <OpenSoT/utils/CapsuleDistance.h>
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <limits>
+
+namespace{
+
+class testCapsuleDistance: public ::testing::Test
+{
+protected:
+
+    testCapsuleDistance()
+    {
+        srand(0);
+    }
+
+    virtual ~testCapsuleDistance() {
+
+    }
+
+    virtual void SetUp() {
+
+    }
+
+    virtual void TearDown() {
+
+    }
+
+};
+
+double pointToSegmentDistance(const Eigen::Vector3d& p,
+                              const Eigen::Vector3d& ep1, const Eigen::Vector3d& ep2)
+{
+    Eigen::Vector3d d = ep2 - ep1;
+    double s = 0.0;
+    if(d.squaredNorm() > 0.0)
+        s = std::min(std::max((p - ep1).dot(d)/d.squaredNorm(), 0.0), 1.0);
+    return (p - (ep1 + s*d)).norm();
+}
+
+/**
+ * @brief bruteForceAxisDistance samples both segments on a regular grid
+ * @return the minimum sampled distance between the two segments
+ */
+double bruteForceAxisDistance(const Eigen::Vector3d& A_ep1, const Eigen::Vector3d& A_ep2,
+                              const Eigen::Vector3d& B_ep1, const Eigen::Vector3d& B_ep2,
+                              const unsigned int samples)
+{
+    double min_distance = std::numeric_limits<double>::infinity();
+    for(unsigned int i = 0; i <= samples; ++i)
+    {
+        Eigen::Vector3d a = A_ep1 + (double(i)/samples)*(A_ep2 - A_ep1);
+        min_distance = std::min(min_distance, pointToSegmentDistance(a, B_ep1, B_ep2));
+    }
+    return min_distance;
+}
+
+TEST_F(testCapsuleDistance, testRandomCapsules)
+{
+    const unsigned int number_of_pairs = 200;
+    const unsigned int samples = 2000;
+
+    std::vector<Eigen::Vector3d> A_ep1(number_of_pairs), A_ep2(number_of_pairs),
+                                 B_ep1(number_of_pairs), B_ep2(number_of_pairs);
+    std::vector<double> A_radius(number_of_pairs), B_radius(number_of_pairs);
+
+    OpenSoT::utils::CapsuleDistanceBatch batch(number_of_pairs);
+    for(unsigned int i = 0; i < number_of_pairs; ++i)
+    {
+        A_ep1[i].setRandom(); A_ep2[i].setRandom();
+        B_ep1[i].setRandom(); B_ep2[i].setRandom();
+        // one every four is a sphere-capsule pair, one every eight a sphere-sphere pair
+        if(i % 4 == 0)
+            A_ep2[i] = A_ep1[i];
+        if(i % 8 == 0)
+            B_ep2[i] = B_ep1[i];
+        A_radius[i] = 0.05 + 0.05*(Eigen::Vector2d::Random()[0] + 1.0);
+        B_radius[i] = 0.05 + 0.05*(Eigen::Vector2d::Random()[0] + 1.0);
+
+        batch.setPair(i, A_ep1[i], A_ep2[i], A_radius[i], B_ep1[i], B_ep2[i], B_radius[i]);
+    }
+
+    batch.compute(number_of_pairs);
+
+    for(unsigned int i = 0; i < number_of_pairs; ++i)
+    {
+        double reference_distance = bruteForceAxisDistance(A_ep1[i], A_ep2[i], B_ep1[i], B_ep2[i], samples)
+                - A_radius[i] - B_radius[i];
+        double resolution = (A_ep2[i] - A_ep1[i]).norm()/samples;
+
+        EXPECT_LE(batch.getDistance(i), reference_distance + 1E-9) << "pair " << i;
+        EXPECT_GE(batch.getDistance(i), reference_distance - resolution - 1E-9) << "pair " << i;
+
+        Eigen::Vector3d pA, pB;
+        batch.getClosestPoints(i, pA, pB);
+        EXPECT_NEAR(pointToSegmentDistance(pA, A_ep1[i], A_ep2[i]), A_radius[i], 1E-9) << "pair " << i;
+        EXPECT_NEAR(pointToSegmentDistance(pB, B_ep1[i], B_ep2[i]), B_radius[i], 1E-9) << "pair " << i;
+        if(batch.getDistance(i) > 0.0)
+        {
+            EXPECT_NEAR((pA - pB).norm(), batch.getDistance(i), 1E-9) << "pair " << i;
+        }
+    }
+}
+
+TEST_F(testCapsuleDistance, testDegenerateCases)
+{
+    OpenSoT::utils::CapsuleDistanceBatch batch(4);
+
+    // parallel capsules, overlapping along the axis
+    batch.setPair(0, Eigen::Vector3d(0.,0.,0.), Eigen::Vector3d(0.,0.,1.), 0.1,
+                     Eigen::Vector3d(1.,0.,0.5), Eigen::Vector3d(1.,0.,1.5), 0.2);
+    // parallel capsules, not overlapping along the axis
+    batch.setPair(1, Eigen::Vector3d(0.,0.,0.), Eigen::Vector3d(0.,0.,1.), 0.1,
+                     Eigen::Vector3d(0.,1.,2.), Eigen::Vector3d(0.,1.,3.), 0.1);
+    // sphere-sphere
+    batch.setPair(2, Eigen::Vector3d(0.,0.,0.), Eigen::Vector3d(0.,0.,0.), 0.1,
+                     Eigen::Vector3d(0.,3.,4.), Eigen::Vector3d(0.,3.,4.), 0.4);
+    // capsule-sphere, with the sphere projecting on the interior of the capsule axis
+    batch.setPair(3, Eigen::Vector3d(-1.,0.,0.), Eigen::Vector3d(1.,0.,0.), 0.1,
+                     Eigen::Vector3d(0.5,0.,1.), Eigen::Vector3d(0.5,0.,1.), 0.1);
+
+    batch.compute(4);
+
+    EXPECT_NEAR(batch.getDistance(0), 0.7, 1E-12);
+    EXPECT_NEAR(batch.getDistance(1), std::sqrt(2.0) - 0.2, 1E-12);
+    EXPECT_NEAR(batch.getDistance(2), 4.5, 1E-12);
+    EXPECT_NEAR(batch.getDistance(3), 0.8, 1E-12);
+
+    Eigen::Vector3d pA, pB;
+    batch.getClosestPoints(3, pA, pB);
+    EXPECT_TRUE(pA.isApprox(Eigen::Vector3d(0.5,0.,0.1)));
+    EXPECT_TRUE(pB.isApprox(Eigen::Vector3d(0.5,0.,0.9)));
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
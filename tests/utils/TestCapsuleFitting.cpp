@@ -0,0 +1,117 @@
+#include <OpenSoT/utils/CapsuleFitting.h>
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+using OpenSoT::utils::CapsuleFitting;
+
+namespace{
+
+class testCapsuleFitting: public ::testing::Test
+{
+protected:
+
+    testCapsuleFitting()
+    {
+        srand(0);
+    }
+
+    virtual ~testCapsuleFitting() {
+
+    }
+
+    virtual void SetUp() {
+
+    }
+
+    virtual void TearDown() {
+
+    }
+
+};
+
+/**
+ * @brief sampleCapsule samples points on the surface of a capsule
+ */
+CapsuleFitting::Points sampleCapsule(const CapsuleFitting::Capsule& capsule, const unsigned int samples)
+{
+    CapsuleFitting::Points points;
+    Eigen::Affine3d frame = capsule.getCenterFrame();
+    double half_length = 0.5*capsule.getLength();
+    for(unsigned int i = 0; i < samples; ++i)
+    {
+        Eigen::Vector3d direction = Eigen::Vector3d::Random().normalized();
+        double z = half_length*(2.0*double(rand())/RAND_MAX - 1.0);
+        Eigen::Vector3d p(capsule.radius*direction.x(), capsule.radius*direction.y(), 0.0);
+        p.normalize();
+        p *= capsule.radius;
+        p.z() = z;
+        // half of the points on the hemispheres
+        if(i % 2)
+            p = capsule.radius*direction + (direction.z() > 0 ? half_length : -half_length)*Eigen::Vector3d::UnitZ();
+        points.push_back(frame*p);
+    }
+    return points;
+}
+
+TEST_F(testCapsuleFitting, testRecoverCapsule)
+{
+    CapsuleFitting::Capsule capsule;
+    capsule.ep1 << 0.1, -0.2, 0.3;
+    capsule.ep2 << 0.4, 0.2, -0.1;
+    capsule.radius = 0.05;
+
+    CapsuleFitting::Points points = sampleCapsule(capsule, 5000);
+    CapsuleFitting::Capsule fitted = CapsuleFitting::fit(points);
+
+    // the fitted capsule encloses all the points
+    for(unsigned int i = 0; i < points.size(); ++i)
+        EXPECT_LE(fitted.getDistance(points[i]), 1e-9);
+
+    // and it is almost the original one
+    EXPECT_NEAR(fitted.radius, capsule.radius, 2e-3);
+    EXPECT_NEAR(fitted.getLength(), capsule.getLength(), 1e-2);
+    EXPECT_LT(CapsuleFitting::getApproximationError(fitted, points), 2e-2);
+}
+
+TEST_F(testCapsuleFitting, testBox)
+{
+    // box 0.1 x 0.1 x 0.5 along x
+    CapsuleFitting::Points points;
+    for(int i = -1; i <= 1; i += 2)
+        for(int j = -1; j <= 1; j += 2)
+            for(int k = -1; k <= 1; k += 2)
+                points.push_back(Eigen::Vector3d(0.25*i, 0.05*j, 0.05*k));
+
+    CapsuleFitting::Capsule fitted = CapsuleFitting::fit(points);
+    for(unsigned int i = 0; i < points.size(); ++i)
+        EXPECT_LE(fitted.getDistance(points[i]), 1e-9);
+
+    // the axis is along x and the radius is half of the diagonal of the section
+    Eigen::Vector3d axis = (fitted.ep2 - fitted.ep1).normalized();
+    EXPECT_NEAR(std::fabs(axis.x()), 1.0, 1e-9);
+    EXPECT_NEAR(fitted.radius, 0.05*std::sqrt(2.0), 1e-9);
+    EXPECT_NEAR(fitted.getLength(), 0.5, 1e-6);
+
+    // the error is at least the distance between the hemispheres and the box faces
+    EXPECT_GT(CapsuleFitting::getApproximationError(fitted, points), fitted.radius);
+}
+
+TEST_F(testCapsuleFitting, testSphere)
+{
+    CapsuleFitting::Points points;
+    for(unsigned int i = 0; i < 1000; ++i)
+        points.push_back(Eigen::Vector3d(1., 2., 3.) + 0.2*Eigen::Vector3d::Random().normalized());
+
+    CapsuleFitting::Capsule fitted = CapsuleFitting::fit(points);
+    for(unsigned int i = 0; i < points.size(); ++i)
+        EXPECT_LE(fitted.getDistance(points[i]), 1e-9);
+    EXPECT_LT(fitted.getLength(), 2e-2);
+    EXPECT_NEAR(fitted.radius, 0.2, 1e-2);
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
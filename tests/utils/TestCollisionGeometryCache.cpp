@@ -0,0 +1,142 @@
+#include <OpenSoT/utils/CollisionGeometryCache.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+
+using namespace OpenSoT::utils;
+
+namespace{
+
+class testCollisionGeometryCache: public ::testing::Test
+{
+protected:
+
+    testCollisionGeometryCache():
+        file_name("testCollisionGeometryCache.bin")
+    {
+        CollisionGeometryCache::Shape capsule;
+        capsule.link_name = "LForeArm";
+        capsule.type = CollisionGeometryCache::CAPSULE;
+        capsule.size << 0.05, 0.3, 0.0;
+        capsule.position << 0.1, 0.2, 0.3;
+        capsule.orientation = Eigen::Quaterniond(Eigen::AngleAxisd(0.5, Eigen::Vector3d::UnitY()));
+        cache.shapes.push_back(capsule);
+
+        CollisionGeometryCache::Shape mesh;
+        mesh.link_name = "Waist";
+        mesh.type = CollisionGeometryCache::MESH;
+        mesh.size.setOnes();
+        mesh.position.setZero();
+        mesh.orientation.setIdentity();
+        for(unsigned int i = 0; i < 12; ++i)
+            mesh.vertices.push_back(0.1*i);
+        mesh.triangles.push_back(0); mesh.triangles.push_back(1); mesh.triangles.push_back(2);
+        mesh.triangles.push_back(1); mesh.triangles.push_back(2); mesh.triangles.push_back(3);
+        cache.shapes.push_back(mesh);
+
+        cache.pairs.push_back(CollisionGeometryCache::LinksPair("LForeArm", "Waist"));
+
+        key = CollisionGeometryCache::computeKey("<robot name=\"test\"/>");
+    }
+
+    virtual ~testCollisionGeometryCache() {
+        std::remove(file_name.c_str());
+    }
+
+    virtual void SetUp() {
+
+    }
+
+    virtual void TearDown() {
+
+    }
+
+    CollisionGeometryCache cache;
+    std::string file_name;
+    uint64_t key;
+};
+
+TEST_F(testCollisionGeometryCache, testSaveLoad)
+{
+    ASSERT_TRUE(cache.save(file_name, key));
+
+    CollisionGeometryCache loaded;
+    ASSERT_TRUE(loaded.load(file_name, key));
+
+    ASSERT_EQ(loaded.shapes.size(), cache.shapes.size());
+    for(unsigned int i = 0; i < cache.shapes.size(); ++i)
+    {
+        EXPECT_EQ(loaded.shapes[i].link_name, cache.shapes[i].link_name);
+        EXPECT_EQ(loaded.shapes[i].type, cache.shapes[i].type);
+        EXPECT_TRUE(loaded.shapes[i].size == cache.shapes[i].size);
+        EXPECT_TRUE(loaded.shapes[i].position == cache.shapes[i].position);
+        EXPECT_TRUE(loaded.shapes[i].orientation.coeffs() == cache.shapes[i].orientation.coeffs());
+        EXPECT_TRUE(loaded.shapes[i].vertices == cache.shapes[i].vertices);
+        EXPECT_TRUE(loaded.shapes[i].triangles == cache.shapes[i].triangles);
+    }
+    EXPECT_TRUE(loaded.pairs == cache.pairs);
+}
+
+TEST_F(testCollisionGeometryCache, testKeyMismatch)
+{
+    ASSERT_TRUE(cache.save(file_name, key));
+
+    uint64_t other_key = CollisionGeometryCache::computeKey("<robot name=\"other\"/>");
+    EXPECT_NE(key, other_key);
+
+    CollisionGeometryCache loaded;
+    EXPECT_FALSE(loaded.load(file_name, other_key));
+    EXPECT_TRUE(loaded.shapes.empty());
+    EXPECT_TRUE(loaded.pairs.empty());
+
+    EXPECT_FALSE(loaded.load("not_existing_file.bin", key));
+}
+
+TEST_F(testCollisionGeometryCache, testTruncatedFile)
+{
+    ASSERT_TRUE(cache.save(file_name, key));
+
+    std::ifstream file(file_name.c_str(), std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    for(std::size_t size = 0; size < content.size(); size += 7)
+    {
+        std::ofstream truncated(file_name.c_str(), std::ios::binary | std::ios::trunc);
+        truncated.write(content.data(), size);
+        truncated.close();
+
+        CollisionGeometryCache loaded;
+        EXPECT_FALSE(loaded.load(file_name, key)) << "size " << size;
+    }
+}
+
+TEST_F(testCollisionGeometryCache, testKeyContinuation)
+{
+    std::string urdf = "<robot name=\"test\"/>";
+    std::string mesh = "solid mesh";
+
+    uint64_t continued = CollisionGeometryCache::computeKey(mesh.data(), mesh.size(),
+                                                            CollisionGeometryCache::computeKey(urdf));
+    EXPECT_EQ(continued, CollisionGeometryCache::computeKey(urdf + mesh));
+    EXPECT_NE(continued, CollisionGeometryCache::computeKey(urdf));
+}
+
+TEST_F(testCollisionGeometryCache, testNoTemporaryFileLeft)
+{
+    ASSERT_TRUE(cache.save(file_name, key));
+    ASSERT_TRUE(cache.save(file_name, key));
+
+    std::ifstream tmp((file_name + ".tmp").c_str());
+    EXPECT_FALSE(tmp.good());
+
+    CollisionGeometryCache loaded;
+    EXPECT_TRUE(loaded.load(file_name, key));
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
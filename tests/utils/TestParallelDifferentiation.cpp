@@ -0,0 +1,211 @@
+#include <OpenSoT/utils/ParallelDifferentiation.h>
+#include <gtest/gtest.h>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using OpenSoT::utils::ParallelDifferentiation;
+
+namespace{
+
+/**
+ * @brief f(x) = sum_i sin(x_i) x_{i+1} + x_i^2, also for complex x
+ */
+template <typename Scalar>
+Scalar testFunction(const Eigen::Matrix<Scalar, Eigen::Dynamic, 1>& x)
+{
+    Scalar f(0.0);
+    for(int i = 0; i < x.size(); ++i)
+        f += std::sin(x[i])*x[(i+1)%x.size()] + x[i]*x[i];
+    return f;
+}
+
+Eigen::VectorXd testGradient(const Eigen::VectorXd& x)
+{
+    Eigen::VectorXd gradient(x.size());
+    for(int i = 0; i < x.size(); ++i)
+    {
+        int previous = (i + x.size() - 1)%x.size();
+        gradient[i] = std::cos(x[i])*x[(i+1)%x.size()] + std::sin(x[previous]) + 2.0*x[i];
+    }
+    return gradient;
+}
+
+/**
+ * @brief The TestCostFunction class checks that each instance is always evaluated by the same thread
+ */
+class TestCostFunction: public CostFunction, public ComplexCostFunction
+{
+public:
+    std::thread::id thread_id;
+    bool same_thread;
+    unsigned int evaluations;
+
+    TestCostFunction(): same_thread(true), evaluations(0) {}
+
+    double compute(const Eigen::VectorXd &x)
+    {
+        check();
+        return testFunction(x);
+    }
+
+    std::complex<double> compute(const Eigen::VectorXcd &x)
+    {
+        check();
+        return testFunction(x);
+    }
+
+private:
+    void check()
+    {
+        if(evaluations++ == 0)
+            thread_id = std::this_thread::get_id();
+        same_thread = same_thread && thread_id == std::this_thread::get_id();
+    }
+};
+
+class TestGradientVector: public GradientVector
+{
+public:
+    TestGradientVector(const int x_size): GradientVector(x_size) {}
+
+    Eigen::VectorXd compute(const Eigen::VectorXd &x)
+    {
+        return testGradient(x);
+    }
+};
+
+class testParallelDifferentiation: public ::testing::Test
+{
+protected:
+
+    testParallelDifferentiation()
+    {
+        srand(0);
+        x = Eigen::VectorXd::Random(30);
+    }
+
+    virtual ~testParallelDifferentiation() {
+
+    }
+
+    virtual void SetUp() {
+
+    }
+
+    virtual void TearDown() {
+
+    }
+
+    Eigen::VectorXd x;
+};
+
+TEST_F(testParallelDifferentiation, testGradient)
+{
+    std::vector<boost::shared_ptr<TestCostFunction> > functions;
+    std::vector<CostFunction*> pool;
+    for(unsigned int i = 0; i < 4; ++i)
+    {
+        functions.push_back(boost::shared_ptr<TestCostFunction>(new TestCostFunction()));
+        pool.push_back(functions.back().get());
+    }
+
+    ParallelDifferentiation differentiation(pool);
+    EXPECT_EQ(differentiation.getNumberOfThreads(), 4);
+
+    Eigen::VectorXd gradient = testGradient(x);
+
+    // repeated calls, to exercise the synchronization of the pool
+    for(unsigned int k = 0; k < 100; ++k)
+    {
+        Eigen::VectorXd central = differentiation.computeGradient(x, std::vector<bool>(),
+                                                                  ParallelDifferentiation::CENTRAL_DIFFERENCES, 1E-6);
+        EXPECT_TRUE(central.isApprox(gradient, 1E-6));
+    }
+
+    Eigen::VectorXd forward = differentiation.computeGradient(x, std::vector<bool>(),
+                                                              ParallelDifferentiation::FORWARD_DIFFERENCES, 1E-7);
+    EXPECT_TRUE(forward.isApprox(gradient, 1E-5));
+
+    Eigen::VectorXd complex_step = differentiation.computeGradient(x, std::vector<bool>(),
+                                                                   ParallelDifferentiation::COMPLEX_STEP, 1E-20);
+    EXPECT_TRUE(complex_step.isApprox(gradient, 1E-14));
+
+    // the default step of the complex step is tiny, the one of the finite differences is not
+    complex_step = differentiation.computeGradient(x, std::vector<bool>(), ParallelDifferentiation::COMPLEX_STEP);
+    EXPECT_TRUE(complex_step.isApprox(gradient, 1E-14));
+    EXPECT_DOUBLE_EQ(ParallelDifferentiation::getDefaultStep(ParallelDifferentiation::COMPLEX_STEP), 1E-20);
+    EXPECT_DOUBLE_EQ(ParallelDifferentiation::getDefaultStep(ParallelDifferentiation::CENTRAL_DIFFERENCES), 1E-3);
+
+    for(unsigned int i = 0; i < functions.size(); ++i)
+        EXPECT_TRUE(functions[i]->same_thread);
+}
+
+TEST_F(testParallelDifferentiation, testJointMask)
+{
+    TestCostFunction function_a, function_b;
+    std::vector<CostFunction*> pool;
+    pool.push_back(&function_a);
+    pool.push_back(&function_b);
+    ParallelDifferentiation differentiation(pool);
+
+    std::vector<bool> jointMask(x.size(), true);
+    for(unsigned int i = 0; i < jointMask.size(); i += 3)
+        jointMask[i] = false;
+
+    Eigen::VectorXd gradient = testGradient(x);
+    Eigen::VectorXd masked = differentiation.computeGradient(x, jointMask);
+    for(unsigned int i = 0; i < jointMask.size(); ++i)
+    {
+        if(jointMask[i])
+            EXPECT_NEAR(masked[i], gradient[i], 1E-4);
+        else
+            EXPECT_EQ(masked[i], 0.0);
+    }
+
+    // masked columns are not evaluated
+    unsigned int active = std::count(jointMask.begin(), jointMask.end(), true);
+    EXPECT_EQ(function_a.evaluations + function_b.evaluations, 2*active);
+
+    // the result is the same as the serial implementation
+    Eigen::VectorXd serial = cartesian_utils::computeGradient(x, function_a, jointMask);
+    EXPECT_TRUE(masked.isApprox(serial, 1E-12));
+}
+
+TEST_F(testParallelDifferentiation, testHessian)
+{
+    std::vector<boost::shared_ptr<TestGradientVector> > functions;
+    std::vector<GradientVector*> pool;
+    for(unsigned int i = 0; i < 3; ++i)
+    {
+        functions.push_back(boost::shared_ptr<TestGradientVector>(new TestGradientVector(x.size())));
+        pool.push_back(functions.back().get());
+    }
+    ParallelDifferentiation differentiation(pool);
+
+    Eigen::MatrixXd hessian = Eigen::MatrixXd::Zero(x.size(), x.size());
+    for(int i = 0; i < x.size(); ++i)
+    {
+        int next = (i+1)%x.size();
+        int previous = (i + x.size() - 1)%x.size();
+        hessian(i,i) = -std::sin(x[i])*x[next] + 2.0;
+        hessian(i,next) += std::cos(x[i]);
+        hessian(i,previous) += std::cos(x[previous]);
+    }
+
+    Eigen::MatrixXd central = differentiation.computeHessian(x, std::vector<bool>(),
+                                                             ParallelDifferentiation::CENTRAL_DIFFERENCES, 1E-5);
+    EXPECT_TRUE(central.isApprox(hessian, 1E-6));
+
+    Eigen::MatrixXd forward = differentiation.computeHessian(x, std::vector<bool>(),
+                                                             ParallelDifferentiation::FORWARD_DIFFERENCES, 1E-7);
+    EXPECT_TRUE(forward.isApprox(hessian, 1E-5));
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,205 @@
+#include <OpenSoT/utils/RTLogger.h>
+#include <OpenSoT/tasks/velocity/Postural.h>
+#include <OpenSoT/Constraint.h>
+#include <OpenSoT/constraints/Aggregated.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+
+using OpenSoT::utils::RTLogger;
+
+namespace{
+
+class testRTLogger: public ::testing::Test
+{
+protected:
+    testRTLogger() : _file_name("/tmp/testRTLogger.log")
+    {
+
+    }
+
+    virtual ~testRTLogger() {
+        std::remove(_file_name.c_str());
+    }
+
+    std::string _file_name;
+};
+
+TEST_F(testRTLogger, testLogAndLoad)
+{
+    Eigen::MatrixXd M(4,3);
+    Eigen::VectorXd v(5);
+
+    {
+        RTLogger::Ptr logger(new RTLogger(_file_name, 1 << 12, 1));
+        ASSERT_TRUE(logger->isValid());
+
+        RTLogger::Handle hM = logger->registerChannel("M", M.rows(), M.cols());
+        RTLogger::Handle hv = logger->registerChannel("v", v.size());
+        RTLogger::Handle hblock = logger->registerChannel("block", 2, 2);
+        RTLogger::Handle hs = logger->registerChannel("s", 1);
+        EXPECT_EQ(logger->registerChannel("v", v.size()), hv);
+        EXPECT_EQ(logger->getHandle("M"), hM);
+        EXPECT_EQ(logger->getHandle("unknown"), -1);
+
+        // the log is much larger than the buffer, which is never full since it is flushed every 10 samples
+        for(unsigned int k = 0; k < 1000; ++k)
+        {
+            M.setConstant(k);
+            v.setLinSpaced(5, k, k + 4);
+            EXPECT_TRUE(logger->add(hM, M));
+            EXPECT_TRUE(logger->add(hv, v));
+            EXPECT_TRUE(logger->add(hblock, M.block(1,1,2,2)));
+            EXPECT_TRUE(logger->add(hs, double(k)));
+            if(k % 10 == 9)
+                logger->flush();
+        }
+        EXPECT_EQ(logger->getDroppedSamples(), 0);
+
+        // samples larger than the channel are dropped
+        unsigned int dropped = logger->getDroppedSamples();
+        EXPECT_FALSE(logger->add(hblock, M));
+        EXPECT_EQ(logger->getDroppedSamples(), dropped + 1);
+        EXPECT_FALSE(logger->add(-1, M));
+    }
+
+    std::map<std::string, std::vector<Eigen::MatrixXd> > data;
+    ASSERT_TRUE(RTLogger::load(_file_name, data));
+    ASSERT_EQ(data.size(), 4);
+
+    ASSERT_EQ(data["s"].size(), 1000);
+    ASSERT_EQ(data["M"].size(), 1000);
+    for(unsigned int i = 0; i < data["s"].size(); ++i)
+    {
+        double k = data["s"][i](0,0);
+        ASSERT_EQ(data["M"][i].rows(), 4);
+        ASSERT_EQ(data["M"][i].cols(), 3);
+        EXPECT_EQ(data["M"][i], Eigen::MatrixXd::Constant(4,3,k));
+        EXPECT_EQ(data["v"][i], Eigen::VectorXd::LinSpaced(5, k, k + 4));
+        EXPECT_EQ(data["block"][i], Eigen::MatrixXd::Constant(2,2,k));
+    }
+    EXPECT_DOUBLE_EQ(data["s"].back()(0,0), 999.0);
+}
+
+TEST_F(testRTLogger, testDroppedSamples)
+{
+    RTLogger logger(_file_name, 1024, 10000);
+    RTLogger::Handle h = logger.registerChannel("M", 10, 10);
+    logger.flush();
+
+    // the consumer sleeps, a 1024 bytes buffer can hold only one sample of 800 bytes
+    Eigen::MatrixXd M = Eigen::MatrixXd::Random(10,10);
+    EXPECT_TRUE(logger.add(h, M));
+    EXPECT_FALSE(logger.add(h, M));
+    EXPECT_EQ(logger.getDroppedSamples(), 1);
+
+    logger.flush();
+    EXPECT_TRUE(logger.add(h, M));
+}
+
+TEST_F(testRTLogger, testTaskLog)
+{
+    Eigen::VectorXd q(6);
+    q.setRandom();
+    OpenSoT::tasks::velocity::Postural::Ptr postural(new OpenSoT::tasks::velocity::Postural(q));
+
+    {
+        RTLogger::Ptr logger(new RTLogger(_file_name));
+        postural->registerLog(logger);
+        for(unsigned int i = 0; i < 10; ++i)
+        {
+            postural->update(q);
+            postural->log(logger);
+        }
+        EXPECT_EQ(logger->getDroppedSamples(), 0);
+    }
+
+    std::map<std::string, std::vector<Eigen::MatrixXd> > data;
+    ASSERT_TRUE(RTLogger::load(_file_name, data));
+    std::string id = postural->getTaskID();
+    ASSERT_EQ(data[id + "_A"].size(), 10);
+    ASSERT_EQ(data[id + "_lambda"].size(), 10);
+    EXPECT_EQ(data[id + "_A"].back(), postural->getA());
+    EXPECT_EQ(data[id + "_b"].back(), postural->getb());
+    EXPECT_DOUBLE_EQ(data[id + "_lambda"].back()(0,0), postural->getLambda());
+}
+
+/**
+ * @brief The GrowingConstraint class has one inequality per update, up to a maximum
+ */
+class GrowingConstraint: public OpenSoT::Constraint<Eigen::MatrixXd, Eigen::VectorXd>
+{
+public:
+    typedef boost::shared_ptr<GrowingConstraint> Ptr;
+
+    GrowingConstraint(const unsigned int x_size, const unsigned int max_rows):
+        Constraint("growing", x_size), _max_rows(max_rows), _declare_max(true){}
+
+    void update(const Eigen::VectorXd& x)
+    {
+        const unsigned int rows = std::min<unsigned int>(_Aineq.rows() + 1, _max_rows);
+        _Aineq.setConstant(rows, _x_size, rows);
+        _bUpperBound.setConstant(rows, rows);
+        _bLowerBound.setConstant(rows, -1.0*rows);
+    }
+
+    unsigned int getMaxAineqRows() { return _declare_max ? _max_rows : _Aineq.rows(); }
+
+    unsigned int _max_rows;
+    bool _declare_max;
+};
+
+TEST_F(testRTLogger, testConstraintChangingSize)
+{
+    const unsigned int x_size = 3, max_rows = 5;
+    Eigen::VectorXd x = Eigen::VectorXd::Zero(x_size);
+
+    // registered while empty, with and without the maximum number of rows
+    for(unsigned int declare_max = 0; declare_max < 2; ++declare_max)
+    {
+        GrowingConstraint::Ptr constraint(new GrowingConstraint(x_size, max_rows));
+        constraint->_declare_max = declare_max;
+        {
+            RTLogger::Ptr logger(new RTLogger(_file_name));
+            constraint->registerLog(logger);
+            EXPECT_NE(logger->getHandle("growing_Aineq"), -1);
+            for(unsigned int i = 0; i < 2*max_rows; ++i)
+            {
+                constraint->update(x);
+                constraint->log(logger);
+            }
+            // the channels are not registered again: without the maximum number of rows
+            // the samples of Aineq, bLowerBound and bUpperBound are dropped
+            EXPECT_EQ(logger->getDroppedSamples(), declare_max ? 0 : 3*2*max_rows);
+        }
+
+        std::map<std::string, std::vector<Eigen::MatrixXd> > data;
+        ASSERT_TRUE(RTLogger::load(_file_name, data));
+        if(!declare_max)
+        {
+            EXPECT_TRUE(data["growing_Aineq"].empty());
+            continue;
+        }
+        ASSERT_EQ(data["growing_Aineq"].size(), 2*max_rows);
+        ASSERT_EQ(data["growing_bUpperBound"].size(), 2*max_rows);
+        for(unsigned int i = 0; i < 2*max_rows; ++i)
+        {
+            const unsigned int rows = std::min(i + 1, max_rows);
+            EXPECT_EQ(data["growing_Aineq"][i], Eigen::MatrixXd::Constant(rows, x_size, rows));
+            EXPECT_EQ(data["growing_bUpperBound"][i], Eigen::VectorXd::Constant(rows, rows));
+        }
+    }
+
+    // the aggregated constraints declare the maximum number of rows of their constraints
+    GrowingConstraint::Ptr constraint(new GrowingConstraint(x_size, max_rows));
+    constraint->update(x);
+    OpenSoT::constraints::Aggregated aggregated(std::list<OpenSoT::constraints::Aggregated::ConstraintPtr>(1, constraint),
+                                                x_size);
+    EXPECT_EQ(aggregated.getMaxAineqRows(), max_rows);
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
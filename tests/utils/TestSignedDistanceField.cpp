@@ -0,0 +1,146 @@
+#include <OpenSoT/utils/SignedDistanceField.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+
+using namespace OpenSoT::utils;
+
+namespace{
+
+class testSignedDistanceField: public ::testing::Test
+{
+protected:
+
+    testSignedDistanceField():
+        origin(-1.0, -1.0, -1.0),
+        resolution(0.05),
+        size(41, 41, 41)
+    {
+
+    }
+
+    virtual ~testSignedDistanceField() {
+
+    }
+
+    virtual void SetUp() {
+
+    }
+
+    virtual void TearDown() {
+
+    }
+
+    Eigen::Vector3d origin;
+    double resolution;
+    Eigen::Vector3i size;
+};
+
+TEST_F(testSignedDistanceField, testSinglePoint)
+{
+    SignedDistanceField::Points points;
+    points.push_back(Eigen::Vector3d(0.1, 0.2, -0.3));
+
+    SignedDistanceField::Ptr sdf = SignedDistanceField::fromPointCloud(points, origin, resolution, size);
+    ASSERT_TRUE(bool(sdf));
+    EXPECT_FALSE(sdf->isMapped());
+
+    // on the nodes the field is the exact euclidean distance
+    for(int i = 0; i < size[0]; i += 5)
+        for(int j = 0; j < size[1]; j += 5)
+            for(int k = 0; k < size[2]; k += 5)
+            {
+                Eigen::Vector3d node = origin + resolution*Eigen::Vector3d(i, j, k);
+                EXPECT_NEAR(sdf->getNodeDistance(i, j, k), (node - points[0]).norm(), 1E-5);
+            }
+
+    // the occupied node is inside the obstacle
+    EXPECT_NEAR(sdf->getDistance(points[0]), -resolution, 1E-5);
+}
+
+TEST_F(testSignedDistanceField, testPlaneGradient)
+{
+    SignedDistanceField::Points vertices;
+    vertices.push_back(Eigen::Vector3d(-1.0, -1.0, 0.0));
+    vertices.push_back(Eigen::Vector3d( 1.0, -1.0, 0.0));
+    vertices.push_back(Eigen::Vector3d( 1.0,  1.0, 0.0));
+    vertices.push_back(Eigen::Vector3d(-1.0,  1.0, 0.0));
+    SignedDistanceField::Triangles triangles;
+    triangles.push_back(Eigen::Vector3i(0, 1, 2));
+    triangles.push_back(Eigen::Vector3i(0, 2, 3));
+
+    SignedDistanceField::Ptr sdf = SignedDistanceField::fromMesh(vertices, triangles, origin, resolution, size);
+    ASSERT_TRUE(bool(sdf));
+
+    for(unsigned int n = 0; n < 100; ++n)
+    {
+        Eigen::Vector3d p = 0.5*Eigen::Vector3d::Random();
+        p[2] = std::abs(p[2]) + 2.0*resolution;
+
+        Eigen::Vector3d gradient;
+        double distance = sdf->getDistance(p, gradient);
+        EXPECT_NEAR(distance, p[2], 1E-5);
+        EXPECT_TRUE(gradient.isApprox(Eigen::Vector3d::UnitZ(), 1E-5)) << gradient.transpose();
+
+        p[2] = -p[2];
+        distance = sdf->getDistance(p, gradient);
+        EXPECT_NEAR(distance, -p[2], 1E-5);
+        EXPECT_TRUE(gradient.isApprox(-Eigen::Vector3d::UnitZ(), 1E-5)) << gradient.transpose();
+    }
+}
+
+TEST_F(testSignedDistanceField, testInsideIsNegative)
+{
+    // a solid cube of side 0.5
+    SignedDistanceField::Points points;
+    for(double x = -0.25; x <= 0.25 + 1E-9; x += resolution)
+        for(double y = -0.25; y <= 0.25 + 1E-9; y += resolution)
+            for(double z = -0.25; z <= 0.25 + 1E-9; z += resolution)
+                points.push_back(Eigen::Vector3d(x, y, z));
+
+    SignedDistanceField::Ptr sdf = SignedDistanceField::fromPointCloud(points, origin, resolution, size);
+    ASSERT_TRUE(bool(sdf));
+
+    EXPECT_NEAR(sdf->getDistance(Eigen::Vector3d::Zero()), -0.3, 1E-5);
+    EXPECT_NEAR(sdf->getDistance(Eigen::Vector3d(0.5, 0.0, 0.0)), 0.25, 1E-5);
+    EXPECT_NEAR(sdf->getDistance(Eigen::Vector3d(0.0, -0.4, 0.0)), 0.15, 1E-5);
+}
+
+TEST_F(testSignedDistanceField, testSaveLoad)
+{
+    SignedDistanceField::Points points;
+    for(unsigned int n = 0; n < 50; ++n)
+        points.push_back(0.8*Eigen::Vector3d::Random());
+
+    SignedDistanceField::Ptr sdf = SignedDistanceField::fromPointCloud(points, origin, resolution, size);
+    ASSERT_TRUE(bool(sdf));
+
+    std::string file_name = "testSignedDistanceField.sdf";
+    ASSERT_TRUE(sdf->save(file_name));
+
+    SignedDistanceField::Ptr loaded = SignedDistanceField::load(file_name);
+    ASSERT_TRUE(bool(loaded));
+    EXPECT_TRUE(loaded->isMapped());
+    EXPECT_TRUE(loaded->getOrigin() == sdf->getOrigin());
+    EXPECT_EQ(loaded->getResolution(), sdf->getResolution());
+    EXPECT_TRUE(loaded->getSize() == sdf->getSize());
+
+    for(unsigned int n = 0; n < 100; ++n)
+    {
+        Eigen::Vector3d p = 1.2*Eigen::Vector3d::Random();
+        Eigen::Vector3d gradient, loaded_gradient;
+        EXPECT_EQ(sdf->getDistance(p, gradient), loaded->getDistance(p, loaded_gradient));
+        EXPECT_TRUE(gradient == loaded_gradient);
+    }
+
+    EXPECT_FALSE(bool(SignedDistanceField::load("not_existing_file.sdf")));
+
+    loaded.reset();
+    std::remove(file_name.c_str());
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,131 @@
+#include <OpenSoT/utils/TripleBuffer.h>
+#include <OpenSoT/utils/AutoStack.h>
+#include <OpenSoT/tasks/velocity/Postural.h>
+#include <OpenSoT/solvers/iHQP.h>
+#include <gtest/gtest.h>
+#include <thread>
+
+using OpenSoT::utils::TripleBuffer;
+
+namespace{
+
+TEST(testTripleBuffer, testLastValue)
+{
+    TripleBuffer<int> buffer(-1);
+    int value = 0;
+    EXPECT_FALSE(buffer.read(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_EQ(buffer.getReadBuffer(), -1);
+
+    buffer.write(1);
+    buffer.write(2);
+    buffer.write(3);
+    EXPECT_TRUE(buffer.read(value));
+    EXPECT_EQ(value, 3);
+    EXPECT_FALSE(buffer.read(value));
+
+    buffer.getWriteBuffer() = 4;
+    EXPECT_FALSE(buffer.update());
+    buffer.publish();
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.getReadBuffer(), 4);
+}
+
+TEST(testTripleBuffer, testThreads)
+{
+    const unsigned int size = 100;
+    const int samples = 100000;
+    TripleBuffer<Eigen::VectorXd> buffer(Eigen::VectorXd::Zero(size));
+
+    std::thread writer([&buffer, samples]()
+    {
+        for(int k = 1; k <= samples; ++k)
+        {
+            buffer.getWriteBuffer().setConstant(k);
+            buffer.publish();
+        }
+    });
+
+    // the values are never torn and never go back in time
+    double last = 0.0;
+    unsigned int read = 0;
+    while(last < samples)
+    {
+        if(!buffer.update())
+            continue;
+        const Eigen::VectorXd& value = buffer.getReadBuffer();
+        ASSERT_EQ(value.size(), size);
+        ASSERT_EQ(value.minCoeff(), value.maxCoeff());
+        ASSERT_GT(value[0], last);
+        last = value[0];
+        ++read;
+    }
+    writer.join();
+    EXPECT_GT(read, 0);
+}
+
+TEST(testTripleBuffer, testReferencePort)
+{
+    const unsigned int dofs = 5;
+    Eigen::VectorXd q = Eigen::VectorXd::Zero(dofs);
+    OpenSoT::tasks::velocity::Postural::Ptr postural(new OpenSoT::tasks::velocity::Postural(q));
+    OpenSoT::AutoStack::Ptr stack(new OpenSoT::AutoStack(postural));
+
+    Eigen::VectorXd q_ref = Eigen::VectorXd::Constant(dofs, 0.5);
+    EXPECT_FALSE(postural->setReferenceAsync(Eigen::VectorXd::Zero(dofs+1), Eigen::VectorXd::Zero(dofs)));
+    std::thread planner([postural, q_ref, dofs]()
+    {
+        EXPECT_TRUE(postural->setReferenceAsync(q_ref, Eigen::VectorXd::Zero(dofs)));
+    });
+    planner.join();
+
+    // the reference is applied by the update of the stack
+    EXPECT_TRUE((postural->getReference() - q).norm() < 1e-12);
+    stack->update(q);
+    EXPECT_TRUE((postural->getReference() - q_ref).norm() < 1e-12);
+    EXPECT_TRUE((postural->getb() - postural->getLambda()*q_ref).norm() < 1e-12);
+    EXPECT_FALSE(postural->applyReferences());
+}
+
+TEST(testTripleBuffer, testOutputPort)
+{
+    const unsigned int dofs = 5;
+    Eigen::VectorXd q = Eigen::VectorXd::Zero(dofs);
+    OpenSoT::tasks::velocity::Postural::Ptr postural(new OpenSoT::tasks::velocity::Postural(q));
+    OpenSoT::solvers::iHQP::Stack stack;
+    stack.push_back(postural);
+    OpenSoT::solvers::iHQP solver(stack);
+
+    OpenSoT::solvers::iHQP::Output output;
+    EXPECT_FALSE(solver.readOutput(output));
+
+    Eigen::VectorXd dq;
+    for(unsigned int k = 0; k < 3; ++k)
+    {
+        postural->setReference(Eigen::VectorXd::Constant(dofs, 0.1*(k+1)));
+        postural->update(q);
+        ASSERT_TRUE(solver.solve(dq));
+    }
+
+    std::thread monitor([&solver, &output]()
+    {
+        EXPECT_TRUE(solver.readOutput(output));
+    });
+    monitor.join();
+
+    EXPECT_TRUE(output.success);
+    EXPECT_EQ(output.cycle, 3);
+    EXPECT_TRUE((output.solution - dq).norm() < 1e-12);
+    ASSERT_EQ(output.objectives.size(), 1);
+    double objective;
+    ASSERT_TRUE(solver.getObjective(0, objective));
+    EXPECT_DOUBLE_EQ(output.objectives[0], objective);
+    EXPECT_FALSE(solver.readOutput(output));
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
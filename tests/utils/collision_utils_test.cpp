@@ -5,6 +5,7 @@
 #include <fcl/shape/geometric_shapes.h>
 #include <XBotInterface/ModelInterface.h>
 #include <chrono>
+#include <boost/filesystem.hpp>
 
 #define  s                1.0
 #define  dT               0.001* s
@@ -408,6 +409,152 @@ TEST_F(testCollisionUtils, testCapsuleDistance) {
 
 
 
+TEST_F(testCollisionUtils, testBroadPhaseDoesNotChangeResults)
+{
+    getGoodInitialPosition(q,_model_ptr);
+    _model_ptr->setJointPosition(q);
+    _model_ptr->update();
+
+    double detection_threshold = 0.05;
+
+    std::list<LinkPairDistance> all_results = compute_distance->getLinkDistances();
+    std::list<LinkPairDistance> results = compute_distance->getLinkDistances(detection_threshold);
+
+    std::list<LinkPairDistance> expected_results;
+    for(std::list<LinkPairDistance>::iterator it = all_results.begin(); it != all_results.end(); ++it)
+        if(it->getDistance() < detection_threshold)
+            expected_results.push_back(*it);
+
+    ASSERT_EQ(results.size(), expected_results.size());
+
+    std::list<LinkPairDistance>::iterator it_expected = expected_results.begin();
+    for(std::list<LinkPairDistance>::iterator it = results.begin(); it != results.end(); ++it)
+    {
+        EXPECT_EQ(it->getLinkNames(), it_expected->getLinkNames());
+        EXPECT_NEAR(it->getDistance(), it_expected->getDistance(), 1E-12);
+        ++it_expected;
+    }
+}
+
+TEST_F(testCollisionUtils, testCoherenceCacheDoesNotChangeResults)
+{
+    getGoodInitialPosition(q,_model_ptr);
+
+    double detection_threshold = 0.05;
+
+    // with an infinite detection threshold the cache is never used to skip pairs
+    ComputeLinksDistance reference_distance(*_model_ptr);
+
+    for(unsigned int k = 0; k < 100; ++k)
+    {
+        // arms move toward the body, so that pairs enter the detection threshold
+        q[_model_ptr->getDofIndex("LShLat")] -= 0.2*M_PI/180.0;
+        q[_model_ptr->getDofIndex("RShLat")] += 0.2*M_PI/180.0;
+        _model_ptr->setJointPosition(q);
+        _model_ptr->update();
+
+        std::list<LinkPairDistance> results = compute_distance->getLinkDistances(detection_threshold);
+
+        std::list<LinkPairDistance> all_results = reference_distance.getLinkDistances();
+        unsigned int expected_size = 0;
+        for(std::list<LinkPairDistance>::iterator it = all_results.begin(); it != all_results.end(); ++it)
+            if(it->getDistance() < detection_threshold)
+                ++expected_size;
+
+        ASSERT_EQ(results.size(), expected_size) << "at iteration " << k;
+    }
+}
+
+TEST_F(testCollisionUtils, testIndexedResults)
+{
+    getGoodInitialPosition(q,_model_ptr);
+    _model_ptr->setJointPosition(q);
+    _model_ptr->update();
+
+    double detection_threshold = 0.05;
+
+    std::vector<IndexedLinkPairDistance> indexed_results;
+    unsigned int number_of_results = compute_distance->getLinkDistances(detection_threshold, indexed_results);
+    ASSERT_EQ(indexed_results.size(), compute_distance->getNumberOfPairs());
+    const IndexedLinkPairDistance* buffer = indexed_results.data();
+
+    ComputeLinksDistance reference_distance(*_model_ptr);
+    std::list<LinkPairDistance> results = reference_distance.getLinkDistances(detection_threshold);
+    ASSERT_EQ(number_of_results, results.size());
+
+    for(std::list<LinkPairDistance>::iterator it = results.begin(); it != results.end(); ++it)
+    {
+        int linkA = compute_distance->getLinkId(it->getLinkNames().first);
+        int linkB = compute_distance->getLinkId(it->getLinkNames().second);
+        ASSERT_GE(linkA, 0);
+        ASSERT_GE(linkB, 0);
+        EXPECT_EQ(compute_distance->getLinkName(linkA), it->getLinkNames().first);
+
+        bool found = false;
+        for(unsigned int i = 0; i < number_of_results; ++i)
+        {
+            if(indexed_results[i].linkAId == (unsigned int)linkA &&
+               indexed_results[i].linkBId == (unsigned int)linkB)
+            {
+                found = true;
+                EXPECT_NEAR(indexed_results[i].distance, it->getDistance(), 1E-12);
+                EXPECT_TRUE(KDL::Equal(indexed_results[i].linkA_T_closestPoint,
+                                       it->getLink_T_closestPoint().first, 1E-12));
+                EXPECT_TRUE(KDL::Equal(indexed_results[i].linkB_T_closestPoint,
+                                       it->getLink_T_closestPoint().second, 1E-12));
+            }
+        }
+        EXPECT_TRUE(found) << it->getLinkNames().first << " - " << it->getLinkNames().second;
+    }
+
+    EXPECT_EQ(compute_distance->getLinkId("not_a_link"), -1);
+
+    // the buffer is reused
+    compute_distance->getLinkDistances(detection_threshold, indexed_results);
+    EXPECT_EQ(indexed_results.data(), buffer);
+}
+
+TEST_F(testCollisionUtils, testGeometryCache)
+{
+    getGoodInitialPosition(q,_model_ptr);
+    _model_ptr->setJointPosition(q);
+    _model_ptr->update();
+
+    boost::filesystem::path cache_directory =
+        boost::filesystem::temp_directory_path() / "testCollisionUtilsGeometryCache";
+    boost::filesystem::remove_all(cache_directory);
+
+    // the first instance parses the robot model and writes the cache,
+    // the second one loads it
+    ComputeLinksDistance parsed_distance(*_model_ptr, cache_directory.string());
+    ASSERT_TRUE(boost::filesystem::exists(cache_directory));
+    ASSERT_FALSE(boost::filesystem::is_empty(cache_directory));
+    ComputeLinksDistance cached_distance(*_model_ptr, cache_directory.string());
+
+    EXPECT_EQ(cached_distance.getNumberOfLinks(), parsed_distance.getNumberOfLinks());
+    EXPECT_EQ(cached_distance.getNumberOfPairs(), parsed_distance.getNumberOfPairs());
+
+    std::list<LinkPairDistance> parsed_results = parsed_distance.getLinkDistances();
+    std::list<LinkPairDistance> cached_results = cached_distance.getLinkDistances();
+    ASSERT_EQ(cached_results.size(), parsed_results.size());
+
+    std::list<LinkPairDistance>::iterator it_parsed = parsed_results.begin();
+    for(std::list<LinkPairDistance>::iterator it = cached_results.begin(); it != cached_results.end(); ++it)
+    {
+        EXPECT_EQ(it->getLinkNames(), it_parsed->getLinkNames());
+        EXPECT_NEAR(it->getDistance(), it_parsed->getDistance(), 1E-12);
+        ++it_parsed;
+    }
+
+    // white and black lists can be modified also when loading from cache
+    std::list<LinkPairDistance::LinksPair> whiteList;
+    whiteList.push_back(LinkPairDistance::LinksPair("LSoftHandLink", "RSoftHandLink"));
+    EXPECT_TRUE(cached_distance.setCollisionWhiteList(whiteList));
+    EXPECT_EQ(cached_distance.getNumberOfPairs(), 1u);
+
+    boost::filesystem::remove_all(cache_directory);
+}
+
 TEST_F(testCollisionUtils, checkTimings)
 {
     getGoodInitialPosition(q,_model_ptr);
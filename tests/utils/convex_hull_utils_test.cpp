@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <OpenSoT/utils/convex_hull_utils.h>
+#include <cstdlib>
+
+namespace {
+
+class testConvexHullUtils: public ::testing::Test
+{
+protected:
+
+    testConvexHullUtils()
+    {
+        srand(0);
+    }
+
+    virtual ~testConvexHullUtils() {
+
+    }
+
+    virtual void SetUp() {
+
+    }
+
+    virtual void TearDown() {
+
+    }
+
+    convex_hull huller;
+};
+
+double random(const double min, const double max)
+{
+    return min + (max - min)*double(rand())/RAND_MAX;
+}
+
+/**
+ * @brief isLeft true if p is on the left of (or on) the line from p0 to p1
+ */
+bool isLeft(const KDL::Vector& p0, const KDL::Vector& p1, const KDL::Vector& p)
+{
+    return (p1.x() - p0.x())*(p.y() - p0.y()) - (p1.y() - p0.y())*(p.x() - p0.x()) >= -1e-12;
+}
+
+TEST_F(testConvexHullUtils, testSquare)
+{
+    std::vector<KDL::Vector> points;
+    points.push_back(KDL::Vector(0.1, 0.1, 0.3));
+    points.push_back(KDL::Vector(1.0, 1.0, 0.1));
+    points.push_back(KDL::Vector(0.0, 0.0, 0.2));
+    points.push_back(KDL::Vector(0.5, 0.0, 0.0));   // collinear
+    points.push_back(KDL::Vector(1.0, 0.0, 0.0));
+    points.push_back(KDL::Vector(0.0, 1.0, 0.0));
+    points.push_back(KDL::Vector(1.0, 1.0, 0.0));   // duplicated
+    points.push_back(KDL::Vector(0.5, 0.5, -0.1));
+
+    std::vector<KDL::Vector> ch;
+    EXPECT_TRUE(huller.getConvexHull(points, ch));
+    ASSERT_EQ(ch.size(), 4);
+
+    // counter-clockwise, starting from the lowest x
+    EXPECT_TRUE(KDL::Equal(ch[0], KDL::Vector(0.0, 0.0, 0.0)));
+    EXPECT_TRUE(KDL::Equal(ch[1], KDL::Vector(1.0, 0.0, 0.0)));
+    EXPECT_TRUE(KDL::Equal(ch[2], KDL::Vector(1.0, 1.0, 0.0)));
+    EXPECT_TRUE(KDL::Equal(ch[3], KDL::Vector(0.0, 1.0, 0.0)));
+
+    // the list interface gives the same result
+    std::list<KDL::Vector> points_list(points.begin(), points.end());
+    std::vector<KDL::Vector> ch_list;
+    EXPECT_TRUE(huller.getConvexHull(points_list, ch_list));
+    ASSERT_EQ(ch_list.size(), ch.size());
+    for(unsigned int i = 0; i < ch.size(); ++i)
+        EXPECT_TRUE(KDL::Equal(ch[i], ch_list[i]));
+}
+
+TEST_F(testConvexHullUtils, testRandomPoints)
+{
+    std::vector<KDL::Vector> ch;
+    for(unsigned int trial = 0; trial < 100; ++trial)
+    {
+        std::vector<KDL::Vector> points;
+        unsigned int number_of_points = 3 + rand()%30;
+        for(unsigned int i = 0; i < number_of_points; ++i)
+            points.push_back(KDL::Vector(random(-0.3, 0.3), random(-0.2, 0.2), random(-0.01, 0.01)));
+
+        ASSERT_TRUE(huller.getConvexHull(points, ch));
+        ASSERT_GE(ch.size(), 3);
+
+        // every point is inside the (counter-clockwise) convex hull
+        for(unsigned int j = 0; j < ch.size(); ++j)
+        {
+            const KDL::Vector& p0 = ch[j];
+            const KDL::Vector& p1 = ch[(j+1)%ch.size()];
+            for(unsigned int i = 0; i < points.size(); ++i)
+                EXPECT_TRUE(isLeft(p0, p1, points[i]));
+        }
+    }
+}
+
+TEST_F(testConvexHullUtils, testDegenerate)
+{
+    std::vector<KDL::Vector> points;
+    std::vector<KDL::Vector> ch;
+    points.push_back(KDL::Vector(0.0, 0.0, 0.0));
+    points.push_back(KDL::Vector(1.0, 1.0, 0.0));
+    EXPECT_FALSE(huller.getConvexHull(points, ch));
+    EXPECT_TRUE(ch.empty());
+
+    points.push_back(KDL::Vector(2.0, 2.0, 1.0));
+    EXPECT_FALSE(huller.getConvexHull(points, ch));
+    EXPECT_TRUE(ch.empty());
+}
+
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
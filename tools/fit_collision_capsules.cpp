@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2014 Walkman
+ * Author: Alessio Rocchi
+ * email:  alessio.rocchi@iit.it
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU Lesser General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * https://www.gnu.org/licenses/old-licenses/lgpl-2.1.html
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+ * fit_collision_capsules reads a URDF, replaces every mesh and box collision with its bounding capsule
+ * (written as a cylinder, as ComputeLinksDistance interprets cylinders as capsules) and writes
+ * <robot>_capsules.urdf next to it. If given, the SRDF is copied to <robot>_capsules.srdf, so that
+ * the capsule model is loaded by ComputeLinksDistance in place of the mesh model.
+ * For each link, the conservative approximation error (see CapsuleFitting::getApproximationError) is reported.
+ *
+ * usage: fit_collision_capsules robot.urdf [robot.srdf]
+ */
+
+#include <OpenSoT/utils/CapsuleFitting.h>
+#include <boost/foreach.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include <geometric_shapes/shapes.h>
+#include <geometric_shapes/shape_operations.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using OpenSoT::utils::CapsuleFitting;
+namespace pt = boost::property_tree;
+
+namespace
+{
+
+Eigen::Vector3d parseVector(const std::string& value, const Eigen::Vector3d& default_value)
+{
+    if(value.empty())
+        return default_value;
+    Eigen::Vector3d v = default_value;
+    std::istringstream stream(value);
+    stream >> v[0] >> v[1] >> v[2];
+    return v;
+}
+
+std::string toString(const Eigen::Vector3d& v)
+{
+    std::ostringstream stream;
+    stream.precision(9);
+    stream << v[0] << " " << v[1] << " " << v[2];
+    return stream.str();
+}
+
+std::string toString(const double v)
+{
+    std::ostringstream stream;
+    stream.precision(9);
+    stream << v;
+    return stream.str();
+}
+
+Eigen::Affine3d parseOrigin(const pt::ptree& collision)
+{
+    Eigen::Vector3d xyz = parseVector(collision.get("origin.<xmlattr>.xyz", ""), Eigen::Vector3d::Zero());
+    Eigen::Vector3d rpy = parseVector(collision.get("origin.<xmlattr>.rpy", ""), Eigen::Vector3d::Zero());
+
+    Eigen::Affine3d origin = Eigen::Affine3d::Identity();
+    origin.translation() = xyz;
+    origin.linear() = (Eigen::AngleAxisd(rpy[2], Eigen::Vector3d::UnitZ())*
+                       Eigen::AngleAxisd(rpy[1], Eigen::Vector3d::UnitY())*
+                       Eigen::AngleAxisd(rpy[0], Eigen::Vector3d::UnitX())).toRotationMatrix();
+    return origin;
+}
+
+void writeOrigin(const Eigen::Affine3d& origin, pt::ptree& collision)
+{
+    // URDF rpy are fixed axis X-Y-Z, i.e. R = Rz(yaw)*Ry(pitch)*Rx(roll)
+    Eigen::Vector3d ypr = origin.linear().eulerAngles(2, 1, 0);
+    collision.put("origin.<xmlattr>.xyz", toString(Eigen::Vector3d(origin.translation())));
+    collision.put("origin.<xmlattr>.rpy", toString(Eigen::Vector3d(ypr[2], ypr[1], ypr[0])));
+}
+
+/**
+ * @brief getPoints computes the points to enclose for the geometry of a collision, in collision frame
+ * @return false if the geometry has not to be replaced
+ */
+bool getPoints(const pt::ptree& geometry, CapsuleFitting::Points& points)
+{
+    points.clear();
+    if(geometry.count("mesh"))
+    {
+        std::string file_name = geometry.get("mesh.<xmlattr>.filename", "");
+        Eigen::Vector3d scale = parseVector(geometry.get("mesh.<xmlattr>.scale", ""), Eigen::Vector3d::Ones());
+
+        shapes::Mesh* mesh = shapes::createMeshFromResource(file_name);
+        if(mesh == NULL)
+        {
+            std::cerr << "Error loading mesh " << file_name << std::endl;
+            return false;
+        }
+        for(unsigned int i = 0; i < mesh->vertex_count; ++i)
+            points.push_back(Eigen::Vector3d(mesh->vertices[3*i], mesh->vertices[3*i+1], mesh->vertices[3*i+2]).cwiseProduct(scale));
+        delete mesh;
+    }
+    else if(geometry.count("box"))
+    {
+        Eigen::Vector3d size = parseVector(geometry.get("box.<xmlattr>.size", ""), Eigen::Vector3d::Zero());
+        for(int i = -1; i <= 1; i += 2)
+            for(int j = -1; j <= 1; j += 2)
+                for(int k = -1; k <= 1; k += 2)
+                    points.push_back(0.5*Eigen::Vector3d(i*size[0], j*size[1], k*size[2]));
+    }
+    return !points.empty();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cout << "usage: " << argv[0] << " robot.urdf [robot.srdf]" << std::endl;
+        return 1;
+    }
+
+    std::string urdf_file(argv[1]);
+    std::string stem = urdf_file.substr(0, urdf_file.rfind(".urdf"));
+
+    pt::ptree urdf;
+    try
+    {
+        pt::read_xml(urdf_file, urdf, pt::xml_parser::trim_whitespace);
+    }
+    catch(const pt::xml_parser_error& e)
+    {
+        std::cerr << "Error parsing " << urdf_file << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "link\tradius\tlength\terror" << std::endl;
+    BOOST_FOREACH(pt::ptree::value_type& link, urdf.get_child("robot"))
+    {
+        if(link.first != "link")
+            continue;
+        std::string link_name = link.second.get("<xmlattr>.name", "");
+
+        BOOST_FOREACH(pt::ptree::value_type& collision, link.second)
+        {
+            if(collision.first != "collision")
+                continue;
+
+            pt::ptree& geometry = collision.second.get_child("geometry");
+            CapsuleFitting::Points points;
+            if(!getPoints(geometry, points))
+                continue;
+
+            CapsuleFitting::Capsule capsule = CapsuleFitting::fit(points);
+            double error = CapsuleFitting::getApproximationError(capsule, points);
+
+            writeOrigin(parseOrigin(collision.second)*capsule.getCenterFrame(), collision.second);
+            geometry.clear();
+            geometry.put("cylinder.<xmlattr>.radius", toString(capsule.radius));
+            geometry.put("cylinder.<xmlattr>.length", toString(capsule.getLength()));
+
+            std::cout << link_name << "\t" << capsule.radius << "\t" << capsule.getLength()
+                      << "\t" << error << std::endl;
+        }
+    }
+
+    std::string capsules_urdf_file = stem + "_capsules.urdf";
+    pt::write_xml(capsules_urdf_file, urdf, std::locale(),
+                  pt::xml_writer_make_settings<std::string>(' ', 2));
+    std::cout << "Written " << capsules_urdf_file << std::endl;
+
+    if(argc > 2)
+    {
+        std::string srdf_file(argv[2]);
+        std::string capsules_srdf_file = stem + "_capsules.srdf";
+        std::ifstream srdf(srdf_file.c_str(), std::ios::binary);
+        std::ofstream capsules_srdf(capsules_srdf_file.c_str(), std::ios::binary);
+        if(!srdf.is_open() || !capsules_srdf.is_open())
+        {
+            std::cerr << "Error copying " << srdf_file << " to " << capsules_srdf_file << std::endl;
+            return 1;
+        }
+        capsules_srdf << srdf.rdbuf();
+        std::cout << "Written " << capsules_srdf_file << std::endl;
+    }
+
+    return 0;
+}
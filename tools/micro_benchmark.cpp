@@ -0,0 +1,476 @@
+#include <OpenSoT/tasks/Aggregated.h>
+#include <OpenSoT/tasks/GenericTask.h>
+#include <OpenSoT/tasks/MinimizeVariable.h>
+#include <OpenSoT/SubTask.h>
+#include <OpenSoT/tasks/velocity/AngularMomentum.h>
+#include <OpenSoT/tasks/velocity/Cartesian.h>
+#include <OpenSoT/tasks/velocity/CoM.h>
+#include <OpenSoT/tasks/velocity/Contact.h>
+#include <OpenSoT/tasks/velocity/Gaze.h>
+#include <OpenSoT/tasks/velocity/LinearMomentum.h>
+#include <OpenSoT/tasks/velocity/Manipulability.h>
+#include <OpenSoT/tasks/velocity/MinimizeAcceleration.h>
+#include <OpenSoT/tasks/velocity/MinimumEffort.h>
+#include <OpenSoT/tasks/velocity/MinimumVelocity.h>
+#include <OpenSoT/tasks/velocity/Postural.h>
+#include <OpenSoT/tasks/velocity/PureRolling.h>
+#include <OpenSoT/tasks/velocity/RigidRotation.h>
+#include <OpenSoT/tasks/velocity/Unicycle.h>
+#include <OpenSoT/tasks/acceleration/Cartesian.h>
+#include <OpenSoT/tasks/acceleration/CoM.h>
+#include <OpenSoT/tasks/acceleration/Contact.h>
+#include <OpenSoT/tasks/acceleration/Postural.h>
+#include <OpenSoT/tasks/force/CoM.h>
+#include <OpenSoT/tasks/force/FloatingBase.h>
+#include <OpenSoT/tasks/force/Wrench.h>
+#include <OpenSoT/tasks/floating_base/Contact.h>
+#include <OpenSoT/tasks/torque/CartesianImpedanceCtrl.h>
+#include <OpenSoT/tasks/torque/JointImpedanceCtrl.h>
+#include <OpenSoT/constraints/Aggregated.h>
+#include <OpenSoT/constraints/GenericConstraint.h>
+#include <OpenSoT/constraints/TaskToConstraint.h>
+#include <OpenSoT/constraints/velocity/CapturePoint.h>
+#include <OpenSoT/constraints/velocity/CartesianPositionConstraint.h>
+#include <OpenSoT/constraints/velocity/CartesianVelocity.h>
+#include <OpenSoT/constraints/velocity/CoMVelocity.h>
+#include <OpenSoT/constraints/velocity/ConvexHull.h>
+#include <OpenSoT/constraints/velocity/EnvironmentCollisionAvoidance.h>
+#include <OpenSoT/constraints/velocity/JointLimits.h>
+#include <OpenSoT/constraints/velocity/VelocityLimits.h>
+#include <OpenSoT/constraints/acceleration/DynamicFeasibility.h>
+#include <OpenSoT/constraints/force/CoP.h>
+#include <OpenSoT/constraints/force/FrictionCone.h>
+#include <OpenSoT/constraints/force/WrenchLimits.h>
+#include <OpenSoT/constraints/torque/JointLimits.h>
+#include <OpenSoT/constraints/torque/TorqueLimits.h>
+#include <OpenSoT/solvers/iHQP.h>
+#include <OpenSoT/utils/Affine.h>
+#include <OpenSoT/utils/Indices.h>
+#include <OpenSoT/utils/Piler.h>
+#include <XBotInterface/ModelInterface.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+
+/**
+ * The heap allocations are counted by interposing malloc, calloc and realloc of glibc: Eigen allocates with
+ * malloc, operator new of libstdc++ calls it as well. Only the allocations done while a benchmark runs are counted.
+ */
+namespace {
+    bool counting = false;
+    unsigned long allocations = 0;
+    unsigned long allocated_bytes = 0;
+}
+
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t n, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+
+    void* malloc(size_t size) throw()
+    {
+        if(counting){ ++allocations; allocated_bytes += size; }
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t n, size_t size) throw()
+    {
+        if(counting){ ++allocations; allocated_bytes += n*size; }
+        return __libc_calloc(n, size);
+    }
+
+    void* realloc(void* ptr, size_t size) throw()
+    {
+        if(counting){ ++allocations; allocated_bytes += size; }
+        return __libc_realloc(ptr, size);
+    }
+}
+
+namespace {
+
+using namespace OpenSoT;
+
+/**
+ * @brief The CostFunction class gives access to the cost functions computed by iHQP
+ */
+class CostFunction: public solvers::iHQP
+{
+public:
+    CostFunction(Stack& stack): solvers::iHQP(stack){}
+    using solvers::iHQP::computeCostFunction;
+};
+
+/**
+ * @brief The MicroBenchmark class times single operations and prints one row for each of them:
+ * mean time, heap allocations and allocated bytes per operation
+ */
+class MicroBenchmark
+{
+public:
+    MicroBenchmark(const double time_budget, const std::string& filter):
+        _time_budget(time_budget),
+        _filter(filter)
+    {
+        std::printf("%-32s %5s %8s  %-44s %12s %10s %12s\n", "model", "dofs", "contacts", "operation",
+                    "ns/op", "allocs/op", "bytes/op");
+    }
+
+    void setModel(const std::string& model, const int dofs, const int contacts)
+    {
+        _model = model;
+        _dofs = dofs;
+        _contacts = contacts;
+    }
+
+    /**
+     * @brief run repeats an operation in batches of doubling size until the time budget is spent.
+     * The operation is run once before, so that the buffers sized at the first call are not counted
+     */
+    void run(const std::string& name, const std::function<void()>& operation)
+    {
+        if(!_filter.empty() && name.find(_filter) == std::string::npos)
+            return;
+
+        operation();
+
+        typedef std::chrono::steady_clock clock;
+        unsigned long iterations = 0;
+        double elapsed = 0.0;
+        allocations = allocated_bytes = 0;
+        for(unsigned long batch = 1; elapsed < _time_budget; batch *= 2)
+        {
+            counting = true;
+            const clock::time_point start = clock::now();
+            for(unsigned long i = 0; i < batch; ++i)
+                operation();
+            const clock::time_point end = clock::now();
+            counting = false;
+
+            elapsed += std::chrono::duration<double>(end - start).count();
+            iterations += batch;
+        }
+
+        char contacts[16] = "-";
+        if(_contacts > 0)
+            std::snprintf(contacts, sizeof(contacts), "%d", _contacts);
+        std::printf("%-32s %5d %8s  %-44s %12.1f %10.2f %12.1f\n", _model.c_str(), _dofs, contacts, name.c_str(),
+                    1e9*elapsed/iterations, double(allocations)/iterations, double(allocated_bytes)/iterations);
+        std::fflush(stdout);
+    }
+
+private:
+    double _time_budget;
+    std::string _filter;
+    std::string _model;
+    int _dofs, _contacts;
+};
+
+template <class Updatable>
+std::function<void()> update(const boost::shared_ptr<Updatable>& updatable, const Eigen::VectorXd& x)
+{
+    return [updatable, &x](){ updatable->update(x); };
+}
+
+/**
+ * @brief benchmarkModel times the tasks, constraints and utilities which do not depend on the contacts
+ */
+void benchmarkModel(MicroBenchmark& benchmark, XBot::ModelInterface::Ptr model, const Eigen::VectorXd& q)
+{
+    const int n = q.size();
+    XBot::ModelInterface& robot = *model;
+
+    Eigen::VectorXd qmin, qmax, qdotmax, taumax;
+    robot.getJointLimits(qmin, qmax);
+    robot.getVelocityLimits(qdotmax);
+    robot.getEffortLimits(taumax);
+
+    benchmark.run("ModelInterface::update", [&robot](){ robot.update(); });
+
+    // velocity tasks
+    tasks::velocity::Cartesian::Ptr cartesian(
+        new tasks::velocity::Cartesian("cartesian", q, robot, "LSoftHand", "world"));
+    benchmark.run("tasks::velocity::Cartesian", update(cartesian, q));
+    tasks::velocity::CoM::Ptr com(new tasks::velocity::CoM(q, robot));
+    benchmark.run("tasks::velocity::CoM", update(com, q));
+    tasks::velocity::Postural::Ptr postural(new tasks::velocity::Postural(q));
+    benchmark.run("tasks::velocity::Postural", update(postural, q));
+    benchmark.run("tasks::velocity::Gaze",
+        update(boost::make_shared<tasks::velocity::Gaze>("gaze", q, robot, "Waist"), q));
+    benchmark.run("tasks::velocity::Contact",
+        update(boost::make_shared<tasks::velocity::Contact>("contact", robot, "l_sole",
+                                                            Eigen::MatrixXd::Identity(6,6)), q));
+    benchmark.run("tasks::velocity::AngularMomentum",
+        update(boost::make_shared<tasks::velocity::AngularMomentum>(q, robot), q));
+    benchmark.run("tasks::velocity::LinearMomentum",
+        update(boost::make_shared<tasks::velocity::LinearMomentum>(q, robot), q));
+    benchmark.run("tasks::velocity::MinimizeAcceleration",
+        update(boost::make_shared<tasks::velocity::MinimizeAcceleration>(q), q));
+    benchmark.run("tasks::velocity::MinimumVelocity",
+        update(boost::make_shared<tasks::velocity::MinimumVelocity>(n), q));
+    benchmark.run("tasks::velocity::MinimumEffort",
+        update(boost::make_shared<tasks::velocity::MinimumEffort>(q, robot), q));
+    benchmark.run("tasks::velocity::Manipulability",
+        update(boost::make_shared<tasks::velocity::Manipulability>(q, robot, cartesian), q));
+    // the soles of the humanoids stand in for the wheels
+    benchmark.run("tasks::velocity::PureRolling",
+        update(boost::make_shared<tasks::velocity::PureRolling>("l_sole", 0.1, robot), q));
+    benchmark.run("tasks::velocity::RigidRotation",
+        update(boost::make_shared<tasks::velocity::RigidRotation>("l_sole", "Waist", robot, 0.01), q));
+    benchmark.run("tasks::velocity::Unicycle",
+        update(boost::make_shared<tasks::velocity::Unicycle>("unicycle", q, robot, "l_sole", "world", 0.1, 1), q));
+
+    // acceleration tasks
+    benchmark.run("tasks::acceleration::Cartesian",
+        update(boost::make_shared<tasks::acceleration::Cartesian>("cartesian", robot, "LSoftHand", "world", q), q));
+    benchmark.run("tasks::acceleration::CoM",
+        update(boost::make_shared<tasks::acceleration::CoM>(robot, q), q));
+    benchmark.run("tasks::acceleration::Postural",
+        update(boost::make_shared<tasks::acceleration::Postural>(robot, n), q));
+    benchmark.run("tasks::acceleration::Contact",
+        update(boost::make_shared<tasks::acceleration::Contact>("contact", robot, "l_sole", q), q));
+
+    // torque, force and floating base tasks
+    benchmark.run("tasks::torque::JointImpedanceCtrl",
+        update(boost::make_shared<tasks::torque::JointImpedanceCtrl>(q, robot), q));
+    benchmark.run("tasks::torque::CartesianImpedanceCtrl",
+        update(boost::make_shared<tasks::torque::CartesianImpedanceCtrl>("impedance", q, robot,
+                                                                         "LSoftHand", "world"), q));
+    Eigen::VectorXd wrench = Eigen::VectorXd::Zero(6);
+    benchmark.run("tasks::force::Wrench", update(boost::make_shared<tasks::force::Wrench>(wrench), wrench));
+    if(robot.isFloatingBase())
+        benchmark.run("tasks::floating_base::Contact",
+            update(boost::make_shared<tasks::floating_base::Contact>(robot, "l_sole"), q));
+
+    // generic tasks and containers
+    benchmark.run("tasks::GenericTask",
+        update(boost::make_shared<tasks::GenericTask>("generic", Eigen::MatrixXd::Identity(6, n),
+                                                      Eigen::VectorXd::Zero(6)), q));
+    benchmark.run("tasks::MinimizeVariable",
+        update(boost::make_shared<tasks::MinimizeVariable>("minimize", AffineHelper::Identity(n)), q));
+    std::list<unsigned int> position;
+    position.push_back(0); position.push_back(1); position.push_back(2);
+    benchmark.run("SubTask", update(boost::make_shared<SubTask>(cartesian, position), q));
+    benchmark.run("tasks::Aggregated",
+        update(boost::make_shared<tasks::Aggregated>(cartesian, postural, n), q));
+
+    // velocity constraints
+    constraints::velocity::JointLimits::Ptr joint_limits(
+        new constraints::velocity::JointLimits(q, qmax, qmin));
+    benchmark.run("constraints::velocity::JointLimits", update(joint_limits, q));
+    constraints::velocity::VelocityLimits::Ptr velocity_limits(
+        new constraints::velocity::VelocityLimits(qdotmax, 0.01));
+    benchmark.run("constraints::velocity::VelocityLimits", update(velocity_limits, q));
+    benchmark.run("constraints::velocity::CoMVelocity",
+        update(boost::make_shared<constraints::velocity::CoMVelocity>(Eigen::VectorXd::Constant(3, 0.1), 0.01,
+                                                                      q, robot), q));
+    benchmark.run("constraints::velocity::CartesianVelocity",
+        update(boost::make_shared<constraints::velocity::CartesianVelocity>(Eigen::VectorXd::Constant(6, 0.1),
+                                                                            0.01, cartesian), q));
+
+    Eigen::MatrixXd A_box(6, 3);
+    A_box << Eigen::Matrix3d::Identity(), -Eigen::Matrix3d::Identity();
+    Eigen::VectorXd b_box = Eigen::VectorXd::Constant(6, 2.0);
+    benchmark.run("constraints::velocity::CartesianPositionConstraint",
+        update(boost::make_shared<constraints::velocity::CartesianPositionConstraint>(q, cartesian,
+                                                                                      A_box, b_box), q));
+    Eigen::MatrixXd A_square(4, 2);
+    A_square << Eigen::Matrix2d::Identity(), -Eigen::Matrix2d::Identity();
+    Eigen::VectorXd b_square = Eigen::VectorXd::Constant(4, 0.2);
+    benchmark.run("constraints::velocity::CapturePointConstraint",
+        update(boost::make_shared<constraints::velocity::CapturePointConstraint>(q, com, robot,
+                                                                                 A_square, b_square, 0.01), q));
+
+    // a wall in front of the robot
+    utils::SignedDistanceField::Points wall;
+    for(double y = -1.0; y <= 1.0; y += 0.05)
+        for(double z = 0.0; z <= 2.0; z += 0.05)
+            wall.push_back(Eigen::Vector3d(1.0, y, z));
+    constraints::velocity::EnvironmentCollisionAvoidance::Ptr environment(
+        new constraints::velocity::EnvironmentCollisionAvoidance(q, robot,
+            utils::SignedDistanceField::fromPointCloud(wall, Eigen::Vector3d(-1.5, -1.5, -0.5), 0.05,
+                                                       Eigen::Vector3i(60, 60, 60))));
+    environment->addControlSphere("LSoftHand", Eigen::Vector3d::Zero(), 0.1);
+    environment->addControlSphere("RSoftHand", Eigen::Vector3d::Zero(), 0.1);
+    environment->addControlCapsule("torso", Eigen::Vector3d::Zero(), Eigen::Vector3d(0.0, 0.0, 0.3), 0.2);
+    benchmark.run("constraints::velocity::EnvironmentCollisionAvoidance", update(environment, q));
+
+    // torque and generic constraints
+    benchmark.run("constraints::torque::JointLimits",
+        update(boost::make_shared<constraints::torque::JointLimits>(q, qmax, qmin, robot), q));
+    benchmark.run("constraints::torque::TorqueLimits",
+        update(boost::make_shared<constraints::torque::TorqueLimits>(taumax, -taumax), q));
+    benchmark.run("constraints::GenericConstraint",
+        update(boost::make_shared<constraints::GenericConstraint>("generic", AffineHelper::Identity(n), qdotmax,
+                                                                  -qdotmax,
+                                                                  constraints::GenericConstraint::Type::BOUND), q));
+    benchmark.run("constraints::TaskToConstraint",
+        update(boost::make_shared<constraints::TaskToConstraint>(postural, Eigen::VectorXd::Constant(n, -0.1),
+                                                                 Eigen::VectorXd::Constant(n, 0.1)), q));
+    benchmark.run("constraints::Aggregated",
+        update(boost::make_shared<constraints::Aggregated>(joint_limits, velocity_limits, n), q));
+
+    // utilities
+    AffineHelper identity = AffineHelper::Identity(n);
+    AffineHelper affine = AffineHelper::Identity(n);
+    Eigen::MatrixXd J;
+    robot.getJacobian("LSoftHand", J);
+    benchmark.run("AffineHelper matrix*affine", [&affine, &J, &identity](){ affine = J*identity; });
+    benchmark.run("AffineHelper affine+affine", [&affine, &identity](){ affine = identity + identity; });
+    benchmark.run("AffineHelper affine-vector", [&affine, &identity, &q](){ affine = identity - q; });
+    benchmark.run("AffineHelper affine/affine", [&affine, &identity](){ affine = identity/identity; });
+
+    Indices left = Indices::range(0, n/2), right = Indices::range(n/4, n-1);
+    benchmark.run("Indices::range", [n](){ Indices::range(0, n-1); });
+    benchmark.run("Indices operator+", [&left, &right](){ left + right; });
+    benchmark.run("Indices operator-", [&left, &right](){ left - right; });
+    benchmark.run("Indices::filter", [&left, &right](){ Indices(left).filter(right); });
+    benchmark.run("Indices::shift", [&left](){ Indices(left).shift(6); });
+
+    // cost function and solution of a two levels stack
+    solvers::iHQP::Stack stack;
+    stack.push_back(cartesian);
+    stack.push_back(postural);
+    CostFunction solver(stack);
+    Eigen::MatrixXd H;
+    Eigen::VectorXd g, dq;
+    benchmark.run("iHQP::computeCostFunction", [&solver, &cartesian, &H, &g](){
+        solver.computeCostFunction(cartesian, H, g); });
+    benchmark.run("iHQP::solve", [&solver, &dq](){ solver.solve(dq); });
+}
+
+/**
+ * @brief benchmarkContacts times the tasks, constraints and utilities whose size grows with the contacts
+ */
+void benchmarkContacts(MicroBenchmark& benchmark, XBot::ModelInterface::Ptr model, const Eigen::VectorXd& q,
+                       std::vector<std::string> links)
+{
+    const int n = q.size();
+    XBot::ModelInterface& robot = *model;
+
+    OptvarHelper::VariableVector variables;
+    variables.push_back(std::make_pair(std::string("qddot"), n));
+    for(unsigned int i = 0; i < links.size(); ++i)
+        variables.push_back(std::make_pair(links[i], 6));
+    OptvarHelper optvar(variables);
+    AffineHelper qddot = optvar.getVariable("qddot");
+    std::vector<AffineHelper> wrenches;
+    for(unsigned int i = 0; i < links.size(); ++i)
+        wrenches.push_back(optvar.getVariable(links[i]));
+    Eigen::VectorXd x = Eigen::VectorXd::Zero(optvar.getSize());
+    Eigen::VectorXd w = Eigen::VectorXd::Zero(6*links.size());
+
+    constraints::force::FrictionCone::friction_cones cones;
+    for(unsigned int i = 0; i < links.size(); ++i)
+        cones.push_back(std::make_pair(links[i], 0.5));
+
+    benchmark.run("tasks::force::CoM", update(boost::make_shared<tasks::force::CoM>(w, links, robot), w));
+    benchmark.run("constraints::force::FrictionCone",
+        update(boost::make_shared<constraints::force::FrictionCone>(w, robot, cones), w));
+    benchmark.run("constraints::force::WrenchLimits",
+        update(boost::make_shared<constraints::force::WrenchLimits>(300., w.size()), w));
+    // CoP::update is private, it is called as a Constraint
+    benchmark.run("constraints::force::CoP",
+        update<constraints::force::CoP::ConstraintType>(boost::make_shared<constraints::force::CoP>(robot, wrenches, links, Eigen::Vector2d(-0.05, 0.1),
+                                                           Eigen::Vector2d(-0.05, 0.05)), x));
+    if(robot.isFloatingBase())
+    {
+        benchmark.run("tasks::force::FloatingBase",
+            update(boost::make_shared<tasks::force::FloatingBase>(robot, wrenches, links), x));
+        benchmark.run("constraints::acceleration::DynamicFeasibility",
+            update(boost::make_shared<constraints::acceleration::DynamicFeasibility>("dynamics", robot, qddot,
+                                                                                     wrenches, links), x));
+    }
+    // a support polygon needs at least three points
+    if(links.size() > 2)
+        benchmark.run("constraints::velocity::ConvexHull",
+            update(boost::make_shared<constraints::velocity::ConvexHull>(q, robot,
+                std::list<std::string>(links.begin(), links.end())), q));
+
+    std::vector<Eigen::MatrixXd> jacobians(links.size());
+    for(unsigned int i = 0; i < links.size(); ++i)
+        robot.getJacobian(links[i], jacobians[i]);
+    utils::MatrixPiler piler(n);
+    benchmark.run("MatrixPiler::pile", [&piler, &jacobians](){
+        piler.reset();
+        for(unsigned int i = 0; i < jacobians.size(); ++i)
+            piler.pile(jacobians[i]);
+    });
+}
+
+}
+
+/**
+ * Times the update of the tasks and the constraints of OpenSoT, and some of the utilities used by them, on the
+ * models of the tests: the number of dofs changes with the model, the number of contacts from one to four
+ * (the soles, then the hands). For each operation prints the mean time and the heap allocations per operation.
+ */
+int main(int argc, char** argv)
+{
+    double time_budget = 0.2;
+    std::string filter;
+    std::vector<std::string> configs;
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        if(arg == "-t" && i + 1 < argc)
+            time_budget = std::atof(argv[++i]);
+        else if(arg == "-f" && i + 1 < argc)
+            filter = argv[++i];
+        else if(arg == "-h" || arg == "--help")
+        {
+            std::cout << "Usage: " << argv[0] << " [-t seconds per operation] [-f operation filter] [config]..."
+                      << std::endl;
+            std::cout << "    without configs the models of the tests are used, from $ROBOTOLOGY_ROOT" << std::endl;
+            return 0;
+        }
+        else
+            configs.push_back(arg);
+    }
+
+    if(configs.empty())
+    {
+        const char* robotology_root = std::getenv("ROBOTOLOGY_ROOT");
+        if(!robotology_root)
+        {
+            std::cout << "ROBOTOLOGY_ROOT is not set, give the config files of the models" << std::endl;
+            return 1;
+        }
+        const std::string path = std::string(robotology_root) + "/external/OpenSoT/tests/configs/";
+        configs.push_back(path + "coman/configs/config_coman_RBDL.yaml");
+        configs.push_back(path + "coman/configs/config_coman_floating_base.yaml");
+        configs.push_back(path + "bigman/configs/config_bigman.yaml");
+    }
+
+    const char* contact_links[] = {"l_sole", "r_sole", "LSoftHand", "RSoftHand"};
+
+    MicroBenchmark benchmark(time_budget, filter);
+    for(unsigned int c = 0; c < configs.size(); ++c)
+    {
+        XBot::ModelInterface::Ptr model = XBot::ModelInterface::getModel(configs[c]);
+
+        // middle of the joint range, floating base at the origin
+        Eigen::VectorXd qmin, qmax;
+        model->getJointLimits(qmin, qmax);
+        Eigen::VectorXd q = 0.5*(qmin + qmax);
+        if(model->isFloatingBase())
+            q.head(6).setZero();
+        model->setJointPosition(q);
+        model->setJointVelocity(Eigen::VectorXd::Zero(q.size()));
+        model->update();
+
+        const std::string name = configs[c].substr(configs[c].find_last_of('/') + 1);
+        benchmark.setModel(name, q.size(), 0);
+        benchmarkModel(benchmark, model, q);
+
+        std::vector<std::string> links;
+        for(unsigned int i = 0; i < sizeof(contact_links)/sizeof(contact_links[0]); ++i)
+        {
+            links.push_back(contact_links[i]);
+            benchmark.setModel(name, q.size(), links.size());
+            benchmarkContacts(benchmark, model, q, links);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <OpenSoT/solvers/QPReplay.h>
+#include <qpOASES.hpp>
+#include <cstdio>
+#include <iostream>
+
+using namespace OpenSoT::solvers;
+
+/**
+ * Replays the QP problems recorded by OpenSoT::solvers::QPRecorder with one or more back-ends and option sets,
+ * and prints the distribution of the solve times and the distance from the recorded solutions.
+ * A configuration is the name of a back-end, for qpOASES followed by an option preset:
+ * qpOASES (the options used by OpenSoT), qpOASES:default, qpOASES:reliable, qpOASES:mpc, OSQP
+ */
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <snapshot file> [configuration]..." << std::endl;
+        std::cout << "    configurations: qpOASES, qpOASES:default, qpOASES:reliable, qpOASES:mpc, OSQP" << std::endl;
+        return 1;
+    }
+
+    std::vector<QPSnapshot> snapshots;
+    QPRecorder::load(argv[1], snapshots);
+    if(snapshots.empty())
+    {
+        std::cout << "No snapshots in " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> configurations(argv + 2, argv + argc);
+    if(configurations.empty())
+    {
+        configurations.push_back("qpOASES");
+        configurations.push_back("OSQP");
+    }
+
+    double recorded_time = 0.0;
+    for(unsigned int i = 0; i < snapshots.size(); ++i)
+        recorded_time += snapshots[i].solve_time;
+    std::printf("%lu snapshots, recorded mean solve time %.1f us\n\n", snapshots.size(),
+                1e6*recorded_time/snapshots.size());
+    std::printf("%-18s %8s %10s %10s %10s %10s %10s %12s\n", "configuration", "failures",
+                "mean [us]", "p50 [us]", "p95 [us]", "p99 [us]", "max [us]", "max error");
+
+    QPReplay replay(snapshots);
+    for(unsigned int i = 0; i < configurations.size(); ++i)
+    {
+        const std::string& configuration = configurations[i];
+        solver_back_ends be_solver;
+        boost::any options;
+        if(configuration.compare(0, 7, "qpOASES") == 0)
+        {
+            be_solver = solver_back_ends::qpOASES;
+            if(configuration.size() > 7)
+            {
+                qpOASES::Options opt;
+                if(configuration == "qpOASES:default")
+                    opt.setToDefault();
+                else if(configuration == "qpOASES:reliable")
+                    opt.setToReliable();
+                else if(configuration == "qpOASES:mpc")
+                    opt.setToMPC();
+                else
+                {
+                    std::cout << "Unknown configuration " << configuration << std::endl;
+                    continue;
+                }
+                opt.printLevel = qpOASES::PL_NONE;
+                options = opt;
+            }
+        }
+        else if(configuration == "OSQP")
+            be_solver = solver_back_ends::OSQP;
+        else
+        {
+            std::cout << "Unknown configuration " << configuration << std::endl;
+            continue;
+        }
+
+        QPReplayResult result;
+        if(!replay.replay(be_solver, result, options))
+            continue;
+
+        std::printf("%-18s %8u %10.1f %10.1f %10.1f %10.1f %10.1f %12.3e\n", configuration.c_str(), result.failures,
+                    1e6*result.getMeanSolveTime(), 1e6*result.getSolveTimePercentile(50.0),
+                    1e6*result.getSolveTimePercentile(95.0), 1e6*result.getSolveTimePercentile(99.0),
+                    1e6*result.getSolveTimePercentile(100.0), result.getMaxSolutionError());
+    }
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <OpenSoT/utils/RTLogger.h>
+#include <XBotInterface/Logger.hpp>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+/**
+ * Converts a log written by OpenSoT::utils::RTLogger into a .mat file (through XBot::MatLogger),
+ * where each channel is a variable with one sample per column (matrices are stored column major)
+ */
+int main(int argc, char** argv)
+{
+    if(argc != 3)
+    {
+        std::cout << "Usage: " << argv[0] << " <log file> <mat file prefix>" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::vector<Eigen::MatrixXd> > data;
+    bool complete = OpenSoT::utils::RTLogger::load(argv[1], data);
+    if(data.empty())
+        return 1;
+
+    XBot::MatLogger::Ptr logger = XBot::MatLogger::getLogger(argv[2]);
+    for(std::map<std::string, std::vector<Eigen::MatrixXd> >::const_iterator it = data.begin(); it != data.end(); ++it)
+    {
+        unsigned int size = 0;
+        for(unsigned int i = 0; i < it->second.size(); ++i)
+            size = std::max<unsigned int>(size, it->second[i].size());
+        if(size == 0)
+            continue;
+
+        // samples smaller than the channel are padded with NaN
+        logger->createVectorVariable(it->first, size, 1, it->second.size());
+        Eigen::VectorXd sample(size);
+        for(unsigned int i = 0; i < it->second.size(); ++i)
+        {
+            sample.setConstant(std::numeric_limits<double>::quiet_NaN());
+            sample.head(it->second[i].size()) = Eigen::Map<const Eigen::VectorXd>(it->second[i].data(), it->second[i].size());
+            logger->add(it->first, sample);
+        }
+        std::cout << it->first << ": " << it->second.size() << " samples" << std::endl;
+    }
+    logger->flush();
+
+    return complete ? 0 : 1;
+}